@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 199309L
+#include "bench_common.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_PHRASES (4)
+
+double benchNow(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Synthetic projects
+//
+
+void benchProjectInit(Project* p, int chipsCount) {
+  static const char noteStrings[12][4] = { "C-", "C#", "D-", "D#", "E-", "F-", "F#", "G-", "G#", "A-", "A#", "B-" };
+
+  projectInit(p);
+
+  strcpy(p->title, "Benchmark");
+  p->tickRate = 50;
+  p->chipType = chipAY;
+  p->chipsCount = chipsCount;
+  p->chipSetup.ay.clock = 1750000;
+  p->chipSetup.ay.isYM = 0;
+  p->chipSetup.ay.stereoMode = ayStereoABC;
+  p->chipSetup.ay.stereoSeparation = 50;
+  p->tracksCount = projectGetTotalTracks(p);
+
+  // 12TET, 9 octaves starting from C-0
+  strcpy(p->pitchTable.name, "12TET 1750000Hz");
+  p->pitchTable.length = 9 * 12;
+  p->pitchTable.octaveSize = 12;
+  for (int c = 0; c < p->pitchTable.length; c++) {
+    float freq = 440.0f * powf(2.0f, (c + 12 - 69) / 12.0f);
+    int period = (int)(p->chipSetup.ay.clock / (16.0f * freq) + 0.5f);
+    if (period > 4095) period = 4095;
+    p->pitchTable.values[c] = period;
+    sprintf(p->pitchTable.noteNames[c], "%s%d", noteStrings[c % 12], c / 12);
+  }
+
+  // Instrument 0: plain tone with a short decay, table 0
+  Instrument* inst = &p->instruments[0];
+  inst->type = instAY;
+  strcpy(inst->name, "BENCH");
+  inst->tableSpeed = 1;
+  inst->transposeEnabled = 1;
+  inst->chip.ay.veA = 0;
+  inst->chip.ay.veD = 8;
+  inst->chip.ay.veS = 10;
+  inst->chip.ay.veR = 4;
+  inst->chip.ay.autoEnvN = 0;
+  inst->chip.ay.autoEnvD = 1;
+  inst->chip.ay.defaultMixer = 0x01;
+}
+
+void benchProjectFillSong(Project* p) {
+  // Every track plays its own chain so tracks don't share phrase state
+  for (int t = 0; t < p->tracksCount; t++) {
+    p->song[0][t] = t;
+    for (int c = 0; c < BENCH_PHRASES; c++) {
+      p->chains[t].rows[c].phrase = t * BENCH_PHRASES + c;
+      p->chains[t].rows[c].transpose = 0;
+    }
+
+    for (int c = 0; c < BENCH_PHRASES; c++) {
+      Phrase* phrase = &p->phrases[t * BENCH_PHRASES + c];
+      for (int r = 0; r < 16; r++) {
+        phrase->rows[r].note = 36 + ((r * 7 + c * 3 + t) % 24);
+        phrase->rows[r].instrument = 0;
+        phrase->rows[r].volume = 15;
+      }
+    }
+  }
+}
+
+void benchProjectSetPhraseFX(Project* p, int column, uint8_t fx, uint8_t value) {
+  for (int c = 0; c < p->tracksCount * BENCH_PHRASES; c++) {
+    for (int r = 0; r < 16; r++) {
+      p->phrases[c].rows[r].fx[column][0] = fx;
+      p->phrases[c].rows[r].fx[column][1] = value;
+    }
+  }
+}
+
+uint8_t benchFXDefaultValue(uint8_t fx) {
+  switch (fx) {
+  case fxARP: return 0x37;
+  case fxARC: return 0x21;
+  case fxPVB: return 0x44;
+  case fxPBN: return 0x10;
+  case fxPSL: return 0x04;
+  case fxPIT: return 0x01;
+  case fxFIN: return 0x02;
+  case fxPRD: return 0x01;
+  case fxVOL: return 0x01;
+  case fxRET: return 0x82;
+  case fxDEL: return 0x02;
+  case fxOFF: return 0x03;
+  case fxKIL: return 0x04;
+  case fxTIC: return 0x02;
+  case fxTBL: return 0x00;
+  case fxTBX: return 0x01;
+  case fxTHO: return 0x00;
+  case fxTXH: return 0x00;
+  case fxGRV: return 0x00;
+  case fxGGR: return 0x00;
+  case fxHOP: return 0x10;
+  case fxSNG: return 0x00;
+  case fxAYM: return 0x03;
+  case fxERT: return 0x00;
+  case fxNOI: return 0x01;
+  case fxNOA: return 0x05;
+  case fxEAU: return 0x11;
+  case fxEVB: return 0x44;
+  case fxEBN: return 0x10;
+  case fxESL: return 0x04;
+  case fxENT: return 0x30;
+  case fxEPT: return 0x01;
+  case fxEPL: return 0x20;
+  case fxEPH: return 0x01;
+  default: return 0x00;
+  }
+}
@@ -0,0 +1,19 @@
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include "chipnomad_lib.h"
+
+// Monotonic time in nanoseconds
+double benchNow(void);
+
+// Initialize an empty AY project with 12TET pitch table and a default instrument 0
+void benchProjectInit(Project* p, int chipsCount);
+// Fill song with one looping chain per track. Every phrase row gets a note and instrument 0
+void benchProjectFillSong(Project* p);
+// Put the FX into the given column of every phrase row used by the song
+void benchProjectSetPhraseFX(Project* p, int column, uint8_t fx, uint8_t value);
+
+// Typical value for the FX, used by synthetic scenarios
+uint8_t benchFXDefaultValue(uint8_t fx);
+
+#endif
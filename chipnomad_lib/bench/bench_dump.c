@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+
+// Register dump benchmark: exports every project as PSG, VGM and a compact
+// register dump (.cnr) to scratch files, then decodes the dump into null
+// sound chips. Reports file sizes, compression ratio of the dump against
+// PSG, export times and decode cost per frame. VGM is skipped for projects
+// with more than 2 chips.
+//
+// Usage: bench_dump [-o scratch] [-n decodeRuns] [--json] project.cnm ...
+
+static const char* scratchPath = "bench_dump";
+static int decodeRuns = 20;
+
+typedef struct DumpResult {
+  char name[64];
+  int frames;
+  long psgBytes;
+  long vgmBytes; // -1 if the project can't be exported to VGM
+  long dumpBytes;
+  double ratio;
+  double psgExportMs;
+  double vgmExportMs;
+  double dumpExportMs;
+  double decodeNsPerFrame;
+} DumpResult;
+
+static long fileSize(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+// Returns export time in ms or -1 on failure
+static double measureExport(Exporter* exporter) {
+  if (!exporter) return -1;
+
+  double start = benchNow();
+  while (exporter->next(exporter) != -1);
+  if (exporter->finish(exporter)) return -1;
+  return (benchNow() - start) / 1e6;
+}
+
+// Returns decoding time per frame in ns or -1 on failure
+static double measureDecode(const char* path, int* frames) {
+  SoundChip chips[PROJECT_MAX_CHIPS];
+  ChipSetup setup;
+  memset(&setup, 0, sizeof(setup));
+  for (int c = 0; c < PROJECT_MAX_CHIPS; c++) {
+    chips[c] = createChipNull(c, 44100, setup);
+  }
+
+  double totalNs = 0;
+  long totalFrames = 0;
+  for (int run = 0; run < decodeRuns; run++) {
+    double start = benchNow();
+    RegisterDumpReader* reader = registerDumpOpen(path);
+    if (!reader) return -1;
+
+    int result;
+    while ((result = registerDumpNextFrame(reader, chips)) == 0);
+    *frames = reader->framesCount;
+    registerDumpClose(reader);
+    if (result < 0) return -1;
+
+    totalNs += benchNow() - start;
+    totalFrames += *frames;
+  }
+  return totalFrames > 0 ? totalNs / totalFrames : 0;
+}
+
+static int measureProject(Project* project, DumpResult* result) {
+  char psgPath[1024];
+  char vgmPath[1024];
+  char dumpPath[1024];
+  snprintf(psgPath, sizeof(psgPath), "%s.psg", scratchPath);
+  snprintf(vgmPath, sizeof(vgmPath), "%s.vgm", scratchPath);
+  snprintf(dumpPath, sizeof(dumpPath), "%s.cnr", scratchPath);
+
+  result->psgExportMs = measureExport(createPSGExporter(psgPath, project, 0));
+  result->vgmExportMs = -1;
+  result->vgmBytes = -1;
+  if (project->chipsCount <= 2) {
+    result->vgmExportMs = measureExport(createVGMExporter(vgmPath, project, 0));
+    result->vgmBytes = fileSize(vgmPath);
+    fileDelete(vgmPath);
+    if (result->vgmExportMs < 0 || result->vgmBytes <= 0) return 1;
+  }
+  result->dumpExportMs = measureExport(createRegisterDumpExporter(dumpPath, project, 0));
+  result->dumpBytes = fileSize(dumpPath);
+  result->decodeNsPerFrame = measureDecode(dumpPath, &result->frames);
+  fileDelete(dumpPath);
+
+  // PSG exporter writes a file per chip
+  result->psgBytes = 0;
+  for (int c = 0; c < project->chipsCount; c++) {
+    if (project->chipsCount > 1) snprintf(psgPath, sizeof(psgPath), "%s-%d.psg", scratchPath, c + 1);
+    long size = fileSize(psgPath);
+    if (size > 0) result->psgBytes += size;
+    fileDelete(psgPath);
+  }
+
+  if (result->psgExportMs < 0 || result->dumpExportMs < 0 || result->decodeNsPerFrame < 0 ||
+      result->psgBytes <= 0 || result->dumpBytes <= 0) {
+    return 1;
+  }
+  result->ratio = (double)result->psgBytes / result->dumpBytes;
+  return 0;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      decodeRuns = atoi(argv[++c]);
+      if (decodeRuns < 1) decodeRuns = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-o scratch] [-n decodeRuns] [--json] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  DumpResult* results = calloc(filesCount, sizeof(DumpResult));
+  if (!project || !results) return 1;
+  int resultsCount = 0;
+
+  for (int f = 0; f < filesCount; f++) {
+    if (projectLoad(project, files[f])) {
+      fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+      continue;
+    }
+
+    DumpResult* result = &results[resultsCount];
+    snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+    if (measureProject(project, result)) {
+      fprintf(stderr, "Can't export %s to %s\n", files[f], scratchPath);
+      continue;
+    }
+    resultsCount++;
+
+    if (!json) {
+      if (resultsCount == 1) {
+        printf("%-24s %7s %10s %10s %10s %7s %8s %8s %8s %12s\n",
+          "Project", "Frames", "PSG bytes", "VGM bytes", "CNR bytes", "Ratio", "PSG ms", "VGM ms", "CNR ms", "Decode ns/f");
+      }
+      printf("%-24s %7d %10ld %10ld %10ld %6.2fx %8.2f %8.2f %8.2f %12.1f\n",
+        result->name, result->frames, result->psgBytes, result->vgmBytes, result->dumpBytes, result->ratio,
+        result->psgExportMs, result->vgmExportMs, result->dumpExportMs, result->decodeNsPerFrame);
+      fflush(stdout);
+    }
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"dump\",\n  \"decodeRuns\": %d,\n  \"results\": [\n", decodeRuns);
+    for (int c = 0; c < resultsCount; c++) {
+      DumpResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"frames\": %d, \"psgBytes\": %ld, \"vgmBytes\": %ld, \"dumpBytes\": %ld, "
+        "\"ratio\": %.2f, \"psgExportMs\": %.2f, \"vgmExportMs\": %.2f, \"dumpExportMs\": %.2f, \"decodeNsPerFrame\": %.1f}%s\n",
+        r->name, r->frames, r->psgBytes, r->vgmBytes, r->dumpBytes, r->ratio, r->psgExportMs, r->vgmExportMs,
+        r->dumpExportMs, r->decodeNsPerFrame, c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(results);
+  free(project);
+  return 0;
+}
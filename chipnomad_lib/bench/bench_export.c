@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bench_common.h"
+#include "export/export.h"
+
+// WAV export benchmark: runs the WAV exporter to a scratch file for every
+// bit depth and reports export throughput next to the cost of rendering
+// alone, so the remainder is what conversion and file writes cost.
+// With -j the parallel exporter is used with the given number of threads.
+// Loudness normalization to 16 bit is compared with the two-step way of
+// exporting float32 first, then measuring and rewriting the file.
+//
+// Usage: bench_export [-o scratch.wav] [-r sampleRate] [-j threads] [-n LUFS] [--json] project.cnm ...
+
+static const char* outputPath = "bench_export.wav";
+static int sampleRate = 44100;
+static int threadsCount = 1;
+static float targetLUFS = -14.0f;
+
+#define TRUE_PEAK_LIMIT (-1.0f)
+#define TWO_STEP_CHUNK (8192)
+
+static const int bitDepths[] = {16, 24, 32};
+
+typedef struct ExportResult {
+  char name[64];
+  int bitDepth;
+  double seconds;
+  double exportMs;
+  double renderMs;
+  long bytes;
+} ExportResult;
+
+typedef struct NormalizeResult {
+  char name[64];
+  double plainMs; // 16 bit export without normalization
+  double singleMs;
+  double twoStepMs;
+  LoudnessStats stats;
+} NormalizeResult;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Measurement
+//
+
+// Render the song the same way the exporter does, without writing anything
+static double measureRenderOnly(Project* project) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return 0;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, sampleRate, NULL);
+  chipnomadSetQuality(state, CHIPNOMAD_QUALITY_BEST);
+  playbackStartSong(&state->playbackState, 0, 0, 0);
+
+  float* buffer = malloc(sampleRate * 2 * sizeof(float));
+
+  double start = benchNow();
+  while (chipnomadRender(state, buffer, sampleRate) == sampleRate);
+  double ns = benchNow() - start;
+
+  free(buffer);
+  chipnomadDestroy(state);
+  return ns;
+}
+
+static Exporter* createExporter(Project* project, int bitDepth) {
+  return threadsCount > 1 ?
+    createWAVExporterParallel(outputPath, project, 0, sampleRate, bitDepth, threadsCount) :
+    createWAVExporter(outputPath, project, 0, sampleRate, bitDepth);
+}
+
+static int measureExport(Project* project, int bitDepth, ExportResult* result) {
+  double start = benchNow();
+
+  Exporter* exporter = createExporter(project, bitDepth);
+  if (!exporter) return 1;
+  int seconds = 0;
+  int next;
+  while ((next = exporter->next(exporter)) != -1) seconds = next;
+  exporter->finish(exporter);
+
+  result->exportMs = (benchNow() - start) / 1e6;
+  result->bitDepth = bitDepth;
+  result->seconds = seconds;
+
+  FILE* file = fopen(outputPath, "rb");
+  if (file) {
+    fseek(file, 0, SEEK_END);
+    result->bytes = ftell(file);
+    fclose(file);
+  }
+  return 0;
+}
+
+// Single pass: normalization built into the exporter
+static double measureNormalized(Project* project, LoudnessStats* stats) {
+  double start = benchNow();
+
+  Exporter* exporter = createExporter(project, 16);
+  if (!exporter) return -1;
+  if (wavExporterSetNormalization(exporter, targetLUFS, TRUE_PEAK_LIMIT)) {
+    exporter->cancel(exporter);
+    return -1;
+  }
+  while (exporter->next(exporter) != -1);
+  int failed = exporter->finish(exporter);
+  double ms = (benchNow() - start) / 1e6;
+
+  if (failed || wavReadLoudness(outputPath, stats)) return -1;
+  return ms;
+}
+
+// Two steps: float32 export, then read it back to measure, and read it once
+// more to write the 16 bit file with gain
+static double measureTwoStep(Project* project) {
+  char floatPath[1024];
+  snprintf(floatPath, sizeof(floatPath), "%s.f32", outputPath);
+  double start = benchNow();
+
+  Exporter* exporter = threadsCount > 1 ?
+    createWAVExporterParallel(floatPath, project, 0, sampleRate, 32, threadsCount) :
+    createWAVExporter(floatPath, project, 0, sampleRate, 32);
+  if (!exporter) return -1;
+  while (exporter->next(exporter) != -1);
+  exporter->finish(exporter);
+
+  float* buffer = malloc(TWO_STEP_CHUNK * 2 * sizeof(float));
+  int16_t* block = malloc(TWO_STEP_CHUNK * 2 * sizeof(int16_t));
+  LoudnessMeter* meter = loudnessCreate(sampleRate, 0);
+  FILE* input = fopen(floatPath, "rb");
+  FILE* output = fopen(outputPath, "wb");
+  if (!buffer || !block || !meter || !input || !output) {
+    free(buffer);
+    free(block);
+    loudnessFree(meter);
+    if (input) fclose(input);
+    if (output) fclose(output);
+    remove(floatPath);
+    return -1;
+  }
+
+  // 44 byte header written by the exporter
+  uint8_t header[44];
+  size_t count = fread(header, 1, sizeof(header), input);
+  while ((count = fread(buffer, sizeof(float) * 2, TWO_STEP_CHUNK, input)) > 0) {
+    loudnessAdd(meter, buffer, (int)count);
+  }
+  LoudnessStats stats;
+  loudnessGetStats(meter, &stats);
+  float scale = powf(10.0f, loudnessNormalizationGain(&stats, targetLUFS, TRUE_PEAK_LIMIT) / 20.0f);
+
+  fseek(input, sizeof(header), SEEK_SET);
+  fwrite(header, 1, sizeof(header), output);
+  while ((count = fread(buffer, sizeof(float) * 2, TWO_STEP_CHUNK, input)) > 0) {
+    for (size_t i = 0; i < count * 2; i++) {
+      float sample = buffer[i] * scale * 32767.0f;
+      sample = sample > 32767.0f ? 32767.0f : sample;
+      sample = sample < -32768.0f ? -32768.0f : sample;
+      block[i] = (int16_t)sample;
+    }
+    fwrite(block, sizeof(int16_t) * 2, count, output);
+  }
+  // Header would be patched for 16 bit here, it doesn't change the cost
+
+  fclose(input);
+  fclose(output);
+  double ms = (benchNow() - start) / 1e6;
+
+  free(buffer);
+  free(block);
+  loudnessFree(meter);
+  remove(floatPath);
+  return ms;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      outputPath = argv[++c];
+    } else if (!strcmp(argv[c], "-r") && c + 1 < argc) {
+      sampleRate = atoi(argv[++c]);
+      if (sampleRate < 8000) sampleRate = 8000;
+    } else if (!strcmp(argv[c], "-j") && c + 1 < argc) {
+      threadsCount = atoi(argv[++c]);
+      if (threadsCount < 1) threadsCount = 1;
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      targetLUFS = (float)atof(argv[++c]);
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-o scratch.wav] [-r sampleRate] [-j threads] [-n LUFS] [--json] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+
+  const int bitDepthsCount = sizeof(bitDepths) / sizeof(bitDepths[0]);
+  ExportResult* results = calloc(filesCount * bitDepthsCount, sizeof(ExportResult));
+  int resultsCount = 0;
+  NormalizeResult* normalizeResults = calloc(filesCount, sizeof(NormalizeResult));
+  int normalizeCount = 0;
+
+  for (int f = 0; f < filesCount; f++) {
+    if (projectLoad(project, files[f])) {
+      fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+      continue;
+    }
+
+    double renderMs = measureRenderOnly(project) / 1e6;
+
+    for (int b = 0; b < bitDepthsCount; b++) {
+      ExportResult* result = &results[resultsCount];
+      snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+      result->renderMs = renderMs;
+      if (measureExport(project, bitDepths[b], result)) {
+        fprintf(stderr, "Can't export to %s\n", outputPath);
+        continue;
+      }
+      resultsCount++;
+      if (bitDepths[b] == 16) normalizeResults[normalizeCount].plainMs = result->exportMs;
+    }
+
+    NormalizeResult* normalize = &normalizeResults[normalizeCount];
+    snprintf(normalize->name, sizeof(normalize->name), "%s", baseName(files[f]));
+    normalize->singleMs = measureNormalized(project, &normalize->stats);
+    normalize->twoStepMs = measureTwoStep(project);
+    if (normalize->singleMs < 0 || normalize->twoStepMs < 0) {
+      fprintf(stderr, "Can't export normalized %s\n", files[f]);
+      continue;
+    }
+    normalizeCount++;
+  }
+  remove(outputPath);
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"export\",\n  \"sampleRate\": %d,\n  \"threads\": %d,\n  \"results\": [\n",
+      sampleRate, threadsCount);
+    for (int c = 0; c < resultsCount; c++) {
+      ExportResult* r = &results[c];
+      double writeMs = r->exportMs - r->renderMs;
+      printf("    {\"project\": \"%s\", \"bitDepth\": %d, \"seconds\": %.0f, \"bytes\": %ld, "
+        "\"exportMs\": %.2f, \"renderMs\": %.2f, \"writeMs\": %.2f, \"realtime\": %.2f, \"mbPerSec\": %.2f}%s\n",
+        r->name, r->bitDepth, r->seconds, r->bytes, r->exportMs, r->renderMs, writeMs,
+        r->seconds * 1000.0 / r->exportMs, r->bytes / 1048576.0 / (r->exportMs / 1000.0),
+        c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ],\n  \"targetLUFS\": %.1f,\n  \"normalize\": [\n", targetLUFS);
+    for (int c = 0; c < normalizeCount; c++) {
+      NormalizeResult* r = &normalizeResults[c];
+      printf("    {\"project\": \"%s\", \"integrated\": %.2f, \"truePeak\": %.2f, \"gain\": %.2f, "
+        "\"plainMs\": %.2f, \"singlePassMs\": %.2f, \"twoStepMs\": %.2f}%s\n",
+        r->name, r->stats.integrated, r->stats.truePeak, r->stats.gain, r->plainMs, r->singleMs, r->twoStepMs,
+        c < normalizeCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  } else {
+    printf("%-24s %4s %8s %10s %10s %10s %10s %9s %8s\n",
+      "Project", "Bits", "Seconds", "MB", "Export ms", "Render ms", "Write ms", "Realtime", "MB/s");
+    for (int c = 0; c < resultsCount; c++) {
+      ExportResult* r = &results[c];
+      printf("%-24s %4d %8.0f %10.2f %10.1f %10.1f %10.1f %8.1fx %8.1f\n",
+        r->name, r->bitDepth, r->seconds, r->bytes / 1048576.0, r->exportMs, r->renderMs,
+        r->exportMs - r->renderMs, r->seconds * 1000.0 / r->exportMs, r->bytes / 1048576.0 / (r->exportMs / 1000.0));
+    }
+
+    printf("\nNormalized to %.1f LUFS, 16 bit\n", targetLUFS);
+    printf("%-24s %8s %8s %8s %10s %12s %10s %9s\n",
+      "Project", "LUFS", "dBTP", "Gain", "Plain ms", "1 pass ms", "2 step ms", "Speedup");
+    for (int c = 0; c < normalizeCount; c++) {
+      NormalizeResult* r = &normalizeResults[c];
+      printf("%-24s %8.2f %8.2f %+8.2f %10.1f %12.1f %10.1f %8.2fx\n",
+        r->name, r->stats.integrated, r->stats.truePeak, r->stats.gain, r->plainMs, r->singleMs, r->twoStepMs,
+        r->twoStepMs / r->singleMs);
+    }
+  }
+
+  free(normalizeResults);
+  free(results);
+  free(project);
+  return 0;
+}
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+
+// Sequencer benchmark: runs playbackNextFrame against null sound chips
+// and reports the cost of a single tick for synthetic and real projects.
+//
+// Usage: bench_playback [-n frames] [--json] [project.cnm ...]
+
+#define BENCH_RUNS (5)
+#define BENCH_WARMUP_FRAMES (1000)
+
+static int framesPerRun = 100000;
+
+typedef struct BenchScenario {
+  const char* name;
+  int chipsCount;
+  void (*setup)(Project* p);
+} BenchScenario;
+
+typedef struct BenchResult {
+  char name[64];
+  int chipsCount;
+  double nsPerFrame;
+} BenchResult;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Synthetic scenarios
+//
+
+static void setupBaseline(Project* p) {
+}
+
+static void setupDenseFX(Project* p) {
+  static const uint8_t fxList[] = {
+    fxARP, fxPVB, fxPBN, fxVOL, fxEVB, fxNOI, fxPSL, fxEBN, fxAYM, fxPRD, fxRET, fxFIN,
+  };
+  const int fxCount = sizeof(fxList) / sizeof(fxList[0]);
+
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    if (phraseIsEmpty(p, c)) continue;
+    for (int r = 0; r < 16; r++) {
+      for (int col = 0; col < 3; col++) {
+        uint8_t fx = fxList[(r * 3 + col + c) % fxCount];
+        p->phrases[c].rows[r].fx[col][0] = fx;
+        p->phrases[c].rows[r].fx[col][1] = benchFXDefaultValue(fx);
+      }
+    }
+  }
+}
+
+static void setTableFX(Table* table, int row, int col, uint8_t fx, uint8_t value) {
+  table->rows[row].fx[col][0] = fx;
+  table->rows[row].fx[col][1] = value;
+}
+
+static void setupTableHops(Project* p) {
+  // Instrument table: nested HOP loops in every column and a THO near the end
+  Table* table = &p->tables[0];
+  for (int r = 0; r < 16; r++) {
+    table->rows[r].pitchOffset = (r * 5) % 12;
+    table->rows[r].volume = 15 - (r % 4);
+  }
+  setTableFX(table, 5, 0, fxHOP, 0x32);
+  setTableFX(table, 15, 0, fxHOP, 0x00);
+  setTableFX(table, 3, 1, fxHOP, 0x11);
+  setTableFX(table, 9, 1, fxHOP, 0x04);
+  setTableFX(table, 0, 2, fxARP, 0x37);
+  setTableFX(table, 6, 2, fxPIT, 0x01);
+  setTableFX(table, 11, 2, fxHOP, 0x26);
+  setTableFX(table, 14, 3, fxTHO, 0x04);
+
+  // Aux table with a short unconditional loop, started from the phrase
+  table = &p->tables[1];
+  for (int r = 0; r < 16; r++) {
+    table->rows[r].pitchOffset = r & 3;
+  }
+  setTableFX(table, 3, 0, fxHOP, 0x00);
+  setTableFX(table, 1, 1, fxNOI, 0x01);
+  setTableFX(table, 2, 1, fxHOP, 0x31);
+
+  benchProjectSetPhraseFX(p, 0, fxTBX, 0x01);
+}
+
+static void setupArp(Project* p) {
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    if (phraseIsEmpty(p, c)) continue;
+    for (int r = 0; r < 16; r++) {
+      p->phrases[c].rows[r].fx[0][0] = fxARP;
+      p->phrases[c].rows[r].fx[0][1] = 0x47;
+      // Cycle through all arpeggio types
+      p->phrases[c].rows[r].fx[1][0] = fxARC;
+      p->phrases[c].rows[r].fx[1][1] = ((r % arpTypeMax) << 4) | 1;
+    }
+  }
+}
+
+static void setupSlides(Project* p) {
+  benchProjectSetPhraseFX(p, 0, fxPSL, 0x06);
+  benchProjectSetPhraseFX(p, 1, fxPBN, 0x20);
+  benchProjectSetPhraseFX(p, 2, fxPVB, 0x24);
+}
+
+static void setupRetrig(Project* p) {
+  benchProjectSetPhraseFX(p, 0, fxRET, 0x91);
+  benchProjectSetPhraseFX(p, 1, fxVOL, 0xFF);
+}
+
+static const BenchScenario scenarios[] = {
+  {"baseline", 1, setupBaseline},
+  {"dense_fx", 1, setupDenseFX},
+  {"table_hops", 1, setupTableHops},
+  {"arp", 1, setupArp},
+  {"psl_pbn", 1, setupSlides},
+  {"retrig", 1, setupRetrig},
+  {"baseline", 3, setupBaseline},
+  {"dense_fx", 3, setupDenseFX},
+  {"table_hops", 3, setupTableHops},
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Measurement
+//
+
+static double measure(Project* project) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return -1;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, 44100, createChipNull);
+  playbackStartSong(&state->playbackState, 0, 0, 1);
+
+  for (int c = 0; c < BENCH_WARMUP_FRAMES; c++) {
+    if (playbackNextFrame(&state->playbackState, state->chips)) {
+      playbackStartSong(&state->playbackState, 0, 0, 1);
+    }
+  }
+
+  double best = -1;
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    double start = benchNow();
+    for (int c = 0; c < framesPerRun; c++) {
+      if (playbackNextFrame(&state->playbackState, state->chips)) {
+        playbackStartSong(&state->playbackState, 0, 0, 1);
+      }
+    }
+    double ns = (benchNow() - start) / framesPerRun;
+    if (best < 0 || ns < best) best = ns;
+  }
+
+  chipnomadDestroy(state);
+  return best;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      framesPerRun = atoi(argv[++c]);
+      if (framesPerRun < 1) framesPerRun = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+
+  const int scenariosCount = sizeof(scenarios) / sizeof(scenarios[0]);
+  const int fxTotal = fxCommonCount + fxAYCount;
+  BenchResult* results = calloc(scenariosCount + filesCount, sizeof(BenchResult));
+  BenchResult* fxResults = calloc(fxTotal, sizeof(BenchResult));
+  int resultsCount = 0;
+  double baseline = 0;
+
+  // Synthetic scenarios
+  for (int c = 0; c < scenariosCount; c++) {
+    benchProjectInit(project, scenarios[c].chipsCount);
+    benchProjectFillSong(project);
+    scenarios[c].setup(project);
+
+    BenchResult* r = &results[resultsCount++];
+    snprintf(r->name, sizeof(r->name), "%s", scenarios[c].name);
+    r->chipsCount = scenarios[c].chipsCount;
+    r->nsPerFrame = measure(project);
+    if (c == 0) baseline = r->nsPerFrame;
+  }
+
+  // Real projects
+  for (int c = 0; c < filesCount; c++) {
+    if (projectLoad(project, files[c])) {
+      fprintf(stderr, "Can't load %s: %s\n", files[c], projectFileError);
+      continue;
+    }
+    BenchResult* r = &results[resultsCount++];
+    snprintf(r->name, sizeof(r->name), "%s", baseName(files[c]));
+    r->chipsCount = project->chipsCount;
+    r->nsPerFrame = measure(project);
+  }
+
+  // Per-FX cost: every phrase row of a single chip song has the FX in the first column
+  for (int c = 0; c < fxTotal; c++) {
+    FXName* fxName = (c < fxCommonCount) ? &fxNamesCommon[c] : &fxNamesAY[c - fxCommonCount];
+    benchProjectInit(project, 1);
+    benchProjectFillSong(project);
+    benchProjectSetPhraseFX(project, 0, fxName->fx, benchFXDefaultValue(fxName->fx));
+
+    snprintf(fxResults[c].name, sizeof(fxResults[c].name), "%s", fxName->name);
+    fxResults[c].chipsCount = 1;
+    fxResults[c].nsPerFrame = measure(project);
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"playback\",\n  \"framesPerRun\": %d,\n  \"runs\": %d,\n", framesPerRun, BENCH_RUNS);
+    printf("  \"scenarios\": [\n");
+    for (int c = 0; c < resultsCount; c++) {
+      printf("    {\"name\": \"%s\", \"chips\": %d, \"nsPerFrame\": %.2f}%s\n",
+        results[c].name, results[c].chipsCount, results[c].nsPerFrame, c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ],\n  \"fx\": [\n");
+    for (int c = 0; c < fxTotal; c++) {
+      printf("    {\"fx\": \"%s\", \"nsPerFrame\": %.2f, \"deltaNs\": %.2f}%s\n",
+        fxResults[c].name, fxResults[c].nsPerFrame, fxResults[c].nsPerFrame - baseline, c < fxTotal - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  } else {
+    printf("%-32s %5s %12s\n", "Scenario", "Chips", "ns/frame");
+    for (int c = 0; c < resultsCount; c++) {
+      printf("%-32s %5d %12.1f\n", results[c].name, results[c].chipsCount, results[c].nsPerFrame);
+    }
+    printf("\n%-32s %12s %12s\n", "FX (1 chip, every row)", "ns/frame", "vs baseline");
+    for (int c = 0; c < fxTotal; c++) {
+      printf("%-32s %12.1f %+12.1f\n", fxResults[c].name, fxResults[c].nsPerFrame, fxResults[c].nsPerFrame - baseline);
+    }
+  }
+
+  free(fxResults);
+  free(results);
+  free(project);
+  return 0;
+}
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "corelib/corelib_file.h"
+
+// Project file benchmark: saves every project as text (.cnm) and binary
+// (.cnb) to scratch files and loads them back. Reports file sizes, average
+// load and save times and the number of calls to the OS per load and save. A synthetic project with every song row,
+// chain, phrase, instrument and table filled is measured first, as the
+// largest project the format can hold.
+//
+// Usage: bench_project [-o scratch] [-n runs] [--json] [project.cnm ...]
+
+static const char* scratchPath = "bench_project";
+static int runs = 20;
+
+typedef struct ProjectResult {
+  char name[64];
+  long textBytes;
+  long binaryBytes;
+  double textLoadMs;
+  double textSaveMs;
+  double binaryLoadMs;
+  double binarySaveMs;
+  long textLoadCalls;
+  long textSaveCalls;
+  long binaryLoadCalls;
+  long binarySaveCalls;
+} ProjectResult;
+
+static long fileSize(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+// Every entity filled with valid values
+static void fillLargeProject(Project* p) {
+  benchProjectInit(p, PROJECT_MAX_CHIPS);
+  strcpy(p->title, "Large project");
+
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
+    for (int t = 0; t < p->tracksCount; t++) {
+      p->song[c][t] = (c * p->tracksCount + t) % PROJECT_MAX_CHAINS;
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    for (int r = 0; r < 16; r++) {
+      p->chains[c].rows[r].phrase = (c * 16 + r) % PROJECT_MAX_PHRASES;
+      p->chains[c].rows[r].transpose = r;
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    for (int r = 0; r < 16; r++) {
+      PhraseRow* row = &p->phrases[c].rows[r];
+      row->note = 36 + ((r * 7 + c * 3) % 24);
+      row->instrument = c % PROJECT_MAX_INSTRUMENTS;
+      row->volume = r % 16;
+      row->fx[0][0] = fxVOL;
+      row->fx[0][1] = benchFXDefaultValue(fxVOL);
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_GROOVES; c++) {
+    p->grooves[c].speed[0] = 3 + c % 4;
+    p->grooves[c].speed[1] = 3 + c % 5;
+  }
+
+  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
+    Instrument* instrument = &p->instruments[c];
+    instrument->type = instAY;
+    sprintf(instrument->name, "Instrument %d", c);
+    instrument->tableSpeed = 1 + c % 4;
+    instrument->chip.ay.veA = c % 16;
+    instrument->chip.ay.veD = 8;
+    instrument->chip.ay.veS = 10;
+    instrument->chip.ay.veR = 4;
+  }
+
+  for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
+    for (int r = 0; r < 16; r++) {
+      TableRow* row = &p->tables[c].rows[r];
+      row->pitchFlag = r & 1;
+      row->pitchOffset = r * 3;
+      row->volume = 15 - r % 16;
+      row->fx[0][0] = fxVOL;
+      row->fx[0][1] = benchFXDefaultValue(fxVOL);
+    }
+  }
+}
+
+// Average calls to the OS per run since the stats were reset
+static long callsPerRun(void) {
+  FileStats stats;
+  fileGetStats(&stats);
+  return (stats.opens + stats.reads + stats.writes + stats.seeks + stats.maps) / runs;
+}
+
+// Average time in ms of saving the project, or -1 on failure
+static double measureSave(Project* project, const char* path, int isBinary, long* calls) {
+  fileResetStats();
+  double start = benchNow();
+  for (int c = 0; c < runs; c++) {
+    if (isBinary ? projectSaveBinary(project, path) : projectSave(project, path)) return -1;
+  }
+  double time = (benchNow() - start) / 1e6 / runs;
+  *calls = callsPerRun();
+  return time;
+}
+
+// Average time in ms of loading the file, or -1 on failure
+static double measureLoad(Project* project, const char* path, long* calls) {
+  fileResetStats();
+  double start = benchNow();
+  for (int c = 0; c < runs; c++) {
+    if (projectLoad(project, path)) return -1;
+  }
+  double time = (benchNow() - start) / 1e6 / runs;
+  *calls = callsPerRun();
+  return time;
+}
+
+static int measureProject(Project* project, ProjectResult* result) {
+  char textPath[1024];
+  char binaryPath[1024];
+  snprintf(textPath, sizeof(textPath), "%s.cnm", scratchPath);
+  snprintf(binaryPath, sizeof(binaryPath), "%s.cnb", scratchPath);
+
+  result->textSaveMs = measureSave(project, textPath, 0, &result->textSaveCalls);
+  result->binarySaveMs = measureSave(project, binaryPath, 1, &result->binarySaveCalls);
+  result->textBytes = fileSize(textPath);
+  result->binaryBytes = fileSize(binaryPath);
+
+  Project* loaded = malloc(sizeof(Project));
+  result->textLoadMs = loaded ? measureLoad(loaded, textPath, &result->textLoadCalls) : -1;
+  result->binaryLoadMs = loaded ? measureLoad(loaded, binaryPath, &result->binaryLoadCalls) : -1;
+  free(loaded);
+  fileDelete(textPath);
+  fileDelete(binaryPath);
+
+  return result->textSaveMs < 0 || result->binarySaveMs < 0 || result->textLoadMs < 0 || result->binaryLoadMs < 0 ||
+    result->textBytes <= 0 || result->binaryBytes <= 0;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      runs = atoi(argv[++c]);
+      if (runs < 1) runs = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  ProjectResult* results = calloc(filesCount + 1, sizeof(ProjectResult));
+  if (!project || !results) return 1;
+  int resultsCount = 0;
+
+  // Synthetic project first, then the files
+  for (int f = -1; f < filesCount; f++) {
+    ProjectResult* result = &results[resultsCount];
+    if (f < 0) {
+      fillLargeProject(project);
+      snprintf(result->name, sizeof(result->name), "large (synthetic)");
+    } else {
+      if (projectLoad(project, files[f])) {
+        fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+        continue;
+      }
+      snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+    }
+
+    if (measureProject(project, result)) {
+      fprintf(stderr, "Can't save and load %s at %s: %s\n", result->name, scratchPath, projectFileError);
+      continue;
+    }
+    resultsCount++;
+
+    if (!json) {
+      if (resultsCount == 1) {
+        printf("%-24s %10s %10s %9s %9s %9s %9s %8s %9s %9s\n",
+          "Project", "CNM bytes", "CNB bytes", "CNM load", "CNB load", "CNM save", "CNB save", "Load x",
+          "CNM I/O", "CNB I/O");
+      }
+      printf("%-24s %10ld %10ld %8.3fms %8.3fms %8.3fms %8.3fms %7.1fx %4ld/%-4ld %4ld/%-4ld\n",
+        result->name, result->textBytes, result->binaryBytes, result->textLoadMs, result->binaryLoadMs,
+        result->textSaveMs, result->binarySaveMs, result->textLoadMs / result->binaryLoadMs,
+        result->textLoadCalls, result->textSaveCalls, result->binaryLoadCalls, result->binarySaveCalls);
+      fflush(stdout);
+    }
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"project\",\n  \"runs\": %d,\n  \"results\": [\n", runs);
+    for (int c = 0; c < resultsCount; c++) {
+      ProjectResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"textBytes\": %ld, \"binaryBytes\": %ld, \"textLoadMs\": %.3f, "
+        "\"binaryLoadMs\": %.3f, \"textSaveMs\": %.3f, \"binarySaveMs\": %.3f, \"textLoadCalls\": %ld, "
+        "\"textSaveCalls\": %ld, \"binaryLoadCalls\": %ld, \"binarySaveCalls\": %ld}%s\n",
+        r->name, r->textBytes, r->binaryBytes, r->textLoadMs, r->binaryLoadMs, r->textSaveMs, r->binarySaveMs,
+        r->textLoadCalls, r->textSaveCalls, r->binaryLoadCalls, r->binarySaveCalls, c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(results);
+  free(project);
+  return 0;
+}
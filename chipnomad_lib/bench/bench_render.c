@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+
+// End-to-end render benchmark: runs chipnomadRender for every combination
+// of quality level, chip count and sample rate over a set of projects.
+// Reports samples/sec, realtime multiple and the time split between
+// sequencer, chip synthesis and mixing.
+//
+// Usage: bench_render [-s seconds] [--json] project.cnm ...
+
+#define RENDER_CHUNK (1024)
+
+static int secondsPerRun = 10;
+
+static const int sampleRates[] = {44100, 48000, 96000};
+static const int chipCounts[] = {1, 2, 3};
+static const char* qualityNames[] = {"low", "medium", "high", "best"};
+
+typedef struct RenderResult {
+  char name[64];
+  const char* quality;
+  int chipsCount;
+  int sampleRate;
+  double samplesPerSec;
+  double realtime;
+  double sequencerMs;
+  double synthesisMs;
+  double mixMs;
+} RenderResult;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Timing chip: wraps the default AY chip and measures time spent in render
+//
+
+typedef struct TimedChipData {
+  SoundChip chip;
+  double renderNs;
+} TimedChipData;
+
+static int timedChipInit(SoundChip* self) {
+  TimedChipData* data = self->userdata;
+  return data->chip.init ? data->chip.init(&data->chip) : 0;
+}
+
+static void timedChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  TimedChipData* data = self->userdata;
+  self->regs[reg & 0xff] = value;
+  data->chip.setRegister(&data->chip, reg, value);
+}
+
+static void timedChipRender(SoundChip* self, float* buffer, int samples) {
+  TimedChipData* data = self->userdata;
+  double start = benchNow();
+  data->chip.render(&data->chip, buffer, samples);
+  data->renderNs += benchNow() - start;
+}
+
+static void timedChipSetQuality(SoundChip* self, int quality) {
+  TimedChipData* data = self->userdata;
+  data->chip.setQuality(&data->chip, quality);
+}
+
+static int timedChipCleanup(SoundChip* self) {
+  TimedChipData* data = self->userdata;
+  data->chip.cleanup(&data->chip);
+  free(data);
+  return 0;
+}
+
+static SoundChip timedChipFactory(int chipIndex, int sampleRate, ChipSetup setup) {
+  TimedChipData* data = calloc(1, sizeof(TimedChipData));
+  data->chip = createChipAY(sampleRate, setup);
+
+  SoundChip chip = {
+    .userdata = data,
+    .init = timedChipInit,
+    .setRegister = timedChipSetRegister,
+    .render = timedChipRender,
+    .setQuality = timedChipSetQuality,
+    .cleanup = timedChipCleanup,
+  };
+
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+
+  return chip;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Measurement
+//
+
+static void setChipsCount(Project* p, int chipsCount) {
+  p->chipsCount = chipsCount;
+  p->tracksCount = projectGetTotalTracks(p);
+}
+
+// Sequencer alone, for the same number of frames as the render run
+static double measureSequencer(Project* project, int frames) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return 0;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, 44100, createChipNull);
+  playbackStartSong(&state->playbackState, 0, 0, 1);
+
+  double start = benchNow();
+  for (int c = 0; c < frames; c++) {
+    if (playbackNextFrame(&state->playbackState, state->chips)) {
+      playbackStartSong(&state->playbackState, 0, 0, 1);
+    }
+  }
+  double ns = benchNow() - start;
+
+  chipnomadDestroy(state);
+  return ns;
+}
+
+static int measureRender(Project* project, int quality, int sampleRate, RenderResult* result) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return 1;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, sampleRate, timedChipFactory);
+  chipnomadSetQuality(state, quality);
+  playbackStartSong(&state->playbackState, 0, 0, 1);
+
+  float* buffer = malloc(RENDER_CHUNK * 2 * sizeof(float));
+  long totalSamples = (long)sampleRate * secondsPerRun;
+  long rendered = 0;
+
+  // Warm up caches and the chip's filters before measuring
+  for (int c = 0; c < sampleRate / 2; c += RENDER_CHUNK) {
+    chipnomadRender(state, buffer, RENDER_CHUNK);
+  }
+  playbackStartSong(&state->playbackState, 0, 0, 1);
+  for (int c = 0; c < state->project.chipsCount; c++) {
+    ((TimedChipData*)state->chips[c].userdata)->renderNs = 0;
+  }
+
+  double start = benchNow();
+  while (rendered < totalSamples) {
+    int samples = (totalSamples - rendered < RENDER_CHUNK) ? (int)(totalSamples - rendered) : RENDER_CHUNK;
+    if (chipnomadRender(state, buffer, samples) < samples) {
+      // Song doesn't loop, start it over
+      playbackStartSong(&state->playbackState, 0, 0, 1);
+    }
+    rendered += samples;
+  }
+  double totalNs = benchNow() - start;
+
+  double synthesisNs = 0;
+  for (int c = 0; c < state->project.chipsCount; c++) {
+    synthesisNs += ((TimedChipData*)state->chips[c].userdata)->renderNs;
+  }
+
+  int frames = (int)(secondsPerRun * project->tickRate);
+  double sequencerNs = measureSequencer(project, frames);
+  double mixNs = totalNs - synthesisNs - sequencerNs;
+  if (mixNs < 0) mixNs = 0;
+
+  result->quality = qualityNames[quality];
+  result->chipsCount = project->chipsCount;
+  result->sampleRate = sampleRate;
+  result->samplesPerSec = rendered / (totalNs / 1e9);
+  result->realtime = result->samplesPerSec / sampleRate;
+  result->sequencerMs = sequencerNs / 1e6;
+  result->synthesisMs = synthesisNs / 1e6;
+  result->mixMs = mixNs / 1e6;
+
+  free(buffer);
+  chipnomadDestroy(state);
+  return 0;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-s") && c + 1 < argc) {
+      secondsPerRun = atoi(argv[++c]);
+      if (secondsPerRun < 1) secondsPerRun = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-s seconds] [--json] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+
+  const int ratesCount = sizeof(sampleRates) / sizeof(sampleRates[0]);
+  const int chipCountsCount = sizeof(chipCounts) / sizeof(chipCounts[0]);
+  const int qualitiesCount = CHIPNOMAD_QUALITY_BEST + 1;
+  int maxResults = filesCount * ratesCount * chipCountsCount * qualitiesCount;
+  RenderResult* results = calloc(maxResults, sizeof(RenderResult));
+  int resultsCount = 0;
+
+  for (int f = 0; f < filesCount; f++) {
+    for (int q = 0; q < qualitiesCount; q++) {
+      for (int c = 0; c < chipCountsCount; c++) {
+        for (int r = 0; r < ratesCount; r++) {
+          if (projectLoad(project, files[f])) {
+            fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+            break;
+          }
+          // Extra chips play empty tracks, missing ones drop their tracks
+          setChipsCount(project, chipCounts[c]);
+
+          RenderResult* result = &results[resultsCount];
+          snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+          if (measureRender(project, q, sampleRates[r], result)) continue;
+          resultsCount++;
+
+          if (!json) {
+            if (resultsCount == 1) {
+              printf("%-24s %-7s %5s %6s %12s %9s %10s %10s %10s\n",
+                "Project", "Quality", "Chips", "Rate", "Samples/s", "Realtime", "Seq ms", "Synth ms", "Mix ms");
+            }
+            printf("%-24s %-7s %5d %6d %12.0f %8.1fx %10.2f %10.2f %10.2f\n",
+              result->name, result->quality, result->chipsCount, result->sampleRate,
+              result->samplesPerSec, result->realtime, result->sequencerMs, result->synthesisMs, result->mixMs);
+            fflush(stdout);
+          }
+        }
+      }
+    }
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"render\",\n  \"secondsPerRun\": %d,\n  \"results\": [\n", secondsPerRun);
+    for (int c = 0; c < resultsCount; c++) {
+      RenderResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"quality\": \"%s\", \"chips\": %d, \"sampleRate\": %d, "
+        "\"samplesPerSec\": %.0f, \"realtime\": %.2f, \"sequencerMs\": %.2f, \"synthesisMs\": %.2f, \"mixMs\": %.2f}%s\n",
+        r->name, r->quality, r->chipsCount, r->sampleRate, r->samplesPerSec, r->realtime,
+        r->sequencerMs, r->synthesisMs, r->mixMs, c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(results);
+  free(project);
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "corelib/corelib_thread.h"
+
+// Synthesis benchmark: captures each project's register stream once, then
+// replays it for every quality level and sample rate. Replay has no
+// sequencer cost and writes the same registers on every run, so the numbers
+// only depend on chip synthesis and mixing. With -j the same stream is
+// replayed on several threads at once.
+//
+// Usage: bench_replay [-s seconds] [-j threads] [--json] project.cnm ...
+
+static int secondsPerRun = 60;
+static int threadsCount = 1;
+
+static const int sampleRates[] = {44100, 48000, 96000};
+static const char* qualityNames[] = {"low", "medium", "high", "best"};
+
+typedef struct ReplayResult {
+  char name[64];
+  const char* quality;
+  int sampleRate;
+  int frames;
+  int writes;
+  double captureMs;
+  double samplesPerSec;
+  double realtime;
+} ReplayResult;
+
+typedef struct ReplayJob {
+  const RegisterStream* stream;
+  int quality;
+  int sampleRate;
+  long rendered;
+} ReplayJob;
+
+static int replayWorker(void* arg) {
+  ReplayJob* job = arg;
+  job->rendered = 0;
+
+  ChipNomadState* state = chipnomadCreate();
+  // A second per call, so the render comes back short once playback stops
+  float* buffer = malloc(job->sampleRate * 2 * sizeof(float));
+  if (state && buffer) {
+    chipnomadStartReplay(state, job->stream, job->sampleRate, NULL, 0xffffffff);
+    chipnomadSetQuality(state, job->quality);
+
+    int samples;
+    do {
+      samples = chipnomadRender(state, buffer, job->sampleRate);
+      job->rendered += samples;
+    } while (samples == job->sampleRate);
+  }
+
+  free(buffer);
+  chipnomadDestroy(state);
+  return 0;
+}
+
+static void measureReplay(const RegisterStream* stream, int quality, int sampleRate, ReplayResult* result) {
+  ReplayJob jobs[CORELIB_MAX_THREADS];
+  int threadIds[CORELIB_MAX_THREADS];
+
+  double start = benchNow();
+  for (int c = 0; c < threadsCount; c++) {
+    jobs[c].stream = stream;
+    jobs[c].quality = quality;
+    jobs[c].sampleRate = sampleRate;
+    threadIds[c] = threadsCount > 1 ? threadStart(replayWorker, &jobs[c]) : -1;
+    if (threadIds[c] == -1) replayWorker(&jobs[c]);
+  }
+
+  long rendered = 0;
+  for (int c = 0; c < threadsCount; c++) {
+    if (threadIds[c] != -1) threadJoin(threadIds[c]);
+    rendered += jobs[c].rendered;
+  }
+  double totalNs = benchNow() - start;
+
+  result->quality = qualityNames[quality];
+  result->sampleRate = sampleRate;
+  result->samplesPerSec = rendered / (totalNs / 1e9);
+  result->realtime = result->samplesPerSec / sampleRate;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-s") && c + 1 < argc) {
+      secondsPerRun = atoi(argv[++c]);
+      if (secondsPerRun < 1) secondsPerRun = 1;
+    } else if (!strcmp(argv[c], "-j") && c + 1 < argc) {
+      threadsCount = atoi(argv[++c]);
+      if (threadsCount < 1) threadsCount = 1;
+      if (threadsCount > CORELIB_MAX_THREADS) threadsCount = CORELIB_MAX_THREADS;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-s seconds] [-j threads] [--json] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+
+  const int ratesCount = sizeof(sampleRates) / sizeof(sampleRates[0]);
+  const int qualitiesCount = CHIPNOMAD_QUALITY_BEST + 1;
+  int maxResults = filesCount * ratesCount * qualitiesCount;
+  ReplayResult* results = calloc(maxResults, sizeof(ReplayResult));
+  int resultsCount = 0;
+
+  for (int f = 0; f < filesCount; f++) {
+    if (projectLoad(project, files[f])) {
+      fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+      continue;
+    }
+
+    double start = benchNow();
+    RegisterStream* stream = registerStreamCapture(project, 0, secondsPerRun);
+    double captureMs = (benchNow() - start) / 1e6;
+    if (!stream) {
+      fprintf(stderr, "Can't capture %s\n", files[f]);
+      continue;
+    }
+
+    for (int q = 0; q < qualitiesCount; q++) {
+      for (int r = 0; r < ratesCount; r++) {
+        ReplayResult* result = &results[resultsCount++];
+        snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+        result->frames = stream->framesCount;
+        result->writes = stream->writesCount;
+        result->captureMs = captureMs;
+        measureReplay(stream, q, sampleRates[r], result);
+
+        if (!json) {
+          if (resultsCount == 1) {
+            printf("%-24s %7s %8s %10s %-7s %6s %12s %9s\n",
+              "Project", "Frames", "Writes", "Capture ms", "Quality", "Rate", "Samples/s", "Realtime");
+          }
+          printf("%-24s %7d %8d %10.2f %-7s %6d %12.0f %8.1fx\n",
+            result->name, result->frames, result->writes, result->captureMs, result->quality,
+            result->sampleRate, result->samplesPerSec, result->realtime);
+          fflush(stdout);
+        }
+      }
+    }
+
+    registerStreamFree(stream);
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"replay\",\n  \"secondsPerRun\": %d,\n  \"threads\": %d,\n  \"results\": [\n",
+      secondsPerRun, threadsCount);
+    for (int c = 0; c < resultsCount; c++) {
+      ReplayResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"frames\": %d, \"writes\": %d, \"captureMs\": %.2f, \"quality\": \"%s\", "
+        "\"sampleRate\": %d, \"samplesPerSec\": %.0f, \"realtime\": %.2f}%s\n",
+        r->name, r->frames, r->writes, r->captureMs, r->quality, r->sampleRate, r->samplesPerSec, r->realtime,
+        c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(results);
+  free(project);
+  return 0;
+}
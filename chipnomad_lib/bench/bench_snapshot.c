@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+
+// Project snapshot benchmark: compares a full copy of the Project struct with
+// taking a snapshot, both from scratch and based on the previous snapshot
+// after editing one phrase row, like autosave does every second. Then keeps a
+// history of snapshots with one edit between each and reports the memory they
+// take against the same number of full copies.
+//
+// Usage: bench_snapshot [-n runs] [--json] [project.cnm ...]
+
+static int runs = 1000;
+#define HISTORY_LENGTH (60)
+
+// Kept until the next copy, so the copies aren't optimized away
+static Project* lastCopy = NULL;
+
+typedef struct SnapshotResult {
+  char name[64];
+  double copyUs;
+  double takeUs;
+  double editUs;
+  double pagesPerEdit;
+  long historyBytes;
+  long copiesBytes;
+} SnapshotResult;
+
+// One phrase row edit, somewhere else each step
+static void edit(Project* p, int step) {
+  PhraseRow* row = &p->phrases[(step * 37) % PROJECT_MAX_PHRASES].rows[step % 16];
+  row->volume = (row->volume + 1) & 15;
+}
+
+static void measureProject(Project* project, SnapshotResult* result) {
+  // A job's own copy, like exporters and background saves make
+  double start = benchNow();
+  for (int c = 0; c < runs; c++) {
+    edit(project, c);
+    free(lastCopy);
+    lastCopy = malloc(sizeof(Project));
+    memcpy(lastCopy, project, sizeof(Project));
+  }
+  result->copyUs = (benchNow() - start) / runs / 1000.0;
+
+  start = benchNow();
+  for (int c = 0; c < runs; c++) {
+    edit(project, c);
+    projectSnapshotFree(projectSnapshotTake(project, NULL));
+  }
+  result->takeUs = (benchNow() - start) / runs / 1000.0;
+
+  ProjectSnapshot* base = projectSnapshotTake(project, NULL);
+  long pagesCopied = 0;
+  start = benchNow();
+  for (int c = 0; c < runs; c++) {
+    edit(project, c);
+    ProjectSnapshot* snapshot = projectSnapshotTake(project, base);
+    pagesCopied += snapshot->pagesCopied;
+    projectSnapshotFree(base);
+    base = snapshot;
+  }
+  result->editUs = (benchNow() - start) / runs / 1000.0;
+  result->pagesPerEdit = (double)pagesCopied / runs;
+  projectSnapshotFree(base);
+
+  ProjectSnapshot* history[HISTORY_LENGTH];
+  for (int c = 0; c < HISTORY_LENGTH; c++) {
+    edit(project, c);
+    history[c] = projectSnapshotTake(project, c > 0 ? history[c - 1] : NULL);
+  }
+  ProjectSnapshotStats stats;
+  projectSnapshotGetStats(history, HISTORY_LENGTH, &stats);
+  result->historyBytes = stats.bytesAllocated;
+  result->copiesBytes = stats.bytesUsed;
+  for (int c = 0; c < HISTORY_LENGTH; c++) projectSnapshotFree(history[c]);
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      runs = atoi(argv[++c]);
+      if (runs < 1) runs = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  SnapshotResult* results = calloc(filesCount + 1, sizeof(SnapshotResult));
+  if (!project || !results) return 1;
+  int resultsCount = 0;
+
+  // Synthetic song first, then the files
+  for (int f = -1; f < filesCount; f++) {
+    SnapshotResult* result = &results[resultsCount];
+    if (f < 0) {
+      benchProjectInit(project, 1);
+      benchProjectFillSong(project);
+      snprintf(result->name, sizeof(result->name), "song (synthetic)");
+    } else {
+      if (projectLoad(project, files[f])) {
+        fprintf(stderr, "Can't load %s: %s\n", files[f], projectFileError);
+        continue;
+      }
+      snprintf(result->name, sizeof(result->name), "%s", baseName(files[f]));
+    }
+
+    measureProject(project, result);
+    resultsCount++;
+
+    if (!json) {
+      if (resultsCount == 1) {
+        printf("%-24s %9s %9s %9s %7s %12s %12s %6s\n",
+          "Project", "Copy", "Snapshot", "Edit", "Pages", "60 copies", "60 snaps", "Saved");
+      }
+      printf("%-24s %7.2fus %7.2fus %7.2fus %7.2f %12ld %12ld %5.1f%%\n",
+        result->name, result->copyUs, result->takeUs, result->editUs, result->pagesPerEdit,
+        result->copiesBytes, result->historyBytes, 100.0 - result->historyBytes * 100.0 / result->copiesBytes);
+      fflush(stdout);
+    }
+  }
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"snapshot\",\n  \"runs\": %d,\n  \"pageSize\": %d,\n  \"pagesCount\": %d,\n"
+      "  \"results\": [\n", runs, PROJECT_SNAPSHOT_PAGE_SIZE, PROJECT_SNAPSHOT_PAGES_COUNT);
+    for (int c = 0; c < resultsCount; c++) {
+      SnapshotResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"copyUs\": %.3f, \"takeUs\": %.3f, \"editUs\": %.3f, \"pagesPerEdit\": %.2f, "
+        "\"historyBytes\": %ld, \"copiesBytes\": %ld}%s\n",
+        r->name, r->copyUs, r->takeUs, r->editUs, r->pagesPerEdit, r->historyBytes, r->copiesBytes,
+        c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(lastCopy);
+  free(results);
+  free(project);
+  return 0;
+}
@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "corelib/corelib_file.h"
+
+// Text project load benchmark: loads each project with the .cnm parser as it
+// was before the hand-rolled one (sscanf for every value, linear note and FX
+// searches, kept below as it was) and with projectLoad, and checks that both
+// give the same Project. Both read through the same file layer, so only the
+// parsers are compared. Reports the best and average time of each. A synthetic
+// project with every entity filled is measured before the given files.
+//
+// Usage: bench_text_load [-o scratch] [-n runs] [--json] [project.cnm ...]
+
+static const char* scratchPath = "bench_text_load";
+static int runs = 20;
+
+typedef struct LoadResult {
+  char name[64];
+  long bytes;
+  double legacyBestMs;
+  double legacyAverageMs;
+  double bestMs;
+  double averageMs;
+} LoadResult;
+
+///////////////////////////////////////////////////////////////////////////////
+// Parser before the hand-rolled one
+
+static char *lpstr;
+static char chipNames[][16] = { "AY8910" };
+
+// Convenience function to read a non-empty string
+static char* legacyReadString(int fileId) {
+  while (1) {
+    lpstr = fileReadString(fileId);
+    if (lpstr == NULL) {
+      sprintf(projectFileError, "Couldn't read string");
+      return NULL;
+    }
+    // Skip empty lines and lines with ```
+    if (strlen(lpstr) > 0 && strcmp(lpstr, "```")) break;
+  }
+  sprintf(projectFileError, "%s", lpstr);
+
+  return lpstr;
+}
+
+static uint8_t legacyScanByteOrEmpty(char* str) {
+  static char buf[3];
+  buf[0] = str[0];
+  buf[1] = str[1];
+  buf[2] = 0;
+  if (buf[0] == '-' && buf[1] == '-') {
+    return EMPTY_VALUE_8;
+  } else {
+    uint8_t result;
+    if (sscanf(buf, "%hhX", &result) != 1) return EMPTY_VALUE_8;
+    return result;
+  }
+}
+
+static uint8_t legacyScanNote(char* str, Project* p) {
+  // Silly linear search through pitch table. To replace with a simple hash
+  static char buf[4];
+  buf[0] = str[0];
+  buf[1] = str[1];
+  buf[2] = str[2];
+  buf[3] = 0;
+
+  if (!strcmp(buf, "---")) return EMPTY_VALUE_8;
+  if (!strcmp(buf, "OFF")) return NOTE_OFF;
+
+  for (int c = 0; c < p->pitchTable.length; c++) {
+    if (!strcmp(buf, p->pitchTable.noteNames[c])) return c;
+  }
+
+  return EMPTY_VALUE_8;
+}
+
+static uint8_t legacyScanFX(char* str, Project* p) {
+  // Silly linear search through the list of FX. To replace with a simple hash
+  static char buf[4];
+  buf[0] = str[0];
+  buf[1] = str[1];
+  buf[2] = str[2];
+  buf[3] = 0;
+
+  if (!strcmp(buf, "---")) return EMPTY_VALUE_8;
+
+  // Common FX
+  for (int c = 0; c < fxCommonCount; c++) {
+    if (!strcmp(buf, fxNamesCommon[c].name)) return fxNamesCommon[c].fx;
+  }
+
+  // AY FX
+  for (int c = 0; c < fxAYCount; c++) {
+    if (!strcmp(buf, fxNamesAY[c].name)) return fxNamesAY[c].fx;
+  }
+
+  return EMPTY_VALUE_8;
+}
+
+#define READ_STRING legacyReadString(fileId); if (lpstr == NULL) return 1;
+
+static int legacyProjectLoadPitchTable(int fileId, Project* p) {
+  char buf[128];
+
+  READ_STRING; if (strcmp(lpstr, "## Pitch table")) return 1;
+  READ_STRING; if (sscanf(lpstr, "- Title: %[^\n]", p->pitchTable.name) != 1) return 1;
+
+  int idx = 0;
+  int period;
+  while (1) {
+    READ_STRING;
+    if (sscanf(lpstr, "%s %d", buf, &period) != 2) break;
+    if (strlen(buf) != 3) return 1;
+    strcpy(p->pitchTable.noteNames[idx], buf);
+    p->pitchTable.values[idx] = period;
+    idx++;
+  }
+  p->pitchTable.length = idx;
+
+  // Detect octave size
+  char oct = p->pitchTable.noteNames[0][2];
+  for (int c = 0; c < p->pitchTable.length; c++) {
+    if (p->pitchTable.noteNames[c][2] != oct) {
+      p->pitchTable.octaveSize = c;
+      break;
+    }
+  }
+
+  return 0;
+}
+
+static int legacyProjectLoadSong(int fileId, Project* p) {
+  char buf[4];
+  if (strcmp(lpstr, "## Song")) return 1;
+
+  int idx = 0;
+  while (1) {
+    READ_STRING;
+    if (lpstr[0] == '#') break;
+    // Minimum length: 2 chars per cell, plus 1 separator for each cell (optional for last)
+    if (strlen(lpstr) < (p->tracksCount * 3 - 1)) return 1;
+    for (int c = 0; c < p->tracksCount; c++) {
+      buf[0] = lpstr[c * 3];
+      buf[1] = lpstr[c * 3 + 1];
+      buf[2] = 0;
+      if (buf[0] == '-' && buf[1] == '-') {
+        p->song[idx][c] = EMPTY_VALUE_16;
+      } else {
+        if (sscanf(buf, "%hX", &p->song[idx][c]) != 1) return 1;
+      }
+      // Check for highlight asterisk (after the 2 hex digits)
+      if ((int)strlen(lpstr) > c * 3 + 2 && lpstr[c * 3 + 2] == '*') {
+        p->songHighlight[idx][c] = 1;
+      } else {
+        p->songHighlight[idx][c] = 0;
+      }
+    }
+    idx++;
+  }
+
+  return 0;
+}
+
+static int legacyProjectLoadChains(int fileId, Project* p) {
+  int idx;
+
+  if (strcmp(lpstr, "## Chains")) return 1;
+
+  while (1) {
+    READ_STRING;
+    if (strncmp(lpstr, "### Chain", 9)) break;
+    if (sscanf(lpstr, "### Chain %X", &idx) != 1) return 1;
+
+    for (int c = 0; c < 16; c++) {
+      READ_STRING;
+      if (strlen(lpstr) != 6) return 1;
+
+      if (lpstr[0] == '-') {
+        p->chains[idx].rows[c].phrase = EMPTY_VALUE_16;
+        if (sscanf(lpstr + 4, "%hhX", &p->chains[idx].rows[c].transpose) != 1) return 1;
+      } else {
+        if (sscanf(lpstr, "%hX %hhX", &p->chains[idx].rows[c].phrase, &p->chains[idx].rows[c].transpose) != 2) return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int legacyProjectLoadGrooves(int fileId, Project* p) {
+  int idx;
+
+  if (strcmp(lpstr, "## Grooves")) return 1;
+
+  while (1) {
+    READ_STRING;
+    if (strncmp(lpstr, "### Groove", 10)) break;
+    if (sscanf(lpstr, "### Groove %X", &idx) != 1) return 1;
+
+    for (int c = 0; c < 16; c++) {
+      READ_STRING;
+      if (strlen(lpstr) != 2) return 1;
+      p->grooves[idx].speed[c] = legacyScanByteOrEmpty(lpstr);
+    }
+  }
+
+  return 0;
+}
+
+static int legacyProjectLoadPhrases(int fileId, Project* p) {
+  int idx;
+
+  if (strcmp(lpstr, "## Phrases")) return 1;
+
+  while (1) {
+    READ_STRING;
+    if (strncmp(lpstr, "### Phrase", 10)) break;
+    if (sscanf(lpstr, "### Phrase %X", &idx) != 1) return 1;
+
+    for (int c = 0; c < 16; c++) {
+      READ_STRING;
+      if (strlen(lpstr) != 30) return 1;
+      // Note
+      p->phrases[idx].rows[c].note = legacyScanNote(lpstr, p);
+      // Instrument
+      p->phrases[idx].rows[c].instrument = legacyScanByteOrEmpty(lpstr + 4);
+      // Volume
+      p->phrases[idx].rows[c].volume = legacyScanByteOrEmpty(lpstr + 7);
+      // FX1
+      p->phrases[idx].rows[c].fx[0][0] = legacyScanFX(lpstr + 10, p);
+      p->phrases[idx].rows[c].fx[0][1] = legacyScanByteOrEmpty(lpstr + 14);
+      // FX2
+      p->phrases[idx].rows[c].fx[1][0] = legacyScanFX(lpstr + 17, p);
+      p->phrases[idx].rows[c].fx[1][1] = legacyScanByteOrEmpty(lpstr + 21);
+      // FX3
+      p->phrases[idx].rows[c].fx[2][0] = legacyScanFX(lpstr + 24, p);
+      p->phrases[idx].rows[c].fx[2][1] = legacyScanByteOrEmpty(lpstr + 28);
+    }
+  }
+
+  return 0;
+}
+
+static int legacyLoadInstrument(int fileId, Instrument* instrument, Project* p) {
+  instrumentClear(instrument);
+  
+  while (1) {
+    READ_STRING;
+    if (lpstr[0] == '#') return 0;
+    
+    if (strncmp(lpstr, "- Name: ", 8) == 0) {
+      sscanf(lpstr, "- Name: %[^\n]", instrument->name);
+    } else if (strncmp(lpstr, "- Type: ", 8) == 0) {
+      sscanf(lpstr, "- Type: %hhd", &instrument->type);
+    } else if (strncmp(lpstr, "- Table speed: ", 15) == 0) {
+      sscanf(lpstr, "- Table speed: %hhu", &instrument->tableSpeed);
+    } else if (strncmp(lpstr, "- Transpose: ", 13) == 0) {
+      sscanf(lpstr, "- Transpose: %hhu", &instrument->transposeEnabled);
+    } else if (strncmp(lpstr, "- Volume envelope: ", 19) == 0) {
+      sscanf(lpstr, "- Volume envelope: %hhu,%hhu,%hhu,%hhu",
+        &instrument->chip.ay.veA, &instrument->chip.ay.veD,
+        &instrument->chip.ay.veS, &instrument->chip.ay.veR);
+    } else if (strncmp(lpstr, "- Auto envelope: ", 17) == 0) {
+      sscanf(lpstr, "- Auto envelope: %hhu,%hhu",
+        &instrument->chip.ay.autoEnvN, &instrument->chip.ay.autoEnvD);
+    } else if (strncmp(lpstr, "- Default mixer: ", 17) == 0) {
+      sscanf(lpstr, "- Default mixer: %hhX", &instrument->chip.ay.defaultMixer);
+    }
+  }
+}
+
+static int legacyProjectLoadInstruments(int fileId, Project* p) {
+  int idx;
+
+  if (strcmp(lpstr, "## Instruments")) return 1;
+
+  READ_STRING;
+  while (strncmp(lpstr, "### Instrument", 14) == 0) {
+    if (sscanf(lpstr, "### Instrument %X", &idx) != 1) return 1;
+    if (legacyLoadInstrument(fileId, &p->instruments[idx], p)) return 1;
+  }
+
+  return 0;
+}
+
+static int legacyLoadTable(int fileId, Table* table, Project* p) {
+  for (int d = 0; d < 16; d++) {
+    READ_STRING;
+    if (strlen(lpstr) < 35) return 1;  // Minimum length check
+
+    // Read pitch flag (single char)
+    table->rows[d].pitchFlag = (lpstr[0] == '=') ? 1 : 0;
+
+    // Read pitch offset
+    table->rows[d].pitchOffset = legacyScanByteOrEmpty(lpstr + 2);
+
+    // Read volume
+    table->rows[d].volume = legacyScanByteOrEmpty(lpstr + 5);
+
+    // Read FX1
+    table->rows[d].fx[0][0] = legacyScanFX(lpstr + 8, p);
+    table->rows[d].fx[0][1] = legacyScanByteOrEmpty(lpstr + 12);
+
+    // Read FX2
+    table->rows[d].fx[1][0] = legacyScanFX(lpstr + 15, p);
+    table->rows[d].fx[1][1] = legacyScanByteOrEmpty(lpstr + 19);
+
+    // Read FX3
+    table->rows[d].fx[2][0] = legacyScanFX(lpstr + 22, p);
+    table->rows[d].fx[2][1] = legacyScanByteOrEmpty(lpstr + 26);
+
+    // Read FX4
+    table->rows[d].fx[3][0] = legacyScanFX(lpstr + 29, p);
+    table->rows[d].fx[3][1] = legacyScanByteOrEmpty(lpstr + 33);
+  }
+  return 0;
+}
+
+static int legacyProjectLoadTables(int fileId, Project* p) {
+  int idx;
+
+  if (strcmp(lpstr, "## Tables")) return 1;
+
+  while (1) {
+    READ_STRING;
+    if (strncmp(lpstr, "### Table", 9)) break;
+    if (sscanf(lpstr, "### Table %X", &idx) != 1) return 1;
+    if (legacyLoadTable(fileId, &p->tables[idx], p)) return 1;
+  }
+
+  return 0;
+}
+
+static int legacyProjectLoadInternal(int fileId, Project* project) {
+  char buf[128];
+  Project p;
+
+  projectInit(&p);
+
+  sprintf(projectFileError, "Module header");
+  READ_STRING; if (strcmp(lpstr, "# ChipNomad Tracker Module 1.0")) return 1;
+  READ_STRING;
+  if (!strncmp(lpstr, "- Title:", 8)) {
+    if (sscanf(lpstr, "- Title: %[^\n]", p.title) != 1) {
+      p.title[0] = 0; // Empty title
+    }
+  } else {
+    return 1;
+  }
+  READ_STRING;
+  if (!strncmp(lpstr, "- Author:", 9)) {
+    if (sscanf(lpstr, "- Author: %[^\n]", p.author) != 1) {
+      p.author[0] = 0; // Empty author
+    }
+  }
+
+  READ_STRING; if (sscanf(lpstr, "- Frame rate: %f", &p.tickRate) != 1) return 1;
+  READ_STRING; if (sscanf(lpstr, "- Chips count: %d", &p.chipsCount) != 1) return 1;
+
+  // Try to read linear pitch (optional for backwards compatibility)
+  READ_STRING;
+  int tempLinearPitch;
+  if (sscanf(lpstr, "- Linear pitch: %d", &tempLinearPitch) == 1) {
+    p.linearPitch = (uint8_t)tempLinearPitch;
+    READ_STRING; // Read next line for chip type
+  }
+  // If linear pitch not found, lpstr already contains the chip type line
+  if (sscanf(lpstr, "- Chip type: %s", buf) != 1) return 1;
+
+  int found = 0;
+  for (int c = 0; c < chipTotalCount; c++) {
+    if (strcmp(buf, chipNames[c]) == 0) {
+      found = 1;
+      p.chipType = c;
+      break;
+    }
+  }
+  if (!found) return 1;
+
+  switch (p.chipType) {
+  case chipAY:
+    READ_STRING; if (sscanf(lpstr, "- *AY8910* Clock: %d", &p.chipSetup.ay.clock) != 1) return 1;
+    int tempIsYM;
+    READ_STRING; if (sscanf(lpstr, "- *AY8910* AY/YM: %d", &tempIsYM) != 1) return 1;
+    p.chipSetup.ay.isYM = (uint8_t)tempIsYM;
+    // TODO: Remove old pan logic for the first public release
+    READ_STRING;
+    if (strncmp(lpstr, "- *AY8910* PanA:", 15) == 0) {
+      // Old pan storage
+      READ_STRING; // Skip B
+      READ_STRING; // Skip C
+      // Default to ABC
+      p.chipSetup.ay.stereoMode = ayStereoABC;
+      p.chipSetup.ay.stereoSeparation = 50;
+    } else if (strncmp(lpstr, "- *AY8910* Stereo:", 18) == 0) {
+      // New pan storage
+      if (sscanf(lpstr, "- *AY8910* Stereo: %s", buf) != 1) return 1;
+      if (strcmp(buf, "ABC") == 0) {
+        p.chipSetup.ay.stereoMode = ayStereoABC;
+      } else if (strcmp(buf, "ACB") == 0) {
+        p.chipSetup.ay.stereoMode = ayStereoACB;
+      } else if (strcmp(buf, "BAC") == 0) {
+        p.chipSetup.ay.stereoMode = ayStereoBAC;
+      } else {
+        return 1;
+      }
+      READ_STRING; if (sscanf(lpstr, "- *AY8910* Stereo separation: %hhu", &p.chipSetup.ay.stereoSeparation) != 1) return 1;
+    } else {
+      // Error, pan information should be here
+      return 1;
+    }
+    break;
+  default:
+    break;
+  }
+
+  p.tracksCount = projectGetTotalTracks(&p);
+
+  sprintf(projectFileError, "Pitch table");
+
+  if (legacyProjectLoadPitchTable(fileId, &p)) return 1;
+  if (legacyProjectLoadSong(fileId, &p)) return 1;
+  if (legacyProjectLoadChains(fileId, &p)) return 1;
+  if (legacyProjectLoadGrooves(fileId, &p)) return 1;
+  if (legacyProjectLoadPhrases(fileId, &p)) return 1;
+  if (legacyProjectLoadInstruments(fileId, &p)) return 1;
+  if (legacyProjectLoadTables(fileId, &p)) return 1;
+
+  // Copy loaded project to the target project
+  memcpy(project, &p, sizeof(Project));
+
+  return 0;
+}
+
+static int legacyProjectLoad(Project* p, const char* path) {
+  projectFileError[0] = 0;
+
+  int fileId = fileOpen(path, 0);
+  if (fileId == -1) {
+    sprintf(projectFileError, "Can't open file");
+    return 1;
+  }
+
+  int result = legacyProjectLoadInternal(fileId, p);
+  fileClose(fileId);
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+typedef int LoadFunction(Project* p, const char* path);
+
+// Best and average time in ms of loading the file. Returns 1 on failure
+static int measureLoad(LoadFunction* load, Project* project, const char* path, double* bestMs, double* averageMs) {
+  double total = 0;
+  *bestMs = -1;
+  for (int c = 0; c < runs; c++) {
+    double start = benchNow();
+    if (load(project, path)) return 1;
+    double time = (benchNow() - start) / 1e6;
+    total += time;
+    if (*bestMs < 0 || time < *bestMs) *bestMs = time;
+  }
+  *averageMs = total / runs;
+  return 0;
+}
+
+static long fileSize(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+// Every song row, chain, phrase, instrument and table filled
+static void fillLargeProject(Project* p) {
+  benchProjectInit(p, PROJECT_MAX_CHIPS);
+  strcpy(p->title, "Large project");
+
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
+    for (int t = 0; t < p->tracksCount; t++) {
+      p->song[c][t] = (c * p->tracksCount + t) % PROJECT_MAX_CHAINS;
+    }
+  }
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    for (int r = 0; r < 16; r++) {
+      p->chains[c].rows[r].phrase = (c * 16 + r) % PROJECT_MAX_PHRASES;
+      p->chains[c].rows[r].transpose = r;
+    }
+  }
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    for (int r = 0; r < 16; r++) {
+      PhraseRow* row = &p->phrases[c].rows[r];
+      row->note = 36 + ((r * 7 + c * 3) % 24);
+      row->instrument = c % PROJECT_MAX_INSTRUMENTS;
+      row->volume = r % 16;
+      row->fx[0][0] = fxVOL;
+      row->fx[0][1] = benchFXDefaultValue(fxVOL);
+    }
+  }
+  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
+    Instrument* instrument = &p->instruments[c];
+    instrument->type = instAY;
+    sprintf(instrument->name, "Instrument %d", c);
+    instrument->tableSpeed = 1 + c % 4;
+  }
+  for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
+    for (int r = 0; r < 16; r++) {
+      TableRow* row = &p->tables[c].rows[r];
+      row->pitchOffset = r * 3;
+      row->volume = 15 - r % 16;
+      row->fx[0][0] = fxVOL;
+      row->fx[0][1] = benchFXDefaultValue(fxVOL);
+    }
+  }
+}
+
+// Returns an error message or NULL
+static const char* measureFile(const char* path, LoadResult* result) {
+  Project* legacy = malloc(sizeof(Project));
+  Project* loaded = malloc(sizeof(Project));
+  const char* error = NULL;
+  if (!legacy || !loaded) {
+    error = "out of memory";
+  } else if (measureLoad(legacyProjectLoad, legacy, path, &result->legacyBestMs, &result->legacyAverageMs)) {
+    error = "old parser can't load it";
+  } else if (measureLoad(projectLoad, loaded, path, &result->bestMs, &result->averageMs)) {
+    error = "can't load it";
+  } else if (memcmp(legacy, loaded, sizeof(Project))) {
+    error = "parsers differ";
+  }
+  result->bytes = fileSize(path);
+  free(legacy);
+  free(loaded);
+  return error;
+}
+
+static const char* baseName(const char* path) {
+  const char* name = strrchr(path, '/');
+  return name ? name + 1 : path;
+}
+
+int main(int argc, char* argv[]) {
+  int json = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--json")) {
+      json = 1;
+    } else if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (!strcmp(argv[c], "-n") && c + 1 < argc) {
+      runs = atoi(argv[++c]);
+      if (runs < 1) runs = 1;
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  char largePath[1024];
+  snprintf(largePath, sizeof(largePath), "%s.cnm", scratchPath);
+  Project* project = malloc(sizeof(Project));
+  LoadResult* results = calloc(filesCount + 1, sizeof(LoadResult));
+  if (!project || !results) return 1;
+  fillLargeProject(project);
+  int isLargeSaved = !projectSave(project, largePath);
+  free(project);
+  if (!isLargeSaved) fprintf(stderr, "Can't save the large project at %s: %s\n", largePath, projectFileError);
+
+  int resultsCount = 0;
+  // Synthetic project first, then the files
+  for (int f = isLargeSaved ? -1 : 0; f < filesCount; f++) {
+    LoadResult* result = &results[resultsCount];
+    const char* path = f < 0 ? largePath : files[f];
+    snprintf(result->name, sizeof(result->name), "%s", f < 0 ? "large (synthetic)" : baseName(path));
+
+    const char* error = measureFile(path, result);
+    if (error) {
+      fprintf(stderr, "%s: %s %s\n", result->name, error, projectFileError);
+      continue;
+    }
+    resultsCount++;
+
+    if (!json) {
+      if (resultsCount == 1) {
+        printf("%-24s %10s %10s %10s %10s %10s %8s\n",
+          "Project", "Bytes", "Old best", "Old avg", "New best", "New avg", "Speedup");
+      }
+      printf("%-24s %10ld %8.3fms %8.3fms %8.3fms %8.3fms %7.1fx\n",
+        result->name, result->bytes, result->legacyBestMs, result->legacyAverageMs, result->bestMs,
+        result->averageMs, result->legacyBestMs / result->bestMs);
+      fflush(stdout);
+    }
+  }
+  if (isLargeSaved) fileDelete(largePath);
+
+  if (json) {
+    printf("{\n  \"benchmark\": \"text_load\",\n  \"runs\": %d,\n  \"results\": [\n", runs);
+    for (int c = 0; c < resultsCount; c++) {
+      LoadResult* r = &results[c];
+      printf("    {\"project\": \"%s\", \"bytes\": %ld, \"legacyBestMs\": %.4f, \"legacyAverageMs\": %.4f, "
+        "\"bestMs\": %.4f, \"averageMs\": %.4f}%s\n",
+        r->name, r->bytes, r->legacyBestMs, r->legacyAverageMs, r->bestMs, r->averageMs,
+        c < resultsCount - 1 ? "," : "");
+    }
+    printf("  ]\n}\n");
+  }
+
+  free(results);
+  return 0;
+}
@@ -61,6 +61,7 @@ void chipnomadInitChips(ChipNomadState* state, int sampleRate, ChipFactory facto
   // Zero the entire chips array for safety
   memset(state->chips, 0, sizeof(state->chips));
   state->sampleRate = sampleRate;
+  state->chipFactory = factory;
 
   // Use provided factory or default
   ChipFactory chipFactory = factory ? factory : defaultChipFactory;
@@ -71,6 +72,22 @@ void chipnomadInitChips(ChipNomadState* state, int sampleRate, ChipFactory facto
   }
 }
 
+// Run playback for the next frame. Returns 1 if all tracks are stopped
+static int startFrame(ChipNomadState* state) {
+  state->frameSampleCounter += state->sampleRate / state->project.tickRate;
+  int allTracksStopped = state->replayStream ?
+    registerStreamApplyFrame(state->replayStream, state->replayFrame++, state->chips, state->replayTrackMask) :
+    playbackNextFrame(&state->playbackState, state->chips);
+  state->framesCount++;
+  // Decrease audio overload cooldown each frame
+  if (state->audioOverload > 0) {
+    state->audioOverload--;
+  }
+  // Detect AY pitch conflicts each frame
+  detectAYPitchConflicts(state);
+  return allTracksStopped;
+}
+
 int chipnomadRender(ChipNomadState* state, float* buffer, int samples) {
   if (!state) return 0;
 
@@ -79,14 +96,7 @@ int chipnomadRender(ChipNomadState* state, float* buffer, int samples) {
 
   while (samplesLeft > 0 && !allTracksStopped) {
     if ((int)state->frameSampleCounter == 0) {
-      state->frameSampleCounter += state->sampleRate / state->project.tickRate;
-      allTracksStopped = playbackNextFrame(&state->playbackState, state->chips);
-      // Decrease audio overload cooldown each frame
-      if (state->audioOverload > 0) {
-        state->audioOverload--;
-      }
-      // Detect AY pitch conflicts each frame
-      detectAYPitchConflicts(state);
+      allTracksStopped = startFrame(state);
     }
 
     int samplesToRender = ((int)state->frameSampleCounter < samplesLeft) ?
@@ -144,6 +154,90 @@ int chipnomadRender(ChipNomadState* state, float* buffer, int samples) {
   return samples - samplesLeft;
 }
 
+int chipnomadRenderChannels(ChipNomadState* state, float** buffers, int samples) {
+  if (!state) return 0;
+
+  int samplesLeft = samples;
+  int allTracksStopped = 0;
+
+  while (samplesLeft > 0 && !allTracksStopped) {
+    if ((int)state->frameSampleCounter == 0) {
+      allTracksStopped = startFrame(state);
+    }
+
+    int samplesToRender = ((int)state->frameSampleCounter < samplesLeft) ?
+    (int)state->frameSampleCounter : samplesLeft;
+    int bufferOffset = (samples - samplesLeft) * 2;
+
+    int trackIdx = 0;
+    for (int chipIdx = 0; chipIdx < state->project.chipsCount; chipIdx++) {
+      SoundChip* chip = &state->chips[chipIdx];
+      int chipTracks = projectGetChipTracks(&state->project, chipIdx);
+
+      float* chipBuffers[PROJECT_MAX_TRACKS];
+      for (int t = 0; t < chipTracks; t++) {
+        chipBuffers[t] = buffers[trackIdx + t] + bufferOffset;
+        memset(chipBuffers[t], 0, samplesToRender * 2 * sizeof(float));
+      }
+
+      if (chip->renderChannels) {
+        chip->renderChannels(chip, chipBuffers, samplesToRender);
+      } else if (chip->render) {
+        // Chip can't separate channels, the whole mix goes to its first track
+        chip->render(chip, chipBuffers[0], samplesToRender);
+      }
+
+      for (int t = 0; t < chipTracks; t++) {
+        for (int i = 0; i < samplesToRender * 2; i++) {
+          chipBuffers[t][i] *= state->mixVolume;
+        }
+      }
+      trackIdx += chipTracks;
+    }
+
+    samplesLeft -= samplesToRender;
+    state->frameSampleCounter -= (float)samplesToRender;
+  }
+
+  // Fill remaining buffers with silence if playback stopped early
+  if (samplesLeft > 0) {
+    int bufferOffset = (samples - samplesLeft) * 2;
+    for (int t = 0; t < state->project.tracksCount; t++) {
+      memset(buffers[t] + bufferOffset, 0, samplesLeft * 2 * sizeof(float));
+    }
+  }
+
+  return samples - samplesLeft;
+}
+
+int chipnomadSkip(ChipNomadState* state, int samples) {
+  if (!state) return 0;
+
+  int samplesLeft = samples;
+  int allTracksStopped = 0;
+
+  while (samplesLeft > 0 && !allTracksStopped) {
+    if ((int)state->frameSampleCounter == 0) {
+      allTracksStopped = startFrame(state);
+    }
+
+    int samplesToSkip = ((int)state->frameSampleCounter < samplesLeft) ?
+    (int)state->frameSampleCounter : samplesLeft;
+
+    for (int chipIdx = 0; chipIdx < state->project.chipsCount; chipIdx++) {
+      SoundChip* chip = &state->chips[chipIdx];
+      if (chip->skip) {
+        chip->skip(chip, samplesToSkip);
+      }
+    }
+
+    samplesLeft -= samplesToSkip;
+    state->frameSampleCounter -= (float)samplesToSkip;
+  }
+
+  return samples - samplesLeft;
+}
+
 static void detectAYPitchConflicts(ChipNomadState* state) {
   if (!state || state->project.chipType != chipAY) return;
 
@@ -195,4 +289,31 @@ void chipnomadSetQuality(ChipNomadState* state, chipnomad_quality_t quality) {
       state->chips[i].setQuality(&state->chips[i], quality);
     }
   }
-}
\ No newline at end of file
+}
+
+void chipnomadSetProject(ChipNomadState* state, const Project* project) {
+  if (!state || !project) return;
+
+  playbackStop(&state->playbackState);
+  memcpy(&state->project, project, sizeof(Project));
+  if (state->sampleRate > 0) chipnomadInitChips(state, state->sampleRate, state->chipFactory);
+}
+
+void chipnomadStartReplay(ChipNomadState* state, const RegisterStream* stream, int sampleRate, ChipFactory factory, uint32_t trackMask) {
+  if (!state || !stream) return;
+
+  // Only the chip configuration is used from the project while replaying
+  state->project.chipType = stream->chipType;
+  state->project.chipsCount = stream->chipsCount;
+  state->project.tracksCount = stream->tracksCount;
+  state->project.tickRate = stream->tickRate;
+  state->project.chipSetup = stream->chipSetup;
+
+  state->replayStream = stream;
+  state->replayFrame = 0;
+  state->replayTrackMask = trackMask;
+  state->frameSampleCounter = 0;
+  state->framesCount = 0;
+
+  chipnomadInitChips(state, sampleRate, factory);
+}
@@ -5,8 +5,17 @@
 // Include this file to access all ChipNomad library functionality
 
 #include "project.h"
+#include "project_slots.h"
+#include "project_snapshot.h"
+#include "project_journal.h"
+#include "project_io.h"
+#include "project_index.h"
+#include "directory_cache.h"
 #include "playback.h"
 #include "chips/chips.h"
+#include "register_stream.h"
+#include "register_dump.h"
+#include "loudness.h"
 #include "utils.h"
 
 #define AUDIO_OVERLOAD_COOLDOWN_FRAMES 20
@@ -37,11 +46,16 @@ typedef struct ChipNomadState {
   SoundChip chips[PROJECT_MAX_CHIPS];
   int sampleRate;
   float frameSampleCounter;
+  int framesCount; // Playback frames run since the state was created
   float mixVolume;
   int audioOverload;
   int trackWarnings[PROJECT_MAX_TRACKS];
   float* mixBuffer;
   int mixBufferSize;
+  const RegisterStream* replayStream; // Played instead of the project when set
+  int replayFrame;
+  uint32_t replayTrackMask;
+  ChipFactory chipFactory; // Factory the chips were made with, NULL for the default
 } ChipNomadState;
 
 /**
@@ -73,6 +87,25 @@ void chipnomadInitChips(ChipNomadState* state, int sampleRate, ChipFactory facto
 */
 int chipnomadRender(ChipNomadState* state, float* buffer, int samples);
 
+/**
+* Render every track into its own buffer in a single pass
+* Chips without per-channel rendering put their whole output into their first track
+* @param state ChipNomad state
+* @param buffers One interleaved stereo float buffer per track (project.tracksCount)
+* @param samples Number of stereo sample pairs to render
+* @return Number of samples actually rendered (may be less if playback stops)
+*/
+int chipnomadRenderChannels(ChipNomadState* state, float** buffers, int samples);
+
+/**
+* Advance playback and chip state as chipnomadRender would, without producing audio
+* Filter history isn't updated, so render a short pre-roll before using the output
+* @param state ChipNomad state
+* @param samples Number of stereo sample pairs to skip
+* @return Number of samples actually skipped (may be less if playback stops)
+*/
+int chipnomadSkip(ChipNomadState* state, int samples);
+
 /**
 * Set emulation quality for all chips
 * @param state ChipNomad state
@@ -80,6 +113,26 @@ int chipnomadRender(ChipNomadState* state, float* buffer, int samples);
 */
 void chipnomadSetQuality(ChipNomadState* state, chipnomad_quality_t quality);
 
+/**
+* Play a captured register stream instead of the project
+* Chips are set up from the stream's chip configuration, then render functions work as usual.
+* Any number of states can replay the same stream at the same time
+* @param state ChipNomad state
+* @param stream Captured stream, must stay valid while the state plays it
+* @param sampleRate Audio sample rate
+* @param factory Chip factory function, or NULL to use default implementations
+* @param trackMask Bit per track, tracks with a cleared bit are muted
+*/
+void chipnomadStartReplay(ChipNomadState* state, const RegisterStream* stream, int sampleRate, ChipFactory factory, uint32_t trackMask);
+
+/**
+* Replace the project: stops playback, copies the project in and sets up the chips again
+* Only call it when nothing is rendering from the state, e.g. with audio paused
+* @param state ChipNomad state
+* @param project Project to copy, can be freed afterwards
+*/
+void chipnomadSetProject(ChipNomadState* state, const Project* project);
+
 
 
 #endif
\ No newline at end of file
@@ -21,6 +21,25 @@ static void render(SoundChip* self, float* buffer, int samples) {
   }
 }
 
+static void renderChannels(SoundChip* self, float** buffers, int samples) {
+  struct ayumi* ay = self->userdata;
+
+  for (int c = 0; c < samples; c++) {
+    ayumi_process_channels(ay);
+    ayumi_remove_dc_channels(ay);
+
+    for (int ch = 0; ch < TONE_CHANNELS; ch++) {
+      float out = ay->channel_filters[ch].out;
+      buffers[ch][c * 2] = out * ay->channels[ch].pan_left;
+      buffers[ch][c * 2 + 1] = out * ay->channels[ch].pan_right;
+    }
+  }
+}
+
+static void skip(SoundChip* self, int samples) {
+  ayumi_skip((struct ayumi*)self->userdata, samples);
+}
+
 static void setRegister(SoundChip* self, uint16_t reg, uint8_t value) {
   if (reg > 13) return;
   struct ayumi* ay = (struct ayumi*)self->userdata;
@@ -125,6 +144,8 @@ SoundChip createChipAY(int sampleRate, ChipSetup setup) {
     .userdata = ay,
     .init = init,
     .render = render,
+    .renderChannels = renderChannels,
+    .skip = skip,
     .setRegister = setRegister,
     .setQuality = setQuality,
     .cleanup = cleanup,
@@ -0,0 +1,36 @@
+#include <string.h>
+#include "chips.h"
+
+// Null sound chip: keeps the register values and renders silence, for
+// running the sequencer without synthesis
+
+static int init(SoundChip* self) {
+  return 0;
+}
+
+static void setRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  self->regs[reg & 0xff] = value;
+}
+
+static void render(SoundChip* self, float* buffer, int samples) {
+  memset(buffer, 0, samples * 2 * sizeof(float));
+}
+
+static int cleanup(SoundChip* self) {
+  return 0;
+}
+
+SoundChip createChipNull(int chipIndex, int sampleRate, ChipSetup setup) {
+  SoundChip chip = {
+    .userdata = NULL,
+    .init = init,
+    .setRegister = setRegister,
+    .render = render,
+    .cleanup = cleanup,
+  };
+
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+
+  return chip;
+}
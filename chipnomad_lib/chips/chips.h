@@ -11,6 +11,10 @@ typedef struct SoundChip {
   int (*init)(struct SoundChip* self);
   void (*setRegister)(struct SoundChip* self, uint16_t reg, uint8_t value);
   void (*render)(struct SoundChip* self, float* buffer, int samples);
+  // Optional: render each channel into its own stereo buffer
+  void (*renderChannels)(struct SoundChip* self, float** buffers, int samples);
+  // Optional: advance emulation state by the number of samples without rendering
+  void (*skip)(struct SoundChip* self, int samples);
   void (*setQuality)(struct SoundChip* self, int quality);
   int (*cleanup)(struct SoundChip* self);
 } SoundChip;
@@ -20,4 +24,7 @@ void updateChipAYType(SoundChip* chip, uint8_t isYM);
 void updateChipAYStereoMode(SoundChip* chip, enum StereoModeAY stereoMode, uint8_t separation);
 void updateChipAYClock(SoundChip* chip, int clockRate, int sampleRate);
 
+// Keeps the registers and renders silence. Can be passed as a chip factory
+SoundChip createChipNull(int chipIndex, int sampleRate, ChipSetup setup);
+
 #endif
\ No newline at end of file
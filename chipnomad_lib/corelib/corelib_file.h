@@ -2,6 +2,9 @@
 #define __CORELIB_FILE_H__
 
 #define CORELIB_MAX_OPEN_FILES (16)
+// Default size of the read/write buffer of each open file
+#define CORELIB_FILE_BUFFER_SIZE (65536)
+#define CORELIB_FILE_MIN_BUFFER_SIZE (1024)
 
 #ifdef _WIN32
 #define PATH_SEPARATOR '\\'
@@ -11,31 +14,67 @@
 #define PATH_SEPARATOR_STR "/"
 #endif
 
-// Return a fileId
+// Return a fileId, -1 on error or when all handles are in use
 int fileOpen(const char* path, int isWriting);
+// Writes out buffered data. Returns 0 on success, -1 if this or any earlier
+// write to the file failed. Writes are buffered, so check it after writing
 int fileClose(int fileId);
 
+// Buffer size for files opened after the call. Smaller buffers suit slow
+// storage with little RAM, like SD cards on handhelds
+void fileSetBufferSize(int size);
+
 // Returns number of bytes read
 int fileRead(int fileId, void* buffer, int maxLength);
-// Reads a text line from the file
+// Reads a text line from the file, without the trailing EOL and space characters
 char* fileReadString(int fileId);
+// Reads a text line without copying it. Returns the line without "\n" and sets
+// its length, NULL at the end of file. The line can be changed in place and is
+// valid until the next read from the file. Lines longer than the buffer are split
+char* fileReadLine(int fileId, int* length);
 
 // Returns number of bytes written
 int fileWrite(int fileId, void* data, int length);
 // Returns number of bytes written
 int filePrintf(int fileId, const char* format, ...);
+// Writes out buffered data without closing the file. Returns 0 on success,
+// -1 if this or any earlier write failed
+int fileFlush(int fileId);
 
 // File positioning
 int fileSeek(int fileId, long offset, int whence);
 
+// Whole file in memory, mapped where the platform supports it. Returns NULL
+// on error. The data is read-only and stays valid until fileUnmap
+const void* fileMap(const char* path, long* size);
+void fileUnmap(const void* data, long size);
+
+// Calls to the OS made by the file layer since the last reset
+typedef struct FileStats {
+  long opens;
+  long reads;
+  long writes;
+  long seeks;
+  long maps;
+  long long bytesRead;
+  long long bytesWritten;
+} FileStats;
+
+void fileGetStats(FileStats* stats);
+void fileResetStats(void);
+
 // File operations
 int fileDelete(const char* path);
+// Replaces the target file if it exists
+int fileRename(const char* from, const char* to);
 int fileCreateDirectory(const char* path);
 
 // File browser functions
 typedef struct FileEntry {
   char name[256];
   int isDirectory;
+  long size;
+  long long modifiedTime; // Seconds since the epoch
 } FileEntry;
 
 // Returns allocated array of entries, NULL on error. Caller must free.
@@ -44,5 +83,7 @@ FileEntry* fileListDirectory(const char* path, const char* extension, int* entry
 int fileGetCurrentDirectory(char* buffer, int bufferSize);
 // Check if directory exists
 int fileDirectoryExists(const char* path);
+// Modified time of a file or directory in seconds since the epoch. Returns 0 on success
+int fileGetModifiedTime(const char* path, long long* modifiedTime);
 
 #endif
\ No newline at end of file
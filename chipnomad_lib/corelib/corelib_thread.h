@@ -0,0 +1,32 @@
+#ifndef __CORELIB_THREAD_H__
+#define __CORELIB_THREAD_H__
+
+#define CORELIB_MAX_THREADS (32)
+#define CORELIB_MAX_MUTEXES (32)
+
+typedef int (*ThreadFunction)(void* data);
+
+// Returns a threadId or -1 on failure
+int threadStart(ThreadFunction function, void* data);
+// Waits for the thread to finish, returns the thread function's result
+int threadJoin(int threadId);
+
+// Number of CPU cores available to the process
+int threadCPUCount(void);
+void threadSleep(int ms);
+// Milliseconds since an arbitrary point, for measuring intervals
+int threadTicks(void);
+
+// Returns a mutexId or -1 on failure
+int mutexCreate(void);
+void mutexLock(int mutexId);
+void mutexUnlock(int mutexId);
+void mutexDestroy(int mutexId);
+
+// Atomic access to int values shared between threads
+int atomicGet(int* value);
+void atomicSet(int* value, int newValue);
+// Returns the new value
+int atomicAdd(int* value, int delta);
+
+#endif
@@ -7,60 +7,202 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 #include "../corelib/corelib_file.h"
 
-static FILE* files[CORELIB_MAX_OPEN_FILES];
-static int currentFileId = 0;
-static char stringBuffer[1024];
+// Open file with its own buffer. The FILE is unbuffered, so each fread,
+// fwrite and fseek here is a call to the OS and is counted in the stats
+typedef struct FileHandle {
+  FILE* file;
+  char* buffer; // One byte longer than bufferSize for the line terminator
+  int bufferSize;
+  int pos; // Next byte to read or write
+  int end; // End of read data
+  int isWriting;
+  int isEOF;
+  int isFailed; // A write failed, reported by fileFlush and fileClose
+} FileHandle;
+
+static FileHandle handles[CORELIB_MAX_OPEN_FILES];
+static int filesUsed[CORELIB_MAX_OPEN_FILES];
+static int bufferSize = CORELIB_FILE_BUFFER_SIZE;
+static FileStats stats;
+
+static int osRead(FileHandle* handle, void* buffer, int length) {
+  int read = fread(buffer, 1, length, handle->file);
+  __sync_fetch_and_add(&stats.reads, 1);
+  __sync_fetch_and_add(&stats.bytesRead, read);
+  return read;
+}
 
-int fileOpen(const char* path, int isWriting) {
-  int fileId = currentFileId;
+static int osWrite(FileHandle* handle, const void* data, int length) {
+  int written = fwrite(data, 1, length, handle->file);
+  if (written != length) handle->isFailed = 1;
+  __sync_fetch_and_add(&stats.writes, 1);
+  __sync_fetch_and_add(&stats.bytesWritten, written);
+  return written;
+}
+
+// Returns 1 if not everything was written
+static int flushWrites(FileHandle* handle) {
+  if (!handle->isWriting || handle->pos == 0) return 0;
+  int length = handle->pos;
+  handle->pos = 0;
+  return osWrite(handle, handle->buffer, length) != length;
+}
+
+void fileSetBufferSize(int size) {
+  bufferSize = size < CORELIB_FILE_MIN_BUFFER_SIZE ? CORELIB_FILE_MIN_BUFFER_SIZE : size;
+}
 
+int fileOpen(const char* path, int isWriting) {
   FILE* file = fopen(path, isWriting ? "wb" : "rb");
   if (file == NULL) {
     // TODO: Return error details?
     return -1;
   }
-  files[fileId] = file;
+  __sync_fetch_and_add(&stats.opens, 1);
 
-  currentFileId++;
-  if (currentFileId == CORELIB_MAX_OPEN_FILES) {
-    currentFileId = 0;
+  int size = bufferSize;
+  char* buffer = malloc(size + 1);
+  if (buffer == NULL) {
+    fclose(file);
+    return -1;
+  }
+  setvbuf(file, NULL, _IONBF, 0);
+
+  // Take the first free slot, files may be opened from several threads
+  for (int fileId = 0; fileId < CORELIB_MAX_OPEN_FILES; fileId++) {
+    if (__sync_bool_compare_and_swap(&filesUsed[fileId], 0, 1)) {
+      FileHandle* handle = &handles[fileId];
+      handle->file = file;
+      handle->buffer = buffer;
+      handle->bufferSize = size;
+      handle->pos = 0;
+      handle->end = 0;
+      handle->isWriting = isWriting;
+      handle->isEOF = 0;
+      handle->isFailed = 0;
+      return fileId;
+    }
   }
 
-  return fileId;
+  free(buffer);
+  fclose(file);
+  return -1;
 }
 
 int fileClose(int fileId) {
-  fclose(files[fileId]);
-  return 0;
+  FileHandle* handle = &handles[fileId];
+  int result = flushWrites(handle) || handle->isFailed;
+  if (fclose(handle->file)) result = 1;
+  free(handle->buffer);
+  handle->file = NULL;
+  handle->buffer = NULL;
+  __sync_lock_release(&filesUsed[fileId]);
+  return result ? -1 : 0;
 }
 
 int fileRead(int fileId, void* buffer, int maxLength) {
-  return fread(buffer, 1, maxLength, files[fileId]);
+  FileHandle* handle = &handles[fileId];
+  char* dest = buffer;
+  int length = 0;
+
+  while (length < maxLength) {
+    int available = handle->end - handle->pos;
+    if (available > 0) {
+      int count = available < maxLength - length ? available : maxLength - length;
+      memcpy(dest + length, handle->buffer + handle->pos, count);
+      handle->pos += count;
+      length += count;
+      continue;
+    }
+    if (handle->isEOF) break;
+
+    // Large reads skip the buffer
+    if (maxLength - length >= handle->bufferSize) {
+      int read = osRead(handle, dest + length, maxLength - length);
+      if (read < maxLength - length) handle->isEOF = 1;
+      length += read;
+      break;
+    }
+
+    handle->pos = 0;
+    handle->end = osRead(handle, handle->buffer, handle->bufferSize);
+    if (handle->end < handle->bufferSize) handle->isEOF = 1;
+    if (handle->end == 0) break;
+  }
+
+  return length;
+}
+
+char* fileReadLine(int fileId, int* length) {
+  FileHandle* handle = &handles[fileId];
+  char* line = handle->buffer + handle->pos;
+  char* eol = memchr(line, '\n', handle->end - handle->pos);
+
+  if (eol == NULL && !handle->isEOF && (handle->pos > 0 || handle->end < handle->bufferSize)) {
+    // Move the unread part to the start of the buffer and fill the rest
+    int unread = handle->end - handle->pos;
+    memmove(handle->buffer, line, unread);
+    handle->pos = 0;
+    handle->end = unread;
+    int read = osRead(handle, handle->buffer + unread, handle->bufferSize - unread);
+    if (read < handle->bufferSize - unread) handle->isEOF = 1;
+    handle->end += read;
+    line = handle->buffer;
+    eol = memchr(line + unread, '\n', read);
+  }
+
+  if (eol == NULL) {
+    // Last line without EOL, or a line longer than the buffer
+    if (handle->pos == handle->end) return NULL;
+    eol = handle->buffer + handle->end;
+    handle->pos = handle->end;
+  } else {
+    handle->pos = eol - handle->buffer + 1;
+  }
+
+  *eol = 0;
+  if (length) *length = eol - line;
+  return line;
 }
 
 char* fileReadString(int fileId) {
-  char* r = fgets(stringBuffer, 1024, files[fileId]);
+  int length;
+  char* line = fileReadLine(fileId, &length);
 
-  if (r == NULL) return NULL;
+  if (line == NULL) return NULL;
 
   // Trim (if needed) EOL and space characters
-  int idx = strlen(stringBuffer) - 1;
-  while (idx >= 0 && isspace(stringBuffer[idx])) {
-    stringBuffer[idx] = 0;
+  int idx = length - 1;
+  while (idx >= 0 && isspace((unsigned char)line[idx])) {
+    line[idx] = 0;
     idx--;
   }
 
-  return stringBuffer;
+  return line;
 }
 
 int fileWrite(int fileId, void* data, int length) {
-  return fwrite(data, 1, length, files[fileId]);
+  FileHandle* handle = &handles[fileId];
+
+  if (handle->pos + length > handle->bufferSize) {
+    if (flushWrites(handle)) return 0;
+    // Large writes skip the buffer
+    if (length >= handle->bufferSize) return osWrite(handle, data, length);
+  }
+
+  memcpy(handle->buffer + handle->pos, data, length);
+  handle->pos += length;
+  return length;
 }
 
 int filePrintf(int fileId, const char* format, ...) {
-  static char writeBuffer[1024];
+  char writeBuffer[1024];
 
   va_list args;
   va_start(args, format);
@@ -70,8 +212,80 @@ int filePrintf(int fileId, const char* format, ...) {
   return fileWrite(fileId, writeBuffer, strlen(writeBuffer));
 }
 
+int fileFlush(int fileId) {
+  FileHandle* handle = &handles[fileId];
+  return flushWrites(handle) || handle->isFailed ? -1 : 0;
+}
+
 int fileSeek(int fileId, long offset, int whence) {
-  return fseek(files[fileId], offset, whence);
+  FileHandle* handle = &handles[fileId];
+  if (flushWrites(handle)) return -1;
+
+  // Position of the file is after the buffered data
+  if (!handle->isWriting && whence == SEEK_CUR) offset -= handle->end - handle->pos;
+  handle->pos = 0;
+  handle->end = 0;
+  handle->isEOF = 0;
+
+  __sync_fetch_and_add(&stats.seeks, 1);
+  return fseek(handle->file, offset, whence);
+}
+
+const void* fileMap(const char* path, long* size) {
+  #ifdef _WIN32
+  int fileId = fileOpen(path, 0);
+  if (fileId == -1) return NULL;
+  FILE* file = handles[fileId].file;
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char* data = length >= 0 ? malloc(length + 1) : NULL;
+  if (data && osRead(&handles[fileId], data, length) != length) {
+    free(data);
+    data = NULL;
+  }
+  fileClose(fileId);
+  #else
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) return NULL;
+  struct stat statBuf;
+  void* data = NULL;
+  long length = 0;
+  if (fstat(fd, &statBuf) == 0) {
+    length = statBuf.st_size;
+    // Nothing to map in an empty file
+    data = length > 0 ? mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0) : malloc(1);
+    if (data == MAP_FAILED) data = NULL;
+  }
+  close(fd);
+  #endif
+
+  if (data == NULL) return NULL;
+  __sync_fetch_and_add(&stats.maps, 1);
+  *size = length;
+  return data;
+}
+
+void fileUnmap(const void* data, long size) {
+  #ifdef _WIN32
+  free((void*)data);
+  #else
+  if (size > 0) {
+    munmap((void*)data, size);
+  } else {
+    free((void*)data);
+  }
+  #endif
+}
+
+void fileGetStats(FileStats* result) {
+  __sync_synchronize();
+  *result = stats;
+}
+
+void fileResetStats(void) {
+  memset(&stats, 0, sizeof(stats));
+  __sync_synchronize();
 }
 
 FileEntry* fileListDirectory(const char* path, const char* extension, int* entryCount) {
@@ -141,6 +355,8 @@ FileEntry* fileListDirectory(const char* path, const char* extension, int* entry
     strncpy(entries[count].name, entry->d_name, 255);
     entries[count].name[255] = 0;
     entries[count].isDirectory = isDir;
+    entries[count].size = statBuf.st_size;
+    entries[count].modifiedTime = statBuf.st_mtime;
     count++;
   }
 
@@ -158,10 +374,25 @@ int fileDirectoryExists(const char* path) {
   return (stat(path, &statBuf) == 0 && S_ISDIR(statBuf.st_mode)) ? 1 : 0;
 }
 
+int fileGetModifiedTime(const char* path, long long* modifiedTime) {
+  struct stat statBuf;
+  if (stat(path, &statBuf) != 0) return -1;
+  *modifiedTime = statBuf.st_mtime;
+  return 0;
+}
+
 int fileDelete(const char* path) {
   return remove(path) == 0 ? 0 : -1;
 }
 
+int fileRename(const char* from, const char* to) {
+  #ifdef _WIN32
+  // rename() doesn't replace existing files on Windows
+  remove(to);
+  #endif
+  return rename(from, to) == 0 ? 0 : -1;
+}
+
 int fileCreateDirectory(const char* path) {
   #ifdef _WIN32
   return mkdir(path) == 0 ? 0 : -1;
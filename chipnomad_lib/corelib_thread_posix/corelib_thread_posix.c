@@ -0,0 +1,104 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../corelib/corelib_thread.h"
+
+typedef struct {
+  pthread_t thread;
+  ThreadFunction function;
+  void* data;
+  int isUsed;
+} ThreadSlot;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  int isUsed;
+} MutexSlot;
+
+static ThreadSlot threads[CORELIB_MAX_THREADS];
+static MutexSlot mutexes[CORELIB_MAX_MUTEXES];
+
+static void* threadEntry(void* arg) {
+  ThreadSlot* slot = arg;
+  return (void*)(intptr_t)slot->function(slot->data);
+}
+
+int threadStart(ThreadFunction function, void* data) {
+  for (int c = 0; c < CORELIB_MAX_THREADS; c++) {
+    if (!__sync_bool_compare_and_swap(&threads[c].isUsed, 0, 1)) continue;
+
+    threads[c].function = function;
+    threads[c].data = data;
+    if (pthread_create(&threads[c].thread, NULL, threadEntry, &threads[c]) != 0) {
+      atomicSet(&threads[c].isUsed, 0);
+      return -1;
+    }
+    return c;
+  }
+  return -1;
+}
+
+int threadJoin(int threadId) {
+  void* result = NULL;
+  pthread_join(threads[threadId].thread, &result);
+  atomicSet(&threads[threadId].isUsed, 0);
+  return (int)(intptr_t)result;
+}
+
+int threadCPUCount(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+}
+
+void threadSleep(int ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+}
+
+int threadTicks(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+int mutexCreate(void) {
+  for (int c = 0; c < CORELIB_MAX_MUTEXES; c++) {
+    if (!__sync_bool_compare_and_swap(&mutexes[c].isUsed, 0, 1)) continue;
+
+    if (pthread_mutex_init(&mutexes[c].mutex, NULL) != 0) {
+      atomicSet(&mutexes[c].isUsed, 0);
+      return -1;
+    }
+    return c;
+  }
+  return -1;
+}
+
+void mutexLock(int mutexId) {
+  pthread_mutex_lock(&mutexes[mutexId].mutex);
+}
+
+void mutexUnlock(int mutexId) {
+  pthread_mutex_unlock(&mutexes[mutexId].mutex);
+}
+
+void mutexDestroy(int mutexId) {
+  pthread_mutex_destroy(&mutexes[mutexId].mutex);
+  atomicSet(&mutexes[mutexId].isUsed, 0);
+}
+
+int atomicGet(int* value) {
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+void atomicSet(int* value, int newValue) {
+  __atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+}
+
+int atomicAdd(int* value, int delta) {
+  return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,208 @@
+#include "directory_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "corelib/corelib_thread.h"
+
+// Seconds between a folder's last change and a scan for the listing to be
+// trusted, as the modified time doesn't change again within the same second
+#define DIRECTORY_TIME_GRANULARITY (2)
+
+typedef struct DirectoryKey {
+  char path[2048];
+  char extension[32];
+} DirectoryKey;
+
+typedef struct DirectoryListing {
+  DirectoryKey key;
+  FileEntry* entries;
+  int count;
+  long long modifiedTime; // Of the folder when the scan started, -1 if unknown
+  long long scanTime;
+  int lastUsed;
+  int isUsed;
+  int isFresh; // Landed and not listed yet
+} DirectoryListing;
+
+typedef struct DirectoryScan {
+  DirectoryKey key;
+  DirectoryCompare* compare;
+  FileEntry* entries;
+  int count;
+  long long modifiedTime;
+  long long scanTime;
+  int threadId;
+  int isDone; // Shared with the worker, accessed atomically
+} DirectoryScan;
+
+struct DirectoryCache {
+  DirectoryCompare* compare;
+  DirectoryListing listings[DIRECTORY_CACHE_MAX_PATHS];
+  DirectoryScan* scan; // Running or finished, not stored yet
+  DirectoryKey pending; // Next scan to start
+  int isPending;
+  int useCounter;
+};
+
+static void setKey(DirectoryKey* key, const char* path, const char* extension) {
+  snprintf(key->path, sizeof(key->path), "%s", path);
+  snprintf(key->extension, sizeof(key->extension), "%s", extension ? extension : "");
+}
+
+static int isKey(const DirectoryKey* key, const char* path, const char* extension) {
+  return !strcmp(key->path, path) && !strcmp(key->extension, extension ? extension : "");
+}
+
+static int scanRun(void* arg) {
+  DirectoryScan* scan = arg;
+
+  // The time is taken first, so changes made during the scan outdate it
+  if (fileGetModifiedTime(scan->key.path, &scan->modifiedTime)) scan->modifiedTime = -1;
+  scan->scanTime = time(NULL);
+  scan->entries = fileListDirectory(scan->key.path, scan->key.extension, &scan->count);
+  if (scan->entries && scan->count > 0 && scan->compare) {
+    qsort(scan->entries, scan->count, sizeof(FileEntry), scan->compare);
+  }
+
+  atomicSet(&scan->isDone, 1);
+  return 0;
+}
+
+static void startScan(DirectoryCache* cache, const DirectoryKey* key) {
+  DirectoryScan* scan = calloc(1, sizeof(DirectoryScan));
+  if (!scan) return;
+
+  scan->key = *key;
+  scan->compare = cache->compare;
+  cache->scan = scan;
+  scan->threadId = threadStart(scanRun, scan);
+  // No thread available, do it now
+  if (scan->threadId == -1) scanRun(scan);
+}
+
+static DirectoryListing* findListing(DirectoryCache* cache, const char* path, const char* extension) {
+  for (int c = 0; c < DIRECTORY_CACHE_MAX_PATHS; c++) {
+    DirectoryListing* listing = &cache->listings[c];
+    if (listing->isUsed && isKey(&listing->key, path, extension)) return listing;
+  }
+  return NULL;
+}
+
+// The path's listing, or a free or the least recently used one for it
+static DirectoryListing* takeListing(DirectoryCache* cache, const DirectoryKey* key) {
+  DirectoryListing* listing = findListing(cache, key->path, key->extension);
+  if (listing) return listing;
+
+  listing = &cache->listings[0];
+  for (int c = 0; c < DIRECTORY_CACHE_MAX_PATHS; c++) {
+    if (!cache->listings[c].isUsed) {
+      listing = &cache->listings[c];
+      break;
+    }
+    if (cache->listings[c].lastUsed < listing->lastUsed) listing = &cache->listings[c];
+  }
+
+  free(listing->entries);
+  memset(listing, 0, sizeof(DirectoryListing));
+  listing->key = *key;
+  listing->isUsed = 1;
+  return listing;
+}
+
+static void finishScan(DirectoryCache* cache) {
+  DirectoryScan* scan = cache->scan;
+  if (scan->threadId != -1) threadJoin(scan->threadId);
+
+  DirectoryListing* listing = takeListing(cache, &scan->key);
+  free(listing->entries);
+  listing->entries = scan->entries;
+  listing->count = scan->entries ? scan->count : 0;
+  listing->modifiedTime = scan->modifiedTime;
+  listing->scanTime = scan->scanTime;
+  listing->lastUsed = ++cache->useCounter;
+  listing->isFresh = 1;
+
+  free(scan);
+  cache->scan = NULL;
+}
+
+static void requestScan(DirectoryCache* cache, const char* path, const char* extension) {
+  if (cache->scan) {
+    // Waits for the running one, a newer request replaces it
+    if (!isKey(&cache->scan->key, path, extension)) {
+      setKey(&cache->pending, path, extension);
+      cache->isPending = 1;
+    }
+    return;
+  }
+
+  DirectoryKey key;
+  setKey(&key, path, extension);
+  startScan(cache, &key);
+}
+
+DirectoryCache* directoryCacheCreate(DirectoryCompare* compare) {
+  DirectoryCache* cache = calloc(1, sizeof(DirectoryCache));
+  if (!cache) return NULL;
+  cache->compare = compare;
+  return cache;
+}
+
+void directoryCacheFree(DirectoryCache* cache) {
+  if (!cache) return;
+  if (cache->scan) finishScan(cache);
+  for (int c = 0; c < DIRECTORY_CACHE_MAX_PATHS; c++) {
+    free(cache->listings[c].entries);
+  }
+  free(cache);
+}
+
+FileEntry* directoryCacheList(DirectoryCache* cache, const char* path, const char* extension, int* entryCount) {
+  *entryCount = 0;
+
+  DirectoryListing* listing = findListing(cache, path, extension);
+  long long modifiedTime;
+  // A landed listing is shown once before a recent change makes it scan again
+  int isCurrent = listing && !fileGetModifiedTime(path, &modifiedTime) && listing->modifiedTime == modifiedTime &&
+    (listing->isFresh || listing->scanTime - modifiedTime >= DIRECTORY_TIME_GRANULARITY);
+
+  if (!isCurrent) {
+    requestScan(cache, path, extension);
+    // Without threads the scan has finished already
+    if (cache->scan && cache->scan->threadId == -1) {
+      finishScan(cache);
+      listing = findListing(cache, path, extension);
+    }
+  }
+
+  if (!listing) return NULL;
+  listing->lastUsed = ++cache->useCounter;
+  listing->isFresh = 0;
+  if (listing->count == 0) return NULL;
+
+  FileEntry* entries = malloc(listing->count * sizeof(FileEntry));
+  if (!entries) return NULL;
+  memcpy(entries, listing->entries, listing->count * sizeof(FileEntry));
+  *entryCount = listing->count;
+  return entries;
+}
+
+int directoryCacheUpdate(DirectoryCache* cache, const char* path, const char* extension) {
+  int isLanded = 0;
+  if (cache->scan && atomicGet(&cache->scan->isDone)) {
+    isLanded = isKey(&cache->scan->key, path, extension);
+    finishScan(cache);
+  }
+
+  if (!cache->scan && cache->isPending) {
+    cache->isPending = 0;
+    startScan(cache, &cache->pending);
+  }
+  return isLanded;
+}
+
+int directoryCacheIsScanning(DirectoryCache* cache, const char* path, const char* extension) {
+  return (cache->scan && isKey(&cache->scan->key, path, extension)) ||
+    (cache->isPending && isKey(&cache->pending, path, extension));
+}
@@ -0,0 +1,40 @@
+#ifndef __DIRECTORY_CACHE_H__
+#define __DIRECTORY_CACHE_H__
+
+#include "corelib/corelib_file.h"
+
+// Directory listings cached per path and extension filter, so a file browser
+// doesn't scan and sort a big folder on each visit. Scans run on a worker
+// thread, one at a time, and the caller shows the cached listing meanwhile.
+// Without threads they run on the caller's thread when started.
+//
+// A cached listing is current while the folder's modified time is the same,
+// which changes when files are added, removed or renamed. Atomic saves rename
+// over the old file, so they count too. Times have a 1-2 second granularity,
+// so a listing scanned within 2 seconds of the folder's last change is scanned
+// again on the next visit. Changes inside files don't touch the folder, the
+// listing keeps their old size and modified time until the next scan.
+
+#define DIRECTORY_CACHE_MAX_PATHS (16)
+
+typedef struct DirectoryCache DirectoryCache;
+
+// Order of the entries in a listing, as for qsort
+typedef int DirectoryCompare(const void* a, const void* b);
+
+// Returns NULL if out of memory
+DirectoryCache* directoryCacheCreate(DirectoryCompare* compare);
+// Waits for a running scan
+void directoryCacheFree(DirectoryCache* cache);
+
+// Copy of the cached listing, filtered like fileListDirectory and sorted.
+// Starts a scan unless the listing is current. Returns NULL with entryCount
+// 0 when the path isn't cached yet. The caller frees the copy
+FileEntry* directoryCacheList(DirectoryCache* cache, const char* path, const char* extension, int* entryCount);
+// Call regularly: stores a finished scan and starts the next one. Returns 1
+// when a new listing of the path has landed, list it again to get it
+int directoryCacheUpdate(DirectoryCache* cache, const char* path, const char* extension);
+// Is a scan of the path running or waiting?
+int directoryCacheIsScanning(DirectoryCache* cache, const char* path, const char* extension);
+
+#endif
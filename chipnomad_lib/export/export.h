@@ -1,6 +1,7 @@
 #ifndef __EXPORT_H__
 #define __EXPORT_H__
 
+#include <stdio.h>
 #include <stdint.h>
 #include "project.h"
 #include "chipnomad_lib.h"
@@ -14,9 +15,50 @@ typedef struct Exporter {
   void (*cancel)(struct Exporter* self);
 } Exporter;
 
+// Progress of a background exporter
+typedef struct ExportProgress {
+  int seconds; // Seconds of audio exported
+  int framesDone;
+  int framesTotal; // -1 while unknown
+  int etaSeconds; // -1 while unknown
+} ExportProgress;
+
+enum PCMStreamFormat {
+  pcmStreamRaw, // Interleaved stereo samples, no header
+  pcmStreamWAV,
+};
+
 // Export factory functions
 Exporter* createWAVExporter(const char* filename, Project* project, int startRow, int sampleRate, int bitDepth);
-Exporter* createWAVStemsExporter(const char* basePath, Project* project, int startRow, int sampleRate, int bitDepth);
+// Stems are rendered in a single pass, one file per track. withMix adds the mixed song as <basePath>-mix.wav
+Exporter* createWAVStemsExporter(const char* basePath, Project* project, int startRow, int sampleRate, int bitDepth, int withMix);
+// Same output as createWAVExporter, rendered in segments on worker threads. threadsCount <= 0 uses all CPU cores
+Exporter* createWAVExporterParallel(const char* filename, Project* project, int startRow, int sampleRate, int bitDepth, int threadsCount);
 Exporter* createPSGExporter(const char* filename, Project* project, int startRow);
+// Compact delta/RLE coded register dump (.cnr), format and decoder in register_dump.h
+Exporter* createRegisterDumpExporter(const char* filename, Project* project, int startRow);
+// VGM for AY-3-8910/YM2149, one or two chips (NULL for more). Songs that jump back to a row on their end loop there
+Exporter* createVGMExporter(const char* filename, Project* project, int startRow);
+// Streams PCM to an open stdio stream (stdout, a pipe, fdopen() of a descriptor) without seeking.
+// The stream isn't closed by finish() or cancel()
+Exporter* createPCMStreamExporter(FILE* stream, Project* project, int startRow, int sampleRate, int bitDepth, enum PCMStreamFormat format);
+
+// Loudness normalization for WAV exporters, serial or parallel. Audio is rendered as float32 to <filename>.tmp
+// and finish() writes the output with the gain that brings it to targetLUFS without going over truePeakLimit dBTP.
+// Call before the first next() and before wrapping the exporter. Returns 1 for other exporters or on failure
+int wavExporterSetNormalization(Exporter* exporter, float targetLUFS, float truePeakLimit);
+// Loudness that WAV exporters store in a LIST chunk of the file. Returns 0 on success
+int wavReadLoudness(const char* filename, LoudnessStats* stats);
+
+// Runs the exporter on a worker thread and takes ownership of it. next() doesn't block,
+// the export starts on its first call, so configure chipnomadState before that
+Exporter* createBackgroundExporter(Exporter* exporter);
+// Creates an exporter for the project, which is only valid during the call
+typedef Exporter* (ExporterFactory)(Project* project, void* arg);
+// Same, but the worker restores the snapshot and creates the exporter with factory(project, arg), so
+// the caller doesn't copy the project. Takes ownership of the snapshot and of arg, which is freed with
+// free() once the exporter is created. chipnomadState is NULL, the factory configures the exporter
+Exporter* createBackgroundExporterFromSnapshot(ProjectSnapshot* snapshot, ExporterFactory* factory, void* arg);
+void backgroundExporterProgress(Exporter* self, ExportProgress* progress);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "export.h"
+#include <stdlib.h>
+#include <string.h>
+#include "corelib/corelib_thread.h"
+#include "playback.h"
+#include "chips/chips.h"
+#include "chipnomad_lib.h"
+
+// Background exporter: calls another exporter's next() on a worker thread
+// until it's done, so export runs at full speed and the caller only polls
+// progress. Created from a project snapshot, the worker also restores the
+// snapshot and creates the wrapped exporter, so the caller doesn't copy the
+// project.
+
+// Songs that don't stop within this time are reported with unknown length
+#define BACKGROUND_MAX_SECONDS (3600)
+
+typedef struct {
+  Exporter* exporter; // Wrapped exporter, only the worker uses it once started
+  // Until the wrapped exporter is created from them
+  ProjectSnapshot* snapshot;
+  ExporterFactory* factory;
+  void* factoryArg;
+  int threadId;
+  int isStarted;
+  int startTicks;
+  // Shared with the worker, accessed atomically
+  int isCancelled;
+  int isDone;
+  int result;
+  int seconds;
+  int framesDone;
+  int framesTotal;
+} BackgroundExporterData;
+
+// Number of frames left in the exporter's playback, or -1 if unknown
+static int countFrames(ChipNomadState* source) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return -1;
+
+  state->project = source->project;
+  state->playbackState = source->playbackState;
+  state->playbackState.p = &state->project;
+  chipnomadInitChips(state, 44100, createChipNull);
+
+  int maxFrames = (int)(state->project.tickRate * BACKGROUND_MAX_SECONDS);
+  int frames = 0;
+  while (frames < maxFrames) {
+    frames++;
+    if (playbackNextFrame(&state->playbackState, state->chips)) break;
+  }
+
+  chipnomadDestroy(state);
+  return frames < maxFrames ? frames : -1;
+}
+
+// Wrapped exporter from the snapshot, on the thread that runs the steps.
+// Returns 1 on failure, which ends the export
+static int backgroundCreate(BackgroundExporterData* data) {
+  if (!data->exporter) {
+    Project* project = malloc(sizeof(Project));
+    if (project) {
+      projectSnapshotRestore(data->snapshot, project);
+      data->exporter = data->factory(project, data->factoryArg);
+      free(project);
+    }
+    projectSnapshotFree(data->snapshot);
+    free(data->factoryArg);
+    data->snapshot = NULL;
+    data->factoryArg = NULL;
+  }
+
+  if (!data->exporter) {
+    atomicSet(&data->result, 1);
+    atomicSet(&data->isDone, 1);
+    return 1;
+  }
+  return 0;
+}
+
+// One step of the wrapped exporter. Returns 1 when it's done
+static int backgroundStep(BackgroundExporterData* data) {
+  Exporter* exporter = data->exporter;
+  int seconds = exporter->next(exporter);
+  atomicSet(&data->framesDone, exporter->chipnomadState->framesCount);
+
+  if (seconds == -1) {
+    atomicSet(&data->result, exporter->finish(exporter));
+    atomicSet(&data->isDone, 1);
+    return 1;
+  }
+  atomicSet(&data->seconds, seconds);
+  return 0;
+}
+
+static int backgroundRun(void* arg) {
+  BackgroundExporterData* data = arg;
+
+  if (backgroundCreate(data)) return 0;
+  atomicSet(&data->framesTotal, countFrames(data->exporter->chipnomadState));
+
+  while (!atomicGet(&data->isCancelled)) {
+    if (backgroundStep(data)) return 0;
+  }
+  data->exporter->cancel(data->exporter);
+  return 0;
+}
+
+static void backgroundStart(BackgroundExporterData* data) {
+  data->startTicks = threadTicks();
+  data->threadId = threadStart(backgroundRun, data);
+  // No thread available, steps run from next() instead
+  if (data->threadId == -1 && !backgroundCreate(data)) {
+    data->framesTotal = countFrames(data->exporter->chipnomadState);
+  }
+  data->isStarted = 1;
+}
+
+static int backgroundNext(Exporter* self) {
+  BackgroundExporterData* data = (BackgroundExporterData*)self->data;
+
+  // Start on the first call, after the caller has configured the state
+  if (!data->isStarted) backgroundStart(data);
+
+  if (data->threadId == -1 && !data->isDone) backgroundStep(data);
+
+  if (atomicGet(&data->isDone)) return -1;
+  return atomicGet(&data->seconds);
+}
+
+static int backgroundFinish(Exporter* self) {
+  BackgroundExporterData* data = (BackgroundExporterData*)self->data;
+
+  if (!data->isStarted) backgroundStart(data);
+  if (data->threadId != -1) {
+    threadJoin(data->threadId);
+  } else {
+    // next() may have run the last step already, which freed the wrapped exporter
+    while (!atomicGet(&data->isDone) && !backgroundStep(data));
+  }
+  int result = data->result;
+
+  free(data);
+  free(self);
+  return result;
+}
+
+static void backgroundCancel(Exporter* self) {
+  BackgroundExporterData* data = (BackgroundExporterData*)self->data;
+
+  atomicSet(&data->isCancelled, 1);
+  if (data->isStarted && data->threadId != -1) {
+    // The worker cancels the wrapped exporter, unless it has already finished
+    threadJoin(data->threadId);
+  } else if (!data->isDone && data->exporter) {
+    data->exporter->cancel(data->exporter);
+  }
+
+  // Left when the export never started
+  projectSnapshotFree(data->snapshot);
+  free(data->factoryArg);
+  free(data);
+  free(self);
+}
+
+void backgroundExporterProgress(Exporter* self, ExportProgress* progress) {
+  BackgroundExporterData* data = (BackgroundExporterData*)self->data;
+
+  progress->seconds = atomicGet(&data->seconds);
+  progress->framesDone = atomicGet(&data->framesDone);
+  progress->framesTotal = atomicGet(&data->framesTotal);
+  progress->etaSeconds = -1;
+
+  if (progress->framesTotal > 0 && progress->framesDone > progress->framesTotal) {
+    progress->framesDone = progress->framesTotal;
+  }
+  if (data->isStarted && progress->framesTotal > 0 && progress->framesDone > 0) {
+    double elapsed = (threadTicks() - data->startTicks) / 1000.0;
+    progress->etaSeconds = (int)(elapsed * (progress->framesTotal - progress->framesDone) / progress->framesDone + 0.5);
+  }
+}
+
+static Exporter* createBackground(BackgroundExporterData* data) {
+  Exporter* background = malloc(sizeof(Exporter));
+  if (!background) return NULL;
+
+  data->threadId = -1;
+  data->framesTotal = -1;
+
+  // Configuration goes to the wrapped exporter's state
+  background->chipnomadState = data->exporter ? data->exporter->chipnomadState : NULL;
+  background->data = data;
+  background->next = backgroundNext;
+  background->finish = backgroundFinish;
+  background->cancel = backgroundCancel;
+
+  return background;
+}
+
+Exporter* createBackgroundExporter(Exporter* exporter) {
+  if (!exporter) return NULL;
+
+  BackgroundExporterData* data = calloc(1, sizeof(BackgroundExporterData));
+  Exporter* background = data ? createBackground(data) : NULL;
+  if (!background) {
+    free(data);
+    exporter->cancel(exporter);
+    return NULL;
+  }
+  data->exporter = exporter;
+  return background;
+}
+
+Exporter* createBackgroundExporterFromSnapshot(ProjectSnapshot* snapshot, ExporterFactory* factory, void* arg) {
+  BackgroundExporterData* data = snapshot ? calloc(1, sizeof(BackgroundExporterData)) : NULL;
+  Exporter* background = data ? createBackground(data) : NULL;
+  if (!background) {
+    free(data);
+    projectSnapshotFree(snapshot);
+    free(arg);
+    return NULL;
+  }
+  data->snapshot = snapshot;
+  data->factory = factory;
+  data->factoryArg = arg;
+  return background;
+}
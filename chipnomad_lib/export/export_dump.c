@@ -0,0 +1,341 @@
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "corelib/corelib_file.h"
+#include "playback.h"
+#include "chips/chips.h"
+#include "chipnomad_lib.h"
+#include "register_dump.h"
+
+#define DUMP_BUFFER_SIZE (16384)
+#define DUMP_FRAME_SIZE (1 + PROJECT_MAX_CHIPS * (2 + REGISTER_DUMP_REGS)) // Largest literal frame
+
+// Register dump exporter state
+typedef struct {
+  int fileId;
+  int allTracksStopped;
+  int renderedSeconds;
+  int framesCount;
+  int encodedCount; // Frames written to the file, the rest are lookahead for the encoder
+  RegisterDumpState states[2]; // Registers after the current and previous frames
+  uint8_t historyFrames[REGISTER_DUMP_HISTORY][DUMP_FRAME_SIZE]; // Frames encoded as literals
+  uint8_t historySizes[REGISTER_DUMP_HISTORY];
+  uint32_t historyHashes[REGISTER_DUMP_HISTORY];
+  uint8_t buffer[DUMP_BUFFER_SIZE];
+  int bufferSize;
+  int failed;
+  char filename[1024];
+} DumpExporterData;
+
+static int writeDumpHeader(int fileId, Project* project) {
+  uint8_t header[REGISTER_DUMP_HEADER_SIZE];
+  memset(header, 0, sizeof(header));
+
+  memcpy(header, "CNRD", 4);
+  header[4] = REGISTER_DUMP_VERSION;
+  header[5] = (uint8_t)project->chipType;
+  header[6] = (uint8_t)project->chipsCount;
+  header[7] = (uint8_t)project->tracksCount;
+  writeLE32(header + 8, (uint32_t)(project->tickRate * 1000.0f + 0.5f));
+  writeLE32(header + 12, 0); // Frames count, set when the export is done
+  writeLE32(header + 16, (uint32_t)project->chipSetup.ay.clock);
+  header[20] = project->chipSetup.ay.isYM;
+  header[21] = (uint8_t)project->chipSetup.ay.stereoMode;
+  header[22] = project->chipSetup.ay.stereoSeparation;
+
+  return fileWrite(fileId, header, REGISTER_DUMP_HEADER_SIZE) == REGISTER_DUMP_HEADER_SIZE ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Output buffer
+//
+
+static void dumpFlush(DumpExporterData* data) {
+  if (data->bufferSize > 0 && fileWrite(data->fileId, data->buffer, data->bufferSize) != data->bufferSize) {
+    data->failed = 1;
+  }
+  data->bufferSize = 0;
+}
+
+static void dumpWrite(DumpExporterData* data, const uint8_t* bytes, int length) {
+  if (data->bufferSize + length > DUMP_BUFFER_SIZE) dumpFlush(data);
+  memcpy(data->buffer + data->bufferSize, bytes, length);
+  data->bufferSize += length;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Recording chip: keeps register values, frames take a snapshot of them
+//
+
+typedef struct {
+  uint16_t writtenMask; // Registers written at least once
+  uint8_t isTriggered; // Trigger register written in the current frame
+} DumpChipData;
+
+static void dumpChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  if (reg >= REGISTER_DUMP_REGS) return;
+
+  DumpChipData* data = (DumpChipData*)self->userdata;
+  data->writtenMask |= 1 << reg;
+  if (reg == REGISTER_DUMP_TRIGGER_REG) data->isTriggered = 1;
+  self->regs[reg] = value;
+}
+
+static void dumpChipRender(SoundChip* self, float* buffer, int samples) {
+  memset(buffer, 0, samples * 2 * sizeof(float));
+}
+
+static int dumpChipCleanup(SoundChip* self) {
+  free(self->userdata);
+  return 0;
+}
+
+static SoundChip dumpChipFactory(int chipIndex, int sampleRate, ChipSetup setup) {
+  SoundChip chip = {
+    .userdata = calloc(1, sizeof(DumpChipData)),
+    .setRegister = dumpChipSetRegister,
+    .render = dumpChipRender,
+    .cleanup = dumpChipCleanup,
+  };
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+  return chip;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Frame encoding
+//
+
+static const RegisterDumpState initialState;
+
+static const RegisterDumpState* frameState(DumpExporterData* data, int frame) {
+  return frame >= 0 ? &data->states[frame % 2] : &initialState;
+}
+
+// Registers of the chip to write for the frame
+static uint16_t frameWriteMask(DumpExporterData* data, int frame, int chip) {
+  const RegisterDumpState* from = frameState(data, frame - 1);
+  const RegisterDumpState* to = frameState(data, frame);
+  uint16_t mask = 0;
+
+  for (int reg = 0; reg < REGISTER_DUMP_REGS; reg++) {
+    uint16_t bit = 1 << reg;
+    if (!(to->writtenMasks[chip] & bit)) continue;
+    if (!(from->writtenMasks[chip] & bit) || from->regs[chip][reg] != to->regs[chip][reg] ||
+        (reg == REGISTER_DUMP_TRIGGER_REG && (to->triggers & (1 << chip)))) {
+      mask |= bit;
+    }
+  }
+  return mask;
+}
+
+// Returns number of bytes in the frame, 1 if it has no writes
+static int encodeFrame(DumpExporterData* data, int frame, int chipsCount, uint8_t* bytes) {
+  const RegisterDumpState* state = frameState(data, frame);
+  int size = 1;
+  bytes[0] = REGISTER_DUMP_FRAME;
+
+  for (int chip = 0; chip < chipsCount; chip++) {
+    uint16_t mask = frameWriteMask(data, frame, chip);
+    if (!mask) continue;
+
+    bytes[0] |= 1 << chip;
+    bytes[size++] = mask & 0xff;
+    bytes[size++] = mask >> 8;
+    for (int reg = 0; reg < REGISTER_DUMP_REGS; reg++) {
+      if (mask & (1 << reg)) bytes[size++] = state->regs[chip][reg];
+    }
+  }
+  return size;
+}
+
+// Frames are equal if they have the same writes
+static int framesEqual(DumpExporterData* data, int frame1, int frame2) {
+  int idx1 = frame1 % REGISTER_DUMP_HISTORY;
+  int idx2 = frame2 % REGISTER_DUMP_HISTORY;
+  return data->historyHashes[idx1] == data->historyHashes[idx2] &&
+    data->historySizes[idx1] == data->historySizes[idx2] &&
+    !memcmp(data->historyFrames[idx1], data->historyFrames[idx2], data->historySizes[idx1]);
+}
+
+// Write the next token: a run of frames without writes, a repeat of earlier
+// frames or a single frame, whichever covers the most frames
+static void dumpEncodeStep(DumpExporterData* data) {
+  int pos = data->encodedCount;
+  int available = data->framesCount - pos;
+  int idx = pos % REGISTER_DUMP_HISTORY;
+
+  int waitFrames = 0;
+  while (waitFrames < available && waitFrames < REGISTER_DUMP_MAX_WAIT &&
+    data->historySizes[(pos + waitFrames) % REGISTER_DUMP_HISTORY] == 1) {
+    waitFrames++;
+  }
+
+  // Earlier frames have to stay in history while the lookahead is there too
+  int maxRepeat = available < REGISTER_DUMP_MAX_REPEAT ? available : REGISTER_DUMP_MAX_REPEAT;
+  int maxDistance = REGISTER_DUMP_HISTORY - REGISTER_DUMP_MAX_WAIT - 1;
+  if (maxDistance > pos) maxDistance = pos;
+  int repeatFrames = 0;
+  int repeatDistance = 0;
+  for (int d = 1; d <= maxDistance && repeatFrames < maxRepeat; d++) {
+    int length = 0;
+    while (length < maxRepeat && framesEqual(data, pos + length, pos + length - d)) length++;
+    if (length > repeatFrames) {
+      repeatFrames = length;
+      repeatDistance = d;
+    }
+  }
+
+  int frameSize = data->historySizes[idx];
+
+  if (waitFrames > 0 && waitFrames >= repeatFrames) {
+    uint8_t token = REGISTER_DUMP_WAIT + waitFrames - 1;
+    dumpWrite(data, &token, 1);
+    data->encodedCount += waitFrames;
+  } else if (repeatFrames > 1 || (repeatFrames == 1 && frameSize > 3)) {
+    uint8_t repeat[3] = {REGISTER_DUMP_REPEAT + repeatFrames - 1, repeatDistance & 0xff, repeatDistance >> 8};
+    dumpWrite(data, repeat, 3);
+    data->encodedCount += repeatFrames;
+  } else {
+    dumpWrite(data, data->historyFrames[idx], frameSize);
+    data->encodedCount++;
+  }
+}
+
+// Take a snapshot of the registers after a playback frame
+static void dumpAddFrame(DumpExporterData* data, ChipNomadState* state) {
+  int idx = data->framesCount % REGISTER_DUMP_HISTORY;
+  RegisterDumpState* frame = &data->states[data->framesCount % 2];
+  memset(frame, 0, sizeof(RegisterDumpState));
+
+  for (int chip = 0; chip < state->project.chipsCount; chip++) {
+    DumpChipData* chipData = (DumpChipData*)state->chips[chip].userdata;
+    memcpy(frame->regs[chip], state->chips[chip].regs, REGISTER_DUMP_REGS);
+    frame->writtenMasks[chip] = chipData->writtenMask;
+    if (chipData->isTriggered) frame->triggers |= 1 << chip;
+    chipData->isTriggered = 0;
+  }
+
+  uint8_t* bytes = data->historyFrames[idx];
+  int size = encodeFrame(data, data->framesCount, state->project.chipsCount, bytes);
+  data->historySizes[idx] = size;
+
+  uint32_t hash = 2166136261u;
+  for (int c = 0; c < size; c++) {
+    hash = (hash ^ bytes[c]) * 16777619u;
+  }
+  data->historyHashes[idx] = hash;
+  data->framesCount++;
+
+  // Longest wait is the longest lookahead the encoder needs
+  if (data->framesCount - data->encodedCount == REGISTER_DUMP_MAX_WAIT) {
+    dumpEncodeStep(data);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Exporter
+//
+
+static int dumpNext(Exporter* self) {
+  DumpExporterData* data = (DumpExporterData*)self->data;
+  if (data->allTracksStopped) return -1;
+
+  int framesPerChunk = (int)(self->chipnomadState->project.tickRate * 10 + 0.5f); // 10 seconds
+  int framesRendered = 0;
+
+  while (framesRendered < framesPerChunk && !data->allTracksStopped) {
+    data->allTracksStopped = playbackNextFrame(&self->chipnomadState->playbackState, self->chipnomadState->chips);
+    self->chipnomadState->framesCount++;
+    dumpAddFrame(data, self->chipnomadState);
+    framesRendered++;
+  }
+
+  if (data->allTracksStopped) return -1;
+
+  data->renderedSeconds += 10;
+  return data->renderedSeconds;
+}
+
+static int dumpFinish(Exporter* self) {
+  DumpExporterData* data = (DumpExporterData*)self->data;
+
+  while (data->encodedCount < data->framesCount) {
+    dumpEncodeStep(data);
+  }
+  dumpFlush(data);
+
+  // Frames count in the header
+  uint8_t framesCount[4];
+  writeLE32(framesCount, (uint32_t)data->framesCount);
+  fileSeek(data->fileId, 12, 0);
+  if (fileWrite(data->fileId, framesCount, 4) != 4) data->failed = 1;
+  int result = data->failed;
+
+  chipnomadDestroy(self->chipnomadState);
+  // A full disk may only show when the file is closed
+  if (fileClose(data->fileId)) result = 1;
+  if (result) fileDelete(data->filename);
+  free(data);
+  free(self);
+  return result;
+}
+
+static void dumpCancel(Exporter* self) {
+  DumpExporterData* data = (DumpExporterData*)self->data;
+
+  chipnomadDestroy(self->chipnomadState);
+  fileClose(data->fileId);
+  fileDelete(data->filename);
+  free(data);
+  free(self);
+}
+
+Exporter* createRegisterDumpExporter(const char* filename, Project* project, int startRow) {
+  Exporter* exporter = malloc(sizeof(Exporter));
+  if (!exporter) return NULL;
+
+  DumpExporterData* data = calloc(1, sizeof(DumpExporterData));
+  if (!data) {
+    free(exporter);
+    return NULL;
+  }
+  snprintf(data->filename, sizeof(data->filename), "%s", filename);
+
+  data->fileId = fileOpen(filename, 1);
+  if (data->fileId == -1) {
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  exporter->chipnomadState = chipnomadCreate();
+  if (!exporter->chipnomadState || writeDumpHeader(data->fileId, project)) {
+    chipnomadDestroy(exporter->chipnomadState);
+    fileClose(data->fileId);
+    fileDelete(filename);
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  // Copy project data and reinitialize playback
+  exporter->chipnomadState->project = *project;
+  playbackInit(&exporter->chipnomadState->playbackState, &exporter->chipnomadState->project);
+  chipnomadInitChips(exporter->chipnomadState, 44100, dumpChipFactory); // Sample rate doesn't matter for dumps
+  playbackStartSong(&exporter->chipnomadState->playbackState, startRow, 0, 0);
+
+  exporter->data = data;
+  exporter->next = dumpNext;
+  exporter->finish = dumpFinish;
+  exporter->cancel = dumpCancel;
+
+  return exporter;
+}
@@ -19,23 +19,51 @@ typedef struct {
   char baseFilename[1024];
 } PSGExporterData;
 
+static void psgFilename(char* buffer, int size, PSGExporterData* data, int chipIdx) {
+  if (data->numChips > 1) {
+    snprintf(buffer, size, "%s-%d.psg", data->baseFilename, chipIdx + 1);
+  } else {
+    snprintf(buffer, size, "%s.psg", data->baseFilename);
+  }
+}
+
 static void writePSGHeader(int fileId) {
   char header[16] = "PSG\x1a\0\0\0\0\0\0\0\0\0\0\0\0";
   fileWrite(fileId, header, 16);
 }
 
+// Register writes are collected per chip and written to the file in large blocks
+#define PSG_BUFFER_SIZE (16384)
+
 // PSG recording chip implementation
 typedef struct {
   int fileId;
   uint8_t lastRegs[14];
+  uint8_t buffer[PSG_BUFFER_SIZE];
+  int bufferSize;
+  int failed;
 } PSGChipData;
 
+static void psgFlush(PSGChipData* data) {
+  if (data->bufferSize > 0 && fileWrite(data->fileId, data->buffer, data->bufferSize) != data->bufferSize) {
+    data->failed = 1;
+  }
+  data->bufferSize = 0;
+}
+
+static void psgWrite(PSGChipData* data, uint8_t byte) {
+  if (data->bufferSize == PSG_BUFFER_SIZE) psgFlush(data);
+  data->buffer[data->bufferSize++] = byte;
+}
+
 static int psgChipInit(SoundChip* self) {
   PSGChipData* data = (PSGChipData*)self->userdata;
   for (int i = 0; i < 14; i++) {
     data->lastRegs[i] = 0;
   }
   data->lastRegs[7] = 0x3f;
+  data->bufferSize = 0;
+  data->failed = 0;
   return 0;
 }
 
@@ -46,8 +74,8 @@ static void psgChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
   self->regs[reg] = value;
 
   if (data->lastRegs[reg] != value || reg == 13) {
-    uint8_t regData[2] = {reg, value};
-    fileWrite(data->fileId, regData, 2);
+    psgWrite(data, (uint8_t)reg);
+    psgWrite(data, value);
     data->lastRegs[reg] = value;
   }
 }
@@ -95,12 +123,13 @@ static int psgNext(Exporter* self) {
   int framesRendered = 0;
 
   while (framesRendered < framesPerChunk && !data->allTracksStopped) {
-    uint8_t frameMarker = 0xFF;
+    // Frame marker
     for (int i = 0; i < data->numChips; i++) {
-      fileWrite(data->fileIds[i], &frameMarker, 1);
+      psgWrite((PSGChipData*)self->chipnomadState->chips[i].userdata, 0xFF);
     }
 
     data->allTracksStopped = playbackNextFrame(&self->chipnomadState->playbackState, self->chipnomadState->chips);
+    self->chipnomadState->framesCount++;
     framesRendered++;
   }
 
@@ -113,13 +142,26 @@ static int psgNext(Exporter* self) {
 static int psgFinish(Exporter* self) {
   PSGExporterData* data = (PSGExporterData*)self->data;
 
+  int result = 0;
+  for (int i = 0; i < data->numChips; i++) {
+    PSGChipData* chipData = (PSGChipData*)self->chipnomadState->chips[i].userdata;
+    psgFlush(chipData);
+    if (chipData->failed) result = 1;
+  }
+
   chipnomadDestroy(self->chipnomadState);
   for (int i = 0; i < data->numChips; i++) {
-    fileClose(data->fileIds[i]);
+    // A full disk may only show when the file is closed
+    if (fileClose(data->fileIds[i])) result = 1;
+  }
+  for (int i = 0; result && i < data->numChips; i++) {
+    char filename[1024];
+    psgFilename(filename, sizeof(filename), data, i);
+    fileDelete(filename);
   }
   free(data);
   free(self);
-  return 0;
+  return result;
 }
 
 static void psgCancel(Exporter* self) {
@@ -128,13 +170,9 @@ static void psgCancel(Exporter* self) {
   chipnomadDestroy(self->chipnomadState);
   for (int i = 0; i < data->numChips; i++) {
     fileClose(data->fileIds[i]);
-    
+
     char filename[1024];
-    if (data->numChips > 1) {
-      snprintf(filename, sizeof(filename), "%s-%d.psg", data->baseFilename, i + 1);
-    } else {
-      snprintf(filename, sizeof(filename), "%s.psg", data->baseFilename);
-    }
+    psgFilename(filename, sizeof(filename), data, i);
     fileDelete(filename);
   }
   free(data);
@@ -164,11 +202,7 @@ Exporter* createPSGExporter(const char* filename, Project* project, int startRow
   // Open files for each chip
   for (int i = 0; i < data->numChips; i++) {
     char chipFilename[1024];
-    if (data->numChips > 1) {
-      snprintf(chipFilename, sizeof(chipFilename), "%s-%d.psg", data->baseFilename, i + 1);
-    } else {
-      snprintf(chipFilename, sizeof(chipFilename), "%s.psg", data->baseFilename);
-    }
+    psgFilename(chipFilename, sizeof(chipFilename), data, i);
 
     data->fileIds[i] = fileOpen(chipFilename, 1);
     if (data->fileIds[i] == -1) {
@@ -0,0 +1,423 @@
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "corelib/corelib_file.h"
+#include "playback.h"
+#include "chips/chips.h"
+#include "chipnomad_lib.h"
+
+// VGM 1.51 with one or two AY-3-8910/YM2149 chips. Frames are written as
+// register writes followed by waits at 44100 Hz. Writes that don't change a
+// register are dropped and the waits of frames without writes are merged.
+
+#define VGM_BUFFER_SIZE (16384)
+#define VGM_HEADER_SIZE (0x80)
+#define VGM_VERSION (0x151)
+#define VGM_SAMPLE_RATE (44100)
+#define VGM_MAX_CHIPS (2)
+#define VGM_REGS (14)
+#define VGM_TRIGGER_REG (13) // Writing it restarts the envelope even with the same value
+#define VGM_MAX_SECONDS (3600) // Longest song the duration analysis follows
+
+// Commands
+#define VGM_CMD_AY_WRITE (0xa0)
+#define VGM_CMD_WAIT (0x61)
+#define VGM_CMD_WAIT_60HZ (0x62) // 735 samples
+#define VGM_CMD_WAIT_50HZ (0x63) // 882 samples
+#define VGM_CMD_END (0x66)
+#define VGM_CMD_WAIT_SHORT (0x70) // 0x70-0x7f, 1-16 samples
+
+// Header fields
+#define VGM_AY_TYPE_AY8910 (0x00)
+#define VGM_AY_TYPE_YM2149 (0x10)
+#define VGM_AY_FLAGS_LEGACY (0x01)
+#define VGM_CLOCK_DUAL (0x40000000)
+
+// VGM exporter state
+typedef struct {
+  int fileId;
+  int numChips;
+  int startRow;
+  int isAnalyzed;
+  int framesTotal; // Frames to export
+  int loopFrame; // First frame of the looped part, -1 if the song doesn't loop
+  int renderedSeconds;
+  uint32_t pendingSamples; // Wait not written yet
+  uint32_t dataSize; // Bytes written, header included
+  uint32_t loopOffset;
+  uint8_t buffer[VGM_BUFFER_SIZE];
+  int bufferSize;
+  int failed;
+  char filename[1024];
+} VGMExporterData;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Output buffer
+//
+
+static void vgmFlush(VGMExporterData* data) {
+  if (data->bufferSize > 0 && fileWrite(data->fileId, data->buffer, data->bufferSize) != data->bufferSize) {
+    data->failed = 1;
+  }
+  data->bufferSize = 0;
+}
+
+static void vgmWrite(VGMExporterData* data, const uint8_t* bytes, int length) {
+  if (data->bufferSize + length > VGM_BUFFER_SIZE) vgmFlush(data);
+  memcpy(data->buffer + data->bufferSize, bytes, length);
+  data->bufferSize += length;
+  data->dataSize += length;
+}
+
+// Waits that take a single byte, 0 if there isn't one
+static uint8_t shortWaitCommand(uint32_t samples) {
+  if (samples >= 1 && samples <= 16) return VGM_CMD_WAIT_SHORT + samples - 1;
+  if (samples == 735) return VGM_CMD_WAIT_60HZ;
+  if (samples == 882) return VGM_CMD_WAIT_50HZ;
+  return 0;
+}
+
+// Write the pending wait with the shortest commands
+static void vgmFlushWait(VGMExporterData* data) {
+  static const uint32_t shortWaits[] = {735, 882, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+  uint32_t samples = data->pendingSamples;
+  data->pendingSamples = 0;
+
+  while (samples > 0) {
+    uint8_t command = shortWaitCommand(samples);
+    if (command) {
+      vgmWrite(data, &command, 1);
+      return;
+    }
+
+    // Two one-byte waits are shorter than a 16-bit wait
+    for (int c = 0; c < (int)(sizeof(shortWaits) / sizeof(shortWaits[0])); c++) {
+      if (samples > shortWaits[c] && shortWaitCommand(samples - shortWaits[c])) {
+        uint8_t commands[2] = {shortWaitCommand(shortWaits[c]), shortWaitCommand(samples - shortWaits[c])};
+        vgmWrite(data, commands, 2);
+        return;
+      }
+    }
+
+    uint32_t wait = samples > 0xffff ? 0xffff : samples;
+    uint8_t command16[3] = {VGM_CMD_WAIT, wait & 0xff, wait >> 8};
+    vgmWrite(data, command16, 3);
+    samples -= wait;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Recording chip: register values are written to the file after each frame
+//
+
+typedef struct {
+  uint16_t setMask; // Registers the song has set
+  uint8_t isTriggered; // Envelope shape set in the current frame
+  uint8_t lastRegs[VGM_REGS]; // Values written to the file
+  uint16_t writtenMask; // Registers written to the file
+} VGMChipData;
+
+static void vgmChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  if (reg >= VGM_REGS) return;
+
+  VGMChipData* data = (VGMChipData*)self->userdata;
+  data->setMask |= 1 << reg;
+  if (reg == VGM_TRIGGER_REG) data->isTriggered = 1;
+  self->regs[reg] = value;
+}
+
+static void vgmChipRender(SoundChip* self, float* buffer, int samples) {
+  memset(buffer, 0, samples * 2 * sizeof(float));
+}
+
+static int vgmChipCleanup(SoundChip* self) {
+  free(self->userdata);
+  return 0;
+}
+
+static SoundChip vgmChipFactory(int chipIndex, int sampleRate, ChipSetup setup) {
+  SoundChip chip = {
+    .userdata = calloc(1, sizeof(VGMChipData)),
+    .setRegister = vgmChipSetRegister,
+    .render = vgmChipRender,
+    .cleanup = vgmChipCleanup,
+  };
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+  return chip;
+}
+
+// Write the registers the frame changed. isRefresh writes all of them, so the
+// chips are in the same state whenever the player gets to the loop. The
+// envelope shape is only written when the song sets it, as that restarts
+// the envelope
+static void vgmWriteFrame(VGMExporterData* data, ChipNomadState* state, int isRefresh) {
+  for (int chip = 0; chip < data->numChips; chip++) {
+    SoundChip* soundChip = &state->chips[chip];
+    VGMChipData* chipData = (VGMChipData*)soundChip->userdata;
+
+    for (int reg = 0; reg < VGM_REGS; reg++) {
+      uint16_t bit = 1 << reg;
+      if (!(chipData->setMask & bit)) continue;
+
+      uint8_t value = soundChip->regs[reg];
+      if (reg == VGM_TRIGGER_REG) {
+        if (!chipData->isTriggered) continue;
+      } else if (!isRefresh && (chipData->writtenMask & bit) && chipData->lastRegs[reg] == value) {
+        continue;
+      }
+
+      vgmFlushWait(data);
+      uint8_t command[3] = {VGM_CMD_AY_WRITE, (uint8_t)(reg | (chip << 7)), value};
+      vgmWrite(data, command, 3);
+      chipData->lastRegs[reg] = value;
+      chipData->writtenMask |= bit;
+    }
+    chipData->isTriggered = 0;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Duration analysis
+//
+
+static ChipNomadState* analysisState(Project* project, int startRow, int loop) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return NULL;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, VGM_SAMPLE_RATE, createChipNull);
+  playbackStartSong(&state->playbackState, startRow, 0, loop);
+  return state;
+}
+
+// Position of a track in the song, larger further in the song
+static int songPosition(PlaybackTrackState* track) {
+  if (track->mode != playbackModeSong || track->songRow == EMPTY_VALUE_16) return -1;
+  return track->songRow * 16 + track->chainRow;
+}
+
+// Plays the song without and with looping side by side. On the frame where
+// the song stops, the looping playback jumps back. If all tracks jump to the
+// same song row and none jumped earlier, the song loops from the first frame
+// of that row, and the frame where it stops isn't exported.
+// Returns 0 on success
+static int vgmAnalyze(VGMExporterData* data, Project* project) {
+  ChipNomadState* once = analysisState(project, data->startRow, 0);
+  ChipNomadState* looped = analysisState(project, data->startRow, 1);
+  int* rowFrames = malloc(PROJECT_MAX_LENGTH * sizeof(int));
+  if (!once || !looped || !rowFrames) {
+    chipnomadDestroy(once);
+    chipnomadDestroy(looped);
+    free(rowFrames);
+    return 1;
+  }
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) rowFrames[c] = -1;
+
+  int maxFrames = (int)(project->tickRate * VGM_MAX_SECONDS);
+  int tracksCount = project->tracksCount;
+  int hasJumped = 0; // The looping playback jumped back before the song stopped
+  data->framesTotal = maxFrames;
+  data->loopFrame = -1;
+
+  for (int frame = 0; frame < maxFrames; frame++) {
+    int positions[PROJECT_MAX_TRACKS];
+    for (int c = 0; c < tracksCount; c++) {
+      positions[c] = songPosition(&looped->playbackState.tracks[c]);
+    }
+
+    int isStopped = playbackNextFrame(&once->playbackState, once->chips);
+    playbackNextFrame(&looped->playbackState, looped->chips);
+
+    int loopRow = -1; // Song row the tracks jumped back to
+    int isSplit = 0; // Tracks jumped to different rows
+    for (int c = 0; c < tracksCount; c++) {
+      PlaybackTrackState* track = &looped->playbackState.tracks[c];
+      int position = songPosition(track);
+      if (position < 0) continue;
+
+      if (positions[c] >= 0 && position < positions[c]) {
+        if (loopRow >= 0 && loopRow != track->songRow) isSplit = 1;
+        loopRow = track->songRow;
+      }
+      if (rowFrames[track->songRow] < 0) rowFrames[track->songRow] = frame;
+    }
+
+    if (isStopped) {
+      data->framesTotal = frame + 1;
+      if (!hasJumped && !isSplit && loopRow >= 0 && rowFrames[loopRow] >= 0 && rowFrames[loopRow] < frame) {
+        data->framesTotal = frame;
+        data->loopFrame = rowFrames[loopRow];
+      }
+      break;
+    }
+    if (loopRow >= 0) hasJumped = 1;
+  }
+
+  chipnomadDestroy(once);
+  chipnomadDestroy(looped);
+  free(rowFrames);
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Exporter
+//
+
+// First sample of the frame
+static uint32_t framePosition(float tickRate, int frame) {
+  return (uint32_t)((double)frame * VGM_SAMPLE_RATE / tickRate + 0.5);
+}
+
+static void writeVGMHeader(VGMExporterData* data, Project* project, uint8_t* header) {
+  memset(header, 0, VGM_HEADER_SIZE);
+
+  uint32_t totalSamples = framePosition(project->tickRate, data->framesTotal);
+  uint32_t clock = (uint32_t)project->chipSetup.ay.clock;
+  if (data->numChips > 1) clock |= VGM_CLOCK_DUAL;
+
+  memcpy(header, "Vgm ", 4);
+  writeLE32(header + 0x04, data->dataSize - 0x04); // EOF offset
+  writeLE32(header + 0x08, VGM_VERSION);
+  writeLE32(header + 0x18, totalSamples);
+  if (data->loopFrame >= 0) {
+    writeLE32(header + 0x1c, data->loopOffset - 0x1c);
+    writeLE32(header + 0x20, totalSamples - framePosition(project->tickRate, data->loopFrame));
+  }
+  // Players only understand PAL or NTSC rate
+  if (project->tickRate == 50.0f || project->tickRate == 60.0f) writeLE32(header + 0x24, (uint32_t)project->tickRate);
+  writeLE32(header + 0x34, VGM_HEADER_SIZE - 0x34); // Data offset
+  writeLE32(header + 0x74, clock);
+  header[0x78] = project->chipSetup.ay.isYM ? VGM_AY_TYPE_YM2149 : VGM_AY_TYPE_AY8910;
+  header[0x79] = VGM_AY_FLAGS_LEGACY;
+}
+
+static int vgmNext(Exporter* self) {
+  VGMExporterData* data = (VGMExporterData*)self->data;
+  ChipNomadState* state = self->chipnomadState;
+
+  // Analysis runs here instead of on creation, so background exporters do it on their thread
+  if (!data->isAnalyzed) {
+    if (vgmAnalyze(data, &state->project)) {
+      data->failed = 1;
+      data->framesTotal = 0;
+    }
+    data->isAnalyzed = 1;
+  }
+  if (state->framesCount >= data->framesTotal) return -1;
+
+  int framesPerChunk = (int)(state->project.tickRate * 10 + 0.5f); // 10 seconds
+  int framesRendered = 0;
+
+  while (framesRendered < framesPerChunk && state->framesCount < data->framesTotal) {
+    int frame = state->framesCount;
+    playbackNextFrame(&state->playbackState, state->chips);
+
+    if (frame == data->loopFrame) {
+      vgmFlushWait(data);
+      data->loopOffset = data->dataSize;
+    }
+    vgmWriteFrame(data, state, frame == data->loopFrame);
+    data->pendingSamples += framePosition(state->project.tickRate, frame + 1) -
+      framePosition(state->project.tickRate, frame);
+
+    state->framesCount++;
+    framesRendered++;
+  }
+
+  if (state->framesCount >= data->framesTotal) return -1;
+
+  data->renderedSeconds += 10;
+  return data->renderedSeconds;
+}
+
+static int vgmFinish(Exporter* self) {
+  VGMExporterData* data = (VGMExporterData*)self->data;
+
+  vgmFlushWait(data);
+  uint8_t end = VGM_CMD_END;
+  vgmWrite(data, &end, 1);
+  vgmFlush(data);
+
+  uint8_t header[VGM_HEADER_SIZE];
+  writeVGMHeader(data, &self->chipnomadState->project, header);
+  fileSeek(data->fileId, 0, 0);
+  if (fileWrite(data->fileId, header, VGM_HEADER_SIZE) != VGM_HEADER_SIZE) data->failed = 1;
+  int result = data->failed;
+
+  chipnomadDestroy(self->chipnomadState);
+  // A full disk may only show when the file is closed
+  if (fileClose(data->fileId)) result = 1;
+  if (result) fileDelete(data->filename);
+  free(data);
+  free(self);
+  return result;
+}
+
+static void vgmCancel(Exporter* self) {
+  VGMExporterData* data = (VGMExporterData*)self->data;
+
+  chipnomadDestroy(self->chipnomadState);
+  fileClose(data->fileId);
+  fileDelete(data->filename);
+  free(data);
+  free(self);
+}
+
+Exporter* createVGMExporter(const char* filename, Project* project, int startRow) {
+  if (project->chipsCount > VGM_MAX_CHIPS) return NULL;
+
+  Exporter* exporter = malloc(sizeof(Exporter));
+  if (!exporter) return NULL;
+
+  VGMExporterData* data = calloc(1, sizeof(VGMExporterData));
+  if (!data) {
+    free(exporter);
+    return NULL;
+  }
+  snprintf(data->filename, sizeof(data->filename), "%s", filename);
+  data->numChips = project->chipsCount;
+  data->startRow = startRow;
+  data->loopFrame = -1;
+
+  data->fileId = fileOpen(filename, 1);
+  if (data->fileId == -1) {
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  exporter->chipnomadState = chipnomadCreate();
+  if (!exporter->chipnomadState) {
+    fileClose(data->fileId);
+    fileDelete(filename);
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  // Header is written when the export is done, reserve space for it
+  uint8_t header[VGM_HEADER_SIZE];
+  memset(header, 0, VGM_HEADER_SIZE);
+  vgmWrite(data, header, VGM_HEADER_SIZE);
+
+  // Copy project data and reinitialize playback
+  exporter->chipnomadState->project = *project;
+  playbackInit(&exporter->chipnomadState->playbackState, &exporter->chipnomadState->project);
+  chipnomadInitChips(exporter->chipnomadState, VGM_SAMPLE_RATE, vgmChipFactory);
+  playbackStartSong(&exporter->chipnomadState->playbackState, startRow, 0, 0);
+
+  exporter->data = data;
+  exporter->next = vgmNext;
+  exporter->finish = vgmFinish;
+  exporter->cancel = vgmCancel;
+
+  return exporter;
+}
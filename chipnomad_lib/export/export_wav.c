@@ -3,13 +3,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <math.h>
 #include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
 #include "playback.h"
 #include "chips/chips.h"
 #include "chipnomad_lib.h"
 
 
 
+// Loudness normalization of a WAV export. Audio is rendered as float32 to
+// a temporary WAV file, and finish copies it to the output with the gain
+typedef struct {
+  int isEnabled;
+  float targetLUFS;
+  float truePeakLimit;
+  int outputFileId;
+  int bitDepth; // Output bit depth
+  char renderPath[1040];
+} WAVNormalization;
+
 // WAV implementation data
 typedef struct {
   int fileId;
@@ -19,23 +32,34 @@ typedef struct {
   int totalSamples;
   int allTracksStopped;
   int renderedSeconds;
+  float* buffer; // One second of rendered audio
+  uint8_t* block; // The same audio converted to the output format
+  LoudnessMeter* meter;
+  WAVNormalization normalization;
   char filename[1024];
 } WAVExporterData;
 
 // WAV Stems implementation data
 typedef struct {
-  int* fileIds;
+  int* fileIds; // One file per track, then the mix if enabled
+  int filesCount;
   int trackCount;
-  int currentTrack;
+  int withMix;
   int sampleRate;
   int channels;
   int bitDepth;
   int totalSamples;
   int allTracksStopped;
   int renderedSeconds;
+  float** buffers; // One chunk of audio per track
+  float* mixBuffer;
+  uint8_t* block;
   char basePath[512];
 } WAVStemsExporterData;
 
+#define WAV_STEMS_CHUNK (4096)
+#define WAV_NORMALIZE_CHUNK (8192)
+
 typedef struct {
   char riff[4];
   uint32_t fileSize;
@@ -52,51 +76,241 @@ typedef struct {
   uint32_t dataSize;
 } WAVHeader;
 
-static void writeWAVHeader(int fileId, int sampleRate, int channels, int bitDepth, int dataSize) {
+// extraSize is the size of chunks after the data
+static void fillWAVHeader(WAVHeader* header, int sampleRate, int channels, int bitDepth, int dataSize, int extraSize) {
+  memcpy(header->riff, "RIFF", 4);
+  header->fileSize = 36 + dataSize + extraSize;
+  memcpy(header->wave, "WAVE", 4);
+  memcpy(header->fmt, "fmt ", 4);
+  header->fmtSize = 16;
+  header->audioFormat = (bitDepth == 32) ? 3 : 1;
+  header->channels = channels;
+  header->sampleRate = sampleRate;
+  header->bitsPerSample = bitDepth;
+  header->byteRate = sampleRate * channels * (bitDepth / 8);
+  header->blockAlign = channels * (bitDepth / 8);
+  memcpy(header->data, "data", 4);
+  header->dataSize = dataSize;
+}
+
+static void writeWAVHeader(int fileId, int sampleRate, int channels, int bitDepth, int dataSize, int extraSize) {
   WAVHeader header;
+  fillWAVHeader(&header, sampleRate, channels, bitDepth, dataSize, extraSize);
+  fileWrite(fileId, &header, sizeof(WAVHeader));
+}
 
-  memcpy(header.riff, "RIFF", 4);
-  header.fileSize = 36 + dataSize;
-  memcpy(header.wave, "WAVE", 4);
-  memcpy(header.fmt, "fmt ", 4);
-  header.fmtSize = 16;
-  header.audioFormat = (bitDepth == 32) ? 3 : 1;
-  header.channels = channels;
-  header.sampleRate = sampleRate;
-  header.bitsPerSample = bitDepth;
-  header.byteRate = sampleRate * channels * (bitDepth / 8);
-  header.blockAlign = channels * (bitDepth / 8);
-  memcpy(header.data, "data", 4);
-  header.dataSize = dataSize;
+// Allocate render buffer and output block for one second of audio
+static int allocBuffers(float** buffer, uint8_t** block, int sampleRate, int channels) {
+  *buffer = malloc(sampleRate * channels * sizeof(float));
+  *block = malloc(sampleRate * channels * 4);
+  if (!*buffer || !*block) {
+    free(*buffer);
+    free(*block);
+    return 1;
+  }
+  return 0;
+}
 
-  fileWrite(fileId, &header, sizeof(WAVHeader));
+// Convert samples to the output format in one pass. Clamping is done in float
+// so the loops have no branches and can be vectorized by the compiler
+static int convertBlock(uint8_t* block, const float* buffer, int count, int bitDepth) {
+  if (bitDepth == 16) {
+    int16_t* out = (int16_t*)block;
+    for (int i = 0; i < count; i++) {
+      float sample = buffer[i] * 32767.0f;
+      sample = sample > 32767.0f ? 32767.0f : sample;
+      sample = sample < -32768.0f ? -32768.0f : sample;
+      out[i] = (int16_t)sample;
+    }
+    return count * 2;
+  } else if (bitDepth == 24) {
+    for (int i = 0; i < count; i++) {
+      float sample = buffer[i] * 8388607.0f;
+      sample = sample > 8388607.0f ? 8388607.0f : sample;
+      sample = sample < -8388608.0f ? -8388608.0f : sample;
+      int value = (int)sample;
+      block[i * 3] = value & 0xFF;
+      block[i * 3 + 1] = (value >> 8) & 0xFF;
+      block[i * 3 + 2] = (value >> 16) & 0xFF;
+    }
+    return count * 3;
+  } else if (bitDepth == 32) {
+    memcpy(block, buffer, count * sizeof(float));
+    return count * 4;
+  }
+  return 0;
 }
 
-static int wavExportWrite(WAVExporterData* data, float* buffer, int samples) {
-  if (data->bitDepth == 16) {
-    for (int i = 0; i < samples * data->channels; i++) {
-      int sample = (int)(buffer[i] * 32767.0f);
-      if (sample > 32767) sample = 32767;
-      if (sample < -32768) sample = -32768;
-      int16_t finalSample = (int16_t)sample;
-      fileWrite(data->fileId, &finalSample, sizeof(int16_t));
+static int writeBlock(int fileId, uint8_t* block, const float* buffer, int samples, int channels, int bitDepth) {
+  int length = convertBlock(block, buffer, samples * channels, bitDepth);
+  return (fileWrite(fileId, block, length) == length) ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Loudness. WAV exporters measure the mix while rendering and store the
+// results as a comment in a LIST chunk after the data.
+//
+
+#define WAV_LOUDNESS_FORMAT "Loudness: %.2f LUFS integrated, %.2f dBTP true peak, %.2f dBFS sample peak, %+.2f dB gain"
+#define WAV_LOUDNESS_SCAN "Loudness: %f LUFS integrated, %f dBTP true peak, %f dBFS sample peak, %f dB gain"
+
+// Append the LIST chunk after the data. Returns its size, 0 if it couldn't be written
+static int writeLoudnessChunk(int fileId, int dataSize, const LoudnessStats* stats) {
+  uint8_t chunk[160];
+  char* text = (char*)chunk + 20;
+  int textSize = snprintf(text, sizeof(chunk) - 20, WAV_LOUDNESS_FORMAT,
+    stats->integrated, stats->truePeak, stats->samplePeak, stats->gain) + 1;
+  if (textSize > (int)sizeof(chunk) - 21) return 0;
+  if (textSize & 1) text[textSize++] = 0;
+
+  memcpy(chunk, "LIST", 4);
+  writeLE32(chunk + 4, 12 + textSize);
+  memcpy(chunk + 8, "INFO", 4);
+  memcpy(chunk + 12, "ICMT", 4);
+  writeLE32(chunk + 16, textSize);
+
+  int size = 20 + textSize;
+  fileSeek(fileId, sizeof(WAVHeader) + (long)dataSize, 0);
+  return fileWrite(fileId, chunk, size) == size ? size : 0;
+}
+
+int wavReadLoudness(const char* filename, LoudnessStats* stats) {
+  int fileId = fileOpen(filename, 0);
+  if (fileId == -1) return 1;
+
+  uint8_t header[12];
+  int result = 1;
+  if (fileRead(fileId, header, 12) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) {
+    fileClose(fileId);
+    return 1;
+  }
+
+  uint8_t chunk[160];
+  while (result && fileRead(fileId, chunk, 8) == 8) {
+    uint32_t size = readLE32(chunk + 4);
+    uint32_t padded = size + (size & 1);
+
+    if (memcmp(chunk, "LIST", 4) || size > sizeof(chunk) - 1) {
+      if (fileSeek(fileId, padded, SEEK_CUR)) break;
+      continue;
     }
-  } else if (data->bitDepth == 24) {
-    for (int i = 0; i < samples * data->channels; i++) {
-      int sample = (int)(buffer[i] * 8388607.0f);
-      if (sample > 8388607) sample = 8388607;
-      if (sample < -8388608) sample = -8388608;
-      uint8_t bytes[3] = {sample & 0xFF, (sample >> 8) & 0xFF, (sample >> 16) & 0xFF};
-      fileWrite(data->fileId, bytes, 3);
+
+    if (fileRead(fileId, chunk, padded) != (int)padded) break;
+    chunk[size] = 0;
+    // Subchunks of INFO
+    for (uint32_t pos = 4; !memcmp(chunk, "INFO", 4) && pos + 8 <= size;) {
+      uint32_t subSize = readLE32(chunk + pos + 4);
+      if (pos + 8 + subSize > size) break;
+      if (!memcmp(chunk + pos, "ICMT", 4) && sscanf((char*)chunk + pos + 8, WAV_LOUDNESS_SCAN,
+        &stats->integrated, &stats->truePeak, &stats->samplePeak, &stats->gain) == 4) {
+        result = 0;
+        break;
+      }
+      pos += 8 + subSize + (subSize & 1);
+    }
+  }
+
+  fileClose(fileId);
+  return result;
+}
+
+// Redirect the render to a float32 temporary file. Returns 1 on failure
+static int startNormalization(WAVNormalization* normalization, int* fileId, int* bitDepth,
+  const char* filename, int sampleRate, int channels, float targetLUFS, float truePeakLimit) {
+  snprintf(normalization->renderPath, sizeof(normalization->renderPath), "%s.tmp", filename);
+  int renderFileId = fileOpen(normalization->renderPath, 1);
+  if (renderFileId == -1) return 1;
+  writeWAVHeader(renderFileId, sampleRate, channels, 32, 0, 0);
+
+  normalization->isEnabled = 1;
+  normalization->targetLUFS = targetLUFS;
+  normalization->truePeakLimit = truePeakLimit;
+  normalization->outputFileId = *fileId;
+  normalization->bitDepth = *bitDepth;
+  *fileId = renderFileId;
+  *bitDepth = 32;
+  return 0;
+}
+
+// Close and delete the temporary file, and close the output
+static void cancelNormalization(WAVNormalization* normalization, int renderFileId) {
+  fileClose(renderFileId);
+  fileClose(normalization->outputFileId);
+  fileDelete(normalization->renderPath);
+  normalization->isEnabled = 0;
+}
+
+// Copy the float32 render to the output with the gain that brings it to
+// the target loudness, and adjust stats to match. Returns 1 on failure
+static int normalize(WAVNormalization* normalization, int renderFileId, int totalSamples, int channels, LoudnessStats* stats) {
+  float gain = loudnessNormalizationGain(stats, normalization->targetLUFS, normalization->truePeakLimit);
+  float scale = powf(10.0f, gain / 20.0f);
+
+  // The render is complete only if its buffered writes made it to the disk
+  int result = fileClose(renderFileId) != 0;
+  renderFileId = fileOpen(normalization->renderPath, 0);
+  float* buffer = malloc(WAV_NORMALIZE_CHUNK * channels * sizeof(float));
+  uint8_t* block = malloc(WAV_NORMALIZE_CHUNK * channels * 4);
+
+  if (renderFileId == -1 || !buffer || !block) result = 1;
+  if (!result) {
+    fileSeek(renderFileId, sizeof(WAVHeader), 0);
+    fileSeek(normalization->outputFileId, sizeof(WAVHeader), 0);
+  }
+  for (int done = 0; !result && done < totalSamples;) {
+    int samples = totalSamples - done;
+    if (samples > WAV_NORMALIZE_CHUNK) samples = WAV_NORMALIZE_CHUNK;
+    int length = samples * channels * sizeof(float);
+    if (fileRead(renderFileId, buffer, length) != length) {
+      result = 1;
+      break;
     }
-  } else if (data->bitDepth == 32) {
-    for (int i = 0; i < samples * data->channels; i++) {
-      float sample = buffer[i];
-      fileWrite(data->fileId, &sample, sizeof(float));
+    for (int i = 0; i < samples * channels; i++) {
+      buffer[i] *= scale;
     }
+    result = writeBlock(normalization->outputFileId, block, buffer, samples, channels, normalization->bitDepth);
+    done += samples;
   }
+
+  free(buffer);
+  free(block);
+  if (renderFileId != -1) fileClose(renderFileId);
+  fileDelete(normalization->renderPath);
+  normalization->isEnabled = 0;
+
+  if (stats->integrated > LOUDNESS_FLOOR_DB) stats->integrated += gain;
+  if (stats->truePeak > LOUDNESS_FLOOR_DB) stats->truePeak += gain;
+  if (stats->samplePeak > LOUDNESS_FLOOR_DB) stats->samplePeak += gain;
+  stats->gain = gain;
+  return result;
+}
+
+// Normalize if enabled, append the loudness and write the final header.
+// meter is NULL if loudness is unknown. Returns 1 on failure
+static int finishWAVFile(int* fileId, WAVNormalization* normalization, const LoudnessMeter* meter,
+  int sampleRate, int channels, int* bitDepth, int totalSamples) {
+  LoudnessStats stats = {LOUDNESS_FLOOR_DB, LOUDNESS_FLOOR_DB, LOUDNESS_FLOOR_DB, 0};
+  if (meter) loudnessGetStats(meter, &stats);
+
+  int result = 0;
+  if (normalization->isEnabled) {
+    result = normalize(normalization, *fileId, totalSamples, channels, &stats);
+    *fileId = normalization->outputFileId;
+    *bitDepth = normalization->bitDepth;
+  }
+
+  int dataSize = totalSamples * channels * (*bitDepth / 8);
+  int extraSize = meter ? writeLoudnessChunk(*fileId, dataSize, &stats) : 0;
+  fileSeek(*fileId, 0, 0);
+  writeWAVHeader(*fileId, sampleRate, channels, *bitDepth, dataSize, extraSize);
+  return result;
+}
+
+static int wavExportWrite(WAVExporterData* data, float* buffer, int samples) {
   data->totalSamples += samples;
-  return 0;
+  loudnessAdd(data->meter, buffer, samples);
+  return writeBlock(data->fileId, data->block, buffer, samples, data->channels, data->bitDepth);
 }
 
 // WAV exporter methods
@@ -104,11 +318,10 @@ static int wavNext(Exporter* self) {
   WAVExporterData* data = (WAVExporterData*)self->data;
   if (data->allTracksStopped) return -1;
 
-  float buffer[data->sampleRate * 2];
-  int samplesRendered = chipnomadRender(self->chipnomadState, buffer, data->sampleRate);
+  int samplesRendered = chipnomadRender(self->chipnomadState, data->buffer, data->sampleRate);
 
   if (samplesRendered > 0) {
-    wavExportWrite(data, buffer, samplesRendered);
+    wavExportWrite(data, data->buffer, samplesRendered);
   }
 
   if (samplesRendered < data->sampleRate) {
@@ -122,23 +335,34 @@ static int wavNext(Exporter* self) {
 static int wavFinish(Exporter* self) {
   WAVExporterData* data = (WAVExporterData*)self->data;
 
-  int dataSize = data->totalSamples * data->channels * (data->bitDepth / 8);
-  fileSeek(data->fileId, 0, 0);
-  writeWAVHeader(data->fileId, data->sampleRate, data->channels, data->bitDepth, dataSize);
+  int result = finishWAVFile(&data->fileId, &data->normalization, data->meter,
+    data->sampleRate, data->channels, &data->bitDepth, data->totalSamples);
 
   chipnomadDestroy(self->chipnomadState);
-  fileClose(data->fileId);
+  // A full disk may only show when the file is closed
+  if (fileClose(data->fileId)) result = 1;
+  if (result) fileDelete(data->filename);
+  loudnessFree(data->meter);
+  free(data->buffer);
+  free(data->block);
   free(data);
   free(self);
-  return 0;
+  return result;
 }
 
 static void wavCancel(Exporter* self) {
   WAVExporterData* data = (WAVExporterData*)self->data;
 
   chipnomadDestroy(self->chipnomadState);
-  fileClose(data->fileId);
+  if (data->normalization.isEnabled) {
+    cancelNormalization(&data->normalization, data->fileId);
+  } else {
+    fileClose(data->fileId);
+  }
   fileDelete(data->filename);
+  loudnessFree(data->meter);
+  free(data->buffer);
+  free(data->block);
   free(data);
   free(self);
 }
@@ -147,14 +371,24 @@ Exporter* createWAVExporter(const char* filename, Project* project, int startRow
   Exporter* exporter = malloc(sizeof(Exporter));
   if (!exporter) return NULL;
 
-  WAVExporterData* data = malloc(sizeof(WAVExporterData));
+  WAVExporterData* data = calloc(1, sizeof(WAVExporterData));
   if (!data) {
     free(exporter);
     return NULL;
   }
 
-  data->fileId = fileOpen(filename, 1);
+  if (allocBuffers(&data->buffer, &data->block, sampleRate, 2)) {
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  data->meter = loudnessCreate(sampleRate, 0);
+  data->fileId = data->meter ? fileOpen(filename, 1) : -1;
   if (data->fileId == -1) {
+    loudnessFree(data->meter);
+    free(data->buffer);
+    free(data->block);
     free(data);
     free(exporter);
     return NULL;
@@ -169,12 +403,15 @@ Exporter* createWAVExporter(const char* filename, Project* project, int startRow
   strncpy(data->filename, filename, sizeof(data->filename) - 1);
   data->filename[sizeof(data->filename) - 1] = 0;
 
-  writeWAVHeader(data->fileId, sampleRate, 2, bitDepth, 0);
+  writeWAVHeader(data->fileId, sampleRate, 2, bitDepth, 0, 0);
 
   // Create ChipNomad state and initialize
   exporter->chipnomadState = chipnomadCreate();
   if (!exporter->chipnomadState) {
     fileClose(data->fileId);
+    loudnessFree(data->meter);
+    free(data->buffer);
+    free(data->block);
     free(data);
     free(exporter);
     return NULL;
@@ -201,36 +438,56 @@ Exporter* createWAVExporter(const char* filename, Project* project, int startRow
 }
 
 // WAV Stems exporter methods
+static void stemFilename(char* buffer, int size, WAVStemsExporterData* data, int fileIdx) {
+  if (fileIdx < data->trackCount) {
+    snprintf(buffer, size, "%s-%02d.wav", data->basePath, fileIdx + 1);
+  } else {
+    snprintf(buffer, size, "%s-mix.wav", data->basePath);
+  }
+}
+
+static void wavStemsFree(WAVStemsExporterData* data) {
+  if (data->buffers) free(data->buffers[0]);
+  free(data->buffers);
+  free(data->mixBuffer);
+  free(data->block);
+  free(data->fileIds);
+  free(data);
+}
+
 static int wavStemsNext(Exporter* self) {
   WAVStemsExporterData* data = (WAVStemsExporterData*)self->data;
   if (data->allTracksStopped) return -1;
 
-  float buffer[data->sampleRate * 2];
-  int samplesRendered = chipnomadRender(self->chipnomadState, buffer, data->sampleRate);
+  // All stems and the mix come from a single playback pass
+  for (int rendered = 0; rendered < data->sampleRate;) {
+    int samples = data->sampleRate - rendered;
+    if (samples > WAV_STEMS_CHUNK) samples = WAV_STEMS_CHUNK;
 
-  if (samplesRendered > 0) {
-    wavExportWrite((WAVExporterData*)&(WAVExporterData){
-      .fileId = data->fileIds[data->currentTrack],
-      .sampleRate = data->sampleRate,
-      .channels = data->channels,
-      .bitDepth = data->bitDepth,
-      .totalSamples = 0
-    }, buffer, samplesRendered);
-    data->totalSamples += samplesRendered;
-  }
+    int samplesRendered = chipnomadRenderChannels(self->chipnomadState, data->buffers, samples);
 
-  if (samplesRendered < data->sampleRate) {
-    data->currentTrack++;
-    if (data->currentTrack >= data->trackCount) {
-      data->allTracksStopped = 1;
-      return -1;
+    if (samplesRendered > 0) {
+      for (int t = 0; t < data->trackCount; t++) {
+        writeBlock(data->fileIds[t], data->block, data->buffers[t], samplesRendered, data->channels, data->bitDepth);
+      }
+
+      if (data->withMix) {
+        memcpy(data->mixBuffer, data->buffers[0], samplesRendered * 2 * sizeof(float));
+        for (int t = 1; t < data->trackCount; t++) {
+          for (int i = 0; i < samplesRendered * 2; i++) {
+            data->mixBuffer[i] += data->buffers[t][i];
+          }
+        }
+        writeBlock(data->fileIds[data->trackCount], data->block, data->mixBuffer, samplesRendered, data->channels, data->bitDepth);
+      }
+      data->totalSamples += samplesRendered;
     }
 
-    playbackStartSong(&self->chipnomadState->playbackState, 0, 0, 0);
-    for (int t = 0; t < PROJECT_MAX_TRACKS; t++) {
-      self->chipnomadState->playbackState.trackEnabled[t] = (t == data->currentTrack) ? 1 : 0;
+    if (samplesRendered < samples) {
+      data->allTracksStopped = 1;
+      return -1;
     }
-    data->totalSamples = 0;
+    rendered += samplesRendered;
   }
 
   return ++data->renderedSeconds;
@@ -239,88 +496,103 @@ static int wavStemsNext(Exporter* self) {
 static int wavStemsFinish(Exporter* self) {
   WAVStemsExporterData* data = (WAVStemsExporterData*)self->data;
 
-  for (int i = 0; i < data->trackCount; i++) {
-    int dataSize = data->totalSamples * data->channels * (data->bitDepth / 8);
+  int result = 0;
+  int dataSize = data->totalSamples * data->channels * (data->bitDepth / 8);
+  for (int i = 0; i < data->filesCount; i++) {
     fileSeek(data->fileIds[i], 0, 0);
-    writeWAVHeader(data->fileIds[i], data->sampleRate, data->channels, data->bitDepth, dataSize);
-    fileClose(data->fileIds[i]);
+    writeWAVHeader(data->fileIds[i], data->sampleRate, data->channels, data->bitDepth, dataSize, 0);
+    // A full disk may only show when the file is closed
+    if (fileClose(data->fileIds[i])) result = 1;
+  }
+
+  // No partial set of stems is left behind
+  for (int i = 0; result && i < data->filesCount; i++) {
+    char filename[1024];
+    stemFilename(filename, sizeof(filename), data, i);
+    fileDelete(filename);
   }
 
   chipnomadDestroy(self->chipnomadState);
-  free(data->fileIds);
-  free(data);
+  wavStemsFree(data);
   free(self);
-  return 0;
+  return result;
 }
 
 static void wavStemsCancel(Exporter* self) {
   WAVStemsExporterData* data = (WAVStemsExporterData*)self->data;
 
-  for (int i = 0; i < data->trackCount; i++) {
+  for (int i = 0; i < data->filesCount; i++) {
     fileClose(data->fileIds[i]);
     char filename[1024];
-    snprintf(filename, sizeof(filename), "%s-%02d.wav", data->basePath, i + 1);
+    stemFilename(filename, sizeof(filename), data, i);
     fileDelete(filename);
   }
 
   chipnomadDestroy(self->chipnomadState);
-  free(data->fileIds);
-  free(data);
+  wavStemsFree(data);
   free(self);
 }
 
-Exporter* createWAVStemsExporter(const char* basePath, Project* project, int startRow, int sampleRate, int bitDepth) {
+Exporter* createWAVStemsExporter(const char* basePath, Project* project, int startRow, int sampleRate, int bitDepth, int withMix) {
   Exporter* exporter = malloc(sizeof(Exporter));
   if (!exporter) return NULL;
 
-  WAVStemsExporterData* data = malloc(sizeof(WAVStemsExporterData));
+  WAVStemsExporterData* data = calloc(1, sizeof(WAVStemsExporterData));
   if (!data) {
     free(exporter);
     return NULL;
   }
 
-  int trackCount = project->chipsCount * 3;
-  data->fileIds = malloc(sizeof(int) * trackCount);
-  if (!data->fileIds) {
-    free(data);
+  int trackCount = projectGetTotalTracks(project);
+  data->trackCount = trackCount;
+  data->withMix = withMix;
+  data->sampleRate = sampleRate;
+  data->channels = 2;
+  data->bitDepth = bitDepth;
+  strncpy(data->basePath, basePath, sizeof(data->basePath) - 1);
+  data->basePath[sizeof(data->basePath) - 1] = 0;
+
+  data->fileIds = malloc(sizeof(int) * (trackCount + 1));
+  data->buffers = malloc(sizeof(float*) * trackCount);
+  data->mixBuffer = malloc(WAV_STEMS_CHUNK * 2 * sizeof(float));
+  data->block = malloc(WAV_STEMS_CHUNK * 2 * 4);
+  float* trackBuffers = malloc(trackCount * WAV_STEMS_CHUNK * 2 * sizeof(float));
+  if (data->buffers) {
+    for (int t = 0; t < trackCount; t++) {
+      data->buffers[t] = trackBuffers + t * WAV_STEMS_CHUNK * 2;
+    }
+  } else {
+    free(trackBuffers);
+  }
+  if (!data->fileIds || !data->buffers || !trackBuffers || !data->mixBuffer || !data->block) {
+    wavStemsFree(data);
     free(exporter);
     return NULL;
   }
 
-  for (int i = 0; i < trackCount; i++) {
+  int filesCount = trackCount + (withMix ? 1 : 0);
+  for (int i = 0; i < filesCount; i++) {
     char filename[1024];
-    snprintf(filename, sizeof(filename), "%s-%02d.wav", basePath, i + 1);
+    stemFilename(filename, sizeof(filename), data, i);
     data->fileIds[i] = fileOpen(filename, 1);
     if (data->fileIds[i] == -1) {
       for (int j = 0; j < i; j++) {
         fileClose(data->fileIds[j]);
       }
-      free(data->fileIds);
-      free(data);
+      wavStemsFree(data);
       free(exporter);
       return NULL;
     }
-    writeWAVHeader(data->fileIds[i], sampleRate, 2, bitDepth, 0);
+    writeWAVHeader(data->fileIds[i], sampleRate, 2, bitDepth, 0, 0);
   }
-
-  data->trackCount = trackCount;
-  data->currentTrack = 0;
-  data->sampleRate = sampleRate;
-  data->channels = 2;
-  data->bitDepth = bitDepth;
-  data->totalSamples = 0;
-  data->allTracksStopped = 0;
-  data->renderedSeconds = 0;
-  strncpy(data->basePath, basePath, sizeof(data->basePath) - 1);
-  data->basePath[sizeof(data->basePath) - 1] = 0;
+  data->filesCount = filesCount;
 
   exporter->chipnomadState = chipnomadCreate();
   if (!exporter->chipnomadState) {
-    for (int i = 0; i < trackCount; i++) {
+    for (int i = 0; i < filesCount; i++) {
       fileClose(data->fileIds[i]);
     }
-    free(data->fileIds);
-    free(data);
+    wavStemsFree(data);
     free(exporter);
     return NULL;
   }
@@ -331,9 +603,6 @@ Exporter* createWAVStemsExporter(const char* basePath, Project* project, int sta
   chipnomadSetQuality(exporter->chipnomadState, CHIPNOMAD_QUALITY_BEST);
 
   playbackStartSong(&exporter->chipnomadState->playbackState, startRow, 0, 0);
-  for (int t = 0; t < PROJECT_MAX_TRACKS; t++) {
-    exporter->chipnomadState->playbackState.trackEnabled[t] = (t == 0) ? 1 : 0;
-  }
 
   exporter->data = data;
   exporter->next = wavStemsNext;
@@ -343,3 +612,456 @@ Exporter* createWAVStemsExporter(const char* basePath, Project* project, int sta
   return exporter;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parallel WAV exporter. The song is split into segments that are rendered
+// on worker threads. Each worker fast-forwards playback and chips to the
+// segment start and renders a short pre-roll, so the chip filters settle
+// before its first sample is written.
+//
+
+#define WAV_PARALLEL_CHUNK (8192)
+#define WAV_PARALLEL_PREROLL (4096)
+#define WAV_PARALLEL_MAX_SEGMENTS (CORELIB_MAX_THREADS / 2)
+#define WAV_PARALLEL_MIN_SEGMENT_SECONDS (4)
+
+struct WAVParallelExporterData;
+
+typedef struct {
+  struct WAVParallelExporterData* data;
+  int startSample;
+  int endSample;
+  int threadId;
+  int result;
+  LoudnessMeter* meter;
+} WAVSegment;
+
+typedef struct WAVParallelExporterData {
+  int fileId;
+  int fileMutex;
+  int sampleRate;
+  int channels;
+  int bitDepth;
+  int startRow;
+  int totalSamples;
+  int segmentsCount;
+  WAVSegment segments[WAV_PARALLEL_MAX_SEGMENTS];
+  int isStarted;
+  int isJoined;
+  ChipNomadState* config; // Exporter's state, workers copy project and settings from it
+  // Shared with workers, accessed atomically
+  int samplesDone;
+  int segmentsDone;
+  int isCancelled;
+  WAVNormalization normalization;
+  char filename[1024];
+} WAVParallelExporterData;
+
+// Song length in samples, with the same stop logic as the serial exporter
+static int wavSongLength(Project* project, int startRow, int sampleRate) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return -1;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, sampleRate, createChipNull);
+  playbackStartSong(&state->playbackState, startRow, 0, 0);
+
+  int totalSamples = 0;
+  int samples;
+  do {
+    samples = chipnomadSkip(state, sampleRate);
+    totalSamples += samples;
+  } while (samples == sampleRate);
+
+  chipnomadDestroy(state);
+  return totalSamples;
+}
+
+static int wavSegmentRender(void* arg) {
+  WAVSegment* segment = arg;
+  WAVParallelExporterData* data = segment->data;
+  int result = 1;
+
+  ChipNomadState* state = chipnomadCreate();
+  float* buffer = malloc(WAV_PARALLEL_CHUNK * data->channels * sizeof(float));
+  uint8_t* block = malloc(WAV_PARALLEL_CHUNK * data->channels * 4);
+  segment->meter = loudnessCreate(data->sampleRate, segment->startSample);
+  if (!state || !buffer || !block || !segment->meter) goto done;
+
+  state->project = data->config->project;
+  state->mixVolume = data->config->mixVolume;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, data->sampleRate, NULL);
+  chipnomadSetQuality(state, CHIPNOMAD_QUALITY_BEST);
+  playbackStartSong(&state->playbackState, data->startRow, 0, 0);
+
+  int preroll = segment->startSample < WAV_PARALLEL_PREROLL ? segment->startSample : WAV_PARALLEL_PREROLL;
+  int position = 0;
+
+  // Fast-forward, then pre-roll to fill chip and loudness filter history
+  while (position < segment->startSample - preroll) {
+    if (atomicGet(&data->isCancelled)) goto done;
+    int samples = segment->startSample - preroll - position;
+    if (samples > data->sampleRate) samples = data->sampleRate;
+    chipnomadSkip(state, samples);
+    position += samples;
+  }
+  while (position < segment->startSample) {
+    int samples = segment->startSample - position;
+    if (samples > WAV_PARALLEL_CHUNK) samples = WAV_PARALLEL_CHUNK;
+    chipnomadRender(state, buffer, samples);
+    loudnessPrime(segment->meter, buffer, samples);
+    position += samples;
+  }
+
+  int blockAlign = data->channels * (data->bitDepth / 8);
+  while (position < segment->endSample) {
+    if (atomicGet(&data->isCancelled)) goto done;
+    int samples = segment->endSample - position;
+    if (samples > WAV_PARALLEL_CHUNK) samples = WAV_PARALLEL_CHUNK;
+    // Playback may stop inside the chunk. The serial exporter continues with a
+    // new frame in that case, and the song length accounts for it
+    int rendered = chipnomadRender(state, buffer, samples);
+    loudnessAdd(segment->meter, buffer, rendered);
+
+    int length = convertBlock(block, buffer, rendered * data->channels, data->bitDepth);
+    mutexLock(data->fileMutex);
+    fileSeek(data->fileId, sizeof(WAVHeader) + (long)position * blockAlign, 0);
+    int written = fileWrite(data->fileId, block, length);
+    mutexUnlock(data->fileMutex);
+    if (written != length) goto done;
+
+    position += rendered;
+    atomicAdd(&data->samplesDone, rendered);
+  }
+  result = 0;
+
+done:
+  chipnomadDestroy(state);
+  free(buffer);
+  free(block);
+  segment->result = result;
+  atomicAdd(&data->segmentsDone, 1);
+  return result;
+}
+
+static void wavParallelStart(WAVParallelExporterData* data) {
+  for (int i = 0; i < data->segmentsCount; i++) {
+    WAVSegment* segment = &data->segments[i];
+    segment->threadId = threadStart(wavSegmentRender, segment);
+    // No free thread slots, render this segment in place
+    if (segment->threadId == -1) wavSegmentRender(segment);
+  }
+  data->isStarted = 1;
+}
+
+// Returns 0 if all segments were rendered successfully
+static int wavParallelJoin(WAVParallelExporterData* data) {
+  int result = 0;
+  for (int i = 0; i < data->segmentsCount; i++) {
+    WAVSegment* segment = &data->segments[i];
+    if (!data->isJoined && segment->threadId != -1) threadJoin(segment->threadId);
+    if (segment->result) result = 1;
+  }
+  data->isJoined = 1;
+  return result;
+}
+
+// Returns 1 if the output file couldn't be closed
+static int wavParallelFree(Exporter* self) {
+  WAVParallelExporterData* data = (WAVParallelExporterData*)self->data;
+  int result = 0;
+  chipnomadDestroy(self->chipnomadState);
+  mutexDestroy(data->fileMutex);
+  if (data->normalization.isEnabled) {
+    cancelNormalization(&data->normalization, data->fileId);
+  } else {
+    result = fileClose(data->fileId) != 0;
+  }
+  for (int i = 0; i < data->segmentsCount; i++) {
+    loudnessFree(data->segments[i].meter);
+  }
+  free(data);
+  free(self);
+  return result;
+}
+
+static int wavParallelNext(Exporter* self) {
+  WAVParallelExporterData* data = (WAVParallelExporterData*)self->data;
+
+  // Workers start on the first call, after the caller has configured the state
+  if (!data->isStarted) wavParallelStart(data);
+
+  if (atomicGet(&data->segmentsDone) == data->segmentsCount) return -1;
+
+  threadSleep(10);
+  int samplesDone = atomicGet(&data->samplesDone);
+  // Workers don't share a playback state, frames are derived from samples
+  self->chipnomadState->framesCount = (int)((double)samplesDone * self->chipnomadState->project.tickRate / data->sampleRate);
+  return samplesDone / data->sampleRate;
+}
+
+static int wavParallelFinish(Exporter* self) {
+  WAVParallelExporterData* data = (WAVParallelExporterData*)self->data;
+
+  if (!data->isStarted) wavParallelStart(data);
+  int result = wavParallelJoin(data);
+
+  // Segment meters add up to the song's
+  LoudnessMeter* meter = result ? NULL : data->segments[0].meter;
+  for (int i = 1; meter && i < data->segmentsCount; i++) {
+    if (loudnessMerge(meter, data->segments[i].meter)) meter = NULL;
+  }
+
+  result |= finishWAVFile(&data->fileId, &data->normalization, meter,
+    data->sampleRate, data->channels, &data->bitDepth, data->totalSamples);
+
+  char filename[1024];
+  strcpy(filename, data->filename);
+  // A full disk may only show when the file is closed
+  result |= wavParallelFree(self);
+  if (result) fileDelete(filename);
+  return result;
+}
+
+static void wavParallelCancel(Exporter* self) {
+  WAVParallelExporterData* data = (WAVParallelExporterData*)self->data;
+  char filename[1024];
+  strcpy(filename, data->filename);
+
+  atomicSet(&data->isCancelled, 1);
+  if (data->isStarted) wavParallelJoin(data);
+
+  wavParallelFree(self);
+  fileDelete(filename);
+}
+
+Exporter* createWAVExporterParallel(const char* filename, Project* project, int startRow, int sampleRate, int bitDepth, int threadsCount) {
+  int totalSamples = wavSongLength(project, startRow, sampleRate);
+  if (totalSamples < 0) return NULL;
+
+  Exporter* exporter = malloc(sizeof(Exporter));
+  if (!exporter) return NULL;
+
+  WAVParallelExporterData* data = calloc(1, sizeof(WAVParallelExporterData));
+  if (!data) {
+    free(exporter);
+    return NULL;
+  }
+
+  data->fileMutex = mutexCreate();
+  if (data->fileMutex == -1) {
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  data->fileId = fileOpen(filename, 1);
+  if (data->fileId == -1) {
+    mutexDestroy(data->fileMutex);
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  data->sampleRate = sampleRate;
+  data->channels = 2;
+  data->bitDepth = bitDepth;
+  data->startRow = startRow;
+  data->totalSamples = totalSamples;
+  strncpy(data->filename, filename, sizeof(data->filename) - 1);
+  data->filename[sizeof(data->filename) - 1] = 0;
+
+  // One segment per thread, but not shorter than a few seconds
+  if (threadsCount <= 0) threadsCount = threadCPUCount();
+  int segmentsCount = totalSamples / (sampleRate * WAV_PARALLEL_MIN_SEGMENT_SECONDS);
+  if (segmentsCount > threadsCount) segmentsCount = threadsCount;
+  if (segmentsCount > WAV_PARALLEL_MAX_SEGMENTS) segmentsCount = WAV_PARALLEL_MAX_SEGMENTS;
+  if (segmentsCount < 1) segmentsCount = 1;
+
+  data->segmentsCount = segmentsCount;
+  for (int i = 0; i < segmentsCount; i++) {
+    data->segments[i].data = data;
+    data->segments[i].startSample = (int)((long long)totalSamples * i / segmentsCount);
+    data->segments[i].endSample = (int)((long long)totalSamples * (i + 1) / segmentsCount);
+    data->segments[i].threadId = -1;
+  }
+
+  writeWAVHeader(data->fileId, sampleRate, 2, bitDepth, 0, 0);
+
+  // Configuration template for the workers
+  exporter->chipnomadState = chipnomadCreate();
+  if (!exporter->chipnomadState) {
+    fileClose(data->fileId);
+    mutexDestroy(data->fileMutex);
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+  exporter->chipnomadState->project = *project;
+  playbackInit(&exporter->chipnomadState->playbackState, &exporter->chipnomadState->project);
+  playbackStartSong(&exporter->chipnomadState->playbackState, startRow, 0, 0);
+  data->config = exporter->chipnomadState;
+
+  exporter->data = data;
+  exporter->next = wavParallelNext;
+  exporter->finish = wavParallelFinish;
+  exporter->cancel = wavParallelCancel;
+
+  return exporter;
+}
+
+int wavExporterSetNormalization(Exporter* exporter, float targetLUFS, float truePeakLimit) {
+  if (exporter->next == wavNext) {
+    WAVExporterData* data = (WAVExporterData*)exporter->data;
+    if (data->normalization.isEnabled || data->totalSamples > 0) return 1;
+    return startNormalization(&data->normalization, &data->fileId, &data->bitDepth,
+      data->filename, data->sampleRate, data->channels, targetLUFS, truePeakLimit);
+  } else if (exporter->next == wavParallelNext) {
+    WAVParallelExporterData* data = (WAVParallelExporterData*)exporter->data;
+    if (data->normalization.isEnabled || data->isStarted) return 1;
+    return startNormalization(&data->normalization, &data->fileId, &data->bitDepth,
+      data->filename, data->sampleRate, data->channels, targetLUFS, truePeakLimit);
+  }
+  return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Streaming PCM exporter. Writes raw or WAV-framed PCM to a stdio stream
+// (stdout, a pipe) and never seeks. For WAV the song length is found before
+// rendering, so the header goes out first with the exact data size.
+//
+
+typedef struct {
+  FILE* stream;
+  int sampleRate;
+  int channels;
+  int bitDepth;
+  int expectedSamples; // Data size from the header, -1 for raw output
+  int totalSamples;
+  int allTracksStopped;
+  int renderedSeconds;
+  int isFailed;
+  float* buffer;
+  uint8_t* block;
+} PCMStreamExporterData;
+
+static void pcmStreamWrite(PCMStreamExporterData* data, const float* buffer, int samples) {
+  // Keep the stream consistent with the header
+  if (data->expectedSamples >= 0 && data->totalSamples + samples > data->expectedSamples) {
+    samples = data->expectedSamples - data->totalSamples;
+  }
+  if (samples <= 0) return;
+
+  int length = convertBlock(data->block, buffer, samples * data->channels, data->bitDepth);
+  if (fwrite(data->block, 1, length, data->stream) != (size_t)length) data->isFailed = 1;
+  data->totalSamples += samples;
+}
+
+static void pcmStreamFree(Exporter* self) {
+  PCMStreamExporterData* data = (PCMStreamExporterData*)self->data;
+  chipnomadDestroy(self->chipnomadState);
+  free(data->buffer);
+  free(data->block);
+  free(data);
+  free(self);
+}
+
+static int pcmStreamNext(Exporter* self) {
+  PCMStreamExporterData* data = (PCMStreamExporterData*)self->data;
+  if (data->allTracksStopped || data->isFailed) return -1;
+
+  int samplesRendered = chipnomadRender(self->chipnomadState, data->buffer, data->sampleRate);
+  pcmStreamWrite(data, data->buffer, samplesRendered);
+
+  if (samplesRendered < data->sampleRate) {
+    data->allTracksStopped = 1;
+    return -1;
+  }
+
+  return ++data->renderedSeconds;
+}
+
+static int pcmStreamFinish(Exporter* self) {
+  PCMStreamExporterData* data = (PCMStreamExporterData*)self->data;
+
+  // Pad with silence if the song came out shorter than the header says
+  if (data->expectedSamples > data->totalSamples && !data->isFailed) {
+    memset(data->buffer, 0, data->sampleRate * data->channels * sizeof(float));
+    while (data->totalSamples < data->expectedSamples && !data->isFailed) {
+      int samples = data->expectedSamples - data->totalSamples;
+      if (samples > data->sampleRate) samples = data->sampleRate;
+      pcmStreamWrite(data, data->buffer, samples);
+    }
+  }
+
+  int result = (fflush(data->stream) != 0 || data->isFailed) ? 1 : 0;
+  pcmStreamFree(self);
+  return result;
+}
+
+static void pcmStreamCancel(Exporter* self) {
+  PCMStreamExporterData* data = (PCMStreamExporterData*)self->data;
+  fflush(data->stream);
+  pcmStreamFree(self);
+}
+
+Exporter* createPCMStreamExporter(FILE* stream, Project* project, int startRow, int sampleRate, int bitDepth, enum PCMStreamFormat format) {
+  int expectedSamples = -1;
+  if (format == pcmStreamWAV) {
+    expectedSamples = wavSongLength(project, startRow, sampleRate);
+    if (expectedSamples < 0) return NULL;
+  }
+
+  Exporter* exporter = malloc(sizeof(Exporter));
+  if (!exporter) return NULL;
+
+  PCMStreamExporterData* data = calloc(1, sizeof(PCMStreamExporterData));
+  if (!data) {
+    free(exporter);
+    return NULL;
+  }
+
+  if (allocBuffers(&data->buffer, &data->block, sampleRate, 2)) {
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  data->stream = stream;
+  data->sampleRate = sampleRate;
+  data->channels = 2;
+  data->bitDepth = bitDepth;
+  data->expectedSamples = expectedSamples;
+
+  exporter->chipnomadState = chipnomadCreate();
+  if (!exporter->chipnomadState) {
+    free(data->buffer);
+    free(data->block);
+    free(data);
+    free(exporter);
+    return NULL;
+  }
+
+  exporter->chipnomadState->project = *project;
+  playbackInit(&exporter->chipnomadState->playbackState, &exporter->chipnomadState->project);
+  chipnomadInitChips(exporter->chipnomadState, sampleRate, NULL);
+  chipnomadSetQuality(exporter->chipnomadState, CHIPNOMAD_QUALITY_BEST);
+  playbackStartSong(&exporter->chipnomadState->playbackState, startRow, 0, 0);
+
+  if (format == pcmStreamWAV) {
+    WAVHeader header;
+    int dataSize = expectedSamples * data->channels * (bitDepth / 8);
+    fillWAVHeader(&header, sampleRate, data->channels, bitDepth, dataSize, 0);
+    if (fwrite(&header, 1, sizeof(WAVHeader), stream) != sizeof(WAVHeader)) data->isFailed = 1;
+  }
+
+  exporter->data = data;
+  exporter->next = pcmStreamNext;
+  exporter->finish = pcmStreamFinish;
+  exporter->cancel = pcmStreamCancel;
+
+  return exporter;
+}
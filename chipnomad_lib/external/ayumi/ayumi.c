@@ -137,8 +137,60 @@ static void update_mixer(struct ayumi* ay) {
   for (i = 0; i < TONE_CHANNELS; i += 1) {
     out = (update_tone(ay, i) | ay->channels[i].t_off) & (noise | ay->channels[i].n_off);
     out *= ay->channels[i].e_on ? envelope : ay->channels[i].volume * 2 + 1;
-    ay->left += ay->dac_table[out] * ay->channels[i].pan_left;
-    ay->right += ay->dac_table[out] * ay->channels[i].pan_right;
+    ay->channels[i].out = ay->dac_table[out];
+    ay->left += ay->channels[i].out * ay->channels[i].pan_left;
+    ay->right += ay->channels[i].out * ay->channels[i].pan_right;
+  }
+}
+
+/* Advance tone generator by the number of chip ticks */
+static void skip_tone(struct tone_channel* ch, int ticks) {
+  /* Periods are 0 until the first write and then step on every tick */
+  int period = ch->tone_period ? ch->tone_period : 1;
+  int first = ch->tone_counter < period ? period - ch->tone_counter : 1;
+  if (ticks < first) {
+    ch->tone_counter += ticks;
+    return;
+  }
+  ticks -= first;
+  ch->tone ^= (1 + ticks / period) & 1;
+  ch->tone_counter = ticks % period;
+}
+
+static void skip_noise(struct ayumi* ay, int ticks) {
+  int period = ay->noise_period ? ay->noise_period << 1 : 1;
+  int first = ay->noise_counter < period ? period - ay->noise_counter : 1;
+  int steps;
+  int bit0x3;
+  if (ticks < first) {
+    ay->noise_counter += ticks;
+    return;
+  }
+  ticks -= first;
+  steps = 1 + ticks / period;
+  ay->noise_counter = ticks % period;
+  for (; steps > 0; steps -= 1) {
+    bit0x3 = ((ay->noise ^ (ay->noise >> 3)) & 1);
+    ay->noise = (ay->noise >> 1) | (bit0x3 << 16);
+  }
+}
+
+static void skip_envelope(struct ayumi* ay, int ticks) {
+  int period = ay->envelope_period ? ay->envelope_period : 1;
+  int first = ay->envelope_counter < period ? period - ay->envelope_counter : 1;
+  int steps;
+  if (ticks < first) {
+    ay->envelope_counter += ticks;
+    return;
+  }
+  ticks -= first;
+  steps = 1 + ticks / period;
+  ay->envelope_counter = ticks % period;
+  for (; steps > 0; steps -= 1) {
+    void (*step)(struct ayumi*) = Envelopes[ay->envelope_shape][ay->envelope_segment];
+    /* Hold segments never change state */
+    if (step == hold_top || step == hold_bottom) break;
+    step(ay);
   }
 }
 
@@ -245,6 +297,48 @@ void ayumi_process(struct ayumi* ay) {
   ay->right = ay->filter_func(fir_right);
 }
 
+static void interpolate(struct interpolator* interpolator, float y) {
+  float y1;
+  float* c = interpolator->c;
+  float* yy = interpolator->y;
+  yy[0] = yy[1];
+  yy[1] = yy[2];
+  yy[2] = yy[3];
+  yy[3] = y;
+  y1 = yy[2] - yy[0];
+  c[0] = 0.5 * yy[1] + 0.25 * (yy[0] + yy[2]);
+  c[1] = 0.5 * y1;
+  c[2] = 0.25 * (yy[3] - yy[1] - y1);
+}
+
+/* Same as ayumi_process, but every channel goes through its own filter chain */
+void ayumi_process_channels(struct ayumi* ay) {
+  int i;
+  int j;
+  float* fir[TONE_CHANNELS];
+  for (j = 0; j < TONE_CHANNELS; j += 1) {
+    fir[j] = &ay->channel_filters[j].fir[FIR_SIZE - ay->fir_index * DECIMATE_FACTOR];
+  }
+  ay->fir_index = (ay->fir_index + 1) % (FIR_SIZE / DECIMATE_FACTOR - 1);
+  for (i = DECIMATE_FACTOR - 1; i >= 0; i -= 1) {
+    ay->x += ay->step;
+    if (ay->x >= 1) {
+      ay->x -= 1;
+      update_mixer(ay);
+      for (j = 0; j < TONE_CHANNELS; j += 1) {
+        interpolate(&ay->channel_filters[j].interpolator, ay->channels[j].out);
+      }
+    }
+    for (j = 0; j < TONE_CHANNELS; j += 1) {
+      float* c = ay->channel_filters[j].interpolator.c;
+      fir[j][i] = (c[2] * ay->x + c[1]) * ay->x + c[0];
+    }
+  }
+  for (j = 0; j < TONE_CHANNELS; j += 1) {
+    ay->channel_filters[j].out = ay->filter_func(fir[j]);
+  }
+}
+
 static float dc_filter(struct dc_filter* dc, int index, float x) {
   dc->sum += -dc->delay[index] + x;
   dc->delay[index] = x;
@@ -256,3 +350,36 @@ void ayumi_remove_dc(struct ayumi* ay) {
   ay->right = dc_filter(&ay->dc_right, ay->dc_index, ay->right);
   ay->dc_index = (ay->dc_index + 1) & (DC_FILTER_SIZE - 1);
 }
+
+void ayumi_remove_dc_channels(struct ayumi* ay) {
+  int j;
+  for (j = 0; j < TONE_CHANNELS; j += 1) {
+    struct channel_filter* filter = &ay->channel_filters[j];
+    filter->out = dc_filter(&filter->dc, ay->dc_index, filter->out);
+  }
+  ay->dc_index = (ay->dc_index + 1) & (DC_FILTER_SIZE - 1);
+}
+
+void ayumi_skip(struct ayumi* ay, int samples) {
+  int i;
+  int ticks = 0;
+  float x = ay->x;
+  /* Generator periods don't change during the skip, so only the tick
+     count has to be found sample by sample */
+  for (i = samples * DECIMATE_FACTOR; i > 0; i -= 1) {
+    x += ay->step;
+    if (x >= 1) {
+      x -= 1;
+      ticks += 1;
+    }
+  }
+  ay->x = x;
+  ay->fir_index = (ay->fir_index + samples) % (FIR_SIZE / DECIMATE_FACTOR - 1);
+  ay->dc_index = (ay->dc_index + samples) & (DC_FILTER_SIZE - 1);
+
+  skip_noise(ay, ticks);
+  skip_envelope(ay, ticks);
+  for (i = 0; i < TONE_CHANNELS; i += 1) {
+    skip_tone(&ay->channels[i], ticks);
+  }
+}
@@ -23,6 +23,7 @@ struct tone_channel {
   int volume;
   float pan_left;
   float pan_right;
+  float out;
 };
 
 struct interpolator {
@@ -35,6 +36,14 @@ struct dc_filter {
   float delay[DC_FILTER_SIZE];
 };
 
+/* Filter chain for a single channel, used by ayumi_process_channels */
+struct channel_filter {
+  struct interpolator interpolator;
+  float fir[FIR_SIZE * 2];
+  struct dc_filter dc;
+  float out;
+};
+
 struct ayumi {
   struct tone_channel channels[TONE_CHANNELS];
   int noise_period;
@@ -59,6 +68,7 @@ struct ayumi {
   float left;
   float right;
   ayumi_filter_func filter_func;
+  struct channel_filter channel_filters[TONE_CHANNELS];
 };
 
 int ayumi_configure(struct ayumi* ay, int is_ym, float clock_rate, int sr);
@@ -73,5 +83,10 @@ void ayumi_set_envelope_shape(struct ayumi* ay, int shape);
 void ayumi_set_filter_quality(struct ayumi* ay, ayumi_filter_func filter_func);
 void ayumi_process(struct ayumi* ay);
 void ayumi_remove_dc(struct ayumi* ay);
+/* Per-channel output (mono, before panning) in channel_filters[].out */
+void ayumi_process_channels(struct ayumi* ay);
+void ayumi_remove_dc_channels(struct ayumi* ay);
+/* Advance generators exactly like ayumi_process, without producing output */
+void ayumi_skip(struct ayumi* ay, int samples);
 
 #endif
@@ -0,0 +1,273 @@
+#include "loudness.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Loudness as in ITU-R BS.1770-4: K-weighted mean square of 400 ms blocks
+// overlapping by 75%, gated at -70 LUFS and then 10 LU below the loudness
+// of the blocks above that. True peak comes from 4x oversampled audio.
+
+#define ABSOLUTE_GATE (-70.0)
+#define RELATIVE_GATE (-10.0)
+#define BLOCK_STEPS (4)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// K-weighting filters for any sample rate, from the analog prototypes of the
+// 48 kHz coefficients in the specification
+static void initKWeighting(LoudnessMeter* meter) {
+  double fs = meter->sampleRate;
+
+  // High shelf, +4 dB above 1.5 kHz
+  double f0 = 1681.974450955533;
+  double gain = 3.999843853973347;
+  double q = 0.7071752369554196;
+  double k = tan(M_PI * f0 / fs);
+  double vh = pow(10.0, gain / 20.0);
+  double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  meter->shelfB[0] = (vh + vb * k / q + k * k) / a0;
+  meter->shelfB[1] = 2.0 * (k * k - vh) / a0;
+  meter->shelfB[2] = (vh - vb * k / q + k * k) / a0;
+  meter->shelfA[0] = 1.0;
+  meter->shelfA[1] = 2.0 * (k * k - 1.0) / a0;
+  meter->shelfA[2] = (1.0 - k / q + k * k) / a0;
+
+  // High pass at 38 Hz
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan(M_PI * f0 / fs);
+  a0 = 1.0 + k / q + k * k;
+  meter->passB[0] = 1.0;
+  meter->passB[1] = -2.0;
+  meter->passB[2] = 1.0;
+  meter->passA[0] = 1.0;
+  meter->passA[1] = 2.0 * (k * k - 1.0) / a0;
+  meter->passA[2] = (1.0 - k / q + k * k) / a0;
+}
+
+// Windowed sinc interpolation filter split into one set of taps per phase
+static void initTaps(LoudnessMeter* meter) {
+  const int length = LOUDNESS_OVERSAMPLING * LOUDNESS_PHASE_TAPS;
+  double center = (length - 1) / 2.0;
+
+  for (int phase = 0; phase < LOUDNESS_OVERSAMPLING; phase++) {
+    double sum = 0;
+    for (int c = 0; c < LOUDNESS_PHASE_TAPS; c++) {
+      int n = c * LOUDNESS_OVERSAMPLING + phase;
+      double x = (n - center) / LOUDNESS_OVERSAMPLING;
+      double sinc = x == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+      double window = 0.5 - 0.5 * cos(2.0 * M_PI * (n + 1) / (length + 1));
+      // Tap c applies to the sample c steps back
+      meter->taps[LOUDNESS_PHASE_TAPS - 1 - c][phase] = (float)(sinc * window);
+      sum += sinc * window;
+    }
+    // Unity gain for every phase
+    float tapsGain = 0;
+    for (int c = 0; c < LOUDNESS_PHASE_TAPS; c++) {
+      meter->taps[c][phase] /= (float)sum;
+      tapsGain += fabsf(meter->taps[c][phase]);
+    }
+    if (tapsGain > meter->tapsGain) meter->tapsGain = tapsGain;
+  }
+}
+
+LoudnessMeter* loudnessCreate(int sampleRate, int64_t position) {
+  LoudnessMeter* meter = calloc(1, sizeof(LoudnessMeter));
+  if (!meter) return NULL;
+
+  meter->sampleRate = sampleRate;
+  meter->stepSamples = sampleRate * LOUDNESS_STEP_MS / 1000;
+  meter->position = position;
+  initKWeighting(meter);
+  initTaps(meter);
+  return meter;
+}
+
+void loudnessFree(LoudnessMeter* meter) {
+  if (!meter) return;
+  free(meter->steps);
+  free(meter);
+}
+
+static double biquad(const double* b, const double* a, double* state, double x) {
+  double y = b[0] * x + state[0];
+  state[0] = b[1] * x - a[1] * y + state[1];
+  state[1] = b[2] * x - a[2] * y;
+  return y;
+}
+
+// Returns 1 if out of memory
+static int ensureSteps(LoudnessMeter* meter, int count) {
+  if (count <= meter->stepsCapacity) return 0;
+
+  int capacity = meter->stepsCapacity ? meter->stepsCapacity : 1024;
+  while (capacity < count) capacity *= 2;
+  double* steps = realloc(meter->steps, capacity * sizeof(double));
+  if (!steps) return 1;
+  memset(steps + meter->stepsCapacity, 0, (capacity - meter->stepsCapacity) * sizeof(double));
+  meter->steps = steps;
+  meter->stepsCapacity = capacity;
+  return 0;
+}
+
+static void addEnergy(LoudnessMeter* meter, int64_t step, double energy) {
+  if (ensureSteps(meter, (int)step + 1)) return;
+  meter->steps[step] += energy;
+  if (step >= meter->stepsCount) meter->stepsCount = (int)step + 1;
+}
+
+// Update true peak with the values between the two newest samples in x.
+// All phases are computed together, so the inner loop is a vector multiply-add
+static void interpolatePeak(LoudnessMeter* meter, const float* x) {
+  float values[LOUDNESS_OVERSAMPLING] = {0};
+  for (int c = 0; c < LOUDNESS_PHASE_TAPS; c++) {
+    for (int phase = 0; phase < LOUDNESS_OVERSAMPLING; phase++) {
+      values[phase] += meter->taps[c][phase] * x[c];
+    }
+  }
+  float peak = meter->truePeak;
+  for (int phase = 0; phase < LOUDNESS_OVERSAMPLING; phase++) {
+    float value = fabsf(values[phase]);
+    peak = value > peak ? value : peak;
+  }
+  meter->truePeak = peak;
+}
+
+// Filter one channel sample. Returns its K-weighted value and updates true peak
+static double processSample(LoudnessMeter* meter, int channel, float sample) {
+  float* history = meter->history[channel];
+  history[meter->historyPos] = sample;
+  history[meter->historyPos + LOUDNESS_PHASE_TAPS] = sample;
+
+  // Last samples from the oldest one
+  const float* x = history + meter->historyPos + 1;
+
+  float level = fabsf(sample);
+  if (level >= meter->windowPeak[channel]) {
+    meter->windowPeak[channel] = level;
+    meter->windowPeakAge[channel] = LOUDNESS_PHASE_TAPS;
+  } else if (--meter->windowPeakAge[channel] == 0) {
+    meter->windowPeak[channel] = 0;
+    for (int c = 0; c < LOUDNESS_PHASE_TAPS; c++) {
+      if (fabsf(x[c]) < meter->windowPeak[channel]) continue;
+      meter->windowPeak[channel] = fabsf(x[c]);
+      meter->windowPeakAge[channel] = c + 1;
+    }
+  }
+  if (meter->windowPeak[channel] * meter->tapsGain > meter->truePeak) {
+    interpolatePeak(meter, x);
+  }
+
+
+  double y = biquad(meter->shelfB, meter->shelfA, meter->shelfState[channel], sample);
+  return biquad(meter->passB, meter->passA, meter->passState[channel], y);
+}
+
+static void nextHistoryPos(LoudnessMeter* meter) {
+  meter->historyPos++;
+  if (meter->historyPos == LOUDNESS_PHASE_TAPS) meter->historyPos = 0;
+}
+
+void loudnessAdd(LoudnessMeter* meter, const float* buffer, int samples) {
+  int64_t step = meter->position / meter->stepSamples;
+  int64_t stepEnd = (step + 1) * meter->stepSamples;
+  double energy = 0;
+
+  for (int c = 0; c < samples; c++) {
+    float left = buffer[c * 2];
+    float right = buffer[c * 2 + 1];
+    float peak = fabsf(left) > fabsf(right) ? fabsf(left) : fabsf(right);
+    if (peak > meter->samplePeak) meter->samplePeak = peak;
+
+    double l = processSample(meter, 0, left);
+    double r = processSample(meter, 1, right);
+    nextHistoryPos(meter);
+    energy += l * l + r * r;
+
+    meter->position++;
+    if (meter->position == stepEnd) {
+      addEnergy(meter, step, energy);
+      energy = 0;
+      step++;
+      stepEnd += meter->stepSamples;
+    }
+  }
+  if (energy > 0) addEnergy(meter, step, energy);
+}
+
+void loudnessPrime(LoudnessMeter* meter, const float* buffer, int samples) {
+  float samplePeak = meter->samplePeak;
+  float truePeak = meter->truePeak;
+
+  for (int c = 0; c < samples; c++) {
+    processSample(meter, 0, buffer[c * 2]);
+    processSample(meter, 1, buffer[c * 2 + 1]);
+    nextHistoryPos(meter);
+  }
+
+  meter->samplePeak = samplePeak;
+  meter->truePeak = truePeak;
+}
+
+int loudnessMerge(LoudnessMeter* meter, const LoudnessMeter* other) {
+  if (ensureSteps(meter, other->stepsCount)) return 1;
+
+  for (int c = 0; c < other->stepsCount; c++) {
+    meter->steps[c] += other->steps[c];
+  }
+  if (other->stepsCount > meter->stepsCount) meter->stepsCount = other->stepsCount;
+  if (other->position > meter->position) meter->position = other->position;
+  if (other->samplePeak > meter->samplePeak) meter->samplePeak = other->samplePeak;
+  if (other->truePeak > meter->truePeak) meter->truePeak = other->truePeak;
+  return 0;
+}
+
+static float toDB(double value) {
+  if (value <= 0) return LOUDNESS_FLOOR_DB;
+  double db = 20.0 * log10(value);
+  return db < LOUDNESS_FLOOR_DB ? LOUDNESS_FLOOR_DB : (float)db;
+}
+
+static double blockLoudness(double meanSquare) {
+  return -0.691 + 10.0 * log10(meanSquare);
+}
+
+void loudnessGetStats(const LoudnessMeter* meter, LoudnessStats* stats) {
+  // Only blocks that are complete
+  int blocksCount = (int)(meter->position / meter->stepSamples) - BLOCK_STEPS + 1;
+  if (blocksCount > meter->stepsCount - BLOCK_STEPS + 1) blocksCount = meter->stepsCount - BLOCK_STEPS + 1;
+  double blockSamples = (double)meter->stepSamples * BLOCK_STEPS;
+
+  // Mean square of blocks above a gate
+  double gates[2] = {ABSOLUTE_GATE, 0};
+  double mean = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    double sum = 0;
+    int count = 0;
+    for (int c = 0; c < blocksCount; c++) {
+      double z = (meter->steps[c] + meter->steps[c + 1] + meter->steps[c + 2] + meter->steps[c + 3]) / blockSamples;
+      if (z <= 0 || blockLoudness(z) <= ABSOLUTE_GATE || blockLoudness(z) <= gates[pass]) continue;
+      sum += z;
+      count++;
+    }
+    mean = count > 0 ? sum / count : 0;
+    if (mean <= 0) break;
+    gates[1] = blockLoudness(mean) + RELATIVE_GATE;
+  }
+
+  stats->integrated = mean > 0 ? (float)blockLoudness(mean) : LOUDNESS_FLOOR_DB;
+  stats->samplePeak = toDB(meter->samplePeak);
+  stats->truePeak = toDB(meter->truePeak > meter->samplePeak ? meter->truePeak : meter->samplePeak);
+  stats->gain = 0;
+}
+
+float loudnessNormalizationGain(const LoudnessStats* stats, float targetLUFS, float truePeakLimit) {
+  if (stats->integrated <= ABSOLUTE_GATE) return 0;
+
+  float gain = targetLUFS - stats->integrated;
+  if (stats->truePeak + gain > truePeakLimit) gain = truePeakLimit - stats->truePeak;
+  return gain;
+}
@@ -0,0 +1,103 @@
+#ifndef __LOUDNESS_H__
+#define __LOUDNESS_H__
+
+#include <stdint.h>
+
+#define LOUDNESS_FLOOR_DB (-120.0f) // Reported for silence
+#define LOUDNESS_STEP_MS (100) // Gating blocks are 4 steps long and start every step
+#define LOUDNESS_OVERSAMPLING (4) // True peak interpolation factor
+#define LOUDNESS_PHASE_TAPS (12) // Interpolation filter taps per phase
+
+typedef struct LoudnessStats {
+  float integrated; // LUFS, gated as in ITU-R BS.1770
+  float truePeak; // dBTP
+  float samplePeak; // dBFS
+  float gain; // dB applied by normalization, the other values already include it
+} LoudnessStats;
+
+/**
+* Loudness meter for interleaved stereo audio: K-weighted energy per 100 ms
+* step and sample and true peaks. Meters of consecutive parts of a song can
+* be merged, so each part can be measured on its own thread.
+*/
+typedef struct LoudnessMeter {
+  int sampleRate;
+  int stepSamples;
+  int64_t position; // Song sample of the next added sample
+  // K-weighting: high shelf and high pass biquads, per channel state
+  double shelfB[3], shelfA[3];
+  double passB[3], passA[3];
+  double shelfState[2][2];
+  double passState[2][2];
+  // True peak interpolation
+  float taps[LOUDNESS_PHASE_TAPS][LOUDNESS_OVERSAMPLING]; // Oldest sample's taps first, phases side by side
+  float history[2][LOUDNESS_PHASE_TAPS * 2]; // Last samples, stored twice so they can be read without wrapping
+  int historyPos;
+  // Interpolation is skipped while it can't reach the true peak so far
+  float tapsGain; // Largest sum of absolute taps of a phase
+  float windowPeak[2]; // Largest absolute sample in history
+  int windowPeakAge[2]; // Samples until the largest one leaves history
+  float samplePeak;
+  float truePeak;
+  // K-weighted energy of each step
+  double* steps;
+  int stepsCount;
+  int stepsCapacity;
+} LoudnessMeter;
+
+/**
+* Create a loudness meter
+* @param sampleRate Sample rate of the audio
+* @param position Song sample of the first sample that will be added
+* @return New meter, or NULL on failure
+*/
+LoudnessMeter* loudnessCreate(int sampleRate, int64_t position);
+
+/**
+* Free a loudness meter
+* @param meter Meter to free
+*/
+void loudnessFree(LoudnessMeter* meter);
+
+/**
+* Measure stereo samples that follow the previous ones
+* @param meter Loudness meter
+* @param buffer Interleaved stereo samples
+* @param samples Number of stereo samples
+*/
+void loudnessAdd(LoudnessMeter* meter, const float* buffer, int samples);
+
+/**
+* Run the filters over samples before meter's position without measuring
+* them, so they settle like they would in a meter that measured the whole song
+* @param meter Loudness meter
+* @param buffer Interleaved stereo samples
+* @param samples Number of stereo samples
+*/
+void loudnessPrime(LoudnessMeter* meter, const float* buffer, int samples);
+
+/**
+* Merge another meter's measurements into a meter
+* @param meter Meter to merge into
+* @param other Meter of another part of the same song
+* @return 0 on success, 1 if out of memory
+*/
+int loudnessMerge(LoudnessMeter* meter, const LoudnessMeter* other);
+
+/**
+* Get the measured loudness
+* @param meter Loudness meter
+* @param stats Filled with the results, gain is 0
+*/
+void loudnessGetStats(const LoudnessMeter* meter, LoudnessStats* stats);
+
+/**
+* Gain that brings audio to the target loudness without its true peak going over the limit
+* @param stats Measured loudness
+* @param targetLUFS Target integrated loudness
+* @param truePeakLimit Highest allowed true peak, dBTP
+* @return Gain in dB, 0 for silence
+*/
+float loudnessNormalizationGain(const LoudnessStats* stats, float targetLUFS, float truePeakLimit);
+
+#endif
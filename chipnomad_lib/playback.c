@@ -11,20 +11,17 @@
 static int moveToNextPhraseRow(PlaybackState* state, int trackIdx);
 
 static void resetTrackFXAuxState(PlaybackState* state, int trackIdx) {
-  PlaybackTrackState* track = &state->tracks[trackIdx];
-  for (int c = 0; c < 16; c++) {
-    for (int d = 0; d < 3; d++) {
-      track->fxAuxState[c][d] = 0;
-    }
-  }
+  memset(state->loops[trackIdx].phrase, 0, sizeof(state->loops[trackIdx].phrase));
 }
 
-static void resetTableFXAuxState(PlaybackTableState* tableState) {
-  for (int c = 0; c < 16; c++) {
-    for (int d = 0; d < 4; d++) {
-      tableState->fxAuxState[c][d] = 0;
-    }
-  }
+// Loop counters of the instrument or aux table of the track
+static uint8_t (*tableLoops(PlaybackState* state, int trackIdx, PlaybackTableState* tableState))[4] {
+  if (tableState == &state->tracks[trackIdx].note.auxTable) return state->loops[trackIdx].auxTable;
+  return state->loops[trackIdx].instrumentTable;
+}
+
+static void resetTableFXAuxState(PlaybackState* state, int trackIdx, PlaybackTableState* tableState) {
+  memset(tableLoops(state, trackIdx, tableState), 0, sizeof(state->loops[trackIdx].instrumentTable));
 }
 
 static void resetTrack(PlaybackState* state, int trackIdx) {
@@ -59,8 +56,8 @@ static void resetTrack(PlaybackState* state, int trackIdx) {
   }
 
   resetTrackFXAuxState(state, trackIdx);
-  resetTableFXAuxState(&track->note.instrumentTable);
-  resetTableFXAuxState(&track->note.auxTable);
+  resetTableFXAuxState(state, trackIdx, &track->note.instrumentTable);
+  resetTableFXAuxState(state, trackIdx, &track->note.auxTable);
 
   // Clear cached phrase row
   memset(&track->currentPhraseRow, EMPTY_VALUE_8, sizeof(track->currentPhraseRow));
@@ -74,7 +71,7 @@ void tableInit(PlaybackState* state, int trackIdx, struct PlaybackTableState* ta
 
   Project* p = state->p;
 
-  resetTableFXAuxState(table);
+  resetTableFXAuxState(state, trackIdx, table);
 
   for (int i = 0; i < 4; i++) {
     table->counters[i] = 0;
@@ -112,6 +109,7 @@ void tableReadFX(PlaybackState* state, int trackIdx, struct PlaybackTableState*
 static void tableProgress(PlaybackState* state, int trackIdx, struct PlaybackTableState* table) {
   if (table->tableIdx == EMPTY_VALUE_8) return;
   Project* p = state->p;
+  uint8_t (*loops)[4] = tableLoops(state, trackIdx, table);
 
   for (int i = 0; i < 4; i++) {
     table->counters[i]++;
@@ -142,8 +140,8 @@ static void tableProgress(PlaybackState* state, int trackIdx, struct PlaybackTab
       if (fxType == fxHOP && (fxValue & 0xf) == row) {
         if (fxValue & 0xf0) {
           // Loop counter
-          table->fxAuxState[row][i]++;
-          if (table->fxAuxState[row][i] <= ((fxValue & 0xf0) >> 4)) {
+          loops[row][i]++;
+          if (loops[row][i] <= ((fxValue & 0xf0) >> 4)) {
             tableReadFX(state, trackIdx, table, i, 0);
             continue;
           }
@@ -160,7 +158,7 @@ static void tableProgress(PlaybackState* state, int trackIdx, struct PlaybackTab
       if (table->rows[i] == 0) {
         // Reset all loop counters for this column
         for (int c = 0; c < 16; c++) {
-          table->fxAuxState[c][i] = 0;
+          loops[c][i] = 0;
         }
       }
       
@@ -190,12 +188,12 @@ static void tableProgress(PlaybackState* state, int trackIdx, struct PlaybackTab
         uint8_t hopTarget = fxValue & 0xf;
         if (fxValue & 0xf0) {
           // Loop counter
-          table->fxAuxState[row][i]++;
-          if (table->fxAuxState[row][i] <= ((fxValue & 0xf0) >> 4)) {
+          loops[row][i]++;
+          if (loops[row][i] <= ((fxValue & 0xf0) >> 4)) {
             // Reset "nested" loops when hopping back
             if (hopTarget < row) {
               for (int c = hopTarget; c < row; c++) {
-                table->fxAuxState[c][i] = 0;
+                loops[c][i] = 0;
               }
             }
             table->rows[i] = hopTarget;
@@ -236,8 +234,7 @@ void readPhraseRowDirect(PlaybackState* state, int trackIdx, PhraseRow* phraseRo
   if (!skipDelCheck) {
     for (int i = 0; i < 3; i++) {
       if (phraseRow->fx[i][0] == fxDEL && phraseRow->fx[i][1] != 0) {
-        track->note.fx[i].fx = fxDEL;
-        track->note.fx[i].value = phraseRow->fx[i][1];
+        decodeFX(&track->note.fx[i], fxDEL, phraseRow->fx[i][1]);
         return;
       }
     }
@@ -361,12 +358,12 @@ void readPhraseRow(PlaybackState* state, int trackIdx, int skipDelCheck) {
             return;
           } else {
             // Conditional jump with loop counter
-            track->fxAuxState[phraseRow][i]++;
-            if (track->fxAuxState[phraseRow][i] <= loopCount) {
+            state->loops[trackIdx].phrase[phraseRow][i]++;
+            if (state->loops[trackIdx].phrase[phraseRow][i] <= loopCount) {
               // Reset nested loop counters when hopping backwards
               if (targetRow < phraseRow) {
                 for (int c = targetRow; c < phraseRow; c++) {
-                  track->fxAuxState[c][i] = 0;
+                  state->loops[trackIdx].phrase[c][i] = 0;
                 }
               }
               track->phraseRow = targetRow;
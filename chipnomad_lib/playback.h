@@ -21,7 +21,6 @@ typedef struct PlaybackTableState {
   uint8_t counters[4];
   uint8_t speed[4];
   PlaybackFXState fx[4];
-  uint8_t fxAuxState[16][4];
 } PlaybackTableState;
 
 typedef struct PlaybackAYNoteState {
@@ -97,8 +96,6 @@ enum PlaybackArpType {
 };
 
 typedef struct PlaybackTrackState {
-  PlaybackTrackQueue queue;
-
   enum PlaybackMode mode;
   // Position in the song
   int songRow;
@@ -106,24 +103,32 @@ typedef struct PlaybackTrackState {
   int phraseRow;
   int loop;
 
+  int frameCounter;
+
   // Groove
-  uint8_t grooveIdx;
   int grooveRow;
+  uint8_t grooveIdx;
   uint8_t pendingGrooveIdx; // For GGR synchronization
 
-  int frameCounter;
-
   int arpSpeed;
   enum PlaybackArpType arpType;
 
   // Currently playing note
   PlaybackNoteState note;
+
+  PlaybackTrackQueue queue;
   // Cached phrase row data
   PhraseRow currentPhraseRow;
-  // FX auxillary state data
-  uint8_t fxAuxState[16][3];
 } PlaybackTrackState;
 
+// HOP loop counters. These are only touched when a HOP is reached or a phrase/table restarts,
+// so they are kept apart from the per-frame track state
+typedef struct PlaybackTrackLoops {
+  uint8_t phrase[16][3];
+  uint8_t instrumentTable[16][4];
+  uint8_t auxTable[16][4];
+} PlaybackTrackLoops;
+
 typedef struct PlaybackAYChipState {
   uint8_t envShape;
 } PlaybackAYChipState;
@@ -149,6 +154,7 @@ typedef struct PlaybackState {
   PlaybackChipState chips[PROJECT_MAX_CHIPS];
   uint8_t trackEnabled[PROJECT_MAX_TRACKS];
   LoopRange loopRange;
+  PlaybackTrackLoops loops[PROJECT_MAX_TRACKS];
 } PlaybackState;
 
 
@@ -22,9 +22,19 @@ typedef union PlaybackFXData {
   PlaybackFXData_PSL psl;
 } PlaybackFXData;
 
+struct PlaybackState;
+struct PlaybackTrackState;
+struct PlaybackTableState;
+struct PlaybackFXState;
+
+// FX handler, resolved once when the FX is read from a phrase or table row
+typedef void (*PlaybackFXHandler)(struct PlaybackState* state, struct PlaybackTrackState* track, int trackIdx, int chipIdx, struct PlaybackFXState* fx, struct PlaybackTableState* tableState);
+
 typedef struct PlaybackFXState {
   uint8_t fx;
   uint8_t value;
+  uint8_t priority; // Priority FX are handled before table FX
+  PlaybackFXHandler handler; // NULL for FX without per-frame logic (HOP, SNG)
   PlaybackFXData data;
 } PlaybackFXState;
 
@@ -122,21 +122,18 @@ static void handleFX_ESL(PlaybackState* state, PlaybackTrackState* track, int tr
   fx->data.psl.counter++;
 }
 
-int handleFX_AY(PlaybackState* state, int trackIdx, int chipIdx, struct PlaybackFXState* fx, PlaybackTableState *tableState) {
-  PlaybackTrackState* track = &state->tracks[trackIdx];
-
-  if (fx->fx == fxAYM) handleFX_AYM(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxNOA) handleFX_NOA(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxNOI) handleFX_NOI(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxERT) handleFX_ERT(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEAU) handleFX_EAU(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxENT) handleFX_ENT(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEPT) handleFX_EPT(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEPL) handleFX_EPL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEPH) handleFX_EPH(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEBN) handleFX_EBN(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxEVB) handleFX_EVB(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxESL) handleFX_ESL(state, track, trackIdx, chipIdx, fx, tableState);
-
-  return 0;
-}
+// AY FX handlers, indexed by FX type
+const PlaybackFXHandler fxHandlersAY[fxTotalCount] = {
+  [fxAYM] = handleFX_AYM,
+  [fxNOA] = handleFX_NOA,
+  [fxNOI] = handleFX_NOI,
+  [fxERT] = handleFX_ERT,
+  [fxEAU] = handleFX_EAU,
+  [fxENT] = handleFX_ENT,
+  [fxEPT] = handleFX_EPT,
+  [fxEPL] = handleFX_EPL,
+  [fxEPH] = handleFX_EPH,
+  [fxEBN] = handleFX_EBN,
+  [fxEVB] = handleFX_EVB,
+  [fxESL] = handleFX_ESL,
+};
@@ -383,49 +383,56 @@ static int handleAllTableFX(PlaybackState* state, int trackIdx, int chipIdx) {
   return 0;
 }
 
-static int handlePriorityFXInternal(PlaybackState* state, int trackIdx, int chipIdx, struct PlaybackFXState* fx, PlaybackTableState *tableState) {
-  PlaybackTrackState* track = &state->tracks[trackIdx];
+// Common FX handlers, indexed by FX type
+static const PlaybackFXHandler fxHandlersCommon[fxTotalCount] = {
+  [fxARP] = handleFX_ARP,
+  [fxARC] = handleFX_ARC,
+  [fxPBN] = handleFX_PBN,
+  [fxPIT] = handleFX_PIT,
+  [fxFIN] = handleFX_FIN,
+  [fxPRD] = handleFX_PRD,
+  [fxTIC] = handleFX_TIC,
+  [fxVOL] = handleFX_VOL,
+  [fxGRV] = handleFX_GRV,
+  [fxGGR] = handleFX_GGR,
+  [fxOFF] = handleFX_OFF,
+  [fxKIL] = handleFX_KIL,
+  [fxDEL] = handleFX_DEL,
+  [fxRET] = handleFX_RET,
+  [fxPVB] = handleFX_PVB,
+  [fxPSL] = handleFX_PSL,
+  [fxTBX] = handleFX_TBX,
+  [fxTBL] = handleFX_TBL,
+  [fxTHO] = handleFX_THO,
+  [fxTXH] = handleFX_TXH,
+};
+
+void decodeFX(PlaybackFXState* fxState, uint8_t fx, uint8_t value) {
+  fxState->fx = fx;
+  fxState->value = value;
+  fxState->handler = NULL;
+  fxState->priority = 0;
+
+  if (fx >= fxTotalCount) return;
+
+  // Chip specific FX are looked up only if there's no common FX with this type
+  fxState->handler = fxHandlersCommon[fx] ? fxHandlersCommon[fx] : fxHandlersAY[fx];
+  // Table changes and hops must happen before table FX are processed
+  fxState->priority = (fx == fxTBX || fx == fxTBL || fx == fxTHO || fx == fxTXH);
+}
 
-  if (fx->fx == EMPTY_VALUE_8) return 0;
-  else if (fx->fx == fxTBX) handleFX_TBX(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTBL) handleFX_TBL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTHO) handleFX_THO(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTXH) handleFX_TXH(state, track, trackIdx, chipIdx, fx, tableState);
+static int handlePriorityFXInternal(PlaybackState* state, int trackIdx, int chipIdx, struct PlaybackFXState* fx, PlaybackTableState *tableState) {
+  if (fx->fx == EMPTY_VALUE_8 || !fx->priority) return 0;
 
+  fx->handler(state, &state->tracks[trackIdx], trackIdx, chipIdx, fx, tableState);
   return 0;
 }
 
 static int handleFXInternal(PlaybackState* state, int trackIdx, int chipIdx, struct PlaybackFXState* fx, PlaybackTableState *tableState) {
-  PlaybackTrackState* track = &state->tracks[trackIdx];
-
-  // Common FX
-  if (fx->fx == EMPTY_VALUE_8) return 0;
-  else if (fx->fx == fxARP) handleFX_ARP(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxARC) handleFX_ARC(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxPBN) handleFX_PBN(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxPIT) handleFX_PIT(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxFIN) handleFX_FIN(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxPRD) handleFX_PRD(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTIC) handleFX_TIC(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxVOL) handleFX_VOL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxGRV) handleFX_GRV(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxGGR) handleFX_GGR(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxOFF) handleFX_OFF(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxKIL) handleFX_KIL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxDEL) handleFX_DEL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxRET) handleFX_RET(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxPVB) handleFX_PVB(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxPSL) handleFX_PSL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTBX) handleFX_TBX(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTBL) handleFX_TBL(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTHO) handleFX_THO(state, track, trackIdx, chipIdx, fx, tableState);
-  else if (fx->fx == fxTXH) handleFX_TXH(state, track, trackIdx, chipIdx, fx, tableState);
-
-  // Chip specific FX
-  else {
-    handleFX_AY(state, trackIdx, chipIdx, fx, tableState);
-  }
+  // Handlers stop themselves by setting fx to empty, so the handler pointer can be stale
+  if (fx->fx == EMPTY_VALUE_8 || fx->handler == NULL) return 0;
 
+  fx->handler(state, &state->tracks[trackIdx], trackIdx, chipIdx, fx, tableState);
   return 0;
 }
 
@@ -459,8 +466,7 @@ void initFX(PlaybackState* state, int trackIdx, uint8_t* fx, PlaybackFXState *fx
     if (track->arpSpeed == 0) track->arpSpeed = 1;
   }
 
-  fxState->fx = fxIdx;
-  fxState->value = fx[1];
+  decodeFX(fxState, fxIdx, fx[1]);
 }
 
 int handleFX(PlaybackState* state, int trackIdx, int chipIdx) {
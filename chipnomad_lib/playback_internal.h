@@ -9,6 +9,7 @@ void readPhraseRowDirect(PlaybackState* state, int trackIdx, PhraseRow* phraseRo
 void tableInit(PlaybackState* state, int trackIdx, struct PlaybackTableState* table, int tableIdx, int speed);
 void tableReadFX(PlaybackState* state, int trackIdx, struct PlaybackTableState* table, int fxIdx, int forceRead);
 void initFX(PlaybackState* state, int trackIdx, uint8_t* fx, PlaybackFXState *fxState, int forceCleanState);
+void decodeFX(PlaybackFXState* fxState, uint8_t fx, uint8_t value);
 int handleFX(PlaybackState* state, int trackIdx, int chipIdx);
 void hopToTableRow(PlaybackState* state, int trackIdx, PlaybackTableState* table, int tableRow);
 int vibratoCommonLogic(PlaybackFXState *fxState, int scale);
@@ -21,7 +22,7 @@ void noteOffInstrumentAY(PlaybackState* state, int trackIdx);
 void handleInstrumentAY(PlaybackState* state, int trackIdx);
 void outputRegistersAY(PlaybackState* state, int trackIdx, int chipIdx, SoundChip* chip);
 void resetTrackAY(PlaybackState* state, int trackIdx);
-int handleFX_AY(PlaybackState* state, int trackIdx, int chipIdx, struct PlaybackFXState* fx, PlaybackTableState *tableState);
+extern const PlaybackFXHandler fxHandlersAY[fxTotalCount];
 
 // Convert frequency to AY period with optimal accuracy
 int frequencyToAYPeriod(float frequency, int clockHz);
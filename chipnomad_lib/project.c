@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "project.h"
 #include "corelib/corelib_file.h"
@@ -22,8 +23,56 @@ FXName fxNamesAY[] = {
 };
 int fxAYCount = sizeof(fxNamesAY) / sizeof(FXName);
 
+// Lookup of 3 character names (notes, FX)
+#define NAME_HASH_BITS (9)
+#define NAME_HASH_SIZE (1 << NAME_HASH_BITS) // Over twice the number of pitches or FX
+
+typedef struct NameHash {
+  uint32_t keys[NAME_HASH_SIZE]; // Name characters, 0 for a free slot
+  uint8_t values[NAME_HASH_SIZE];
+} NameHash;
+
+static NameHash fxHash;
+static NameHash noteHash; // Pitch table of the project being loaded
+
+static uint32_t nameKey(const char* name) {
+  return (uint8_t)name[0] | ((uint8_t)name[1] << 8) | ((uint8_t)name[2] << 16);
+}
+
+static int nameSlot(uint32_t key) {
+  return (key * 2654435761u) >> (32 - NAME_HASH_BITS);
+}
+
+// The first value added for a name is kept, like in a linear search
+static void nameHashAdd(NameHash* hash, const char* name, uint8_t value) {
+  uint32_t key = nameKey(name);
+  int slot = nameSlot(key);
+  while (hash->keys[slot] != 0) {
+    if (hash->keys[slot] == key) return;
+    slot = (slot + 1) & (NAME_HASH_SIZE - 1);
+  }
+  hash->keys[slot] = key;
+  hash->values[slot] = value;
+}
+
+// Value of the name, or -1 if there's none
+static int nameHashFind(const NameHash* hash, const char* name) {
+  uint32_t key = nameKey(name);
+  int slot = nameSlot(key);
+  while (hash->keys[slot] != 0) {
+    if (hash->keys[slot] == key) return hash->values[slot];
+    slot = (slot + 1) & (NAME_HASH_SIZE - 1);
+  }
+  return -1;
+}
+
 // Fill FX names
 void fillFXNames() {
+  // The table is constant once filled. Filling it again would race with
+  // readers when states are created on export threads
+  static int isFilled = 0;
+  if (isFilled) return;
+
   for (int c = 0; c < 256; c++) {
     strcpy(fxNames[c].name, "---");
     fxNames[c].fx = c;
@@ -32,59 +81,73 @@ void fillFXNames() {
   for (int c = 0; c < fxCommonCount; c++) {
     strcpy(fxNames[fxNamesCommon[c].fx].name, fxNamesCommon[c].name);
     fxNames[fxNamesCommon[c].fx].fx = fxNamesCommon[c].fx;
+    nameHashAdd(&fxHash, fxNamesCommon[c].name, fxNamesCommon[c].fx);
   }
 
   for (int c = 0; c < fxAYCount; c++) {
     strcpy(fxNames[fxNamesAY[c].fx].name, fxNamesAY[c].name);
     fxNames[fxNamesAY[c].fx].fx = fxNamesAY[c].fx;
+    nameHashAdd(&fxHash, fxNamesAY[c].name, fxNamesAY[c].fx);
+  }
+  isFilled = 1;
+}
+
+int fxFindByName(const char* name) {
+  return nameHashFind(&fxHash, name);
+}
+
+// Copy the first element of an array over the rest, doubling the copied part
+// each time, which is faster than clearing elements one by one
+static void fillFromFirst(void* array, int count, size_t size) {
+  char* bytes = array;
+  int filled = 1;
+  while (filled < count) {
+    int chunk = filled < count - filled ? filled : count - filled;
+    memcpy(bytes + filled * size, bytes, chunk * size);
+    filled += chunk;
   }
 }
 
 // Initialize project
 void projectInit(Project* p) {
+  // Bytes the fields below leave alone, like the ends of names, are the same
+  // for every project, so loads and snapshots can be compared with memcmp
+  memset(p, 0, sizeof(Project));
+
   // Title
   strcpy(p->title, "");
   strcpy(p->author, "");
   p->linearPitch = 0;
 
   // Clean song structure
-  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
-    for (int d = 0; d < PROJECT_MAX_TRACKS; d++) {
-      p->song[c][d] = EMPTY_VALUE_16;
-      p->songHighlight[c][d] = 0;
-    }
+  for (int d = 0; d < PROJECT_MAX_TRACKS; d++) {
+    p->song[0][d] = EMPTY_VALUE_16;
   }
+  fillFromFirst(p->song, PROJECT_MAX_LENGTH, sizeof(p->song[0]));
 
   // Clean chains
-  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
-    chainClear(&p->chains[c]);
-  }
+  chainClear(&p->chains[0]);
+  fillFromFirst(p->chains, PROJECT_MAX_CHAINS, sizeof(Chain));
 
   // Clean grooves
-  for (int c = 0; c < PROJECT_MAX_GROOVES; c++) {
-    for (int d = 0; d < 16; d++) {
-      p->grooves[c].speed[d] = EMPTY_VALUE_8;
-    }
-  }
+  memset(p->grooves[0].speed, EMPTY_VALUE_8, sizeof(p->grooves[0].speed));
+  fillFromFirst(p->grooves, PROJECT_MAX_GROOVES, sizeof(Groove));
 
   // Default groove
   p->grooves[0].speed[0] = 6;
   p->grooves[0].speed[1] = 6;
 
   // Clean phrases
-  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
-    phraseClear(&p->phrases[c]);
-  }
+  phraseClear(&p->phrases[0]);
+  fillFromFirst(p->phrases, PROJECT_MAX_PHRASES, sizeof(Phrase));
 
   // Clean instruments
-  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
-    instrumentClear(&p->instruments[c]);
-  }
+  instrumentClear(&p->instruments[0]);
+  fillFromFirst(p->instruments, PROJECT_MAX_INSTRUMENTS, sizeof(Instrument));
 
   // Clean tables
-  for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
-    tableClear(&p->tables[c]);
-  }
+  tableClear(&p->tables[0]);
+  fillFromFirst(p->tables, PROJECT_MAX_TABLES, sizeof(Table));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -93,81 +156,143 @@ void projectInit(Project* p) {
 //
 
 static char *lpstr;
+static int lpstrLength;
 static char chipNames[][16] = { "AY8910" };
 char projectFileError[41];
 
 ///////////////////////////////////////////////////////////////////////////////
 // Load
 
+// The line where loading failed becomes the error, as lines are only valid
+// while the file is open
+static void setLoadError(int result) {
+  if (!result) {
+    projectFileError[0] = 0;
+  } else if (lpstr) {
+    snprintf(projectFileError, sizeof(projectFileError), "%s", lpstr);
+  }
+  lpstr = NULL;
+}
+
+// Same characters as isspace() in the C locale, without a call per line
+static int isTrimmedSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
 // Convenience function to read a non-empty string
 static char* readString(int fileId) {
   while (1) {
-    lpstr = fileReadString(fileId);
+    int length;
+    lpstr = fileReadLine(fileId, &length);
     if (lpstr == NULL) {
       sprintf(projectFileError, "Couldn't read string");
       return NULL;
     }
+
+    // Trim EOL and space characters
+    while (length > 0 && isTrimmedSpace(lpstr[length - 1])) length--;
+    lpstr[length] = 0;
+    lpstrLength = length;
+
     // Skip empty lines and lines with ```
-    if (strlen(lpstr) > 0 && strcmp(lpstr, "```")) break;
+    if (lpstr[0] != 0 && (lpstr[0] != '`' || strcmp(lpstr, "```"))) break;
   }
-  sprintf(projectFileError, "%s", lpstr);
 
   return lpstr;
 }
 
-static uint8_t scanByteOrEmpty(char* str) {
-  static char buf[3];
-  buf[0] = str[0];
-  buf[1] = str[1];
-  buf[2] = 0;
-  if (buf[0] == '-' && buf[1] == '-') {
-    return EMPTY_VALUE_8;
-  } else {
-    uint8_t result;
-    if (sscanf(buf, "%hhX", &result) != 1) return EMPTY_VALUE_8;
-    return result;
+// Hex digit values plus one, 0 for other characters
+static const uint8_t hexValues[256] = {
+  ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+  ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+  ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+// Two hex digits. Returns 1 if they are digits
+static int scanHex2(const char* str, int* value) {
+  int high = hexValues[(uint8_t)str[0]];
+  int low = hexValues[(uint8_t)str[1]];
+  if (!high || !low) return 0;
+  *value = ((high - 1) << 4) | (low - 1);
+  return 1;
+}
+
+// Entity index at the end of a header like "### Phrase 1F". Anything other
+// than a space and hex digits goes through sscanf with the header's format
+static int scanIndex(const char* str, int prefixLength, const char* format, int* idx) {
+  const char* digits = str + prefixLength;
+  if (digits[0] == ' ' && hexValues[(uint8_t)digits[1]]) {
+    int value = 0;
+    int c = 1;
+    for (; c < 5 && hexValues[(uint8_t)digits[c]]; c++) {
+      value = (value << 4) | (hexValues[(uint8_t)digits[c]] - 1);
+    }
+    if (digits[c] == 0) {
+      *idx = value;
+      return 1;
+    }
   }
+  return sscanf(str, format, idx) == 1;
 }
 
-static uint8_t scanNote(char* str, Project* p) {
-  // Silly linear search through pitch table. To replace with a simple hash
-  static char buf[4];
+// Comma separated decimal numbers at the end of a line, like sscanf "%hhu,%hhu".
+// Returns 0 for anything but up to 5 digits per value, sscanf handles the rest
+static int scanDecimals(const char* str, int* values, int count) {
+  for (int c = 0; c < count; c++) {
+    int value = 0;
+    int digits = 0;
+    for (; digits < 5 && str[digits] >= '0' && str[digits] <= '9'; digits++) {
+      value = value * 10 + str[digits] - '0';
+    }
+    if (digits == 0 || str[digits] != (c < count - 1 ? ',' : 0)) return 0;
+    values[c] = value;
+    str += digits + 1;
+  }
+  return 1;
+}
+
+// Anything but two hex digits or "--", as sscanf reads it
+static uint8_t scanByteUnusual(char* str) {
+  char buf[3];
   buf[0] = str[0];
   buf[1] = str[1];
-  buf[2] = str[2];
-  buf[3] = 0;
+  buf[2] = 0;
+  uint8_t result;
+  if (sscanf(buf, "%hhX", &result) != 1) return EMPTY_VALUE_8;
+  return result;
+}
 
-  if (!strcmp(buf, "---")) return EMPTY_VALUE_8;
-  if (!strcmp(buf, "OFF")) return NOTE_OFF;
+static uint8_t scanByteOrEmpty(char* str) {
+  int value;
+  if (scanHex2(str, &value)) return value;
+  if (str[0] == '-' && str[1] == '-') return EMPTY_VALUE_8;
+  return scanByteUnusual(str);
+}
 
+static void buildNoteHash(Project* p) {
+  memset(&noteHash, 0, sizeof(noteHash));
   for (int c = 0; c < p->pitchTable.length; c++) {
-    if (!strcmp(buf, p->pitchTable.noteNames[c])) return c;
+    nameHashAdd(&noteHash, p->pitchTable.noteNames[c], c);
   }
-
-  return EMPTY_VALUE_8;
 }
 
-static uint8_t scanFX(char* str, Project* p) {
-  // Silly linear search through the list of FX. To replace with a simple hash
-  static char buf[4];
-  buf[0] = str[0];
-  buf[1] = str[1];
-  buf[2] = str[2];
-  buf[3] = 0;
+static int isEmptyName(const char* str) {
+  return str[0] == '-' && str[1] == '-' && str[2] == '-';
+}
 
-  if (!strcmp(buf, "---")) return EMPTY_VALUE_8;
+static uint8_t scanNote(char* str, Project* p) {
+  if (isEmptyName(str)) return EMPTY_VALUE_8;
+  if (str[0] == 'O' && str[1] == 'F' && str[2] == 'F') return NOTE_OFF;
 
-  // Common FX
-  for (int c = 0; c < fxCommonCount; c++) {
-    if (!strcmp(buf, fxNamesCommon[c].name)) return fxNamesCommon[c].fx;
-  }
+  int note = nameHashFind(&noteHash, str);
+  return note < 0 ? EMPTY_VALUE_8 : note;
+}
 
-  // AY FX
-  for (int c = 0; c < fxAYCount; c++) {
-    if (!strcmp(buf, fxNamesAY[c].name)) return fxNamesAY[c].fx;
-  }
+static uint8_t scanFX(char* str, Project* p) {
+  if (isEmptyName(str)) return EMPTY_VALUE_8;
 
-  return EMPTY_VALUE_8;
+  int fx = nameHashFind(&fxHash, str);
+  return fx < 0 ? EMPTY_VALUE_8 : fx;
 }
 
 #define READ_STRING readString(fileId); if (lpstr == NULL) return 1;
@@ -182,8 +307,15 @@ static int projectLoadPitchTable(int fileId, Project* p) {
   int period;
   while (1) {
     READ_STRING;
-    if (sscanf(lpstr, "%s %d", buf, &period) != 2) break;
-    if (strlen(buf) != 3) return 1;
+    if (lpstrLength > 4 && lpstr[3] == ' ' && !isTrimmedSpace(lpstr[0]) && !isTrimmedSpace(lpstr[1]) &&
+      !isTrimmedSpace(lpstr[2]) && scanDecimals(lpstr + 4, &period, 1)) {
+      // Usual "C-4 1234" line
+      memcpy(buf, lpstr, 3);
+      buf[3] = 0;
+    } else if (sscanf(lpstr, "%s %d", buf, &period) != 2) {
+      break;
+    }
+    if (strlen(buf) != 3 || idx >= PROJECT_MAX_PITCHES) return 1;
     strcpy(p->pitchTable.noteNames[idx], buf);
     p->pitchTable.values[idx] = period;
     idx++;
@@ -199,6 +331,7 @@ static int projectLoadPitchTable(int fileId, Project* p) {
     }
   }
 
+  buildNoteHash(p);
   return 0;
 }
 
@@ -211,18 +344,21 @@ static int projectLoadSong(int fileId, Project* p) {
     READ_STRING;
     if (lpstr[0] == '#') break;
     // Minimum length: 2 chars per cell, plus 1 separator for each cell (optional for last)
-    if (strlen(lpstr) < (p->tracksCount * 3 - 1)) return 1;
+    if (lpstrLength < (p->tracksCount * 3 - 1)) return 1;
     for (int c = 0; c < p->tracksCount; c++) {
+      int chain;
       buf[0] = lpstr[c * 3];
       buf[1] = lpstr[c * 3 + 1];
       buf[2] = 0;
-      if (buf[0] == '-' && buf[1] == '-') {
+      if (scanHex2(buf, &chain)) {
+        p->song[idx][c] = chain;
+      } else if (buf[0] == '-' && buf[1] == '-') {
         p->song[idx][c] = EMPTY_VALUE_16;
       } else {
         if (sscanf(buf, "%hX", &p->song[idx][c]) != 1) return 1;
       }
       // Check for highlight asterisk (after the 2 hex digits)
-      if ((int)strlen(lpstr) > c * 3 + 2 && lpstr[c * 3 + 2] == '*') {
+      if (lpstrLength > c * 3 + 2 && lpstr[c * 3 + 2] == '*') {
         p->songHighlight[idx][c] = 1;
       } else {
         p->songHighlight[idx][c] = 0;
@@ -242,15 +378,24 @@ static int projectLoadChains(int fileId, Project* p) {
   while (1) {
     READ_STRING;
     if (strncmp(lpstr, "### Chain", 9)) break;
-    if (sscanf(lpstr, "### Chain %X", &idx) != 1) return 1;
+    if (!scanIndex(lpstr, 9, "### Chain %X", &idx) || idx >= PROJECT_MAX_CHAINS) return 1;
 
     for (int c = 0; c < 16; c++) {
       READ_STRING;
-      if (strlen(lpstr) != 6) return 1;
-
-      if (lpstr[0] == '-') {
+      if (lpstrLength != 6) return 1;
+
+      int phrase, transpose;
+      int isTransposeHex = scanHex2(lpstr + 4, &transpose);
+      if (hexValues[(uint8_t)lpstr[0]] && scanHex2(lpstr + 1, &phrase) && lpstr[3] == ' ' && isTransposeHex) {
+        p->chains[idx].rows[c].phrase = ((hexValues[(uint8_t)lpstr[0]] - 1) << 8) | phrase;
+        p->chains[idx].rows[c].transpose = transpose;
+      } else if (lpstr[0] == '-') {
         p->chains[idx].rows[c].phrase = EMPTY_VALUE_16;
-        if (sscanf(lpstr + 4, "%hhX", &p->chains[idx].rows[c].transpose) != 1) return 1;
+        if (isTransposeHex) {
+          p->chains[idx].rows[c].transpose = transpose;
+        } else {
+          if (sscanf(lpstr + 4, "%hhX", &p->chains[idx].rows[c].transpose) != 1) return 1;
+        }
       } else {
         if (sscanf(lpstr, "%hX %hhX", &p->chains[idx].rows[c].phrase, &p->chains[idx].rows[c].transpose) != 2) return 1;
       }
@@ -268,11 +413,11 @@ static int projectLoadGrooves(int fileId, Project* p) {
   while (1) {
     READ_STRING;
     if (strncmp(lpstr, "### Groove", 10)) break;
-    if (sscanf(lpstr, "### Groove %X", &idx) != 1) return 1;
+    if (!scanIndex(lpstr, 10, "### Groove %X", &idx) || idx >= PROJECT_MAX_GROOVES) return 1;
 
     for (int c = 0; c < 16; c++) {
       READ_STRING;
-      if (strlen(lpstr) != 2) return 1;
+      if (lpstrLength != 2) return 1;
       p->grooves[idx].speed[c] = scanByteOrEmpty(lpstr);
     }
   }
@@ -280,6 +425,8 @@ static int projectLoadGrooves(int fileId, Project* p) {
   return 0;
 }
 
+static const char emptyPhraseRow[] = "--- -- -- --- 00 --- 00 --- 00";
+
 static int projectLoadPhrases(int fileId, Project* p) {
   int idx;
 
@@ -288,11 +435,17 @@ static int projectLoadPhrases(int fileId, Project* p) {
   while (1) {
     READ_STRING;
     if (strncmp(lpstr, "### Phrase", 10)) break;
-    if (sscanf(lpstr, "### Phrase %X", &idx) != 1) return 1;
+    if (!scanIndex(lpstr, 10, "### Phrase %X", &idx) || idx >= PROJECT_MAX_PHRASES) return 1;
 
     for (int c = 0; c < 16; c++) {
       READ_STRING;
-      if (strlen(lpstr) != 30) return 1;
+      if (lpstrLength != 30) return 1;
+      // Most rows are empty
+      if (!memcmp(lpstr, emptyPhraseRow, 30)) {
+        p->phrases[idx].rows[c] = (PhraseRow){ EMPTY_VALUE_8, EMPTY_VALUE_8, EMPTY_VALUE_8,
+          { { EMPTY_VALUE_8, 0 }, { EMPTY_VALUE_8, 0 }, { EMPTY_VALUE_8, 0 } } };
+        continue;
+      }
       // Note
       p->phrases[idx].rows[c].note = scanNote(lpstr, p);
       // Instrument
@@ -315,6 +468,7 @@ static int projectLoadPhrases(int fileId, Project* p) {
 }
 
 static int loadInstrument(int fileId, Instrument* instrument, Project* p) {
+  int values[4];
   instrumentClear(instrument);
   
   while (1) {
@@ -324,20 +478,48 @@ static int loadInstrument(int fileId, Instrument* instrument, Project* p) {
     if (strncmp(lpstr, "- Name: ", 8) == 0) {
       sscanf(lpstr, "- Name: %[^\n]", instrument->name);
     } else if (strncmp(lpstr, "- Type: ", 8) == 0) {
-      sscanf(lpstr, "- Type: %hhd", &instrument->type);
+      if (scanDecimals(lpstr + 8, values, 1)) {
+        instrument->type = values[0];
+      } else {
+        sscanf(lpstr, "- Type: %hhd", &instrument->type);
+      }
     } else if (strncmp(lpstr, "- Table speed: ", 15) == 0) {
-      sscanf(lpstr, "- Table speed: %hhu", &instrument->tableSpeed);
+      if (scanDecimals(lpstr + 15, values, 1)) {
+        instrument->tableSpeed = values[0];
+      } else {
+        sscanf(lpstr, "- Table speed: %hhu", &instrument->tableSpeed);
+      }
     } else if (strncmp(lpstr, "- Transpose: ", 13) == 0) {
-      sscanf(lpstr, "- Transpose: %hhu", &instrument->transposeEnabled);
+      if (scanDecimals(lpstr + 13, values, 1)) {
+        instrument->transposeEnabled = values[0];
+      } else {
+        sscanf(lpstr, "- Transpose: %hhu", &instrument->transposeEnabled);
+      }
     } else if (strncmp(lpstr, "- Volume envelope: ", 19) == 0) {
-      sscanf(lpstr, "- Volume envelope: %hhu,%hhu,%hhu,%hhu",
-        &instrument->chip.ay.veA, &instrument->chip.ay.veD,
-        &instrument->chip.ay.veS, &instrument->chip.ay.veR);
+      if (scanDecimals(lpstr + 19, values, 4)) {
+        instrument->chip.ay.veA = values[0];
+        instrument->chip.ay.veD = values[1];
+        instrument->chip.ay.veS = values[2];
+        instrument->chip.ay.veR = values[3];
+      } else {
+        sscanf(lpstr, "- Volume envelope: %hhu,%hhu,%hhu,%hhu",
+          &instrument->chip.ay.veA, &instrument->chip.ay.veD,
+          &instrument->chip.ay.veS, &instrument->chip.ay.veR);
+      }
     } else if (strncmp(lpstr, "- Auto envelope: ", 17) == 0) {
-      sscanf(lpstr, "- Auto envelope: %hhu,%hhu",
-        &instrument->chip.ay.autoEnvN, &instrument->chip.ay.autoEnvD);
+      if (scanDecimals(lpstr + 17, values, 2)) {
+        instrument->chip.ay.autoEnvN = values[0];
+        instrument->chip.ay.autoEnvD = values[1];
+      } else {
+        sscanf(lpstr, "- Auto envelope: %hhu,%hhu",
+          &instrument->chip.ay.autoEnvN, &instrument->chip.ay.autoEnvD);
+      }
     } else if (strncmp(lpstr, "- Default mixer: ", 17) == 0) {
-      sscanf(lpstr, "- Default mixer: %hhX", &instrument->chip.ay.defaultMixer);
+      if (lpstrLength == 19 && scanHex2(lpstr + 17, &values[0])) {
+        instrument->chip.ay.defaultMixer = values[0];
+      } else {
+        sscanf(lpstr, "- Default mixer: %hhX", &instrument->chip.ay.defaultMixer);
+      }
     }
   }
 }
@@ -349,7 +531,7 @@ static int projectLoadInstruments(int fileId, Project* p) {
 
   READ_STRING;
   while (strncmp(lpstr, "### Instrument", 14) == 0) {
-    if (sscanf(lpstr, "### Instrument %X", &idx) != 1) return 1;
+    if (!scanIndex(lpstr, 14, "### Instrument %X", &idx) || idx >= PROJECT_MAX_INSTRUMENTS) return 1;
     if (loadInstrument(fileId, &p->instruments[idx], p)) return 1;
   }
 
@@ -359,7 +541,7 @@ static int projectLoadInstruments(int fileId, Project* p) {
 static int loadTable(int fileId, Table* table, Project* p) {
   for (int d = 0; d < 16; d++) {
     READ_STRING;
-    if (strlen(lpstr) < 35) return 1;  // Minimum length check
+    if (lpstrLength < 35) return 1;  // Minimum length check
 
     // Read pitch flag (single char)
     table->rows[d].pitchFlag = (lpstr[0] == '=') ? 1 : 0;
@@ -397,7 +579,7 @@ static int projectLoadTables(int fileId, Project* p) {
   while (1) {
     READ_STRING;
     if (strncmp(lpstr, "### Table", 9)) break;
-    if (sscanf(lpstr, "### Table %X", &idx) != 1) return 1;
+    if (!scanIndex(lpstr, 9, "### Table %X", &idx) || idx >= PROJECT_MAX_TABLES) return 1;
     if (loadTable(fileId, &p->tables[idx], p)) return 1;
   }
 
@@ -514,7 +696,92 @@ int projectLoad(Project* p, const char* path) {
     return 1;
   }
 
+  // Binary projects are recognized by their header
+  uint8_t header[4];
+  int headerLength = fileRead(fileId, header, sizeof(header));
+  if (projectIsBinary(header, headerLength)) {
+    fileClose(fileId);
+    return projectLoadBinary(p, path);
+  }
+  fileSeek(fileId, 0, SEEK_SET);
+
+  lpstr = NULL;
   int result = projectLoadInternal(fileId, p);
+  setLoadError(result);
+  fileClose(fileId);
+  return result;
+}
+
+// Only the header and the song, the song length comes from the cells having
+// hex digits, as empty ones are "--"
+static int projectLoadInfoInternal(int fileId, ProjectInfo* info) {
+  char buf[128];
+  memset(info, 0, sizeof(ProjectInfo));
+
+  sprintf(projectFileError, "Module header");
+  READ_STRING; if (strcmp(lpstr, "# ChipNomad Tracker Module 1.0")) return 1;
+  READ_STRING; if (strncmp(lpstr, "- Title:", 8)) return 1;
+  sscanf(lpstr, "- Title: %24[^\n]", info->title);
+  READ_STRING;
+  if (!strncmp(lpstr, "- Author:", 9)) sscanf(lpstr, "- Author: %24[^\n]", info->author);
+
+  READ_STRING; if (sscanf(lpstr, "- Frame rate: %f", &info->tickRate) != 1) return 1;
+  READ_STRING; if (sscanf(lpstr, "- Chips count: %d", &info->chipsCount) != 1) return 1;
+  READ_STRING;
+  if (!strncmp(lpstr, "- Linear pitch:", 15)) {
+    READ_STRING;
+  }
+  if (sscanf(lpstr, "- Chip type: %127s", buf) != 1) return 1;
+
+  int found = 0;
+  for (int c = 0; c < chipTotalCount; c++) {
+    if (strcmp(buf, chipNames[c]) == 0) {
+      found = 1;
+      info->chipType = c;
+      break;
+    }
+  }
+  if (!found) return 1;
+
+  sprintf(projectFileError, "Song");
+  do {
+    READ_STRING;
+  } while (strcmp(lpstr, "## Song"));
+
+  for (int row = 0; ; row++) {
+    READ_STRING;
+    if (lpstr[0] == '#') break;
+    for (int c = 0; c < lpstrLength; c++) {
+      if (hexValues[(uint8_t)lpstr[c]]) {
+        info->songLength = row + 1;
+        break;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int projectLoadInfo(ProjectInfo* info, const char* path) {
+  projectFileError[0] = 0;
+
+  int fileId = fileOpen(path, 0);
+  if (fileId == -1) {
+    sprintf(projectFileError, "Can't open file");
+    return 1;
+  }
+
+  uint8_t header[4];
+  int headerLength = fileRead(fileId, header, sizeof(header));
+  if (projectIsBinary(header, headerLength)) {
+    fileClose(fileId);
+    return projectLoadBinaryInfo(info, path);
+  }
+  fileSeek(fileId, 0, SEEK_SET);
+
+  lpstr = NULL;
+  int result = projectLoadInfoInternal(fileId, info);
+  setLoadError(result);
   fileClose(fileId);
   return result;
 }
@@ -522,21 +789,150 @@ int projectLoad(Project* p, const char* path) {
 /////////////////////////////////////////////////////////////////////////////
 // Save
 
-static int projectSavePitchTable(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Pitch table\n\n");
-  filePrintf(fileId, "- Title: %s\n\n```\n", project->pitchTable.name);
+// File being saved, formatted in memory and written at once
+typedef struct TextWriter {
+  char* data;
+  int size;
+  int capacity;
+  int isFailed;
+} TextWriter;
+
+// Returns space for length characters, NULL if out of memory
+static char* writeReserve(TextWriter* writer, int length) {
+  if (writer->isFailed) return NULL;
+  if (writer->size + length > writer->capacity) {
+    int capacity = writer->capacity ? writer->capacity : 65536;
+    while (capacity < writer->size + length) capacity *= 2;
+    char* data = realloc(writer->data, capacity);
+    if (!data) {
+      writer->isFailed = 1;
+      return NULL;
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+  }
 
-  for (int c = 0; c < project->pitchTable.length; c++) {
-    filePrintf(fileId, "%s %d\n", project->pitchTable.noteNames[c], project->pitchTable.values[c]);
+  char* dest = writer->data + writer->size;
+  writer->size += length;
+  return dest;
+}
+
+static void writeChars(TextWriter* writer, const char* str, int length) {
+  char* dest = writeReserve(writer, length);
+  if (dest) memcpy(dest, str, length);
+}
+
+static void writeText(TextWriter* writer, const char* str) {
+  writeChars(writer, str, strlen(str));
+}
+
+// Two hex digits and a separator
+static void writeByte(TextWriter* writer, const char* hex, char separator) {
+  char* dest = writeReserve(writer, 3);
+  if (!dest) return;
+  dest[0] = hex[0];
+  dest[1] = hex[1];
+  dest[2] = separator;
+}
+
+// Three character name (note, FX) and a separator
+static void writeName(TextWriter* writer, const char* name, char separator) {
+  char* dest = writeReserve(writer, 4);
+  if (!dest) return;
+  dest[0] = name[0];
+  dest[1] = name[1];
+  dest[2] = name[2];
+  dest[3] = separator;
+}
+
+// Same as "%X", or "%0*X" with digits > 0
+static void writeHex(TextWriter* writer, unsigned int value, int digits) {
+  char buf[8];
+  int length = 0;
+  do {
+    buf[7 - length++] = "0123456789ABCDEF"[value & 15];
+    value >>= 4;
+  } while (value != 0 || length < digits);
+  writeChars(writer, buf + 8 - length, length);
+}
+
+// Same as "%d"
+static void writeDecimal(TextWriter* writer, int value) {
+  char buf[12];
+  int length = 0;
+  unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+  do {
+    buf[11 - length++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) buf[11 - length++] = '-';
+  writeChars(writer, buf + 12 - length, length);
+}
+
+// "- <name>: <value>" line with a decimal value
+static void writeDecimalLine(TextWriter* writer, const char* name, int value) {
+  writeText(writer, name);
+  writeDecimal(writer, value);
+  writeChars(writer, "\n", 1);
+}
+
+// Write a new file next to the target and rename it over the target, so an
+// interrupted save never leaves a partial project behind
+int projectWriteFile(const char* path, const void* data, int size) {
+  char tempPath[2048];
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+  int fileId = fileOpen(tempPath, 1);
+  if (fileId == -1) {
+    sprintf(projectFileError, "Can't open file");
+    return 1;
   }
 
-  filePrintf(fileId, "```\n");
+  // Writes are buffered, a full disk may only show when the file is closed
+  int result = fileWrite(fileId, (void*)data, size) != size;
+  if (fileClose(fileId)) result = 1;
 
-  return 0;
+  if (result) {
+    sprintf(projectFileError, "Write failed");
+  } else if (fileRename(tempPath, path)) {
+    sprintf(projectFileError, "Can't replace file");
+    result = 1;
+  }
+  if (result) fileDelete(tempPath);
+  return result;
 }
 
-static int projectSaveSong(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Song\n\n```\n");
+// Returns 1 on failure
+static int textWriterSave(TextWriter* writer, const char* path) {
+  if (writer->isFailed) {
+    free(writer->data);
+    sprintf(projectFileError, "Out of memory");
+    return 1;
+  }
+
+  int result = projectWriteFile(path, writer->data, writer->size);
+  free(writer->data);
+  return result;
+}
+
+static void projectSavePitchTable(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Pitch table\n\n");
+  writeText(writer, "- Title: ");
+  writeText(writer, project->pitchTable.name);
+  writeText(writer, "\n\n```\n");
+
+  for (int c = 0; c < project->pitchTable.length; c++) {
+    writeText(writer, project->pitchTable.noteNames[c]);
+    writeChars(writer, " ", 1);
+    writeDecimal(writer, project->pitchTable.values[c]);
+    writeChars(writer, "\n", 1);
+  }
+
+  writeText(writer, "```\n");
+}
+
+static void projectSaveSong(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Song\n\n```\n");
 
   // Find the last row with values
   int songLength = PROJECT_MAX_LENGTH;
@@ -557,196 +953,200 @@ static int projectSaveSong(int fileId, Project* project) {
   for (int c = 0; c < songLength; c++) {
     for (int d = 0; d < project->tracksCount; d++) {
       int chain = project->song[c][d];
-      int isHighlighted = project->songHighlight[c][d];
-      if (chain == EMPTY_VALUE_16) {
-        filePrintf(fileId, "--");
-      } else {
-        filePrintf(fileId, "%s", byteToHex(chain));
-      }
+      int isLast = d == project->tracksCount - 1;
       // Add asterisk if highlighted, otherwise space (except after last column)
-      if (isHighlighted) {
-        filePrintf(fileId, "*");
-      } else if (d < project->tracksCount - 1) {
-        filePrintf(fileId, " ");
-      }
+      char separator = project->songHighlight[c][d] ? '*' : (isLast ? '\n' : ' ');
+      writeByte(writer, chain == EMPTY_VALUE_16 ? "--" : byteToHex(chain), separator);
+      if (isLast && separator == '*') writeChars(writer, "\n", 1);
     }
-    filePrintf(fileId, "\n");
   }
 
-  filePrintf(fileId, "```\n");
-
-  return 0;
+  writeText(writer, "```\n");
 }
 
-static int projectSaveChains(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Chains\n");
+static void projectSaveChains(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Chains\n");
 
   for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
     if (!chainIsEmpty(project, c)) {
-      filePrintf(fileId, "\n### Chain %X\n\n```\n", c);
+      writeText(writer, "\n### Chain ");
+      writeHex(writer, c, 0);
+      writeText(writer, "\n\n```\n");
       for (int d = 0; d < 16; d++) {
         int phrase = project->chains[c].rows[d].phrase;
         if (phrase == EMPTY_VALUE_16) {
-          filePrintf(fileId, "--- %s\n", byteToHex(project->chains[c].rows[d].transpose));
+          writeChars(writer, "---", 3);
         } else {
-          filePrintf(fileId, "%03X %s\n", project->chains[c].rows[d].phrase, byteToHex(project->chains[c].rows[d].transpose));
+          writeHex(writer, phrase, 3);
         }
+        writeChars(writer, " ", 1);
+        writeByte(writer, byteToHex(project->chains[c].rows[d].transpose), '\n');
       }
-      filePrintf(fileId, "```\n");
+      writeText(writer, "```\n");
     }
   }
-
-  return 0;
 }
 
-static int projectSaveGrooves(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Grooves\n");
+static void projectSaveGrooves(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Grooves\n");
 
   for (int c = 0; c < PROJECT_MAX_GROOVES; c++) {
     if (!grooveIsEmpty(project, c)) {
-      filePrintf(fileId, "\n### Groove %X\n\n```\n", c);
+      writeText(writer, "\n### Groove ");
+      writeHex(writer, c, 0);
+      writeText(writer, "\n\n```\n");
       for (int d = 0; d < 16; d++) {
-        filePrintf(fileId, "%s\n", byteToHexOrEmpty(project->grooves[c].speed[d]));
+        writeByte(writer, byteToHexOrEmpty(project->grooves[c].speed[d]), '\n');
       }
-      filePrintf(fileId, "```\n");
+      writeText(writer, "```\n");
     }
   }
-
-  return 0;
 }
 
-static int projectSavePhrases(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Phrases\n\n");
+static void projectSavePhrases(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Phrases\n\n");
 
   for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
     if (!phraseIsEmpty(project, c)) {
-      filePrintf(fileId, "### Phrase %X\n\n```\n", c);
+      writeText(writer, "### Phrase ");
+      writeHex(writer, c, 0);
+      writeText(writer, "\n\n```\n");
       for (int d = 0; d < 16; d++) {
-        filePrintf(fileId, "%s %s %s %s %s %s %s %s %s\n",
-          noteName(project, project->phrases[c].rows[d].note),
-          byteToHexOrEmpty(project->phrases[c].rows[d].instrument),
-          byteToHexOrEmpty(project->phrases[c].rows[d].volume),
-          fxNames[project->phrases[c].rows[d].fx[0][0]].name,
-          byteToHex(project->phrases[c].rows[d].fx[0][1]),
-          fxNames[project->phrases[c].rows[d].fx[1][0]].name,
-          byteToHex(project->phrases[c].rows[d].fx[1][1]),
-          fxNames[project->phrases[c].rows[d].fx[2][0]].name,
-          byteToHex(project->phrases[c].rows[d].fx[2][1])
-        );
+        PhraseRow* row = &project->phrases[c].rows[d];
+        writeName(writer, noteName(project, row->note), ' ');
+        writeByte(writer, byteToHexOrEmpty(row->instrument), ' ');
+        writeByte(writer, byteToHexOrEmpty(row->volume), ' ');
+        writeName(writer, fxNames[row->fx[0][0]].name, ' ');
+        writeByte(writer, byteToHex(row->fx[0][1]), ' ');
+        writeName(writer, fxNames[row->fx[1][0]].name, ' ');
+        writeByte(writer, byteToHex(row->fx[1][1]), ' ');
+        writeName(writer, fxNames[row->fx[2][0]].name, ' ');
+        writeByte(writer, byteToHex(row->fx[2][1]), '\n');
       }
-      filePrintf(fileId, "```\n");
+      writeText(writer, "```\n");
     }
   }
-
-  return 0;
 }
 
-static int saveInstrument(int fileId, int idx, Instrument* instrument) {
-  filePrintf(fileId, "\n### Instrument %X\n\n", idx);
-  filePrintf(fileId, "- Name: %s\n", instrument->name);
-  filePrintf(fileId, "- Type: %hhd\n", instrument->type);
-  filePrintf(fileId, "- Table speed: %hhu\n", instrument->tableSpeed);
-  filePrintf(fileId, "- Transpose: %hhu\n", instrument->transposeEnabled);
+static void saveInstrument(TextWriter* writer, int idx, Instrument* instrument) {
+  writeText(writer, "\n### Instrument ");
+  writeHex(writer, idx, 0);
+  writeText(writer, "\n\n- Name: ");
+  writeText(writer, instrument->name);
+  writeChars(writer, "\n", 1);
+  writeDecimalLine(writer, "- Type: ", (int8_t)instrument->type);
+  writeDecimalLine(writer, "- Table speed: ", instrument->tableSpeed);
+  writeDecimalLine(writer, "- Transpose: ", instrument->transposeEnabled);
 
   if (instrument->type == instAY) {
-    filePrintf(fileId, "- Volume envelope: %hhu,%hhu,%hhu,%hhu\n",
-      instrument->chip.ay.veA, instrument->chip.ay.veD,
-      instrument->chip.ay.veS, instrument->chip.ay.veR);
-    filePrintf(fileId, "- Auto envelope: %hhd,%hhd\n",
-      instrument->chip.ay.autoEnvN, instrument->chip.ay.autoEnvD);
-    filePrintf(fileId, "- Default mixer: %02X\n", instrument->chip.ay.defaultMixer);
+    writeText(writer, "- Volume envelope: ");
+    writeDecimal(writer, instrument->chip.ay.veA);
+    writeChars(writer, ",", 1);
+    writeDecimal(writer, instrument->chip.ay.veD);
+    writeChars(writer, ",", 1);
+    writeDecimal(writer, instrument->chip.ay.veS);
+    writeChars(writer, ",", 1);
+    writeDecimalLine(writer, "", instrument->chip.ay.veR);
+    writeText(writer, "- Auto envelope: ");
+    writeDecimal(writer, (int8_t)instrument->chip.ay.autoEnvN);
+    writeChars(writer, ",", 1);
+    writeDecimalLine(writer, "", (int8_t)instrument->chip.ay.autoEnvD);
+    writeText(writer, "- Default mixer: ");
+    writeByte(writer, byteToHex(instrument->chip.ay.defaultMixer), '\n');
   }
-  return 0;
 }
 
-static int saveTable(int fileId, int idx, Table* table) {
-  filePrintf(fileId, "\n### Table %X\n\n```\n", idx);
+static void saveTable(TextWriter* writer, int idx, Table* table) {
+  writeText(writer, "\n### Table ");
+  writeHex(writer, idx, 0);
+  writeText(writer, "\n\n```\n");
   for (int d = 0; d < 16; d++) {
-    filePrintf(fileId, "%c %s %s %s %s %s %s %s %s %s %s\n",
-      table->rows[d].pitchFlag ? '=' : '~',
-      byteToHex(table->rows[d].pitchOffset),
-      byteToHexOrEmpty(table->rows[d].volume),
-      fxNames[table->rows[d].fx[0][0]].name, byteToHex(table->rows[d].fx[0][1]),
-      fxNames[table->rows[d].fx[1][0]].name, byteToHex(table->rows[d].fx[1][1]),
-      fxNames[table->rows[d].fx[2][0]].name, byteToHex(table->rows[d].fx[2][1]),
-      fxNames[table->rows[d].fx[3][0]].name, byteToHex(table->rows[d].fx[3][1]));
-  }
-  filePrintf(fileId, "```\n");
-  return 0;
+    TableRow* row = &table->rows[d];
+    writeChars(writer, row->pitchFlag ? "= " : "~ ", 2);
+    writeByte(writer, byteToHex(row->pitchOffset), ' ');
+    writeByte(writer, byteToHexOrEmpty(row->volume), ' ');
+    for (int c = 0; c < 4; c++) {
+      writeName(writer, fxNames[row->fx[c][0]].name, ' ');
+      writeByte(writer, byteToHex(row->fx[c][1]), c < 3 ? ' ' : '\n');
+    }
+  }
+  writeText(writer, "```\n");
 }
 
-static int projectSaveInstruments(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Instruments\n");
+static void projectSaveInstruments(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Instruments\n");
   for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
     if (!instrumentIsEmpty(project, c)) {
-      saveInstrument(fileId, c, &project->instruments[c]);
+      saveInstrument(writer, c, &project->instruments[c]);
     }
   }
-  return 0;
 }
 
-static int projectSaveTables(int fileId, Project* project) {
-  filePrintf(fileId, "\n## Tables\n");
+static void projectSaveTables(TextWriter* writer, Project* project) {
+  writeText(writer, "\n## Tables\n");
   for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
     if (!tableIsEmpty(project, c)) {
-      saveTable(fileId, c, &project->tables[c]);
+      saveTable(writer, c, &project->tables[c]);
     }
   }
-  return 0;
 }
 
-static int projectSaveInternal(int fileId, Project* project) {
-  filePrintf(fileId, "# ChipNomad Tracker Module 1.0\n\n");
+static void projectSaveInternal(TextWriter* writer, Project* project) {
+  char buf[64];
+
+  writeText(writer, "# ChipNomad Tracker Module 1.0\n\n");
 
-  filePrintf(fileId, "- Title: %s\n", project->title);
-  filePrintf(fileId, "- Author: %s\n", project->author);
+  writeText(writer, "- Title: ");
+  writeText(writer, project->title);
+  writeText(writer, "\n- Author: ");
+  writeText(writer, project->author);
+  writeChars(writer, "\n", 1);
 
-  filePrintf(fileId, "- Frame rate: %f\n", project->tickRate);
-  filePrintf(fileId, "- Chips count: %d\n", project->chipsCount);
-  filePrintf(fileId, "- Linear pitch: %d\n", project->linearPitch);
-  filePrintf(fileId, "- Chip type: %s\n", chipNames[project->chipType]);
+  snprintf(buf, sizeof(buf), "- Frame rate: %f\n", project->tickRate);
+  writeText(writer, buf);
+  writeDecimalLine(writer, "- Chips count: ", project->chipsCount);
+  writeDecimalLine(writer, "- Linear pitch: ", project->linearPitch);
+  writeText(writer, "- Chip type: ");
+  writeText(writer, chipNames[project->chipType]);
+  writeChars(writer, "\n", 1);
 
   switch (project->chipType) {
   case chipAY:
-    filePrintf(fileId, "- *AY8910* Clock: %d\n", project->chipSetup.ay.clock);
-    filePrintf(fileId, "- *AY8910* AY/YM: %d\n", project->chipSetup.ay.isYM);
+    writeDecimalLine(writer, "- *AY8910* Clock: ", project->chipSetup.ay.clock);
+    writeDecimalLine(writer, "- *AY8910* AY/YM: ", project->chipSetup.ay.isYM);
     switch (project->chipSetup.ay.stereoMode) {
     case ayStereoABC:
-      filePrintf(fileId, "- *AY8910* Stereo: ABC\n");
+      writeText(writer, "- *AY8910* Stereo: ABC\n");
       break;
     case ayStereoACB:
-      filePrintf(fileId, "- *AY8910* Stereo: ACB\n");
+      writeText(writer, "- *AY8910* Stereo: ACB\n");
       break;
     case ayStereoBAC:
-      filePrintf(fileId, "- *AY8910* Stereo: BAC\n");
+      writeText(writer, "- *AY8910* Stereo: BAC\n");
       break;
     }
-    filePrintf(fileId, "- *AY8910* Stereo separation: %d\n", project->chipSetup.ay.stereoSeparation);
+    writeDecimalLine(writer, "- *AY8910* Stereo separation: ", project->chipSetup.ay.stereoSeparation);
     break;
   default:
     break;
-}
+  }
 
-  projectSavePitchTable(fileId, project);
-  projectSaveSong(fileId, project);
-  projectSaveChains(fileId, project);
-  projectSaveGrooves(fileId, project);
-  projectSavePhrases(fileId, project);
-  projectSaveInstruments(fileId, project);
-  projectSaveTables(fileId, project);
-  filePrintf(fileId, "EOF\n");
-  return 0;
+  projectSavePitchTable(writer, project);
+  projectSaveSong(writer, project);
+  projectSaveChains(writer, project);
+  projectSaveGrooves(writer, project);
+  projectSavePhrases(writer, project);
+  projectSaveInstruments(writer, project);
+  projectSaveTables(writer, project);
+  writeText(writer, "EOF\n");
 }
 
 int projectSave(Project* p, const char* path) {
   projectFileError[0] = 0;
 
-  int fileId = fileOpen(path, 1);
-  if (fileId == -1) return 1;
-
-  int result = projectSaveInternal(fileId, p);
-  fileClose(fileId);
-  return result;
+  TextWriter writer = {0};
+  projectSaveInternal(&writer, p);
+  return textWriterSave(&writer, path);
 }
 
 // Convenience functions
@@ -817,18 +1217,11 @@ char* noteName(Project* project, uint8_t note) {
 int instrumentSave(Project* project, const char* path, int instrumentIdx) {
   projectFileError[0] = 0;
 
-  int fileId = fileOpen(path, 1);
-  if (fileId == -1) {
-    sprintf(projectFileError, "Can't open file");
-    return 1;
-  }
-
-  filePrintf(fileId, "# ChipNomad Instrument\n\n");
-  saveInstrument(fileId, 0, &project->instruments[instrumentIdx]);
-  saveTable(fileId, 0, &project->tables[instrumentIdx]);
-
-  fileClose(fileId);
-  return 0;
+  TextWriter writer = {0};
+  writeText(&writer, "# ChipNomad Instrument\n\n");
+  saveInstrument(&writer, 0, &project->instruments[instrumentIdx]);
+  saveTable(&writer, 0, &project->tables[instrumentIdx]);
+  return textWriterSave(&writer, path);
 }
 
 static int instrumentLoadInternal(int fileId, Project* project, int instrumentIdx) {
@@ -854,7 +1247,9 @@ int instrumentLoad(Project* project, const char* path, int instrumentIdx) {
     return 1;
   }
 
+  lpstr = NULL;
   int result = instrumentLoadInternal(fileId, project, instrumentIdx);
+  setLoadError(result);
   fileClose(fileId);
   return result;
 }
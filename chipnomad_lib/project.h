@@ -4,12 +4,33 @@
 #include <stdint.h>
 
 #define PROJECT_MAX_TRACKS (10)
+#define PROJECT_MAX_GROOVES (32)
+#define PROJECT_MAX_INSTRUMENTS (128)
+
+// Song rows, chains, phrases and tables can be set at build time, e.g.
+// -DPROJECT_MAX_PHRASES=4096. Project reserves memory for all of them, so lower
+// limits save memory on small targets. Indices have to fit the file formats and
+// the screens: 2 hex digits for song rows, chains and tables, 3 for phrases.
+// Tables go at least up to the last instrument, as each has a default table
+#ifndef PROJECT_MAX_LENGTH
 #define PROJECT_MAX_LENGTH (256)
+#endif
+#ifndef PROJECT_MAX_CHAINS
 #define PROJECT_MAX_CHAINS (255)
+#endif
+#ifndef PROJECT_MAX_PHRASES
 #define PROJECT_MAX_PHRASES (1024)
-#define PROJECT_MAX_GROOVES (32)
-#define PROJECT_MAX_INSTRUMENTS (128)
+#endif
+#ifndef PROJECT_MAX_TABLES
 #define PROJECT_MAX_TABLES (255)
+#endif
+
+#if PROJECT_MAX_LENGTH > 256 || PROJECT_MAX_CHAINS > 255 || PROJECT_MAX_PHRASES > 4096 || PROJECT_MAX_TABLES > 255
+#error "Project limits don't fit the indices"
+#endif
+#if PROJECT_MAX_TABLES < PROJECT_MAX_INSTRUMENTS
+#error "Every instrument needs a default table"
+#endif
 #define PROJECT_MAX_CHIPS (3)
 #define PROJECT_MAX_PITCHES (254)
 #define PROJECT_INSTRUMENT_NAME_LENGTH (15)
@@ -24,6 +45,8 @@
 
 // FX
 
+// Binary projects store FX by name in a table (see project_binary.c), so FX
+// can be added anywhere in this list
 enum FX {
   fxARP, // Arpeggio
   fxARC, // Arpeggio config
@@ -77,15 +100,16 @@ extern int fxAYCount;
 
 // Chips
 
+// Values of the enums below are stored in project files, don't renumber them
 enum ChipType {
   chipAY = 0,
   chipTotalCount,
 };
 
 enum StereoModeAY {
-  ayStereoABC,
-  ayStereoACB,
-  ayStereoBAC,
+  ayStereoABC = 0,
+  ayStereoACB = 1,
+  ayStereoBAC = 2,
 };
 
 typedef struct ChipSetupAY {
@@ -114,6 +138,7 @@ typedef struct Table {
 
 // Instruments
 
+// Stored in project files, don't renumber
 enum InstrumentType {
   instNone = 0,
   instAY = 1,
@@ -204,16 +229,41 @@ typedef struct Project {
   Table tables[PROJECT_MAX_TABLES];
 } Project;
 
+// Header fields of a project file, read without loading the rest of it
+typedef struct ProjectInfo {
+  char title[PROJECT_TITLE_LENGTH + 1];
+  char author[PROJECT_TITLE_LENGTH + 1];
+  float tickRate;
+  enum ChipType chipType;
+  int chipsCount;
+  int songLength; // Rows up to the last one with a chain
+} ProjectInfo;
+
 extern char projectFileError[41];
 
 // Fill FX names (call this first before loading any projects)
 void fillFXNames();
+// FX with the 3 character name, -1 if there's none
+int fxFindByName(const char* name);
 // Initialize an empty project
 void projectInit(Project* p);
 // Load project from a file
 int projectLoad(Project* p, const char* path);
 // Save project to a file
 int projectSave(Project* p, const char* path);
+// Load project from a binary (.cnb) file
+int projectLoadBinary(Project* p, const char* path);
+// Save project to a binary (.cnb) file
+int projectSaveBinary(Project* p, const char* path);
+// Does the file header belong to a binary project?
+int projectIsBinary(const uint8_t* header, int length);
+// Read the header and song length of a .cnm or .cnb file
+int projectLoadInfo(ProjectInfo* info, const char* path);
+// Read the header and song length of a binary (.cnb) file
+int projectLoadBinaryInfo(ProjectInfo* info, const char* path);
+// Write data to "<path>.tmp" and rename it over the file, so a failed save
+// leaves the old file as it was. Returns 1 on failure
+int projectWriteFile(const char* path, const void* data, int size);
 // Save instrument to a file
 int instrumentSave(Project* p, const char* path, int instrumentIdx);
 // Load instrument from a file
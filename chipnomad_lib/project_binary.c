@@ -0,0 +1,651 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "project.h"
+#include "corelib/corelib_file.h"
+#include "utils.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Binary project format (.cnb). All values are little-endian.
+//
+// Header, 12 bytes: "CNB" 0x1A, u16 version, u16 sections count, u32 file size
+// Section table, 12 bytes per section: id (4 chars), u32 offset, u32 size
+//
+// Sections:
+//   INFO  title[25], author[25], f32 tick rate, u8 chip type, u8 chips count,
+//         u8 linear pitch, AY setup: u32 clock, u8 YM, u8 stereo mode, u8 stereo separation
+//   FXNM  u8 count, per FX code from 0: name[3]
+//   PTCH  name[19], u16 octave size, u16 length, per pitch: u16 value, name[4]
+//   SONG  u16 rows, u8 tracks, per cell: u16 chain, then per cell: u8 highlight
+//   CHNS  per chain: u8 index, 16 rows of u16 phrase, u8 transpose
+//   GRVS  per groove: u8 index, 16 speeds
+//   PHRS  per phrase: u16 index, 16 rows of u8 note, u8 instrument, u8 volume,
+//         3 FX of u8 code, u8 value
+//   INST  per instrument: u8 index, u8 type, name[16], u8 table speed, u8 transpose,
+//         7 bytes in InstrumentAY order
+//   TBLS  per table: u8 index, 16 rows of u8 pitch flag, u8 pitch offset, u8 volume,
+//         4 FX of u8 code, u8 value
+//
+// FX codes in phrases and tables are looked up by name in FXNM, so enum FX can
+// change without breaking files. Files without FXNM use the codes of the first
+// version. Chip type, stereo mode and instrument type are the enum values, which
+// have fixed numbers.
+//
+// Empty chains, grooves, phrases, instruments and tables are left out, like in
+// the text format. Sections are found by id, unknown ones are skipped.
+//
+
+#define CNB_VERSION (1)
+#define CNB_HEADER_SIZE (12)
+#define CNB_SECTION_ENTRY_SIZE (12)
+#define CNB_SECTIONS_COUNT (9)
+
+static const uint8_t cnbMagic[4] = {'C', 'N', 'B', 0x1a};
+
+#define CNB_PHRASE_ROW_SIZE (9)
+#define CNB_TABLE_ROW_SIZE (11)
+
+// Rows are written field by field. A new field has to go into the format too
+_Static_assert(sizeof(PhraseRow) == CNB_PHRASE_ROW_SIZE, "PhraseRow fields don't match the .cnb format");
+_Static_assert(sizeof(TableRow) == CNB_TABLE_ROW_SIZE, "TableRow fields don't match the .cnb format");
+
+// FX codes of files without an FXNM section: the order of enum FX when the
+// format was introduced. Don't change
+static const char cnbFXNamesV1[][4] = {
+  "ARP", "ARC", "PVB", "PBN", "PSL", "PIT", "FIN", "PRD", "VOL", "RET", "DEL",
+  "OFF", "KIL", "TIC", "TBL", "TBX", "THO", "TXH", "GRV", "GGR", "HOP", "SNG",
+  "AYM", "ERT", "NOI", "NOA", "EAU", "EVB", "EBN", "ESL", "ENT", "EPT", "EPL", "EPH",
+};
+
+int projectIsBinary(const uint8_t* header, int length) {
+  return length >= 4 && memcmp(header, cnbMagic, 4) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Load
+
+typedef struct {
+  const uint8_t* data;
+  uint32_t size;
+  uint32_t pos;
+  int isFailed; // Read past the end
+} CNBReader;
+
+static const uint8_t* readBytes(CNBReader* reader, uint32_t length) {
+  if (reader->isFailed || length > reader->size - reader->pos) {
+    reader->isFailed = 1;
+    return NULL;
+  }
+  const uint8_t* bytes = reader->data + reader->pos;
+  reader->pos += length;
+  return bytes;
+}
+
+static uint8_t read8(CNBReader* reader) {
+  const uint8_t* bytes = readBytes(reader, 1);
+  return bytes ? bytes[0] : 0;
+}
+
+static uint16_t read16(CNBReader* reader) {
+  const uint8_t* bytes = readBytes(reader, 2);
+  return bytes ? readLE16(bytes) : 0;
+}
+
+static uint32_t read32(CNBReader* reader) {
+  const uint8_t* bytes = readBytes(reader, 4);
+  return bytes ? readLE32(bytes) : 0;
+}
+
+// Fixed size string, always terminated in the project
+static void readString(CNBReader* reader, char* string, int length) {
+  const uint8_t* bytes = readBytes(reader, length);
+  if (bytes) memcpy(string, bytes, length);
+  string[length - 1] = 0;
+}
+
+// Reader over a section's data, empty if the file doesn't have it
+static CNBReader findSection(const uint8_t* data, uint32_t fileSize, int sectionsCount, const char* id) {
+  CNBReader section = {data, 0, 0, 0};
+  CNBReader table = {data, fileSize, CNB_HEADER_SIZE, 0};
+
+  for (int c = 0; c < sectionsCount; c++) {
+    const uint8_t* entryId = readBytes(&table, 4);
+    uint32_t offset = read32(&table);
+    uint32_t size = read32(&table);
+    if (table.isFailed) break;
+    if (memcmp(entryId, id, 4)) continue;
+
+    if (offset > fileSize || size > fileSize - offset) {
+      section.isFailed = 1;
+    } else {
+      section.data = data + offset;
+      section.size = size;
+    }
+    break;
+  }
+  return section;
+}
+
+static int loadInfo(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  readString(reader, p->title, PROJECT_TITLE_LENGTH + 1);
+  readString(reader, p->author, PROJECT_TITLE_LENGTH + 1);
+  uint32_t tickRate = read32(reader);
+  memcpy(&p->tickRate, &tickRate, sizeof(float));
+  p->chipType = read8(reader);
+  p->chipsCount = read8(reader);
+  p->linearPitch = read8(reader);
+  p->chipSetup.ay.clock = (int)read32(reader);
+  p->chipSetup.ay.isYM = read8(reader);
+  p->chipSetup.ay.stereoMode = read8(reader);
+  p->chipSetup.ay.stereoSeparation = read8(reader);
+
+  if (reader->isFailed || p->chipType >= chipTotalCount) return 1;
+  if (p->chipsCount < 1 || p->chipsCount > PROJECT_MAX_CHIPS) return 1;
+  if (p->chipSetup.ay.stereoMode > ayStereoBAC) return 1;
+  p->tracksCount = projectGetTotalTracks(p);
+  return 0;
+}
+
+// FX of each code in the file. Unknown FX are left empty, like in the text format
+static void setFXCode(uint8_t* fxCodes, int code, const char* name) {
+  int fx = fxFindByName(name);
+  fxCodes[code] = fx < 0 ? EMPTY_VALUE_8 : fx;
+}
+
+static void setFXCodesV1(uint8_t* fxCodes) {
+  memset(fxCodes, EMPTY_VALUE_8, 256);
+  for (int c = 0; c < (int)(sizeof(cnbFXNamesV1) / sizeof(cnbFXNamesV1[0])); c++) {
+    setFXCode(fxCodes, c, cnbFXNamesV1[c]);
+  }
+}
+
+static int loadFXNames(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  int count = read8(reader);
+  if (count == EMPTY_VALUE_8) return 1;
+
+  memset(fxCodes, EMPTY_VALUE_8, 256);
+  for (int c = 0; c < count; c++) {
+    const uint8_t* bytes = readBytes(reader, 3);
+    if (!bytes) return 1;
+    char name[4] = {bytes[0], bytes[1], bytes[2], 0};
+    setFXCode(fxCodes, c, name);
+  }
+  return reader->isFailed;
+}
+
+static uint8_t readFX(CNBReader* reader, const uint8_t* fxCodes) {
+  return fxCodes[read8(reader)];
+}
+
+static int loadPitchTable(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  readString(reader, p->pitchTable.name, PROJECT_PITCH_TABLE_TITLE_LENGTH + 1);
+  p->pitchTable.octaveSize = read16(reader);
+  p->pitchTable.length = read16(reader);
+  if (p->pitchTable.length > PROJECT_MAX_PITCHES) return 1;
+
+  for (int c = 0; c < p->pitchTable.length; c++) {
+    p->pitchTable.values[c] = read16(reader);
+    readString(reader, p->pitchTable.noteNames[c], 4);
+  }
+  return reader->isFailed;
+}
+
+static int loadSong(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  int rows = read16(reader);
+  int tracks = read8(reader);
+  if (rows > PROJECT_MAX_LENGTH || tracks != p->tracksCount) return 1;
+
+  for (int c = 0; c < rows; c++) {
+    for (int d = 0; d < tracks; d++) {
+      p->song[c][d] = read16(reader);
+    }
+  }
+  for (int c = 0; c < rows; c++) {
+    const uint8_t* highlight = readBytes(reader, tracks);
+    if (highlight) memcpy(p->songHighlight[c], highlight, tracks);
+  }
+  return reader->isFailed;
+}
+
+static int loadChains(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  while (reader->pos < reader->size) {
+    int idx = read8(reader);
+    if (idx >= PROJECT_MAX_CHAINS) return 1;
+    for (int c = 0; c < 16; c++) {
+      p->chains[idx].rows[c].phrase = read16(reader);
+      p->chains[idx].rows[c].transpose = read8(reader);
+    }
+  }
+  return reader->isFailed;
+}
+
+static int loadGrooves(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  while (reader->pos < reader->size) {
+    int idx = read8(reader);
+    const uint8_t* speed = readBytes(reader, 16);
+    if (!speed || idx >= PROJECT_MAX_GROOVES) return 1;
+    memcpy(p->grooves[idx].speed, speed, 16);
+  }
+  return 0;
+}
+
+static int loadPhrases(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  while (reader->pos < reader->size) {
+    int idx = read16(reader);
+    if (idx >= PROJECT_MAX_PHRASES) return 1;
+    for (int c = 0; c < 16; c++) {
+      PhraseRow* row = &p->phrases[idx].rows[c];
+      row->note = read8(reader);
+      row->instrument = read8(reader);
+      row->volume = read8(reader);
+      for (int d = 0; d < 3; d++) {
+        row->fx[d][0] = readFX(reader, fxCodes);
+        row->fx[d][1] = read8(reader);
+      }
+    }
+  }
+  return reader->isFailed;
+}
+
+static int loadInstruments(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  while (reader->pos < reader->size) {
+    int idx = read8(reader);
+    if (idx >= PROJECT_MAX_INSTRUMENTS) return 1;
+    Instrument* instrument = &p->instruments[idx];
+    instrument->type = read8(reader);
+    readString(reader, instrument->name, PROJECT_INSTRUMENT_NAME_LENGTH + 1);
+    instrument->tableSpeed = read8(reader);
+    instrument->transposeEnabled = read8(reader);
+    instrument->chip.ay.veA = read8(reader);
+    instrument->chip.ay.veD = read8(reader);
+    instrument->chip.ay.veS = read8(reader);
+    instrument->chip.ay.veR = read8(reader);
+    instrument->chip.ay.autoEnvN = read8(reader);
+    instrument->chip.ay.autoEnvD = read8(reader);
+    instrument->chip.ay.defaultMixer = read8(reader);
+  }
+  return reader->isFailed;
+}
+
+static int loadTables(CNBReader* reader, Project* p, uint8_t* fxCodes) {
+  while (reader->pos < reader->size) {
+    int idx = read8(reader);
+    if (idx >= PROJECT_MAX_TABLES) return 1;
+    for (int c = 0; c < 16; c++) {
+      TableRow* row = &p->tables[idx].rows[c];
+      row->pitchFlag = read8(reader);
+      row->pitchOffset = read8(reader);
+      row->volume = read8(reader);
+      for (int d = 0; d < 4; d++) {
+        row->fx[d][0] = readFX(reader, fxCodes);
+        row->fx[d][1] = read8(reader);
+      }
+    }
+  }
+  return reader->isFailed;
+}
+
+typedef int (*CNBSectionLoader)(CNBReader* reader, Project* p, uint8_t* fxCodes);
+
+typedef struct {
+  const char* id;
+  CNBSectionLoader load;
+  int isRequired;
+} CNBSection;
+
+// In load order, the song needs the tracks count from the info and phrases and
+// tables need the FX codes
+static const CNBSection cnbSections[CNB_SECTIONS_COUNT] = {
+  {"INFO", loadInfo, 1},
+  {"FXNM", loadFXNames, 0},
+  {"PTCH", loadPitchTable, 1},
+  {"SONG", loadSong, 1},
+  {"CHNS", loadChains, 0},
+  {"GRVS", loadGrooves, 0},
+  {"PHRS", loadPhrases, 0},
+  {"INST", loadInstruments, 0},
+  {"TBLS", loadTables, 0},
+};
+
+// Returns the sections count, -1 if the header is wrong or the file is cut
+static int checkHeader(const uint8_t* data, long dataSize, uint32_t* checkedSize) {
+  sprintf(projectFileError, "Binary header");
+  if (dataSize < CNB_HEADER_SIZE || !projectIsBinary(data, CNB_HEADER_SIZE)) return -1;
+
+  CNBReader reader = {data, CNB_HEADER_SIZE, 4, 0};
+  int version = read16(&reader);
+  int sectionsCount = read16(&reader);
+  uint32_t fileSize = read32(&reader);
+  if (version > CNB_VERSION) {
+    sprintf(projectFileError, "Unsupported version %d", version);
+    return -1;
+  }
+  if (fileSize < CNB_HEADER_SIZE + (uint32_t)sectionsCount * CNB_SECTION_ENTRY_SIZE) return -1;
+  sprintf(projectFileError, "Truncated file");
+  if ((unsigned long)dataSize < fileSize) return -1;
+
+  *checkedSize = fileSize;
+  return sectionsCount;
+}
+
+static int projectLoadBinaryInternal(const uint8_t* data, long dataSize, Project* project) {
+  uint32_t fileSize;
+  int sectionsCount = checkHeader(data, dataSize, &fileSize);
+  if (sectionsCount < 0) return 1;
+
+  Project* p = malloc(sizeof(Project));
+  if (!p) {
+    sprintf(projectFileError, "Out of memory");
+    return 1;
+  }
+  projectInit(p);
+
+  uint8_t fxCodes[256];
+  setFXCodesV1(fxCodes);
+
+  int result = 1;
+  for (int c = 0; c < CNB_SECTIONS_COUNT; c++) {
+    const CNBSection* section = &cnbSections[c];
+    CNBReader sectionReader = findSection(data, fileSize, sectionsCount, section->id);
+    sprintf(projectFileError, "Section %s", section->id);
+    if (sectionReader.isFailed || (section->isRequired && sectionReader.size == 0)) goto done;
+    if (sectionReader.size > 0 && section->load(&sectionReader, p, fxCodes)) goto done;
+  }
+
+  memcpy(project, p, sizeof(Project));
+  projectFileError[0] = 0;
+  result = 0;
+
+done:
+  free(p);
+  return result;
+}
+
+int projectLoadBinary(Project* p, const char* path) {
+  projectFileError[0] = 0;
+
+  // The whole file is mapped, sections are read straight from it
+  long size;
+  const uint8_t* data = fileMap(path, &size);
+  if (data == NULL) {
+    sprintf(projectFileError, "Can't open file");
+    return 1;
+  }
+
+  int result = projectLoadBinaryInternal(data, size, p);
+  fileUnmap(data, size);
+  return result;
+}
+
+// Only the INFO section and the chains of the song
+static int projectLoadBinaryInfoInternal(const uint8_t* data, long dataSize, ProjectInfo* info) {
+  uint32_t fileSize;
+  int sectionsCount = checkHeader(data, dataSize, &fileSize);
+  if (sectionsCount < 0) return 1;
+  memset(info, 0, sizeof(ProjectInfo));
+
+  sprintf(projectFileError, "Section INFO");
+  CNBReader reader = findSection(data, fileSize, sectionsCount, "INFO");
+  readString(&reader, info->title, PROJECT_TITLE_LENGTH + 1);
+  readString(&reader, info->author, PROJECT_TITLE_LENGTH + 1);
+  uint32_t tickRate = read32(&reader);
+  memcpy(&info->tickRate, &tickRate, sizeof(float));
+  info->chipType = read8(&reader);
+  info->chipsCount = read8(&reader);
+  if (reader.isFailed || info->chipType >= chipTotalCount) return 1;
+
+  sprintf(projectFileError, "Section SONG");
+  reader = findSection(data, fileSize, sectionsCount, "SONG");
+  int rows = read16(&reader);
+  int tracks = read8(&reader);
+  if (rows > PROJECT_MAX_LENGTH) return 1;
+  for (int c = 0; c < rows; c++) {
+    for (int d = 0; d < tracks; d++) {
+      if (read16(&reader) != EMPTY_VALUE_16) info->songLength = c + 1;
+    }
+  }
+  if (reader.isFailed) return 1;
+
+  projectFileError[0] = 0;
+  return 0;
+}
+
+int projectLoadBinaryInfo(ProjectInfo* info, const char* path) {
+  projectFileError[0] = 0;
+
+  long size;
+  const uint8_t* data = fileMap(path, &size);
+  if (data == NULL) {
+    sprintf(projectFileError, "Can't open file");
+    return 1;
+  }
+
+  int result = projectLoadBinaryInfoInternal(data, size, info);
+  fileUnmap(data, size);
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Save
+
+typedef struct {
+  uint8_t* data;
+  uint32_t size;
+  uint32_t capacity;
+  int isFailed; // Out of memory
+} CNBWriter;
+
+static uint8_t* writeBytes(CNBWriter* writer, const void* bytes, uint32_t length) {
+  if (writer->isFailed) return NULL;
+  if (writer->size + length > writer->capacity) {
+    uint32_t capacity = writer->capacity ? writer->capacity : 65536;
+    while (capacity < writer->size + length) capacity *= 2;
+    uint8_t* data = realloc(writer->data, capacity);
+    if (!data) {
+      writer->isFailed = 1;
+      return NULL;
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+  }
+
+  uint8_t* dest = writer->data + writer->size;
+  if (bytes) memcpy(dest, bytes, length);
+  writer->size += length;
+  return dest;
+}
+
+static void write8(CNBWriter* writer, uint8_t value) {
+  writeBytes(writer, &value, 1);
+}
+
+static void write16(CNBWriter* writer, uint16_t value) {
+  uint8_t bytes[2];
+  writeLE16(bytes, value);
+  writeBytes(writer, bytes, 2);
+}
+
+static void write32(CNBWriter* writer, uint32_t value) {
+  uint8_t bytes[4];
+  writeLE32(bytes, value);
+  writeBytes(writer, bytes, 4);
+}
+
+// Fixed size string, zero padded
+static void writeString(CNBWriter* writer, const char* string, int length) {
+  uint8_t* dest = writeBytes(writer, NULL, length);
+  if (!dest) return;
+  memset(dest, 0, length);
+  for (int c = 0; c < length - 1 && string[c]; c++) {
+    dest[c] = string[c];
+  }
+}
+
+static void saveInfo(CNBWriter* writer, Project* p) {
+  writeString(writer, p->title, PROJECT_TITLE_LENGTH + 1);
+  writeString(writer, p->author, PROJECT_TITLE_LENGTH + 1);
+  uint32_t tickRate;
+  memcpy(&tickRate, &p->tickRate, sizeof(float));
+  write32(writer, tickRate);
+  write8(writer, p->chipType);
+  write8(writer, p->chipsCount);
+  write8(writer, p->linearPitch);
+  write32(writer, (uint32_t)p->chipSetup.ay.clock);
+  write8(writer, p->chipSetup.ay.isYM);
+  write8(writer, p->chipSetup.ay.stereoMode);
+  write8(writer, p->chipSetup.ay.stereoSeparation);
+}
+
+// Codes are the values of enum FX in this build
+static void saveFXNames(CNBWriter* writer, Project* p) {
+  write8(writer, fxTotalCount);
+  for (int c = 0; c < fxTotalCount; c++) {
+    writeBytes(writer, fxNames[c].name, 3);
+  }
+}
+
+static void savePitchTable(CNBWriter* writer, Project* p) {
+  writeString(writer, p->pitchTable.name, PROJECT_PITCH_TABLE_TITLE_LENGTH + 1);
+  write16(writer, p->pitchTable.octaveSize);
+  write16(writer, p->pitchTable.length);
+  for (int c = 0; c < p->pitchTable.length; c++) {
+    write16(writer, p->pitchTable.values[c]);
+    writeString(writer, p->pitchTable.noteNames[c], 4);
+  }
+}
+
+static void saveSong(CNBWriter* writer, Project* p) {
+  // Up to the last row with values, like in the text format
+  int rows = PROJECT_MAX_LENGTH;
+  while (rows > 0) {
+    int isEmpty = 1;
+    for (int c = 0; c < p->tracksCount; c++) {
+      if (p->song[rows - 1][c] != EMPTY_VALUE_16) isEmpty = 0;
+    }
+    if (!isEmpty) break;
+    rows--;
+  }
+
+  write16(writer, rows);
+  write8(writer, p->tracksCount);
+  for (int c = 0; c < rows; c++) {
+    for (int d = 0; d < p->tracksCount; d++) {
+      write16(writer, p->song[c][d]);
+    }
+  }
+  for (int c = 0; c < rows; c++) {
+    writeBytes(writer, p->songHighlight[c], p->tracksCount);
+  }
+}
+
+static void saveChains(CNBWriter* writer, Project* p) {
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    if (chainIsEmpty(p, c)) continue;
+    write8(writer, c);
+    for (int d = 0; d < 16; d++) {
+      write16(writer, p->chains[c].rows[d].phrase);
+      write8(writer, p->chains[c].rows[d].transpose);
+    }
+  }
+}
+
+static void saveGrooves(CNBWriter* writer, Project* p) {
+  for (int c = 0; c < PROJECT_MAX_GROOVES; c++) {
+    if (grooveIsEmpty(p, c)) continue;
+    write8(writer, c);
+    writeBytes(writer, p->grooves[c].speed, 16);
+  }
+}
+
+static void savePhrases(CNBWriter* writer, Project* p) {
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    if (phraseIsEmpty(p, c)) continue;
+    write16(writer, c);
+    for (int d = 0; d < 16; d++) {
+      PhraseRow* row = &p->phrases[c].rows[d];
+      uint8_t bytes[CNB_PHRASE_ROW_SIZE] = {
+        row->note, row->instrument, row->volume,
+        row->fx[0][0], row->fx[0][1], row->fx[1][0], row->fx[1][1], row->fx[2][0], row->fx[2][1],
+      };
+      writeBytes(writer, bytes, CNB_PHRASE_ROW_SIZE);
+    }
+  }
+}
+
+static void saveInstruments(CNBWriter* writer, Project* p) {
+  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
+    if (instrumentIsEmpty(p, c)) continue;
+    Instrument* instrument = &p->instruments[c];
+    write8(writer, c);
+    write8(writer, instrument->type);
+    writeString(writer, instrument->name, PROJECT_INSTRUMENT_NAME_LENGTH + 1);
+    write8(writer, instrument->tableSpeed);
+    write8(writer, instrument->transposeEnabled);
+    write8(writer, instrument->chip.ay.veA);
+    write8(writer, instrument->chip.ay.veD);
+    write8(writer, instrument->chip.ay.veS);
+    write8(writer, instrument->chip.ay.veR);
+    write8(writer, instrument->chip.ay.autoEnvN);
+    write8(writer, instrument->chip.ay.autoEnvD);
+    write8(writer, instrument->chip.ay.defaultMixer);
+  }
+}
+
+static void saveTables(CNBWriter* writer, Project* p) {
+  for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
+    if (tableIsEmpty(p, c)) continue;
+    write8(writer, c);
+    for (int d = 0; d < 16; d++) {
+      TableRow* row = &p->tables[c].rows[d];
+      uint8_t bytes[CNB_TABLE_ROW_SIZE] = {
+        row->pitchFlag, row->pitchOffset, row->volume,
+        row->fx[0][0], row->fx[0][1], row->fx[1][0], row->fx[1][1],
+        row->fx[2][0], row->fx[2][1], row->fx[3][0], row->fx[3][1],
+      };
+      writeBytes(writer, bytes, CNB_TABLE_ROW_SIZE);
+    }
+  }
+}
+
+typedef void (*CNBSectionSaver)(CNBWriter* writer, Project* p);
+
+static const CNBSectionSaver cnbSavers[CNB_SECTIONS_COUNT] = {
+  saveInfo, saveFXNames, savePitchTable, saveSong, saveChains, saveGrooves, savePhrases, saveInstruments, saveTables,
+};
+
+int projectSaveBinary(Project* p, const char* path) {
+  projectFileError[0] = 0;
+
+  // Header and section table are filled in when sizes are known
+  CNBWriter writer = {NULL, 0, 0, 0};
+  writeBytes(&writer, NULL, CNB_HEADER_SIZE + CNB_SECTIONS_COUNT * CNB_SECTION_ENTRY_SIZE);
+
+  uint32_t offsets[CNB_SECTIONS_COUNT];
+  for (int c = 0; c < CNB_SECTIONS_COUNT; c++) {
+    offsets[c] = writer.size;
+    cnbSavers[c](&writer, p);
+  }
+
+  if (writer.isFailed) {
+    free(writer.data);
+    sprintf(projectFileError, "Out of memory");
+    return 1;
+  }
+
+  CNBWriter header = {writer.data, 0, writer.capacity, 0};
+  writeBytes(&header, cnbMagic, 4);
+  write16(&header, CNB_VERSION);
+  write16(&header, CNB_SECTIONS_COUNT);
+  write32(&header, writer.size);
+  for (int c = 0; c < CNB_SECTIONS_COUNT; c++) {
+    uint32_t end = c + 1 < CNB_SECTIONS_COUNT ? offsets[c + 1] : writer.size;
+    writeBytes(&header, cnbSections[c].id, 4);
+    write32(&header, offsets[c]);
+    write32(&header, end - offsets[c]);
+  }
+
+  int result = projectWriteFile(path, writer.data, writer.size);
+  free(writer.data);
+  return result;
+}
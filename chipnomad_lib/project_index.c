@@ -0,0 +1,213 @@
+#include "project_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_MIN_CAPACITY (64)
+
+static const char* indexHeader = "# ChipNomad project index 1";
+
+static int compareEntries(const void* a, const void* b) {
+  return strcmp(((const ProjectIndexEntry*)a)->name, ((const ProjectIndexEntry*)b)->name);
+}
+
+// Position of the entry with the name, or where it would go
+static int findPosition(ProjectIndex* index, const char* name, int* isFound) {
+  int low = 0;
+  int high = index->count;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    int cmp = strcmp(index->entries[mid].name, name);
+    if (cmp == 0) {
+      *isFound = 1;
+      return mid;
+    }
+    if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  *isFound = 0;
+  return low;
+}
+
+// Returns the new cleared entry, NULL if out of memory
+static ProjectIndexEntry* insertEntry(ProjectIndex* index, int pos) {
+  if (index->count == index->capacity) {
+    int capacity = index->capacity ? index->capacity * 2 : INDEX_MIN_CAPACITY;
+    ProjectIndexEntry* entries = realloc(index->entries, capacity * sizeof(ProjectIndexEntry));
+    if (!entries) return NULL;
+    index->entries = entries;
+    index->capacity = capacity;
+  }
+
+  memmove(&index->entries[pos + 1], &index->entries[pos], (index->count - pos) * sizeof(ProjectIndexEntry));
+  index->count++;
+  memset(&index->entries[pos], 0, sizeof(ProjectIndexEntry));
+  return &index->entries[pos];
+}
+
+// Cuts the field at the next tab. Missing fields are empty
+static char* nextField(char** line) {
+  char* field = *line;
+  if (!field) return "";
+  char* tab = strchr(field, '\t');
+  if (tab) {
+    *tab = 0;
+    *line = tab + 1;
+  } else {
+    *line = NULL;
+  }
+  return field;
+}
+
+static void copyField(char* dest, const char* field, int length) {
+  strncpy(dest, field, length);
+  dest[length] = 0;
+}
+
+static void loadIndexFile(ProjectIndex* index) {
+  int fileId = fileOpen(index->indexPath, 0);
+  if (fileId == -1) return;
+
+  int length;
+  char* line = fileReadLine(fileId, &length);
+  if (line && !strcmp(line, indexHeader)) {
+    while ((line = fileReadLine(fileId, &length))) {
+      long size = atol(nextField(&line));
+      long long modifiedTime = strtoll(nextField(&line), NULL, 10);
+      int isValid = atoi(nextField(&line));
+      int chipType = atoi(nextField(&line));
+      int chipsCount = atoi(nextField(&line));
+      float tickRate = strtof(nextField(&line), NULL);
+      int songLength = atoi(nextField(&line));
+      const char* name = nextField(&line);
+      if (!name[0] || strlen(name) > 255 || chipType < 0 || chipType >= chipTotalCount) continue;
+
+      ProjectIndexEntry* entry = insertEntry(index, index->count);
+      if (!entry) break;
+      strcpy(entry->name, name);
+      entry->size = size;
+      entry->modifiedTime = modifiedTime;
+      entry->isValid = isValid;
+      entry->info.chipType = chipType;
+      entry->info.chipsCount = chipsCount;
+      entry->info.tickRate = tickRate;
+      entry->info.songLength = songLength;
+      copyField(entry->info.title, nextField(&line), PROJECT_TITLE_LENGTH);
+      copyField(entry->info.author, nextField(&line), PROJECT_TITLE_LENGTH);
+    }
+    qsort(index->entries, index->count, sizeof(ProjectIndexEntry), compareEntries);
+  }
+  fileClose(fileId);
+}
+
+ProjectIndex* projectIndexOpen(const char* folder) {
+  ProjectIndex* index = calloc(1, sizeof(ProjectIndex));
+  if (!index) return NULL;
+
+  snprintf(index->folder, sizeof(index->folder), "%s", folder);
+  snprintf(index->indexPath, sizeof(index->indexPath), "%s%s%s", index->folder, PATH_SEPARATOR_STR, PROJECT_INDEX_FILENAME);
+  loadIndexFile(index);
+  return index;
+}
+
+const ProjectIndexEntry* projectIndexFind(ProjectIndex* index, const char* name, long size, long long modifiedTime) {
+  int isFound;
+  int pos = findPosition(index, name, &isFound);
+  if (!isFound) return NULL;
+
+  ProjectIndexEntry* entry = &index->entries[pos];
+  if (entry->size != size || entry->modifiedTime != modifiedTime) return NULL;
+  return entry;
+}
+
+const ProjectIndexEntry* projectIndexUpdate(ProjectIndex* index, const char* name, long size, long long modifiedTime) {
+  if (strlen(name) > 255) return NULL;
+
+  int isFound;
+  int pos = findPosition(index, name, &isFound);
+  ProjectIndexEntry* entry = isFound ? &index->entries[pos] : insertEntry(index, pos);
+  if (!entry) return NULL;
+
+  strcpy(entry->name, name);
+  entry->size = size;
+  entry->modifiedTime = modifiedTime;
+
+  char path[4096];
+  snprintf(path, sizeof(path), "%s%s%s", index->folder, PATH_SEPARATOR_STR, name);
+  entry->isValid = !projectLoadInfo(&entry->info, path);
+  if (!entry->isValid) memset(&entry->info, 0, sizeof(ProjectInfo));
+
+  index->isChanged = 1;
+  return entry;
+}
+
+void projectIndexRetain(ProjectIndex* index, const FileEntry* files, int filesCount) {
+  int kept = 0;
+  for (int c = 0; c < index->count; c++) {
+    int isListed = 0;
+    for (int f = 0; f < filesCount && !isListed; f++) {
+      isListed = !files[f].isDirectory && !strcmp(files[f].name, index->entries[c].name);
+    }
+    if (isListed) {
+      if (kept != c) index->entries[kept] = index->entries[c];
+      kept++;
+    }
+  }
+
+  if (kept != index->count) {
+    index->count = kept;
+    index->isChanged = 1;
+  }
+}
+
+// Tabs and line breaks would split the line
+static int isStorable(const char* str) {
+  return strpbrk(str, "\t\r\n") == NULL;
+}
+
+static void storableCopy(char* dest, const char* str) {
+  strcpy(dest, str);
+  for (char* c = dest; (c = strpbrk(c, "\t\r\n")); c++) *c = ' ';
+}
+
+int projectIndexSave(ProjectIndex* index) {
+  if (!index->isChanged) return 0;
+
+  char tempPath[2200];
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", index->indexPath);
+  int fileId = fileOpen(tempPath, 1);
+  if (fileId == -1) return 1;
+
+  int result = filePrintf(fileId, "%s\n", indexHeader) <= 0;
+  for (int c = 0; c < index->count && !result; c++) {
+    ProjectIndexEntry* entry = &index->entries[c];
+    ProjectInfo* info = &entry->info;
+    if (!isStorable(entry->name)) continue;
+    char title[PROJECT_TITLE_LENGTH + 1];
+    char author[PROJECT_TITLE_LENGTH + 1];
+    storableCopy(title, info->title);
+    storableCopy(author, info->author);
+
+    result = filePrintf(fileId, "%ld\t%lld\t%d\t%d\t%d\t%f\t%d\t%s\t%s\t%s\n",
+      entry->size, entry->modifiedTime, entry->isValid, info->chipType, info->chipsCount, info->tickRate,
+      info->songLength, entry->name, title, author) <= 0;
+  }
+  if (fileClose(fileId)) result = 1;
+
+  if (!result && fileRename(tempPath, index->indexPath)) result = 1;
+  if (result) {
+    fileDelete(tempPath);
+  } else {
+    index->isChanged = 0;
+  }
+  return result;
+}
+
+void projectIndexClose(ProjectIndex* index) {
+  if (!index) return;
+  free(index->entries);
+  free(index);
+}
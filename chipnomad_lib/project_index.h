@@ -0,0 +1,53 @@
+#ifndef __PROJECT_INDEX_H__
+#define __PROJECT_INDEX_H__
+
+#include "project.h"
+#include "corelib/corelib_file.h"
+
+// Cached info of the project files in a folder, so a file browser can show
+// titles, chips and song lengths without reading every file. The index lives in
+// the folder as PROJECT_INDEX_FILENAME, a text file with a line per project:
+//
+//   # ChipNomad project index 1
+//   size, modified time, is valid, chip type, chips count, tick rate,
+//   song length, file name, title, author (separated by tabs)
+//
+// Nothing is read from the projects when the index is opened. Entries are
+// checked against the size and modified time from the directory listing, and a
+// file that is new or has changed is only read when its entry is updated. Files
+// that aren't readable projects get an entry too, so they aren't read again.
+
+#define PROJECT_INDEX_FILENAME ".chipnomad_index"
+
+typedef struct ProjectIndexEntry {
+  char name[256];
+  long size;
+  long long modifiedTime;
+  int isValid; // 0 if the file couldn't be read as a project
+  ProjectInfo info;
+} ProjectIndexEntry;
+
+typedef struct ProjectIndex {
+  char folder[2048];
+  char indexPath[2100];
+  ProjectIndexEntry* entries; // Sorted by name
+  int count;
+  int capacity;
+  int isChanged; // Not saved yet
+} ProjectIndex;
+
+// Open the folder's index, empty if there's none yet. Returns NULL if out of memory
+ProjectIndex* projectIndexOpen(const char* folder);
+// The entry of a file if it's up to date, NULL otherwise
+const ProjectIndexEntry* projectIndexFind(ProjectIndex* index, const char* name, long size, long long modifiedTime);
+// Read the file's info into its entry. Returns NULL if out of memory
+const ProjectIndexEntry* projectIndexUpdate(ProjectIndex* index, const char* name, long size, long long modifiedTime);
+// Drop the entries of files that aren't in the listing anymore
+void projectIndexRetain(ProjectIndex* index, const FileEntry* files, int filesCount);
+// Write the index to the folder if it has changed. Returns 1 on failure, for
+// example in a read-only folder
+int projectIndexSave(ProjectIndex* index);
+// Free the index without saving
+void projectIndexClose(ProjectIndex* index);
+
+#endif
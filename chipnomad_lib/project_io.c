@@ -0,0 +1,89 @@
+#include "project_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "corelib/corelib_thread.h"
+
+struct ProjectIO {
+  char path[4096];
+  Project* project; // Staging project for loads, copy of the saved project for saves
+  ProjectSnapshot* snapshot; // Restored into the copy by the worker
+  int isSave;
+  int threadId;
+  int startTicks;
+  // Shared with the worker, accessed atomically
+  int isDone;
+  int result;
+};
+
+static int projectIORun(void* arg) {
+  ProjectIO* io = arg;
+
+  if (io->snapshot) {
+    projectSnapshotRestore(io->snapshot, io->project);
+    projectSnapshotFree(io->snapshot);
+    io->snapshot = NULL;
+  }
+  int result = io->isSave ? projectSave(io->project, io->path) : projectLoad(io->project, io->path);
+  atomicSet(&io->result, result);
+  atomicSet(&io->isDone, 1);
+  return 0;
+}
+
+static ProjectIO* projectIOStart(Project* p, ProjectSnapshot* snapshot, const char* path, int isSave) {
+  ProjectIO* io = calloc(1, sizeof(ProjectIO));
+  Project* project = calloc(1, sizeof(Project));
+  if (!io || !project) {
+    free(io);
+    free(project);
+    projectSnapshotFree(snapshot);
+    sprintf(projectFileError, "Out of memory");
+    return NULL;
+  }
+
+  snprintf(io->path, sizeof(io->path), "%s", path);
+  io->project = project;
+  io->snapshot = snapshot;
+  io->isSave = isSave;
+  // The copy is made here, edits made during the save go to the next one
+  if (p) *project = *p;
+
+  io->startTicks = threadTicks();
+  io->threadId = threadStart(projectIORun, io);
+  // No thread available, do it now
+  if (io->threadId == -1) projectIORun(io);
+  return io;
+}
+
+ProjectIO* projectIOLoad(const char* path) {
+  return projectIOStart(NULL, NULL, path, 0);
+}
+
+ProjectIO* projectIOSave(Project* p, const char* path) {
+  return projectIOStart(p, NULL, path, 1);
+}
+
+ProjectIO* projectIOSaveSnapshot(ProjectSnapshot* snapshot, const char* path) {
+  return projectIOStart(NULL, snapshot, path, 1);
+}
+
+int projectIOIsDone(ProjectIO* io) {
+  return atomicGet(&io->isDone);
+}
+
+int projectIOElapsed(ProjectIO* io) {
+  return threadTicks() - io->startTicks;
+}
+
+int projectIOFinish(ProjectIO* io, Project** loaded) {
+  if (io->threadId != -1) threadJoin(io->threadId);
+  int result = io->result;
+
+  if (!io->isSave && !result && loaded) {
+    *loaded = io->project;
+  } else {
+    if (loaded) *loaded = NULL;
+    free(io->project);
+  }
+  free(io);
+  return result;
+}
@@ -0,0 +1,38 @@
+#ifndef __PROJECT_IO_H__
+#define __PROJECT_IO_H__
+
+#include "project.h"
+#include "project_snapshot.h"
+
+// Project loads and saves on a worker thread, so the caller's loop keeps
+// running while the file is read or written. Without threads they run on the
+// caller's thread when started.
+//
+// Loads parse into a staging project, the caller's project is untouched until
+// the staging one is swapped in (see chipnomadSetProject). Saves write a copy
+// or a snapshot made when the save starts, so the project can be edited while
+// it's written.
+//
+// The parser and projectFileError are shared, so only one load or save should
+// run at a time and other project files shouldn't be loaded or saved meanwhile.
+
+typedef struct ProjectIO ProjectIO;
+
+// Start loading a .cnm or .cnb project. Returns NULL if out of memory
+ProjectIO* projectIOLoad(const char* path);
+// Start saving a copy of the project. Returns NULL if out of memory
+ProjectIO* projectIOSave(Project* p, const char* path);
+// Start saving a snapshot, the worker frees it. Cheaper for the caller than
+// projectIOSave when the snapshot shares pages with an earlier one. Returns
+// NULL if out of memory
+ProjectIO* projectIOSaveSnapshot(ProjectSnapshot* snapshot, const char* path);
+// Returns 1 when the load or save has finished
+int projectIOIsDone(ProjectIO* io);
+// Milliseconds since the load or save started
+int projectIOElapsed(ProjectIO* io);
+// Wait for the load or save to finish and free it. Returns 1 on failure, with
+// projectFileError set. The loaded project goes to *loaded (NULL on failure or
+// for saves), the caller frees it
+int projectIOFinish(ProjectIO* io, Project** loaded);
+
+#endif
@@ -0,0 +1,240 @@
+#include "project_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "corelib/corelib_file.h"
+#include "utils.h"
+
+#define JOURNAL_MAX_RECORD (4096)
+
+static const uint8_t journalMagic[4] = {'C', 'N', 'J', '2'};
+
+// Size and FNV-1a hash of the snapshot file. Returns 1 if it can't be read
+static int snapshotIdentity(const char* snapshotPath, uint32_t* size, uint32_t* hash) {
+  long length;
+  const uint8_t* data = fileMap(snapshotPath, &length);
+  if (!data) return 1;
+
+  *hash = 2166136261u;
+  for (long c = 0; c < length; c++) {
+    *hash = (*hash ^ data[c]) * 16777619u;
+  }
+  *size = (uint32_t)length;
+  fileUnmap(data, length);
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Load
+
+// Apply the records of a journal that follows the snapshot with the given
+// identity. Returns number of records applied
+static long replay(Project* p, const uint8_t* data, long size, uint32_t snapshotSize, uint32_t snapshotHash) {
+  if (size < PROJECT_JOURNAL_HEADER_SIZE || memcmp(data, journalMagic, 4) || readLE32(data + 4) != sizeof(Project) ||
+    readLE32(data + 8) != snapshotSize || readLE32(data + 12) != snapshotHash) {
+    return 0;
+  }
+
+  long count = 0;
+  long pos = PROJECT_JOURNAL_HEADER_SIZE;
+  while (pos + PROJECT_JOURNAL_RECORD_HEADER_SIZE <= size) {
+    uint32_t offset = readLE32(data + pos);
+    uint32_t length = data[pos + 4] | (data[pos + 5] << 8);
+    pos += PROJECT_JOURNAL_RECORD_HEADER_SIZE;
+    // Cut short or not from this journal
+    if (pos + length > size || offset + length > sizeof(Project)) break;
+    memcpy((uint8_t*)p + offset, data + pos, length);
+    pos += length;
+    count++;
+  }
+  return count;
+}
+
+int projectJournalLoad(Project* p, const char* snapshotPath) {
+  Project* loaded = malloc(sizeof(Project));
+  if (!loaded) {
+    sprintf(projectFileError, "Out of memory");
+    return 1;
+  }
+  if (projectLoad(loaded, snapshotPath)) {
+    free(loaded);
+    return 1;
+  }
+
+  char journalPath[4096 + 16];
+  snprintf(journalPath, sizeof(journalPath), "%s.journal", snapshotPath);
+  long size;
+  uint32_t snapshotSize, snapshotHash;
+  const uint8_t* data = fileMap(journalPath, &size);
+  if (data) {
+    if (!snapshotIdentity(snapshotPath, &snapshotSize, &snapshotHash)) {
+      replay(loaded, data, size, snapshotSize, snapshotHash);
+    }
+    fileUnmap(data, size);
+  }
+
+  memcpy(p, loaded, sizeof(Project));
+  free(loaded);
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Save
+
+int projectJournalOpen(ProjectJournal* journal, Project* p, const char* snapshotPath) {
+  snprintf(journal->snapshotPath, sizeof(journal->snapshotPath), "%s", snapshotPath);
+  snprintf(journal->journalPath, sizeof(journal->journalPath), "%s.journal", snapshotPath);
+  journal->fileId = -1;
+  journal->size = 0;
+  journal->recordsCount = 0;
+  journal->shadow = NULL;
+
+  if (projectJournalCompact(journal, p)) {
+    projectJournalClose(journal);
+    return 1;
+  }
+  return 0;
+}
+
+int projectJournalCompact(ProjectJournal* journal, Project* p) {
+  if (journal->fileId != -1) {
+    fileClose(journal->fileId);
+    journal->fileId = -1;
+  }
+
+  // The new snapshot replaces the old one before the journal is emptied. After
+  // a crash in between, the old journal doesn't match the snapshot and is skipped
+  uint32_t snapshotSize, snapshotHash;
+  if (projectSave(p, journal->snapshotPath)) return 1;
+  if (snapshotIdentity(journal->snapshotPath, &snapshotSize, &snapshotHash)) {
+    sprintf(projectFileError, "Can't read snapshot");
+    return 1;
+  }
+  ProjectSnapshot* shadow = projectSnapshotTake(p, journal->shadow);
+  if (!shadow) {
+    sprintf(projectFileError, "Out of memory");
+    return 1;
+  }
+  projectSnapshotFree(journal->shadow);
+  journal->shadow = shadow;
+
+  journal->fileId = fileOpen(journal->journalPath, 1);
+  if (journal->fileId == -1) {
+    sprintf(projectFileError, "Can't open journal");
+    return 1;
+  }
+
+  uint8_t header[PROJECT_JOURNAL_HEADER_SIZE];
+  memcpy(header, journalMagic, 4);
+  writeLE32(header + 4, sizeof(Project));
+  writeLE32(header + 8, snapshotSize);
+  writeLE32(header + 12, snapshotHash);
+  journal->size = PROJECT_JOURNAL_HEADER_SIZE;
+  journal->recordsCount = 0;
+  if (fileWrite(journal->fileId, header, PROJECT_JOURNAL_HEADER_SIZE) != PROJECT_JOURNAL_HEADER_SIZE ||
+    fileFlush(journal->fileId)) {
+    sprintf(projectFileError, "Journal write failed");
+    return 1;
+  }
+  return 0;
+}
+
+typedef struct JournalBatch {
+  uint8_t data[PROJECT_JOURNAL_MAX_SIZE];
+  long size;
+  long recordsCount;
+  int isFull;
+} JournalBatch;
+
+static void addRecord(JournalBatch* batch, const uint8_t* project, uint32_t offset, uint32_t length) {
+  if (batch->size + PROJECT_JOURNAL_RECORD_HEADER_SIZE + length > PROJECT_JOURNAL_MAX_SIZE) {
+    batch->isFull = 1;
+    return;
+  }
+  uint8_t* record = batch->data + batch->size;
+  writeLE32(record, offset);
+  writeLE16(record + 4, length);
+  memcpy(record + PROJECT_JOURNAL_RECORD_HEADER_SIZE, project + offset, length);
+  batch->size += PROJECT_JOURNAL_RECORD_HEADER_SIZE + length;
+  batch->recordsCount++;
+}
+
+// Records for the changed blocks of the pages that aren't shared with the
+// shadow, neighbouring blocks are merged
+static void diffProject(JournalBatch* batch, const uint8_t* project, ProjectSnapshot* next, ProjectSnapshot* shadow) {
+  uint32_t runStart = 0;
+  uint32_t runEnd = 0;
+
+  for (int page = 0; page < PROJECT_SNAPSHOT_PAGES_COUNT && !batch->isFull; page++) {
+    const uint8_t* newData = projectSnapshotPage(next, page);
+    const uint8_t* oldData = projectSnapshotPage(shadow, page);
+    if (newData == oldData) continue;
+
+    uint32_t pageStart = page * PROJECT_SNAPSHOT_PAGE_SIZE;
+    uint32_t pageSize = projectSnapshotPageSize(page);
+    for (uint32_t block = 0; block < pageSize; block += PROJECT_JOURNAL_BLOCK) {
+      uint32_t blockEnd = block + PROJECT_JOURNAL_BLOCK < pageSize ? block + PROJECT_JOURNAL_BLOCK : pageSize;
+      if (!memcmp(newData + block, oldData + block, blockEnd - block)) continue;
+
+      if (runEnd == pageStart + block && runEnd - runStart < JOURNAL_MAX_RECORD) {
+        runEnd = pageStart + blockEnd;
+      } else {
+        if (runEnd > runStart) addRecord(batch, project, runStart, runEnd - runStart);
+        runStart = pageStart + block;
+        runEnd = pageStart + blockEnd;
+      }
+    }
+  }
+  if (runEnd > runStart) addRecord(batch, project, runStart, runEnd - runStart);
+}
+
+int projectJournalSync(ProjectJournal* journal, Project* p) {
+  if (journal->fileId == -1) return projectJournalCompact(journal, p);
+
+  // Only the pages touched since the last sync are copied and diffed by block
+  ProjectSnapshot* next = projectSnapshotTake(p, journal->shadow);
+  JournalBatch* batch = malloc(sizeof(JournalBatch));
+  if (!next || !batch) {
+    projectSnapshotFree(next);
+    free(batch);
+    return 1;
+  }
+  batch->size = 0;
+  batch->recordsCount = 0;
+  batch->isFull = 0;
+
+  diffProject(batch, (const uint8_t*)p, next, journal->shadow);
+
+  int result = 0;
+  if (batch->isFull || journal->size + batch->size > PROJECT_JOURNAL_MAX_SIZE) {
+    // Large changes, like loading another project, go to a new snapshot
+    projectSnapshotFree(next);
+    result = projectJournalCompact(journal, p);
+  } else if (batch->size > 0) {
+    if (fileWrite(journal->fileId, batch->data, batch->size) != batch->size || fileFlush(journal->fileId)) {
+      // Records after a partly written one would be misread, the next sync starts over
+      sprintf(projectFileError, "Journal write failed");
+      fileClose(journal->fileId);
+      journal->fileId = -1;
+      projectSnapshotFree(next);
+      result = 1;
+    } else {
+      projectSnapshotFree(journal->shadow);
+      journal->shadow = next;
+      journal->size += batch->size;
+      journal->recordsCount += batch->recordsCount;
+    }
+  } else {
+    projectSnapshotFree(next);
+  }
+
+  free(batch);
+  return result;
+}
+
+void projectJournalClose(ProjectJournal* journal) {
+  if (journal->fileId != -1) fileClose(journal->fileId);
+  journal->fileId = -1;
+  projectSnapshotFree(journal->shadow);
+  journal->shadow = NULL;
+}
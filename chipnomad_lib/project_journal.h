@@ -0,0 +1,58 @@
+#ifndef __PROJECT_JOURNAL_H__
+#define __PROJECT_JOURNAL_H__
+
+#include <stdint.h>
+#include "project.h"
+#include "project_snapshot.h"
+
+// Incremental autosave: a full project snapshot (.cnm) and an append-only
+// journal of the edits made since the snapshot was written. The journal lives
+// next to the snapshot as "<snapshot>.journal".
+//
+// Edits aren't reported by the screens. Each sync takes a snapshot of the
+// project based on the one from the previous sync and appends the changed byte
+// ranges of the pages it had to copy, so every change to the Project struct is
+// journaled, whoever made it.
+//
+// Journal, little-endian:
+//   0  "CNJ2"
+//   4  sizeof(Project) of the build that wrote it (uint32)
+//   8  size of the snapshot file it follows (uint32)
+//  12  FNV-1a hash of the snapshot file (uint32)
+//  16  records: offset in Project (uint32), length (uint16), new bytes
+//
+// Records only hold the blocks changed since their snapshot, so a journal is
+// replayed only over the snapshot file it names. A journal left behind by a
+// crash between writing a new snapshot and emptying the journal would undo
+// the newer edits, and is ignored. A record cut short by a crash is ignored.
+// A journal from a build with a different Project layout is ignored too.
+
+#define PROJECT_JOURNAL_HEADER_SIZE (16)
+#define PROJECT_JOURNAL_RECORD_HEADER_SIZE (6)
+#define PROJECT_JOURNAL_BLOCK (16) // Granularity of changed ranges
+#define PROJECT_JOURNAL_MAX_SIZE (65536) // Journal size that triggers compaction
+
+typedef struct ProjectJournal {
+  char snapshotPath[4096];
+  char journalPath[4096];
+  ProjectSnapshot* shadow; // Project as of the last sync, a base for other snapshots too
+  int fileId;
+  long size; // Bytes in the journal file
+  long recordsCount; // Records written since the last compaction
+} ProjectJournal;
+
+// Load the snapshot and replay its journal over it. Returns 1 if the snapshot
+// can't be loaded, the project is left as it was then
+int projectJournalLoad(Project* p, const char* snapshotPath);
+// Start journaling the project: writes it as a new snapshot and starts an
+// empty journal. Returns 1 on failure
+int projectJournalOpen(ProjectJournal* journal, Project* p, const char* snapshotPath);
+// Append changes made since the last sync and flush them. Compacts the journal
+// instead when it would grow over PROJECT_JOURNAL_MAX_SIZE. Returns 1 on failure
+int projectJournalSync(ProjectJournal* journal, Project* p);
+// Write the project as a new snapshot and empty the journal. Returns 1 on failure
+int projectJournalCompact(ProjectJournal* journal, Project* p);
+// Close the journal without syncing
+void projectJournalClose(ProjectJournal* journal);
+
+#endif
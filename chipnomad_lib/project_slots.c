@@ -0,0 +1,96 @@
+#include "project_slots.h"
+#include <string.h>
+
+static void useTable(ProjectSlots* slots, const uint8_t fx[2]) {
+  if ((fx[0] == fxTBL || fx[0] == fxTBX) && fx[1] < PROJECT_MAX_TABLES) slots->isTableUsed[fx[1]] = 1;
+}
+
+static int countUsed(const uint8_t* isUsed, int count) {
+  int used = 0;
+  for (int c = 0; c < count; c++) used += isUsed[c];
+  return used;
+}
+
+void projectSlotsScan(ProjectSlots* slots, Project* p) {
+  memset(slots, 0, sizeof(ProjectSlots));
+
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
+    for (int t = 0; t < PROJECT_MAX_TRACKS; t++) {
+      int chain = p->song[c][t];
+      if (chain < PROJECT_MAX_CHAINS) slots->isChainUsed[chain] = 1;
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    if (!chainIsEmpty(p, c)) slots->isChainUsed[c] = 1;
+    for (int r = 0; r < 16; r++) {
+      int phrase = p->chains[c].rows[r].phrase;
+      if (phrase < PROJECT_MAX_PHRASES) slots->isPhraseUsed[phrase] = 1;
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+    if (!phraseIsEmpty(p, c)) slots->isPhraseUsed[c] = 1;
+    for (int r = 0; r < 16; r++) {
+      for (int f = 0; f < 3; f++) useTable(slots, p->phrases[c].rows[r].fx[f]);
+    }
+  }
+
+  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
+    if (!instrumentIsEmpty(p, c)) slots->isTableUsed[c] = 1;
+  }
+  for (int c = 0; c < PROJECT_MAX_TABLES; c++) {
+    if (!tableIsEmpty(p, c)) slots->isTableUsed[c] = 1;
+    for (int r = 0; r < 16; r++) {
+      for (int f = 0; f < 4; f++) useTable(slots, p->tables[c].rows[r].fx[f]);
+    }
+  }
+
+  slots->chainsUsed = countUsed(slots->isChainUsed, PROJECT_MAX_CHAINS);
+  slots->phrasesUsed = countUsed(slots->isPhraseUsed, PROJECT_MAX_PHRASES);
+  slots->tablesUsed = countUsed(slots->isTableUsed, PROJECT_MAX_TABLES);
+}
+
+// Returns the taken slot or EMPTY_VALUE_16
+static int alloc(uint8_t* isUsed, int* used, int count, int start) {
+  for (int c = start < 0 ? 0 : start; c < count; c++) {
+    if (isUsed[c]) continue;
+    isUsed[c] = 1;
+    (*used)++;
+    return c;
+  }
+  return EMPTY_VALUE_16;
+}
+
+int projectSlotsTakeChain(ProjectSlots* slots, int start) {
+  return alloc(slots->isChainUsed, &slots->chainsUsed, PROJECT_MAX_CHAINS, start);
+}
+
+int projectSlotsTakePhrase(ProjectSlots* slots, int start) {
+  return alloc(slots->isPhraseUsed, &slots->phrasesUsed, PROJECT_MAX_PHRASES, start);
+}
+
+int projectSlotsTakeTable(ProjectSlots* slots, int start) {
+  return alloc(slots->isTableUsed, &slots->tablesUsed, PROJECT_MAX_TABLES, start);
+}
+
+void projectSlotsFreeChain(ProjectSlots* slots, Project* p, int chain) {
+  if (chain < 0 || chain >= PROJECT_MAX_CHAINS) return;
+  chainClear(&p->chains[chain]);
+  if (slots->isChainUsed[chain]) slots->chainsUsed--;
+  slots->isChainUsed[chain] = 0;
+}
+
+void projectSlotsFreePhrase(ProjectSlots* slots, Project* p, int phrase) {
+  if (phrase < 0 || phrase >= PROJECT_MAX_PHRASES) return;
+  phraseClear(&p->phrases[phrase]);
+  if (slots->isPhraseUsed[phrase]) slots->phrasesUsed--;
+  slots->isPhraseUsed[phrase] = 0;
+}
+
+void projectSlotsFreeTable(ProjectSlots* slots, Project* p, int table) {
+  if (table < 0 || table >= PROJECT_MAX_TABLES) return;
+  tableClear(&p->tables[table]);
+  if (slots->isTableUsed[table]) slots->tablesUsed--;
+  slots->isTableUsed[table] = 0;
+}
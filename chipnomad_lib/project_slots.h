@@ -0,0 +1,35 @@
+#ifndef __PROJECT_SLOTS_H__
+#define __PROJECT_SLOTS_H__
+
+#include <stdint.h>
+#include "project.h"
+
+// Map of the free slots of the project's chains, phrases and tables. It isn't a
+// pool and allocates no storage: the entities stay in the fixed arrays of
+// Project, so their indices are stable.
+//
+// A slot is in use when it isn't empty or something refers to it: chains from
+// the song, phrases from chains, tables from their instrument and from TBL and
+// TBX FX. projectSlotsScan finds them all in one pass over the project. Edits
+// made after the scan aren't tracked, scan again before allocating after them.
+
+typedef struct ProjectSlots {
+  uint8_t isChainUsed[PROJECT_MAX_CHAINS];
+  uint8_t isPhraseUsed[PROJECT_MAX_PHRASES];
+  uint8_t isTableUsed[PROJECT_MAX_TABLES];
+  int chainsUsed;
+  int phrasesUsed;
+  int tablesUsed;
+} ProjectSlots;
+
+void projectSlotsScan(ProjectSlots* slots, Project* p);
+// Take the first free slot from start on. Returns EMPTY_VALUE_16 if there's none
+int projectSlotsTakeChain(ProjectSlots* slots, int start);
+int projectSlotsTakePhrase(ProjectSlots* slots, int start);
+int projectSlotsTakeTable(ProjectSlots* slots, int start);
+// Clear the entity and free its slot
+void projectSlotsFreeChain(ProjectSlots* slots, Project* p, int chain);
+void projectSlotsFreePhrase(ProjectSlots* slots, Project* p, int phrase);
+void projectSlotsFreeTable(ProjectSlots* slots, Project* p, int table);
+
+#endif
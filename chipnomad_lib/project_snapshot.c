@@ -0,0 +1,102 @@
+#include "project_snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+#include "corelib/corelib_thread.h"
+
+struct ProjectPage {
+  int refCount; // Accessed atomically
+  uint8_t data[PROJECT_SNAPSHOT_PAGE_SIZE];
+};
+
+static void pageRelease(ProjectPage* page) {
+  if (page && atomicAdd(&page->refCount, -1) == 0) free(page);
+}
+
+int projectSnapshotPageSize(int page) {
+  int offset = page * PROJECT_SNAPSHOT_PAGE_SIZE;
+  return (int)sizeof(Project) - offset < PROJECT_SNAPSHOT_PAGE_SIZE ? (int)sizeof(Project) - offset : PROJECT_SNAPSHOT_PAGE_SIZE;
+}
+
+ProjectSnapshot* projectSnapshotTake(Project* p, ProjectSnapshot* base) {
+  ProjectSnapshot* snapshot = calloc(1, sizeof(ProjectSnapshot));
+  if (!snapshot) return NULL;
+
+  const uint8_t* data = (const uint8_t*)p;
+  for (int c = 0; c < PROJECT_SNAPSHOT_PAGES_COUNT; c++) {
+    int size = projectSnapshotPageSize(c);
+    const uint8_t* pageData = data + c * PROJECT_SNAPSHOT_PAGE_SIZE;
+
+    if (base && !memcmp(base->pages[c]->data, pageData, size)) {
+      atomicAdd(&base->pages[c]->refCount, 1);
+      snapshot->pages[c] = base->pages[c];
+      continue;
+    }
+
+    ProjectPage* page = malloc(sizeof(ProjectPage));
+    if (!page) {
+      projectSnapshotFree(snapshot);
+      return NULL;
+    }
+    page->refCount = 1;
+    memcpy(page->data, pageData, size);
+    snapshot->pages[c] = page;
+    snapshot->pagesCopied++;
+  }
+  return snapshot;
+}
+
+ProjectSnapshot* projectSnapshotCopy(ProjectSnapshot* snapshot) {
+  ProjectSnapshot* copy = malloc(sizeof(ProjectSnapshot));
+  if (!copy) return NULL;
+
+  for (int c = 0; c < PROJECT_SNAPSHOT_PAGES_COUNT; c++) {
+    atomicAdd(&snapshot->pages[c]->refCount, 1);
+    copy->pages[c] = snapshot->pages[c];
+  }
+  copy->pagesCopied = 0;
+  return copy;
+}
+
+void projectSnapshotFree(ProjectSnapshot* snapshot) {
+  if (!snapshot) return;
+  for (int c = 0; c < PROJECT_SNAPSHOT_PAGES_COUNT; c++) {
+    pageRelease(snapshot->pages[c]);
+  }
+  free(snapshot);
+}
+
+void projectSnapshotRestore(ProjectSnapshot* snapshot, Project* p) {
+  uint8_t* data = (uint8_t*)p;
+  for (int c = 0; c < PROJECT_SNAPSHOT_PAGES_COUNT; c++) {
+    memcpy(data + c * PROJECT_SNAPSHOT_PAGE_SIZE, snapshot->pages[c]->data, projectSnapshotPageSize(c));
+  }
+}
+
+const uint8_t* projectSnapshotPage(ProjectSnapshot* snapshot, int page) {
+  return snapshot->pages[page]->data;
+}
+
+static int comparePages(const void* a, const void* b) {
+  const ProjectPage* pageA = *(ProjectPage* const*)a;
+  const ProjectPage* pageB = *(ProjectPage* const*)b;
+  return pageA < pageB ? -1 : pageA > pageB;
+}
+
+void projectSnapshotGetStats(ProjectSnapshot** snapshots, int count, ProjectSnapshotStats* stats) {
+  memset(stats, 0, sizeof(ProjectSnapshotStats));
+  ProjectPage** pages = malloc((count > 0 ? count : 1) * PROJECT_SNAPSHOT_PAGES_COUNT * sizeof(ProjectPage*));
+  if (!pages) return;
+
+  for (int c = 0; c < count; c++) {
+    memcpy(pages + stats->pagesCount, snapshots[c]->pages, sizeof(snapshots[c]->pages));
+    stats->pagesCount += PROJECT_SNAPSHOT_PAGES_COUNT;
+  }
+  qsort(pages, stats->pagesCount, sizeof(ProjectPage*), comparePages);
+  for (long c = 0; c < stats->pagesCount; c++) {
+    if (c == 0 || pages[c] != pages[c - 1]) stats->pagesAllocated++;
+  }
+
+  stats->bytesUsed = count * (long)sizeof(Project);
+  stats->bytesAllocated = count * (long)sizeof(ProjectSnapshot) + stats->pagesAllocated * (long)sizeof(ProjectPage);
+  free(pages);
+}
@@ -0,0 +1,47 @@
+#ifndef __PROJECT_SNAPSHOT_H__
+#define __PROJECT_SNAPSHOT_H__
+
+#include <stdint.h>
+#include "project.h"
+
+// Read-only copies of a project that share unchanged memory. The Project
+// struct is split into pages. A snapshot taken with a base compares every page
+// with the base and keeps a reference to the base's page if nothing in it has
+// changed, so only the pages touched since the base take new memory. Finding
+// them still reads the whole project: a snapshot saves memory, not time.
+//
+// Pages are reference counted and freed with the last snapshot using them.
+// Snapshots can be freed on any thread, e.g. by a background job.
+
+#define PROJECT_SNAPSHOT_PAGE_SIZE (4096)
+#define PROJECT_SNAPSHOT_PAGES_COUNT ((int)((sizeof(Project) + PROJECT_SNAPSHOT_PAGE_SIZE - 1) / PROJECT_SNAPSHOT_PAGE_SIZE))
+
+typedef struct ProjectPage ProjectPage;
+
+typedef struct ProjectSnapshot {
+  ProjectPage* pages[PROJECT_SNAPSHOT_PAGES_COUNT];
+  int pagesCopied; // Pages not shared with the base
+} ProjectSnapshot;
+
+typedef struct ProjectSnapshotStats {
+  long pagesCount; // Pages referenced by the snapshots
+  long pagesAllocated; // Distinct pages among them
+  long bytesUsed; // Memory full copies would take
+  long bytesAllocated; // Memory the snapshots take
+} ProjectSnapshotStats;
+
+// Take a snapshot of the project sharing unchanged pages with base, which may
+// be NULL. Returns NULL if out of memory
+ProjectSnapshot* projectSnapshotTake(Project* p, ProjectSnapshot* base);
+// Another snapshot of the same project, all pages are shared. Returns NULL if out of memory
+ProjectSnapshot* projectSnapshotCopy(ProjectSnapshot* snapshot);
+void projectSnapshotFree(ProjectSnapshot* snapshot);
+// Copy the snapshot into a project
+void projectSnapshotRestore(ProjectSnapshot* snapshot, Project* p);
+// Page contents and size, only the last page is shorter than PROJECT_SNAPSHOT_PAGE_SIZE
+const uint8_t* projectSnapshotPage(ProjectSnapshot* snapshot, int page);
+int projectSnapshotPageSize(int page);
+// Memory taken by a set of snapshots, counting shared pages once
+void projectSnapshotGetStats(ProjectSnapshot** snapshots, int count, ProjectSnapshotStats* stats);
+
+#endif
@@ -0,0 +1,220 @@
+#include "register_dump.h"
+#include <stdlib.h>
+#include <string.h>
+#include "corelib/corelib_file.h"
+#include "utils.h"
+
+// Returns the next byte of the file or -1 at the end
+static int readByte(RegisterDumpReader* reader) {
+  if (reader->bufferPos == reader->bufferSize) {
+    reader->bufferSize = fileRead(reader->fileId, reader->buffer, sizeof(reader->buffer));
+    reader->bufferPos = 0;
+    if (reader->bufferSize <= 0) {
+      reader->bufferSize = 0;
+      return -1;
+    }
+  }
+  return reader->buffer[reader->bufferPos++];
+}
+
+// Writes that turn one register state into another. Returns number of writes
+static int stateWrites(const RegisterDumpState* from, const RegisterDumpState* to, int chipsCount, RegisterWrite* writes) {
+  int count = 0;
+
+  for (int chip = 0; chip < chipsCount; chip++) {
+    for (int reg = 0; reg < REGISTER_DUMP_REGS; reg++) {
+      uint16_t bit = 1 << reg;
+      if (!(to->writtenMasks[chip] & bit)) continue;
+      if ((from->writtenMasks[chip] & bit) && from->regs[chip][reg] == to->regs[chip][reg] &&
+          !(reg == REGISTER_DUMP_TRIGGER_REG && (to->triggers & (1 << chip)))) {
+        continue;
+      }
+      writes[count].chip = (uint8_t)chip;
+      writes[count].reg = (uint8_t)reg;
+      writes[count].value = to->regs[chip][reg];
+      count++;
+    }
+  }
+  return count;
+}
+
+// Read a frame with writes into state
+static int readFrameWrites(RegisterDumpReader* reader, int token, RegisterDumpState* state) {
+  if ((token & 0x3f) >> reader->chipsCount) return 1; // Writes for a chip that isn't there
+
+  for (int chip = 0; chip < reader->chipsCount; chip++) {
+    if (!(token & (1 << chip))) continue;
+
+    int maskLow = readByte(reader);
+    int maskHigh = readByte(reader);
+    if (maskLow < 0 || maskHigh < 0) return 1;
+
+    int mask = maskLow | (maskHigh << 8);
+    for (int reg = 0; reg < REGISTER_DUMP_REGS; reg++) {
+      if (!(mask & (1 << reg))) continue;
+      int value = readByte(reader);
+      if (value < 0) return 1;
+      state->regs[chip][reg] = (uint8_t)value;
+    }
+    state->writtenMasks[chip] |= mask;
+    if (mask & (1 << REGISTER_DUMP_TRIGGER_REG)) state->triggers |= 1 << chip;
+  }
+  return 0;
+}
+
+static const RegisterDumpState* frameState(RegisterDumpReader* reader, int frame) {
+  static const RegisterDumpState initialState;
+  return frame >= 0 ? &reader->history[frame % REGISTER_DUMP_HISTORY] : &initialState;
+}
+
+// Decode the next frame. Returns number of writes or -1 on error
+static int readFrame(RegisterDumpReader* reader, RegisterWrite* writes) {
+  const RegisterDumpState* previous = frameState(reader, reader->frame - 1);
+  RegisterDumpState* state = &reader->history[reader->frame % REGISTER_DUMP_HISTORY];
+
+  if (reader->waitFrames == 0 && reader->repeatFrames == 0) {
+    int token = readByte(reader);
+    if (token < 0) return -1;
+
+    if (token < REGISTER_DUMP_FRAME) {
+      reader->waitFrames = token - REGISTER_DUMP_WAIT + 1;
+    } else if (token >= REGISTER_DUMP_REPEAT) {
+      int distanceLow = readByte(reader);
+      int distanceHigh = readByte(reader);
+      if (distanceLow < 0 || distanceHigh < 0) return -1;
+      reader->repeatFrames = token - REGISTER_DUMP_REPEAT + 1;
+      reader->repeatDistance = distanceLow | (distanceHigh << 8);
+      if (reader->repeatDistance < 1 || reader->repeatDistance > reader->frame ||
+          reader->repeatDistance >= REGISTER_DUMP_HISTORY - 1) {
+        return -1;
+      }
+    } else {
+      *state = *previous;
+      state->triggers = 0;
+      if (readFrameWrites(reader, token, state)) return -1;
+    }
+  }
+
+  if (reader->waitFrames > 0) {
+    reader->waitFrames--;
+    *state = *previous;
+    state->triggers = 0;
+  } else if (reader->repeatFrames > 0) {
+    // Same writes as the repeated frame
+    int source = reader->frame - reader->repeatDistance;
+    int count = stateWrites(frameState(reader, source - 1), frameState(reader, source), reader->chipsCount, writes);
+    reader->repeatFrames--;
+    *state = *previous;
+    state->triggers = 0;
+    for (int c = 0; c < count; c++) {
+      state->regs[writes[c].chip][writes[c].reg] = writes[c].value;
+      state->writtenMasks[writes[c].chip] |= 1 << writes[c].reg;
+      if (writes[c].reg == REGISTER_DUMP_TRIGGER_REG) state->triggers |= 1 << writes[c].chip;
+    }
+  }
+
+  reader->frame++;
+  return stateWrites(previous, state, reader->chipsCount, writes);
+}
+
+RegisterDumpReader* registerDumpOpen(const char* path) {
+  RegisterDumpReader* reader = calloc(1, sizeof(RegisterDumpReader));
+  if (!reader) return NULL;
+
+  reader->fileId = fileOpen(path, 0);
+  if (reader->fileId == -1) {
+    free(reader);
+    return NULL;
+  }
+
+  uint8_t header[REGISTER_DUMP_HEADER_SIZE];
+  if (fileRead(reader->fileId, header, REGISTER_DUMP_HEADER_SIZE) != REGISTER_DUMP_HEADER_SIZE ||
+      memcmp(header, "CNRD", 4) || header[4] != REGISTER_DUMP_VERSION || header[5] >= chipTotalCount ||
+      header[6] < 1 || header[6] > PROJECT_MAX_CHIPS || header[7] > PROJECT_MAX_TRACKS) {
+    registerDumpClose(reader);
+    return NULL;
+  }
+
+  reader->chipType = (enum ChipType)header[5];
+  reader->chipsCount = header[6];
+  reader->tracksCount = header[7];
+  reader->tickRate = readLE32(header + 8) / 1000.0f;
+  reader->framesCount = (int)readLE32(header + 12);
+  reader->chipSetup.ay.clock = (int)readLE32(header + 16);
+  reader->chipSetup.ay.isYM = header[20];
+  reader->chipSetup.ay.stereoMode = (enum StereoModeAY)header[21];
+  reader->chipSetup.ay.stereoSeparation = header[22];
+
+  if (reader->tickRate <= 0 || reader->framesCount < 0) {
+    registerDumpClose(reader);
+    return NULL;
+  }
+  return reader;
+}
+
+int registerDumpNextFrame(RegisterDumpReader* reader, SoundChip* chips) {
+  if (reader->frame >= reader->framesCount) return 1;
+
+  RegisterWrite writes[PROJECT_MAX_CHIPS * REGISTER_DUMP_REGS];
+  int count = readFrame(reader, writes);
+  if (count < 0) return -1;
+
+  for (int c = 0; c < count; c++) {
+    SoundChip* chip = &chips[writes[c].chip];
+    chip->setRegister(chip, writes[c].reg, writes[c].value);
+  }
+  return reader->frame >= reader->framesCount;
+}
+
+void registerDumpClose(RegisterDumpReader* reader) {
+  if (!reader) return;
+
+  fileClose(reader->fileId);
+  free(reader);
+}
+
+RegisterStream* registerDumpLoad(const char* path) {
+  RegisterDumpReader* reader = registerDumpOpen(path);
+  if (!reader) return NULL;
+
+  RegisterStream* stream = calloc(1, sizeof(RegisterStream));
+  int writesCapacity = 8192;
+  if (stream) {
+    stream->frameStarts = malloc((reader->framesCount + 1) * sizeof(int));
+    stream->writes = malloc(writesCapacity * sizeof(RegisterWrite));
+  }
+  if (!stream || !stream->frameStarts || !stream->writes) goto failed;
+
+  stream->chipType = reader->chipType;
+  stream->chipsCount = reader->chipsCount;
+  stream->tracksCount = reader->tracksCount;
+  stream->tickRate = reader->tickRate;
+  stream->chipSetup = reader->chipSetup;
+
+  RegisterWrite writes[PROJECT_MAX_CHIPS * REGISTER_DUMP_REGS];
+  for (int f = 0; f < reader->framesCount; f++) {
+    int count = readFrame(reader, writes);
+    if (count < 0) goto failed;
+
+    if (stream->writesCount + count > writesCapacity) {
+      writesCapacity *= 2;
+      RegisterWrite* grown = realloc(stream->writes, writesCapacity * sizeof(RegisterWrite));
+      if (!grown) goto failed;
+      stream->writes = grown;
+    }
+
+    stream->frameStarts[f] = stream->writesCount;
+    memcpy(stream->writes + stream->writesCount, writes, count * sizeof(RegisterWrite));
+    stream->writesCount += count;
+  }
+  stream->framesCount = reader->framesCount;
+  stream->frameStarts[stream->framesCount] = stream->writesCount;
+
+  registerDumpClose(reader);
+  return stream;
+
+failed:
+  registerDumpClose(reader);
+  registerStreamFree(stream);
+  return NULL;
+}
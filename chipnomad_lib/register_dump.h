@@ -0,0 +1,100 @@
+#ifndef __REGISTER_DUMP_H__
+#define __REGISTER_DUMP_H__
+
+#include <stdint.h>
+#include "project.h"
+#include "chips/chips.h"
+#include "register_stream.h"
+
+// Compact register dump (.cnr): the register writes of every playback frame,
+// delta-coded against the previous frame and run-length coded.
+//
+// Header, 32 bytes, little-endian:
+//   0  "CNRD"
+//   4  version
+//   5  chip type
+//   6  chips count
+//   7  tracks count
+//   8  tick rate in 1/1000 Hz (uint32)
+//   12 frames count (uint32)
+//   16 AY clock (uint32)
+//   20 AY isYM, 21 AY stereo mode, 22 AY stereo separation
+//
+// Frames follow the header, each token codes one or more frames:
+//   0x00-0x7f  1-128 frames without register writes
+//   0x80-0xbf  frame with writes, bit per chip that has writes. For each of
+//              these chips: 16-bit mask of written registers and their values
+//              in register order
+//   0xc0-0xff  1-64 frames with the same writes as the frames starting
+//              16-bit distance frames back. The repeated frames can overlap
+//              the frames they produce
+// Songs repeat phrases and chains, so long stretches become a single repeat.
+
+#define REGISTER_DUMP_VERSION (1)
+#define REGISTER_DUMP_HEADER_SIZE (32)
+#define REGISTER_DUMP_REGS (16) // Registers per chip that frames can write
+#define REGISTER_DUMP_TRIGGER_REG (13) // Writing it has an effect even with the same value
+#define REGISTER_DUMP_HISTORY (2048) // Frames kept by the decoder, a repeat can go back one less
+#define REGISTER_DUMP_MAX_WAIT (128)
+#define REGISTER_DUMP_MAX_REPEAT (64)
+
+#define REGISTER_DUMP_WAIT (0x00)
+#define REGISTER_DUMP_FRAME (0x80)
+#define REGISTER_DUMP_REPEAT (0xc0)
+
+// Chip registers after a frame
+typedef struct RegisterDumpState {
+  uint8_t regs[PROJECT_MAX_CHIPS][REGISTER_DUMP_REGS];
+  uint16_t writtenMasks[PROJECT_MAX_CHIPS]; // Registers written at least once
+  uint8_t triggers; // Bit per chip that wrote REGISTER_DUMP_TRIGGER_REG in the frame
+} RegisterDumpState;
+
+typedef struct RegisterDumpReader {
+  // Header
+  enum ChipType chipType;
+  int chipsCount;
+  int tracksCount;
+  float tickRate;
+  ChipSetup chipSetup;
+  int framesCount;
+  // Decoder state
+  int fileId;
+  int frame;
+  int waitFrames;
+  int repeatFrames;
+  int repeatDistance;
+  RegisterDumpState history[REGISTER_DUMP_HISTORY];
+  uint8_t buffer[4096];
+  int bufferSize;
+  int bufferPos;
+} RegisterDumpReader;
+
+/**
+* Open a register dump and read its header
+* @param path Dump file path
+* @return Reader positioned at the first frame, or NULL on failure
+*/
+RegisterDumpReader* registerDumpOpen(const char* path);
+
+/**
+* Write the next frame of the dump to chips
+* @param reader Dump reader
+* @param chips Chips to write to (reader->chipsCount)
+* @return 1 if it was the last frame, 0 if there are more, -1 on a read error
+*/
+int registerDumpNextFrame(RegisterDumpReader* reader, SoundChip* chips);
+
+/**
+* Close a register dump
+* @param reader Reader to close
+*/
+void registerDumpClose(RegisterDumpReader* reader);
+
+/**
+* Decode a whole register dump into a register stream, to play it with chipnomadStartReplay
+* @param path Dump file path
+* @return Decoded stream, or NULL on failure
+*/
+RegisterStream* registerDumpLoad(const char* path);
+
+#endif
@@ -0,0 +1,174 @@
+#include "register_stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+
+typedef struct CaptureData CaptureData;
+
+typedef struct CaptureChip {
+  CaptureData* capture;
+  int chipIndex;
+  uint8_t isWritten[256]; // Registers written at least once, their value is in regs
+} CaptureChip;
+
+struct CaptureData {
+  RegisterStream* stream;
+  int writesCapacity;
+  int framesCapacity;
+  int failed;
+  CaptureChip chips[PROJECT_MAX_CHIPS];
+};
+
+// Registers where writing the same value again has an effect
+static int isWriteTriggered(enum ChipType chipType, int reg) {
+  // AY envelope shape restarts the envelope
+  return chipType == chipAY && reg == 13;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Recording sound chip
+//
+
+static void captureChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  CaptureChip* chip = (CaptureChip*)self->userdata;
+  CaptureData* capture = chip->capture;
+  RegisterStream* stream = capture->stream;
+  reg &= 0xff;
+
+  int isChanged = !chip->isWritten[reg] || self->regs[reg] != value;
+  chip->isWritten[reg] = 1;
+  self->regs[reg] = value;
+  if (!isChanged && !isWriteTriggered(stream->chipType, reg)) return;
+  if (capture->failed) return;
+
+  if (stream->writesCount == capture->writesCapacity) {
+    int capacity = capture->writesCapacity * 2;
+    RegisterWrite* writes = realloc(stream->writes, capacity * sizeof(RegisterWrite));
+    if (!writes) {
+      capture->failed = 1;
+      return;
+    }
+    stream->writes = writes;
+    capture->writesCapacity = capacity;
+  }
+
+  RegisterWrite* write = &stream->writes[stream->writesCount++];
+  write->chip = (uint8_t)chip->chipIndex;
+  write->reg = (uint8_t)reg;
+  write->value = value;
+}
+
+static SoundChip captureChipFactory(int chipIndex, int sampleRate, ChipSetup setup) {
+  SoundChip chip = {
+    .userdata = NULL, // Set to CaptureChip once chips are created
+    .setRegister = captureChipSetRegister,
+  };
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+  return chip;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Capture
+//
+
+// Mark the start of the next frame. Returns 1 on failure
+static int captureStartFrame(CaptureData* capture) {
+  RegisterStream* stream = capture->stream;
+
+  // One extra entry for the end of the last frame
+  if (stream->framesCount + 2 > capture->framesCapacity) {
+    int capacity = capture->framesCapacity * 2;
+    int* frameStarts = realloc(stream->frameStarts, capacity * sizeof(int));
+    if (!frameStarts) return 1;
+    stream->frameStarts = frameStarts;
+    capture->framesCapacity = capacity;
+  }
+
+  stream->frameStarts[stream->framesCount++] = stream->writesCount;
+  return 0;
+}
+
+RegisterStream* registerStreamCapture(Project* project, int startRow, int maxSeconds) {
+  if (maxSeconds <= 0) maxSeconds = REGISTER_STREAM_MAX_SECONDS;
+
+  RegisterStream* stream = calloc(1, sizeof(RegisterStream));
+  CaptureData* capture = calloc(1, sizeof(CaptureData));
+  ChipNomadState* state = chipnomadCreate();
+  if (!stream || !capture || !state) goto failed;
+
+  stream->chipType = project->chipType;
+  stream->chipsCount = project->chipsCount;
+  stream->tracksCount = project->tracksCount;
+  stream->tickRate = project->tickRate;
+  stream->chipSetup = project->chipSetup;
+
+  capture->stream = stream;
+  capture->framesCapacity = 1024;
+  capture->writesCapacity = 8192;
+  stream->frameStarts = malloc(capture->framesCapacity * sizeof(int));
+  stream->writes = malloc(capture->writesCapacity * sizeof(RegisterWrite));
+  if (!stream->frameStarts || !stream->writes) goto failed;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, 44100, captureChipFactory);
+  for (int c = 0; c < state->project.chipsCount; c++) {
+    capture->chips[c].capture = capture;
+    capture->chips[c].chipIndex = c;
+    state->chips[c].userdata = &capture->chips[c];
+  }
+  playbackStartSong(&state->playbackState, startRow, 0, 0);
+
+  int maxFrames = (int)(project->tickRate * maxSeconds);
+  while (stream->framesCount < maxFrames) {
+    if (captureStartFrame(capture)) goto failed;
+    if (playbackNextFrame(&state->playbackState, state->chips)) break;
+  }
+  if (capture->failed) goto failed;
+  stream->frameStarts[stream->framesCount] = stream->writesCount;
+
+  chipnomadDestroy(state);
+  free(capture);
+  return stream;
+
+failed:
+  chipnomadDestroy(state);
+  free(capture);
+  registerStreamFree(stream);
+  return NULL;
+}
+
+void registerStreamFree(RegisterStream* stream) {
+  if (!stream) return;
+
+  free(stream->frameStarts);
+  free(stream->writes);
+  free(stream);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Replay
+//
+
+int registerStreamApplyFrame(const RegisterStream* stream, int frame, SoundChip* chips, uint32_t trackMask) {
+  if (frame >= stream->framesCount) return 1;
+
+  for (int c = stream->frameStarts[frame]; c < stream->frameStarts[frame + 1]; c++) {
+    const RegisterWrite* write = &stream->writes[c];
+    SoundChip* chip = &chips[write->chip];
+    uint8_t value = write->value;
+
+    // AY volume registers of muted tracks
+    if (stream->chipType == chipAY && write->reg >= 8 && write->reg <= 10 &&
+        !(trackMask & (1u << (write->chip * 3 + write->reg - 8)))) {
+      value = 0;
+    }
+    chip->setRegister(chip, write->reg, value);
+  }
+
+  return frame == stream->framesCount - 1;
+}
@@ -0,0 +1,60 @@
+#ifndef __REGISTER_STREAM_H__
+#define __REGISTER_STREAM_H__
+
+#include <stdint.h>
+#include "project.h"
+#include "chips/chips.h"
+
+#define REGISTER_STREAM_MAX_SECONDS (3600)
+
+typedef struct RegisterWrite {
+  uint8_t chip;
+  uint8_t reg;
+  uint8_t value;
+} RegisterWrite;
+
+/**
+* Captured song: per-frame register writes for all chips, with the chip
+* configuration needed to play it back. Only writes that change a register
+* are kept, except for registers where a write itself has an effect (AY
+* envelope shape). The stream is read-only once captured, so any number of
+* replays can share it.
+*/
+typedef struct RegisterStream {
+  enum ChipType chipType;
+  int chipsCount;
+  int tracksCount;
+  float tickRate;
+  ChipSetup chipSetup;
+  int framesCount;
+  int* frameStarts; // framesCount + 1 entries, index of each frame's first write
+  RegisterWrite* writes;
+  int writesCount;
+} RegisterStream;
+
+/**
+* Play the project from the start row until all tracks stop and capture its register writes
+* @param project Project to capture, it isn't modified
+* @param startRow Song row to start from
+* @param maxSeconds Songs that don't stop are cut after this time, 0 for REGISTER_STREAM_MAX_SECONDS
+* @return Captured stream, or NULL on failure
+*/
+RegisterStream* registerStreamCapture(Project* project, int startRow, int maxSeconds);
+
+/**
+* Free a captured stream
+* @param stream Stream to free
+*/
+void registerStreamFree(RegisterStream* stream);
+
+/**
+* Write one frame of the stream to chips
+* @param stream Captured stream
+* @param frame Frame index, frames past the end have no writes
+* @param chips Chips to write to (stream->chipsCount)
+* @param trackMask Bit per track, volume of tracks with a cleared bit is kept at zero
+* @return 1 if all tracks are stopped after this frame
+*/
+int registerStreamApplyFrame(const RegisterStream* stream, int frame, SoundChip* chips, uint32_t trackMask);
+
+#endif
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+
+// Directory cache test: lists each folder through the cache and checks that
+// the background scan lands the same sorted listing as fileListDirectory, and
+// that an unchanged folder isn't scanned again. Then adds a file to a scratch
+// folder and checks the stale listing is shown until the fresh one lands, that
+// a scan requested during another one waits for it, and that freeing the
+// cache during a scan is safe.
+//
+// Usage: test_directory_cache [-o scratch] folder ...
+
+#define LAND_TIMEOUT_MS (5000)
+
+static const char* scratchFolder = "directory_cache_scratch";
+
+static int compareNames(const void* a, const void* b) {
+  return strcmp(((const FileEntry*)a)->name, ((const FileEntry*)b)->name);
+}
+
+// Returns 1 when the listing of the path landed in time
+static int waitForLanding(DirectoryCache* cache, const char* path) {
+  int start = threadTicks();
+  while (threadTicks() - start < LAND_TIMEOUT_MS) {
+    if (directoryCacheUpdate(cache, path, ".cnm")) return 1;
+    threadSleep(1);
+  }
+  return 0;
+}
+
+// Returns an error message or NULL
+static const char* compareListing(const char* path, FileEntry* entries, int count) {
+  int expectedCount;
+  FileEntry* expected = fileListDirectory(path, ".cnm", &expectedCount);
+  if (!expected) return "can't list folder";
+  qsort(expected, expectedCount, sizeof(FileEntry), compareNames);
+
+  const char* error = NULL;
+  if (count != expectedCount) {
+    error = "listing size differs";
+  } else if (count > 0 && memcmp(entries, expected, count * sizeof(FileEntry))) {
+    error = "listing differs";
+  }
+  free(expected);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testFolder(DirectoryCache* cache, const char* path) {
+  int count;
+  FileEntry* entries = directoryCacheList(cache, path, ".cnm", &count);
+  if (entries) {
+    free(entries);
+    return "listing before the scan";
+  }
+  if (!waitForLanding(cache, path)) return "scan didn't land";
+
+  entries = directoryCacheList(cache, path, ".cnm", &count);
+  const char* error = compareListing(path, entries, count);
+  free(entries);
+  if (error) return error;
+  if (directoryCacheIsScanning(cache, path, ".cnm")) return "landed listing scanned again";
+
+  // Folders changed in the last seconds are scanned on each visit
+  long long modifiedTime;
+  if (!fileGetModifiedTime(path, &modifiedTime) && time(NULL) - modifiedTime > 2) {
+    free(directoryCacheList(cache, path, ".cnm", &count));
+    if (directoryCacheIsScanning(cache, path, ".cnm")) return "unchanged folder scanned again";
+  }
+  return NULL;
+}
+
+// Files in the scratch folder's listing, without ".."
+static int listFiles(DirectoryCache* cache) {
+  int count;
+  FileEntry* entries = directoryCacheList(cache, scratchFolder, ".cnm", &count);
+  int filesCount = 0;
+  for (int c = 0; c < count; c++) filesCount += !entries[c].isDirectory;
+  free(entries);
+  return filesCount;
+}
+
+static int writeFile(const char* name) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s%s%s", scratchFolder, PATH_SEPARATOR_STR, name);
+  int fileId = fileOpen(path, 1);
+  if (fileId == -1) return 1;
+  filePrintf(fileId, "%s\n", name);
+  return fileClose(fileId);
+}
+
+static void deleteFile(const char* name) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s%s%s", scratchFolder, PATH_SEPARATOR_STR, name);
+  fileDelete(path);
+}
+
+// Returns an error message or NULL
+static const char* testChanges(DirectoryCache* cache, const char* otherFolder) {
+  if (writeFile("a.cnm") || writeFile("b.cnm")) return "can't write files";
+
+  int count;
+  free(directoryCacheList(cache, scratchFolder, ".cnm", &count));
+  if (!waitForLanding(cache, scratchFolder)) return "scan didn't land";
+  if (listFiles(cache) != 2) return "wrong number of files";
+
+  // The stale listing is shown while the changed folder is scanned
+  if (writeFile("c.cnm")) return "can't write files";
+  if (listFiles(cache) != 2) return "stale listing not shown";
+  if (!directoryCacheIsScanning(cache, scratchFolder, ".cnm")) return "changed folder not scanned";
+  if (!waitForLanding(cache, scratchFolder)) return "scan didn't land";
+  FileEntry* entries = directoryCacheList(cache, scratchFolder, ".cnm", &count);
+  const char* error = compareListing(scratchFolder, entries, count);
+  free(entries);
+  if (error) return error;
+  if (listFiles(cache) != 3) return "new file missing";
+
+  // A scan requested during another one waits for it
+  if (otherFolder) {
+    deleteFile("c.cnm");
+    free(directoryCacheList(cache, scratchFolder, ".cnm", &count));
+    free(directoryCacheList(cache, otherFolder, ".txt", &count));
+    if (!directoryCacheIsScanning(cache, otherFolder, ".txt")) return "second scan not queued";
+    int start = threadTicks();
+    while (directoryCacheIsScanning(cache, otherFolder, ".txt") && threadTicks() - start < LAND_TIMEOUT_MS) {
+      directoryCacheUpdate(cache, scratchFolder, ".cnm");
+      threadSleep(1);
+    }
+    if (directoryCacheIsScanning(cache, otherFolder, ".txt")) return "queued scan didn't land";
+    if (listFiles(cache) != 2) return "deleted file still listed";
+  }
+  return NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int foldersCount = 0;
+  const char* folders[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchFolder = argv[++c];
+    } else if (foldersCount < 256) {
+      folders[foldersCount++] = argv[c];
+    }
+  }
+
+  DirectoryCache* cache = directoryCacheCreate(compareNames);
+  if (!cache) return 1;
+
+  int failed = 0;
+  for (int c = 0; c < foldersCount; c++) {
+    const char* error = testFolder(cache, folders[c]);
+    if (error) {
+      printf("FAIL %s: %s\n", folders[c], error);
+      failed++;
+    } else {
+      printf("OK   %s\n", folders[c]);
+    }
+  }
+
+  fileCreateDirectory(scratchFolder);
+  const char* error = testChanges(cache, foldersCount > 0 ? folders[0] : NULL);
+  if (error) {
+    printf("FAIL %s: %s\n", scratchFolder, error);
+    failed++;
+  } else {
+    printf("OK   %s\n", scratchFolder);
+  }
+
+  // Freed with a scan running
+  int count;
+  free(directoryCacheList(cache, scratchFolder, "", &count));
+  directoryCacheFree(cache);
+
+  deleteFile("a.cnm");
+  deleteFile("b.cnm");
+  deleteFile("c.cnm");
+  fileDelete(scratchFolder);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+
+// Background exporter test: exports each project as WAV with the serial
+// exporter, then through the background exporter on its worker thread and
+// with every thread taken so the steps run from next(), each time created
+// from the exporter and from a project snapshot. They go through next() until
+// it returns -1 and then finish(), like the export screen, and must write the
+// same file as the serial exporter.
+//
+// Usage: test_export_background [-o scratch] project.cnm ...
+
+#define EXPORT_RATE (22050)
+
+static const char* scratchPath = "test_export_background";
+
+static int isReleased; // Accessed atomically
+
+static int blockRun(void* arg) {
+  while (!atomicGet(&isReleased)) threadSleep(1);
+  return 0;
+}
+
+// Take every free thread. Returns number of threads taken
+static int takeThreads(int* threadIds) {
+  atomicSet(&isReleased, 0);
+  int count = 0;
+  while (count < CORELIB_MAX_THREADS && (threadIds[count] = threadStart(blockRun, NULL)) != -1) count++;
+  return count;
+}
+
+static void releaseThreads(int* threadIds, int count) {
+  atomicSet(&isReleased, 1);
+  for (int c = 0; c < count; c++) threadJoin(threadIds[c]);
+}
+
+// Factory for the snapshot exporter, arg is the path
+static Exporter* createExporter(Project* project, void* arg) {
+  return createWAVExporter(arg, project, 0, EXPORT_RATE, 16);
+}
+
+enum ExportMode {
+  exportSerial,
+  exportBackground,
+  exportSnapshot,
+};
+
+// Returns an error message or NULL
+static const char* exportFile(Project* project, const char* path, enum ExportMode mode) {
+  Exporter* exporter = NULL;
+  if (mode == exportSnapshot) {
+    char* arg = malloc(strlen(path) + 1);
+    if (arg) strcpy(arg, path);
+    exporter = arg ? createBackgroundExporterFromSnapshot(projectSnapshotTake(project, NULL), createExporter, arg) : NULL;
+  } else {
+    exporter = createWAVExporter(path, project, 0, EXPORT_RATE, 16);
+    if (exporter && mode == exportBackground) exporter = createBackgroundExporter(exporter);
+  }
+  if (!exporter) return "can't create the exporter";
+
+  while (exporter->next(exporter) != -1);
+  if (exporter->finish(exporter)) return "export failed";
+  return NULL;
+}
+
+// Returns 1 if the files differ
+static int compareFiles(const char* pathA, const char* pathB) {
+  long sizeA = -1, sizeB = -1;
+  const void* dataA = fileMap(pathA, &sizeA);
+  const void* dataB = fileMap(pathB, &sizeB);
+  int result = !dataA || !dataB || sizeA != sizeB || memcmp(dataA, dataB, sizeA);
+  if (dataA) fileUnmap(dataA, sizeA);
+  if (dataB) fileUnmap(dataB, sizeB);
+  return result;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  if (projectLoad(project, path)) {
+    printf("FAIL %s: can't load project: %s\n", path, projectFileError);
+    free(project);
+    return 1;
+  }
+
+  char serialPath[1024];
+  char backgroundPath[1024];
+  snprintf(serialPath, sizeof(serialPath), "%s-serial.wav", scratchPath);
+  snprintf(backgroundPath, sizeof(backgroundPath), "%s-background.wav", scratchPath);
+
+  const char* error = exportFile(project, serialPath, exportSerial);
+  if (!error) error = exportFile(project, backgroundPath, exportBackground);
+  if (!error && compareFiles(serialPath, backgroundPath)) error = "background export differs";
+  if (!error) error = exportFile(project, backgroundPath, exportSnapshot);
+  if (!error && compareFiles(serialPath, backgroundPath)) error = "snapshot export differs";
+
+  // No thread for the worker, next() runs the steps
+  int threadIds[CORELIB_MAX_THREADS];
+  int count = takeThreads(threadIds);
+  if (!error) error = exportFile(project, backgroundPath, exportBackground);
+  if (!error && compareFiles(serialPath, backgroundPath)) error = "export without threads differs";
+  if (!error) error = exportFile(project, backgroundPath, exportSnapshot);
+  if (!error && compareFiles(serialPath, backgroundPath)) error = "snapshot export without threads differs";
+  releaseThreads(threadIds, count);
+
+  fileDelete(serialPath);
+  fileDelete(backgroundPath);
+
+  if (error) {
+    printf("FAIL %s: %s\n", path, error);
+  } else {
+    printf("OK   %s\n", path);
+  }
+  free(project);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "corelib/corelib_file.h"
+
+// File layer test: reads each file with fileRead in uneven chunks, line by
+// line and through fileMap, with the smallest, a small and the default buffer
+// size, and compares everything with the file read by stdio. Then writes the
+// file back in uneven chunks and checks the result, the number of OS calls
+// and seeking. Opening more files than there are handles must fail. Writes to
+// a full device must fail on close, also when the failed flush was a seek's.
+//
+// Usage: test_file [-o scratch] file ...
+
+static const char* scratchPath = "test_file";
+
+static const int bufferSizes[] = {CORELIB_FILE_MIN_BUFFER_SIZE, 4096, CORELIB_FILE_BUFFER_SIZE};
+#define BUFFER_SIZES_COUNT (int)(sizeof(bufferSizes) / sizeof(bufferSizes[0]))
+
+static const int chunkSizes[] = {1, 7, 1000, 3000, 100000};
+#define CHUNK_SIZES_COUNT (int)(sizeof(chunkSizes) / sizeof(chunkSizes[0]))
+
+static long readFile(const char* path, char** data) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  *data = malloc(size > 0 ? size : 1);
+  if (!*data || fread(*data, 1, size, file) != (size_t)size) size = -1;
+  fclose(file);
+  return size;
+}
+
+// Returns an error message or NULL
+static const char* testRead(const char* path, const char* data, long size) {
+  char* read = malloc(size + 1);
+  if (!read) return "out of memory";
+
+  const char* error = NULL;
+  for (int c = 0; c < CHUNK_SIZES_COUNT && !error; c++) {
+    int fileId = fileOpen(path, 0);
+    if (fileId == -1) {
+      error = "can't open file";
+      break;
+    }
+    long length = 0;
+    while (1) {
+      int chunk = chunkSizes[c] < size + 1 - length ? chunkSizes[c] : size + 1 - length;
+      int count = fileRead(fileId, read + length, chunk);
+      length += count;
+      if (count < chunk) break;
+    }
+    fileClose(fileId);
+    if (length != size || memcmp(read, data, size)) error = "fileRead differs";
+  }
+
+  free(read);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testLines(const char* path, const char* data, long size, int bufferSize) {
+  int fileId = fileOpen(path, 0);
+  if (fileId == -1) return "can't open file";
+
+  const char* error = NULL;
+  long pos = 0;
+  int length;
+  char* line;
+  while ((line = fileReadLine(fileId, &length)) != NULL) {
+    // Same line split at the buffer size
+    const char* eol = memchr(data + pos, '\n', size - pos);
+    long expected = eol ? eol - (data + pos) : size - pos;
+    if (expected > bufferSize) expected = bufferSize;
+    if (length != expected || memcmp(line, data + pos, length) || line[length] != 0) {
+      error = "fileReadLine differs";
+      break;
+    }
+    pos += length;
+    if (pos < size && data[pos] == '\n' && length < bufferSize) pos++;
+  }
+  if (!error && pos != size) error = "fileReadLine stopped early";
+
+  fileClose(fileId);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testMap(const char* path, const char* data, long size) {
+  long mappedSize;
+  const char* mapped = fileMap(path, &mappedSize);
+  if (!mapped) return "can't map file";
+  const char* error = mappedSize != size || memcmp(mapped, data, size) ? "fileMap differs" : NULL;
+  fileUnmap(mapped, mappedSize);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testWrite(const char* data, long size, int bufferSize) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.tmp", scratchPath);
+
+  fileResetStats();
+  int fileId = fileOpen(path, 1);
+  if (fileId == -1) return "can't open scratch file";
+  for (long pos = 0, c = 0; pos < size; c++) {
+    int chunk = chunkSizes[c % CHUNK_SIZES_COUNT];
+    if (chunk > size - pos) chunk = size - pos;
+    if (fileWrite(fileId, (void*)(data + pos), chunk) != chunk) break;
+    pos += chunk;
+  }
+  int closeResult = fileClose(fileId);
+
+  FileStats stats;
+  fileGetStats(&stats);
+  char* written = NULL;
+  long writtenSize = readFile(path, &written);
+  const char* error = NULL;
+  if (closeResult) {
+    error = "close failed";
+  } else if (writtenSize != size || memcmp(written, data, size)) {
+    error = "written file differs";
+  } else if (stats.opens != 1 || stats.bytesWritten != size || stats.writes > size / bufferSize * 2 + 2) {
+    error = "unexpected write stats";
+  }
+  free(written);
+  fileDelete(path);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testSeek(const char* path, const char* data, long size) {
+  if (size < 32) return NULL;
+
+  int fileId = fileOpen(path, 0);
+  if (fileId == -1) return "can't open file";
+  char bytes[10];
+  const char* error = NULL;
+  if (fileRead(fileId, bytes, 10) != 10 || fileSeek(fileId, 5, SEEK_CUR) ||
+    fileRead(fileId, bytes, 1) != 1 || bytes[0] != data[15]) {
+    error = "SEEK_CUR read wrong data";
+  } else if (fileSeek(fileId, 2, SEEK_SET) || fileRead(fileId, bytes, 1) != 1 || bytes[0] != data[2]) {
+    error = "SEEK_SET read wrong data";
+  }
+  fileClose(fileId);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testHandles(const char* path) {
+  int fileIds[CORELIB_MAX_OPEN_FILES];
+  const char* error = NULL;
+  int opened = 0;
+  for (; opened < CORELIB_MAX_OPEN_FILES; opened++) {
+    fileIds[opened] = fileOpen(path, 0);
+    if (fileIds[opened] == -1) break;
+  }
+
+  if (opened < CORELIB_MAX_OPEN_FILES) {
+    error = "can't open all handles";
+  } else if (fileOpen(path, 0) != -1) {
+    error = "opened more files than handles";
+  } else {
+    fileClose(fileIds[0]);
+    fileIds[0] = fileOpen(path, 0);
+    if (fileIds[0] == -1) error = "closed handle not reused";
+  }
+
+  for (int c = 0; c < opened; c++) {
+    if (fileIds[c] != -1) fileClose(fileIds[c]);
+  }
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testWriteErrors(const char* data, long size) {
+  // Linux only, every write to it fails with ENOSPC
+  const char* fullPath = "/dev/full";
+  int fileId = fileOpen(fullPath, 1);
+  if (fileId == -1) return NULL;
+  // Smaller than the buffer, nothing is written before the close
+  fileWrite(fileId, (void*)data, size < 100 ? size : 100);
+  if (!fileClose(fileId)) return "buffered write to a full device didn't fail";
+
+  // The error of a flush before a seek is kept for the close
+  fileId = fileOpen(fullPath, 1);
+  if (fileId == -1) return "can't open a full device again";
+  fileWrite(fileId, (void*)data, size < 100 ? size : 100);
+  fileSeek(fileId, 0, SEEK_SET);
+  if (!fileFlush(fileId)) {
+    fileClose(fileId);
+    return "failed flush before a seek not reported";
+  }
+  if (!fileClose(fileId)) return "failed flush before a seek not reported on close";
+  return NULL;
+}
+
+// Returns 1 on failure
+static int testFile(const char* path) {
+  char* data = NULL;
+  long size = readFile(path, &data);
+  const char* error = size < 0 ? "can't read file" : NULL;
+
+  for (int c = 0; c < BUFFER_SIZES_COUNT && !error; c++) {
+    fileSetBufferSize(bufferSizes[c]);
+    error = testRead(path, data, size);
+    if (!error) error = testLines(path, data, size, bufferSizes[c]);
+    if (!error) error = testMap(path, data, size);
+    if (!error) error = testWrite(data, size, bufferSizes[c]);
+    if (!error) error = testSeek(path, data, size);
+    if (error) printf("FAIL %s (%d byte buffer): %s\n", path, bufferSizes[c], error);
+  }
+  fileSetBufferSize(CORELIB_FILE_BUFFER_SIZE);
+
+  if (!error) {
+    error = testHandles(path);
+    if (!error && size > 0) error = testWriteErrors(data, size);
+    if (error) printf("FAIL %s: %s\n", path, error);
+  }
+  if (!error) printf("OK   %s\n", path);
+
+  free(data);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testFile(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+
+// Autosave journal test: opens a journal for each project, edits phrases,
+// chains, instruments and the song with syncs in between, then "crashes"
+// without compacting. Loading the snapshot with the journal must give the
+// edited project, and a journal cut in the middle of the last sync must give
+// the project as of the sync before. A journal left over from an older
+// snapshot, as after a crash during compaction, must be skipped. Large changes
+// must compact the journal.
+//
+// Usage: test_journal [-o scratch] project.cnm ...
+
+static const char* scratchPath = "test_journal";
+
+// Same text file when saved? Returns 1 if not
+static int compareAsText(Project* a, Project* b) {
+  char pathA[1024];
+  char pathB[1024];
+  snprintf(pathA, sizeof(pathA), "%s-a.cnm", scratchPath);
+  snprintf(pathB, sizeof(pathB), "%s-b.cnm", scratchPath);
+
+  long sizeA = -1, sizeB = -1;
+  const void* dataA = NULL;
+  const void* dataB = NULL;
+  int result = projectSave(a, pathA) || projectSave(b, pathB);
+  if (!result) dataA = fileMap(pathA, &sizeA);
+  if (!result) dataB = fileMap(pathB, &sizeB);
+  result = !dataA || !dataB || sizeA != sizeB || memcmp(dataA, dataB, sizeA);
+
+  if (dataA) fileUnmap(dataA, sizeA);
+  if (dataB) fileUnmap(dataB, sizeB);
+  fileDelete(pathA);
+  fileDelete(pathB);
+  return result;
+}
+
+// A few edits like the ones made on the screens
+static void edit(Project* p, int step) {
+  PhraseRow* row = &p->phrases[step % PROJECT_MAX_PHRASES].rows[step % 16];
+  row->note = (row->note + 1) % p->pitchTable.length;
+  row->volume = step & 15;
+  row->fx[1][0] = fxVOL;
+  row->fx[1][1] = step;
+
+  p->chains[(step * 7) % PROJECT_MAX_CHAINS].rows[step % 16].phrase = step % PROJECT_MAX_PHRASES;
+  p->song[step % PROJECT_MAX_LENGTH][step % p->tracksCount] = step % PROJECT_MAX_CHAINS;
+  snprintf(p->instruments[step % PROJECT_MAX_INSTRUMENTS].name, PROJECT_INSTRUMENT_NAME_LENGTH + 1, "Edit %d", step);
+}
+
+static long fileSize(const char* path) {
+  long size = -1;
+  const void* data = fileMap(path, &size);
+  if (data) fileUnmap(data, size);
+  return size;
+}
+
+// First length bytes of the file, or all of them if length is -1. NULL on failure
+static char* readFile(const char* path, long* length) {
+  long size;
+  const void* data = fileMap(path, &size);
+  if (!data) return NULL;
+  if (*length == -1 || *length > size) *length = size;
+  char* copy = malloc(*length > 0 ? *length : 1);
+  if (copy) memcpy(copy, data, *length);
+  fileUnmap(data, size);
+  return copy;
+}
+
+// Returns 1 on failure
+static int writeFile(const char* path, const char* data, long length) {
+  int fileId = fileOpen(path, 1);
+  if (fileId == -1) return 1;
+  int result = fileWrite(fileId, (void*)data, length) != length;
+  return fileClose(fileId) || result;
+}
+
+// Cut the file to length bytes. Returns 1 on failure
+static int truncateFile(const char* path, long length) {
+  char* data = readFile(path, &length);
+  int result = !data || writeFile(path, data, length);
+  free(data);
+  return result;
+}
+
+// Returns an error message or NULL
+static const char* testJournal(Project* project, Project* expected, Project* loaded) {
+  char snapshotPath[1024];
+  char journalPath[1100];
+  snprintf(snapshotPath, sizeof(snapshotPath), "%s.cnm", scratchPath);
+  snprintf(journalPath, sizeof(journalPath), "%s.journal", snapshotPath);
+
+  ProjectJournal journal;
+  if (projectJournalOpen(&journal, project, snapshotPath)) return "can't open journal";
+  long snapshotSize = fileSize(snapshotPath);
+
+  const char* error = NULL;
+  long syncedSize = 0;
+  for (int step = 0; step < 20 && !error; step++) {
+    syncedSize = journal.size;
+    memcpy(expected, project, sizeof(Project));
+    edit(project, step);
+    if (projectJournalSync(&journal, project)) error = "sync failed";
+  }
+
+  // Crash: the journal isn't compacted
+  projectJournalClose(&journal);
+  if (!error && fileSize(snapshotPath) != snapshotSize) error = "snapshot rewritten by small edits";
+  if (!error && (projectJournalLoad(loaded, snapshotPath) || compareAsText(loaded, project))) {
+    error = "replayed journal differs";
+  }
+  // Crash in the middle of the last sync
+  if (!error && truncateFile(journalPath, syncedSize + 3)) error = "can't cut journal";
+  if (!error && (projectJournalLoad(loaded, snapshotPath) || compareAsText(loaded, expected))) {
+    error = "cut journal differs";
+  }
+
+  // Crash after a compaction wrote the snapshot, before it emptied the journal.
+  // The old journal would undo the edit made after it
+  long oldSize = -1;
+  char* oldJournal = error ? NULL : readFile(journalPath, &oldSize);
+  if (!error && !oldJournal) error = "can't read journal";
+  if (!error) {
+    edit(project, 0);
+    if (projectJournalOpen(&journal, project, snapshotPath)) error = "can't reopen journal";
+    projectJournalClose(&journal);
+  }
+  if (!error && writeFile(journalPath, oldJournal, oldSize)) error = "can't write journal";
+  if (!error && (projectJournalLoad(loaded, snapshotPath) || compareAsText(loaded, project))) {
+    error = "journal of an older snapshot replayed";
+  }
+  free(oldJournal);
+
+  // Edits all over the project, like loading another one
+  if (!error && projectJournalOpen(&journal, loaded, snapshotPath)) error = "can't reopen journal";
+  if (!error) {
+    for (int c = 0; c < PROJECT_MAX_PHRASES; c++) {
+      for (int r = 0; r < 16; r++) loaded->phrases[c].rows[r].volume = r;
+    }
+    if (projectJournalSync(&journal, loaded)) error = "sync failed";
+    else if (journal.size != PROJECT_JOURNAL_HEADER_SIZE) error = "large change not compacted";
+    projectJournalClose(&journal);
+  }
+  if (!error && (projectJournalLoad(expected, snapshotPath) || compareAsText(expected, loaded))) {
+    error = "compacted project differs";
+  }
+
+  fileDelete(snapshotPath);
+  fileDelete(journalPath);
+  return error;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  Project* expected = malloc(sizeof(Project));
+  Project* loaded = malloc(sizeof(Project));
+  if (!project || !expected || !loaded) return 1;
+
+  const char* error = projectLoad(project, path) ? "can't load project" : testJournal(project, expected, loaded);
+  if (error) {
+    printf("FAIL %s: %s %s\n", path, error, projectFileError);
+  } else {
+    printf("OK   %s\n", path);
+  }
+
+  free(project);
+  free(expected);
+  free(loaded);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "chipnomad_lib.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+
+// Loudness test: checks the meter against reference tones and gating, then
+// exports each project with the serial and the parallel WAV exporter, with
+// and without normalization, and measures the written files again.
+//
+// Usage: test_loudness [-o scratch.wav] project.cnm ...
+
+#define TONE_RATE (48000)
+#define EXPORT_RATE (44100)
+#define TARGET_LUFS (-16.0f)
+#define TRUE_PEAK_LIMIT (-1.0f)
+#define TOLERANCE (0.05f)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const char* wavPath = "test_loudness.wav";
+
+// Stereo 997 Hz sine, amplitude in dBFS, or silence for dB <= -120
+static float* makeTone(int samples, float db) {
+  float* buffer = malloc(samples * 2 * sizeof(float));
+  if (!buffer) return NULL;
+  float amplitude = db > LOUDNESS_FLOOR_DB ? powf(10.0f, db / 20.0f) : 0;
+  for (int c = 0; c < samples; c++) {
+    buffer[c * 2] = buffer[c * 2 + 1] = amplitude * (float)sin(2.0 * M_PI * 997.0 * c / TONE_RATE);
+  }
+  return buffer;
+}
+
+static int isNear(float value, float expected) {
+  return fabsf(value - expected) <= TOLERANCE;
+}
+
+// Returns 1 on failure
+static int testTones(void) {
+  int failed = 0;
+  int samples = TONE_RATE * 10;
+  float* tone = makeTone(samples, -23.0f);
+  float* silence = makeTone(samples, LOUDNESS_FLOOR_DB);
+  if (!tone || !silence) return 1;
+
+  // Stereo tone at -23 dBFS is -23 LUFS
+  LoudnessStats stats;
+  LoudnessMeter* meter = loudnessCreate(TONE_RATE, 0);
+  loudnessAdd(meter, tone, samples);
+  loudnessGetStats(meter, &stats);
+  loudnessFree(meter);
+  if (!isNear(stats.integrated, -23.0f) || !isNear(stats.samplePeak, -23.0f)) {
+    printf("FAIL tone: %.2f LUFS, %.2f dBFS\n", stats.integrated, stats.samplePeak);
+    failed = 1;
+  } else {
+    printf("OK   tone: %.2f LUFS, %.2f dBTP\n", stats.integrated, stats.truePeak);
+  }
+
+  // Silence after the tone is gated out. The 3 blocks that overlap the end
+  // of the tone are above the relative gate, so 98.5 blocks of energy in 100
+  meter = loudnessCreate(TONE_RATE, 0);
+  loudnessAdd(meter, tone, samples);
+  loudnessAdd(meter, silence, samples);
+  loudnessGetStats(meter, &stats);
+  if (!isNear(stats.integrated, -23.07f)) {
+    printf("FAIL gating: %.2f LUFS\n", stats.integrated);
+    failed = 1;
+  } else {
+    printf("OK   gating: %.2f LUFS\n", stats.integrated);
+  }
+
+  // Two parts measured separately and merged
+  int split = samples / 3 + 123;
+  LoudnessMeter* first = loudnessCreate(TONE_RATE, 0);
+  LoudnessMeter* second = loudnessCreate(TONE_RATE, split);
+  loudnessAdd(first, tone, split);
+  loudnessPrime(second, tone + (split - 1000) * 2, 1000);
+  loudnessAdd(second, tone + split * 2, samples - split);
+  loudnessAdd(second, silence, samples);
+  LoudnessStats merged;
+  if (loudnessMerge(first, second)) {
+    printf("FAIL merge: out of memory\n");
+    failed = 1;
+  } else {
+    loudnessGetStats(first, &merged);
+    if (!isNear(merged.integrated, stats.integrated) || !isNear(merged.truePeak, stats.truePeak)) {
+      printf("FAIL merge: %.2f LUFS, %.2f dBTP, expected %.2f LUFS, %.2f dBTP\n",
+        merged.integrated, merged.truePeak, stats.integrated, stats.truePeak);
+      failed = 1;
+    } else {
+      printf("OK   merge: %.2f LUFS\n", merged.integrated);
+    }
+  }
+  loudnessFree(meter);
+  loudnessFree(first);
+  loudnessFree(second);
+
+  // Silence has no loudness and isn't amplified
+  meter = loudnessCreate(TONE_RATE, 0);
+  loudnessAdd(meter, silence, samples);
+  loudnessGetStats(meter, &stats);
+  loudnessFree(meter);
+  if (stats.integrated > LOUDNESS_FLOOR_DB || loudnessNormalizationGain(&stats, TARGET_LUFS, TRUE_PEAK_LIMIT) != 0) {
+    printf("FAIL silence: %.2f LUFS\n", stats.integrated);
+    failed = 1;
+  } else {
+    printf("OK   silence\n");
+  }
+
+  free(tone);
+  free(silence);
+  return failed;
+}
+
+// Measure float32 samples of a WAV file written by the exporters. Returns 1 on failure
+static int measureFile(const char* path, LoudnessStats* stats) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return 1;
+
+  uint8_t header[44];
+  int failed = fread(header, 1, sizeof(header), file) != sizeof(header) || header[34] != 32;
+  uint32_t dataSize = header[40] | (header[41] << 8) | (header[42] << 16) | ((uint32_t)header[43] << 24);
+
+  LoudnessMeter* meter = loudnessCreate(EXPORT_RATE, 0);
+  float buffer[4096 * 2];
+  for (uint32_t done = 0; !failed && meter && done < dataSize;) {
+    uint32_t length = dataSize - done;
+    if (length > sizeof(buffer)) length = sizeof(buffer);
+    if (fread(buffer, 1, length, file) != length) failed = 1;
+    loudnessAdd(meter, buffer, length / 8);
+    done += length;
+  }
+  if (meter) loudnessGetStats(meter, stats);
+
+  loudnessFree(meter);
+  fclose(file);
+  return failed || !meter;
+}
+
+// Returns an error message or NULL
+static const char* exportFile(Project* project, int isParallel, int isNormalized, LoudnessStats* stats) {
+  Exporter* exporter = isParallel ?
+    createWAVExporterParallel(wavPath, project, 0, EXPORT_RATE, 32, 4) :
+    createWAVExporter(wavPath, project, 0, EXPORT_RATE, 32);
+  if (!exporter) return "can't create the exporter";
+  if (isNormalized && wavExporterSetNormalization(exporter, TARGET_LUFS, TRUE_PEAK_LIMIT)) {
+    exporter->cancel(exporter);
+    return "can't enable normalization";
+  }
+
+  while (exporter->next(exporter) != -1);
+  if (exporter->finish(exporter)) return "export failed";
+  if (wavReadLoudness(wavPath, stats)) return "no loudness in the file";
+  return NULL;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  if (projectLoad(project, path)) {
+    printf("FAIL %s: can't load project: %s\n", path, projectFileError);
+    free(project);
+    return 1;
+  }
+
+  LoudnessStats serial, parallel, normalized, measured;
+  const char* error = exportFile(project, 0, 0, &serial);
+  if (!error && measureFile(wavPath, &measured)) error = "can't measure the export";
+  if (!error && (!isNear(serial.integrated, measured.integrated) || !isNear(serial.truePeak, measured.truePeak))) {
+    error = "stored loudness differs from the file";
+  }
+
+  if (!error) error = exportFile(project, 1, 0, &parallel);
+  if (!error && (!isNear(serial.integrated, parallel.integrated) || !isNear(serial.truePeak, parallel.truePeak))) {
+    error = "parallel export measured differently";
+  }
+
+  if (!error) error = exportFile(project, 1, 1, &normalized);
+  if (!error && measureFile(wavPath, &measured)) error = "can't measure the normalized export";
+  if (!error && !isNear(normalized.integrated, measured.integrated)) error = "stored loudness differs from the normalized file";
+  // Either at the target or held back by the true peak limit
+  if (!error && !isNear(measured.integrated, TARGET_LUFS) &&
+    !(isNear(normalized.truePeak, TRUE_PEAK_LIMIT) && measured.integrated < TARGET_LUFS)) {
+    error = "normalized loudness is off";
+  }
+  if (!error && measured.truePeak > TRUE_PEAK_LIMIT + TOLERANCE) error = "true peak is over the limit";
+  fileDelete(wavPath);
+
+  if (error) {
+    printf("FAIL %s: %s\n", path, error);
+  } else {
+    printf("OK   %s: %.2f LUFS, %.2f dBTP, normalized with %+.2f dB to %.2f LUFS\n",
+      path, serial.integrated, serial.truePeak, normalized.gain, measured.integrated);
+  }
+
+  free(project);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      wavPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = testTones();
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+
+// Project file test: saves each project as binary (.cnb), loads it back and
+// compares it with the project loaded from text. Both are saved as text again
+// and must give the same file. The text file with CRLF line endings and
+// trailing spaces must load the same. Truncated binary files must fail to
+// load without touching the project. FX in binary files are found by the
+// names in the file, also with renumbered codes or without the names.
+//
+// Usage: test_project [-o scratch] project.cnm ...
+
+static const char* scratchPath = "test_project";
+
+static long readFile(const char* path, char** data) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  *data = malloc(size > 0 ? size : 1);
+  if (!*data || fread(*data, 1, size, file) != (size_t)size) size = -1;
+  fclose(file);
+  return size;
+}
+
+static int writeFile(const char* path, const char* data, long size) {
+  FILE* file = fopen(path, "wb");
+  if (!file) return 1;
+  int result = fwrite(data, 1, size, file) != (size_t)size;
+  fclose(file);
+  return result;
+}
+
+// Same text file when saved? Returns 1 if not
+static int compareAsText(Project* a, Project* b) {
+  char pathA[1024];
+  char pathB[1024];
+  snprintf(pathA, sizeof(pathA), "%s-a.cnm", scratchPath);
+  snprintf(pathB, sizeof(pathB), "%s-b.cnm", scratchPath);
+
+  char* dataA = NULL;
+  char* dataB = NULL;
+  int result = projectSave(a, pathA) || projectSave(b, pathB);
+  long sizeA = result ? -1 : readFile(pathA, &dataA);
+  long sizeB = result ? -1 : readFile(pathB, &dataB);
+  result = sizeA < 0 || sizeA != sizeB || memcmp(dataA, dataB, sizeA);
+
+  free(dataA);
+  free(dataB);
+  fileDelete(pathA);
+  fileDelete(pathB);
+  return result;
+}
+
+// Returns an error message or NULL
+static const char* compareProjects(Project* a, Project* b) {
+  if (strcmp(a->title, b->title) || strcmp(a->author, b->author)) return "title or author differs";
+  if (a->tickRate != b->tickRate || a->chipType != b->chipType || a->chipsCount != b->chipsCount ||
+    a->tracksCount != b->tracksCount || a->linearPitch != b->linearPitch) return "settings differ";
+  if (a->chipSetup.ay.clock != b->chipSetup.ay.clock || a->chipSetup.ay.isYM != b->chipSetup.ay.isYM ||
+    a->chipSetup.ay.stereoMode != b->chipSetup.ay.stereoMode ||
+    a->chipSetup.ay.stereoSeparation != b->chipSetup.ay.stereoSeparation) return "chip setup differs";
+  if (memcmp(a->song, b->song, sizeof(a->song)) || memcmp(a->songHighlight, b->songHighlight, sizeof(a->songHighlight))) {
+    return "song differs";
+  }
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    for (int d = 0; d < 16; d++) {
+      if (a->chains[c].rows[d].phrase != b->chains[c].rows[d].phrase ||
+        a->chains[c].rows[d].transpose != b->chains[c].rows[d].transpose) return "chains differ";
+    }
+  }
+  if (memcmp(a->phrases, b->phrases, sizeof(a->phrases))) return "phrases differ";
+  if (memcmp(a->grooves, b->grooves, sizeof(a->grooves))) return "grooves differ";
+  if (memcmp(a->tables, b->tables, sizeof(a->tables))) return "tables differ";
+  if (compareAsText(a, b)) return "text files differ";
+  return NULL;
+}
+
+// Returns an error message or NULL
+static const char* testTruncated(Project* project, const char* binaryPath) {
+  char* data = NULL;
+  long size = readFile(binaryPath, &data);
+  if (size < 0) return "can't read the binary file";
+
+  char truncatedPath[1024];
+  snprintf(truncatedPath, sizeof(truncatedPath), "%s-truncated.cnb", scratchPath);
+  strcpy(project->title, "Untouched");
+
+  const char* error = NULL;
+  long sizes[] = {2, 12, size / 2, size - 1};
+  for (int c = 0; c < 4 && !error; c++) {
+    if (writeFile(truncatedPath, data, sizes[c])) {
+      error = "can't write the truncated file";
+    } else if (!projectLoad(project, truncatedPath)) {
+      error = "truncated file loaded";
+    } else if (strcmp(project->title, "Untouched")) {
+      error = "failed load changed the project";
+    }
+  }
+
+  fileDelete(truncatedPath);
+  free(data);
+  return error;
+}
+
+static uint8_t swapFX(uint8_t fx, uint8_t a, uint8_t b) {
+  return fx == a ? b : fx == b ? a : fx;
+}
+
+// Section table entry of the FX names, NULL if there's none
+static uint8_t* findFXNames(uint8_t* data, long size) {
+  int sectionsCount = data[6] | (data[7] << 8);
+  for (int c = 0; c < sectionsCount && 12 + c * 12 + 12 <= size; c++) {
+    uint8_t* entry = data + 12 + c * 12;
+    if (!memcmp(entry, "FXNM", 4)) return entry;
+  }
+  return NULL;
+}
+
+// Returns an error message or NULL
+static const char* testFXCodes(Project* text, Project* project, const char* binaryPath) {
+  char* data = NULL;
+  long size = readFile(binaryPath, &data);
+  if (size < 0) return "can't read the binary file";
+
+  char changedPath[1024];
+  snprintf(changedPath, sizeof(changedPath), "%s-fx.cnb", scratchPath);
+  const char* error = NULL;
+  uint8_t* entry = findFXNames((uint8_t*)data, size);
+  if (!entry) error = "no FX names";
+
+  // Names of ARP and VOL swapped: their codes in rows mean the other FX
+  if (!error) {
+    uint32_t offset = entry[4] | (entry[5] << 8) | (entry[6] << 16) | ((uint32_t)entry[7] << 24);
+    memcpy(data + offset + 1 + fxARP * 3, "VOL", 3);
+    memcpy(data + offset + 1 + fxVOL * 3, "ARP", 3);
+    if (writeFile(changedPath, data, size) || projectLoad(project, changedPath)) {
+      error = "can't load swapped FX names";
+    } else {
+      for (int c = 0; c < PROJECT_MAX_PHRASES && !error; c++) {
+        for (int d = 0; d < 16 * 3; d++) {
+          uint8_t fx = text->phrases[c].rows[d / 3].fx[d % 3][0];
+          if (project->phrases[c].rows[d / 3].fx[d % 3][0] != swapFX(fx, fxARP, fxVOL)) error = "phrase FX not renamed";
+        }
+      }
+      for (int c = 0; c < PROJECT_MAX_TABLES && !error; c++) {
+        for (int d = 0; d < 16 * 4; d++) {
+          uint8_t fx = text->tables[c].rows[d / 4].fx[d % 4][0];
+          if (project->tables[c].rows[d / 4].fx[d % 4][0] != swapFX(fx, fxARP, fxVOL)) error = "table FX not renamed";
+        }
+      }
+    }
+    memcpy(data + offset + 1 + fxARP * 3, "ARP", 3);
+    memcpy(data + offset + 1 + fxVOL * 3, "VOL", 3);
+  }
+
+  // Without the section the codes of the first version are used
+  if (!error) {
+    memcpy(entry, "XXXX", 4);
+    if (writeFile(changedPath, data, size) || projectLoad(project, changedPath)) {
+      error = "can't load without FX names";
+    } else if (memcmp(text->phrases, project->phrases, sizeof(text->phrases)) ||
+      memcmp(text->tables, project->tables, sizeof(text->tables))) {
+      error = "FX differ without FX names";
+    }
+  }
+
+  fileDelete(changedPath);
+  free(data);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testCRLF(Project* text, Project* project, const char* path) {
+  char* data = NULL;
+  long size = readFile(path, &data);
+  char* converted = malloc(size * 3 + 1);
+  if (size < 0 || !converted) {
+    free(data);
+    free(converted);
+    return "can't read the text file";
+  }
+
+  long length = 0;
+  for (long c = 0; c < size; c++) {
+    if (data[c] == '\n') {
+      converted[length++] = ' ';
+      converted[length++] = '\r';
+    }
+    converted[length++] = data[c];
+  }
+
+  char crlfPath[1024];
+  snprintf(crlfPath, sizeof(crlfPath), "%s-crlf.cnm", scratchPath);
+  const char* error = NULL;
+  if (writeFile(crlfPath, converted, length)) {
+    error = "can't write the CRLF file";
+  } else if (projectLoad(project, crlfPath)) {
+    error = "can't load the CRLF file";
+  } else {
+    error = compareProjects(text, project);
+  }
+
+  fileDelete(crlfPath);
+  free(data);
+  free(converted);
+  return error;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  char binaryPath[1024];
+  snprintf(binaryPath, sizeof(binaryPath), "%s.cnb", scratchPath);
+
+  Project* text = malloc(sizeof(Project));
+  Project* binary = malloc(sizeof(Project));
+  if (!text || !binary) return 1;
+
+  const char* error = NULL;
+  if (projectLoad(text, path)) {
+    error = "can't load project";
+  } else if (projectSaveBinary(text, binaryPath)) {
+    error = "can't save binary";
+  } else if (projectLoad(binary, binaryPath)) {
+    error = "can't load binary";
+  }
+  if (!error) error = compareProjects(text, binary);
+  if (!error) error = testTruncated(binary, binaryPath);
+  if (!error) error = testFXCodes(text, binary, binaryPath);
+  if (!error) error = testCRLF(text, binary, path);
+  fileDelete(binaryPath);
+
+  if (error) {
+    printf("FAIL %s: %s %s\n", path, error, projectFileError);
+  } else {
+    printf("OK   %s\n", path);
+  }
+
+  free(text);
+  free(binary);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+
+// Project index test: reads the info of each project from its header, also
+// after saving it as .cnb, and compares it with a full load. Then copies the
+// projects and a broken one to a scratch folder, indexes it, and checks that a
+// reopened index has every file without reading them, that a changed file is
+// out of date and that removed files are dropped.
+//
+// Usage: test_project_index [-o scratch] project.cnm ...
+
+static const char* scratchFolder = "project_index_scratch";
+
+// Returns an error message or NULL
+static const char* compareInfo(const ProjectInfo* info, const Project* p) {
+  int songLength = 0;
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
+    for (int t = 0; t < p->tracksCount; t++) {
+      if (p->song[c][t] != EMPTY_VALUE_16) songLength = c + 1;
+    }
+  }
+
+  if (strcmp(info->title, p->title) || strcmp(info->author, p->author)) return "title or author differs";
+  if (info->tickRate != p->tickRate) return "tick rate differs";
+  if (info->chipType != p->chipType || info->chipsCount != p->chipsCount) return "chips differ";
+  if (info->songLength != songLength) return "song length differs";
+  return NULL;
+}
+
+static void filePath(char* path, int size, const char* name) {
+  snprintf(path, size, "%s%s%s", scratchFolder, PATH_SEPARATOR_STR, name);
+}
+
+// Returns an error message or NULL
+static const char* testInfo(const char* path, Project* project) {
+  ProjectInfo info;
+  if (projectLoad(project, path)) return "can't load project";
+  if (projectLoadInfo(&info, path)) return "can't read info";
+  const char* error = compareInfo(&info, project);
+  if (error) return error;
+
+  char binaryPath[1024];
+  filePath(binaryPath, sizeof(binaryPath), "binary.cnb");
+  if (projectSaveBinary(project, binaryPath)) return "can't save binary project";
+  if (projectLoadInfo(&info, binaryPath)) {
+    error = "can't read binary info";
+  } else {
+    error = compareInfo(&info, project);
+  }
+  fileDelete(binaryPath);
+  return error;
+}
+
+// Each project is copied as <n>.cnm, plus broken.cnm
+static int copyProjects(const char** files, int filesCount, Project* project) {
+  char path[1024];
+  for (int c = 0; c < filesCount; c++) {
+    char name[32];
+    snprintf(name, sizeof(name), "%d.cnm", c);
+    filePath(path, sizeof(path), name);
+    if (projectLoad(project, files[c]) || projectSave(project, path)) return 1;
+  }
+
+  filePath(path, sizeof(path), "broken.cnm");
+  int fileId = fileOpen(path, 1);
+  if (fileId == -1) return 1;
+  filePrintf(fileId, "Not a project\n");
+  fileClose(fileId);
+  return 0;
+}
+
+// Returns an error message or NULL
+static const char* testIndex(const char** files, int filesCount, Project* project) {
+  if (copyProjects(files, filesCount, project)) return "can't copy projects";
+
+  int listedCount;
+  FileEntry* listed = fileListDirectory(scratchFolder, ".cnm", &listedCount);
+  if (!listed) return "can't list folder";
+
+  const char* error = NULL;
+  ProjectIndex* index = projectIndexOpen(scratchFolder);
+  int filesIndexed = 0;
+  for (int c = 0; c < listedCount && !error; c++) {
+    FileEntry* file = &listed[c];
+    if (file->isDirectory) continue;
+    if (projectIndexFind(index, file->name, file->size, file->modifiedTime)) {
+      error = "new folder has index entries";
+      break;
+    }
+    const ProjectIndexEntry* entry = projectIndexUpdate(index, file->name, file->size, file->modifiedTime);
+    if (!entry) {
+      error = "can't update entry";
+    } else if (entry->isValid == !strcmp(file->name, "broken.cnm")) {
+      error = "wrong entry validity";
+    } else if (entry->isValid) {
+      char path[1024];
+      filePath(path, sizeof(path), file->name);
+      projectLoad(project, path);
+      error = compareInfo(&entry->info, project);
+    }
+    filesIndexed++;
+  }
+  if (!error && filesIndexed != filesCount + 1) error = "files missing from listing";
+  if (!error && projectIndexSave(index)) error = "can't save index";
+  projectIndexClose(index);
+
+  // The reopened index has every file, nothing is read from the projects
+  index = projectIndexOpen(scratchFolder);
+  FileStats stats;
+  fileResetStats();
+  for (int c = 0; c < listedCount && !error; c++) {
+    FileEntry* file = &listed[c];
+    if (file->isDirectory) continue;
+    if (!projectIndexFind(index, file->name, file->size, file->modifiedTime)) error = "entry missing after reopening";
+  }
+  fileGetStats(&stats);
+  if (!error && (stats.opens || stats.maps)) error = "files read for indexed entries";
+  if (!error && projectIndexFind(index, "broken.cnm", 1, 0)) error = "changed file is up to date";
+
+  // Removed files are dropped
+  char path[1024];
+  filePath(path, sizeof(path), "broken.cnm");
+  fileDelete(path);
+  free(listed);
+  listed = fileListDirectory(scratchFolder, ".cnm", &listedCount);
+  projectIndexRetain(index, listed, listedCount);
+  if (!error && (index->count != filesCount || !index->isChanged)) error = "removed file not dropped";
+  if (!error && projectIndexSave(index)) error = "can't save index";
+  projectIndexClose(index);
+
+  for (int c = 0; c < listedCount; c++) {
+    filePath(path, sizeof(path), listed[c].name);
+    if (!listed[c].isDirectory) fileDelete(path);
+  }
+  free(listed);
+  filePath(path, sizeof(path), PROJECT_INDEX_FILENAME);
+  fileDelete(path);
+  return error;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchFolder = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  fileCreateDirectory(scratchFolder);
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    const char* error = testInfo(files[c], project);
+    if (error) {
+      printf("FAIL %s: %s %s\n", files[c], error, projectFileError);
+      failed++;
+    } else {
+      printf("OK   %s\n", files[c]);
+    }
+  }
+
+  const char* error = testIndex(files, filesCount, project);
+  if (error) {
+    printf("FAIL %s: %s\n", scratchFolder, error);
+    failed++;
+  } else {
+    printf("OK   %s\n", scratchFolder);
+  }
+
+  fileDelete(scratchFolder);
+  free(project);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+
+// Background project I/O test: loads each project on the worker and compares
+// it with a synchronous load, then saves it on the worker while the project
+// is being edited and checks the file has the project as of the save start,
+// also when saving a snapshot.
+// The loaded project is set on a state rendered by another thread with the
+// rendering paused, and must be swapped in whole.
+//
+// Usage: test_project_io [-o scratch] project.cnm ...
+
+static const char* scratchPath = "test_project_io";
+
+typedef struct {
+  ChipNomadState* state;
+  int mutexId; // Held while rendering, like the audio device lock
+  int isStopped; // Accessed atomically
+} RenderThreadData;
+
+// Renders like the audio callback does until stopped
+static int renderRun(void* arg) {
+  RenderThreadData* data = arg;
+  float buffer[256 * 2];
+  while (!atomicGet(&data->isStopped)) {
+    mutexLock(data->mutexId);
+    chipnomadRender(data->state, buffer, 256);
+    mutexUnlock(data->mutexId);
+  }
+  return 0;
+}
+
+// Wait for a load or save like the tracker's main loop does
+static int finish(ProjectIO* io, Project** loaded) {
+  while (!projectIOIsDone(io)) threadSleep(1);
+  return projectIOFinish(io, loaded);
+}
+
+// Returns an error message or NULL
+static const char* testLoadSave(const char* path, Project* expected, Project** loaded) {
+  if (projectLoad(expected, path)) return "can't load project";
+
+  ProjectIO* io = projectIOLoad(path);
+  if (!io) return "can't start load";
+  if (finish(io, loaded)) return "background load failed";
+  if (memcmp(*loaded, expected, sizeof(Project))) return "background load differs";
+
+  char savePath[1024];
+  snprintf(savePath, sizeof(savePath), "%s.cnm", scratchPath);
+  io = projectIOSave(*loaded, savePath);
+  if (!io) return "can't start save";
+  // Edits after the start don't go to this save
+  for (int c = 0; c < PROJECT_MAX_PHRASES; c++) (*loaded)->phrases[c].rows[0].volume = 1;
+  int result = finish(io, NULL);
+  memcpy(*loaded, expected, sizeof(Project));
+
+  const char* error = NULL;
+  if (result) {
+    error = "background save failed";
+  } else if (projectLoad(expected, savePath) || memcmp(*loaded, expected, sizeof(Project))) {
+    error = "background save differs";
+  }
+
+  // Same with a snapshot
+  ProjectSnapshot* snapshot = error ? NULL : projectSnapshotTake(*loaded, NULL);
+  if (!error && !snapshot) error = "can't take snapshot";
+  io = snapshot ? projectIOSaveSnapshot(snapshot, savePath) : NULL;
+  if (!error && !io) error = "can't start snapshot save";
+  if (!error && finish(io, NULL)) error = "background snapshot save failed";
+  if (!error && (projectLoad(expected, savePath) || memcmp(*loaded, expected, sizeof(Project)))) {
+    error = "background snapshot save differs";
+  }
+  fileDelete(savePath);
+  return error;
+}
+
+// Returns an error message or NULL
+static const char* testSetProject(Project* loaded) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return "can't create state";
+  chipnomadInitChips(state, 44100, NULL);
+  playbackStartSong(&state->playbackState, 0, 0, 0);
+
+  RenderThreadData data = {.state = state, .mutexId = mutexCreate(), .isStopped = 0};
+  int threadId = data.mutexId == -1 ? -1 : threadStart(renderRun, &data);
+
+  // Swapped in with the rendering paused, the way the tracker pauses audio
+  if (threadId != -1) {
+    threadSleep(5);
+    mutexLock(data.mutexId);
+  }
+  chipnomadSetProject(state, loaded);
+  if (threadId != -1) {
+    // Rendering goes on with the new chips
+    mutexUnlock(data.mutexId);
+    threadSleep(5);
+    atomicSet(&data.isStopped, 1);
+    threadJoin(threadId);
+  }
+  if (data.mutexId != -1) mutexDestroy(data.mutexId);
+
+  const char* error = NULL;
+  if (memcmp(&state->project, loaded, sizeof(Project))) {
+    error = "set project differs";
+  } else if (playbackIsPlaying(&state->playbackState)) {
+    error = "playback not stopped by the swap";
+  } else if (state->chips[state->project.chipsCount - 1].render == NULL) {
+    error = "chips not set up for the set project";
+  }
+  chipnomadDestroy(state);
+  return error;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* expected = calloc(1, sizeof(Project));
+  Project* loaded = NULL;
+  if (!expected) return 1;
+
+  const char* error = testLoadSave(path, expected, &loaded);
+  if (!error) error = testSetProject(loaded);
+  if (error) {
+    printf("FAIL %s: %s %s\n", path, error, projectFileError);
+  } else {
+    printf("OK   %s\n", path);
+  }
+
+  free(expected);
+  free(loaded);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
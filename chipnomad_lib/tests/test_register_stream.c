@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+
+// Register stream golden test: plays each project once through recording
+// sound chips and compares the per-frame register writes against golden
+// files. Reports the first diverging frame, track and register.
+//
+// Usage: test_register_stream [--update] [-g golden_dir] project.cnm ...
+//
+// Golden file format: one line per frame, "<hash> [<reg>=<value> ...]".
+// hash is FNV-1a over the frame's (chip, register, value) writes in order,
+// followed by register values that changed since the previous frame.
+// reg is chip * 0x100 + register number, everything is hex.
+
+#define MAX_FRAMES (20000)
+#define MAX_WRITES_PER_FRAME (256)
+#define REGS_PER_CHIP (16)
+#define MAX_REGS (PROJECT_MAX_CHIPS * REGS_PER_CHIP)
+
+typedef struct RegWrite {
+  uint8_t chip;
+  uint8_t reg;
+  uint8_t value;
+} RegWrite;
+
+typedef struct FrameRecord {
+  uint32_t hash;
+  uint8_t regs[MAX_REGS];
+} FrameRecord;
+
+static const char* goldenDir = "golden";
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Recording sound chip
+//
+
+static RegWrite frameWrites[MAX_WRITES_PER_FRAME];
+static int frameWritesCount;
+static int frameWritesOverflow;
+
+static int recChipInit(SoundChip* self) {
+  return 0;
+}
+
+static void recChipSetRegister(SoundChip* self, uint16_t reg, uint8_t value) {
+  self->regs[reg & 0xff] = value;
+  if (frameWritesCount == MAX_WRITES_PER_FRAME) {
+    frameWritesOverflow = 1;
+    return;
+  }
+  RegWrite* write = &frameWrites[frameWritesCount++];
+  write->chip = (uint8_t)(size_t)self->userdata;
+  write->reg = (uint8_t)reg;
+  write->value = value;
+}
+
+static void recChipRender(SoundChip* self, float* buffer, int samples) {
+  memset(buffer, 0, samples * 2 * sizeof(float));
+}
+
+static int recChipCleanup(SoundChip* self) {
+  return 0;
+}
+
+static SoundChip recChipFactory(int chipIndex, int sampleRate, ChipSetup setup) {
+  SoundChip chip = {
+    .userdata = (void*)(size_t)chipIndex,
+    .init = recChipInit,
+    .setRegister = recChipSetRegister,
+    .render = recChipRender,
+    .cleanup = recChipCleanup,
+  };
+
+  memset(chip.regs, 0, sizeof(chip.regs));
+  chip.regs[7] = 0x3f;
+
+  return chip;
+}
+
+static uint32_t hashWrites(const RegWrite* writes, int count) {
+  uint32_t hash = 2166136261u;
+  for (int c = 0; c < count; c++) {
+    hash = (hash ^ writes[c].chip) * 16777619u;
+    hash = (hash ^ writes[c].reg) * 16777619u;
+    hash = (hash ^ writes[c].value) * 16777619u;
+  }
+  return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Recording
+//
+
+// Returns number of recorded frames or -1 on error
+static int recordProject(const char* path, FrameRecord* frames) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return -1;
+
+  if (projectLoad(&state->project, path)) {
+    fprintf(stderr, "%s: can't load project: %s\n", path, projectFileError);
+    chipnomadDestroy(state);
+    return -1;
+  }
+
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, 44100, recChipFactory);
+  playbackStartSong(&state->playbackState, 0, 0, 0);
+
+  int framesCount = 0;
+  frameWritesOverflow = 0;
+  while (framesCount < MAX_FRAMES) {
+    frameWritesCount = 0;
+    int stopped = playbackNextFrame(&state->playbackState, state->chips);
+
+    FrameRecord* frame = &frames[framesCount++];
+    frame->hash = hashWrites(frameWrites, frameWritesCount);
+    for (int c = 0; c < state->project.chipsCount; c++) {
+      memcpy(&frame->regs[c * REGS_PER_CHIP], state->chips[c].regs, REGS_PER_CHIP);
+    }
+
+    if (stopped) break;
+  }
+
+  if (frameWritesOverflow) {
+    fprintf(stderr, "%s: more than %d register writes in a frame\n", path, MAX_WRITES_PER_FRAME);
+  }
+
+  chipnomadDestroy(state);
+  return framesCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Golden files
+//
+
+static void goldenPath(char* buffer, int size, const char* projectPath) {
+  const char* name = strrchr(projectPath, '/');
+  name = name ? name + 1 : projectPath;
+  int nameLength = (int)strlen(name);
+  const char* ext = strrchr(name, '.');
+  if (ext) nameLength = (int)(ext - name);
+  snprintf(buffer, size, "%s/%.*s.regs", goldenDir, nameLength, name);
+}
+
+static int saveGolden(const char* path, const FrameRecord* frames, int framesCount) {
+  FILE* file = fopen(path, "w");
+  if (!file) return 1;
+
+  uint8_t regs[MAX_REGS];
+  memset(regs, 0, sizeof(regs));
+
+  for (int f = 0; f < framesCount; f++) {
+    fprintf(file, "%08x", frames[f].hash);
+    for (int r = 0; r < MAX_REGS; r++) {
+      if (frames[f].regs[r] != regs[r]) {
+        fprintf(file, " %03x=%02x", (r / REGS_PER_CHIP) * 0x100 + r % REGS_PER_CHIP, frames[f].regs[r]);
+        regs[r] = frames[f].regs[r];
+      }
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  return 0;
+}
+
+// Returns number of frames or -1 on error
+static int loadGolden(const char* path, FrameRecord* frames) {
+  FILE* file = fopen(path, "r");
+  if (!file) return -1;
+
+  uint8_t regs[MAX_REGS];
+  memset(regs, 0, sizeof(regs));
+
+  char line[2048];
+  int framesCount = 0;
+  while (framesCount < MAX_FRAMES && fgets(line, sizeof(line), file)) {
+    char* ptr = line;
+    FrameRecord* frame = &frames[framesCount++];
+    frame->hash = (uint32_t)strtoul(ptr, &ptr, 16);
+
+    while (*ptr == ' ') {
+      unsigned int reg = (unsigned int)strtoul(ptr + 1, &ptr, 16);
+      if (*ptr != '=') break;
+      unsigned int value = (unsigned int)strtoul(ptr + 1, &ptr, 16);
+      int idx = (reg >> 8) * REGS_PER_CHIP + (reg & 0xff);
+      if (idx < MAX_REGS) regs[idx] = (uint8_t)value;
+    }
+    memcpy(frame->regs, regs, MAX_REGS);
+  }
+
+  fclose(file);
+  return framesCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Comparison
+//
+
+// Track that owns the AY register, or -1 for registers shared by all channels
+static int ayRegisterTrack(int chip, int reg) {
+  if (reg < 6) return chip * 3 + reg / 2;
+  if (reg >= 8 && reg <= 10) return chip * 3 + reg - 8;
+  return -1;
+}
+
+static int compareFrames(const char* name, const FrameRecord* expected, int expectedCount,
+  const FrameRecord* actual, int actualCount) {
+  int mismatches = 0;
+  int firstMismatch = -1;
+  int count = expectedCount < actualCount ? expectedCount : actualCount;
+
+  for (int f = 0; f < count; f++) {
+    if (expected[f].hash == actual[f].hash && !memcmp(expected[f].regs, actual[f].regs, MAX_REGS)) continue;
+    if (firstMismatch < 0) firstMismatch = f;
+    mismatches++;
+  }
+
+  if (firstMismatch >= 0) {
+    const FrameRecord* exp = &expected[firstMismatch];
+    const FrameRecord* act = &actual[firstMismatch];
+    printf("FAIL %s: %d of %d frames differ, first at frame %d\n", name, mismatches, count, firstMismatch);
+
+    int regMismatch = 0;
+    for (int r = 0; r < MAX_REGS; r++) {
+      if (exp->regs[r] == act->regs[r]) continue;
+      int chip = r / REGS_PER_CHIP;
+      int reg = r % REGS_PER_CHIP;
+      int track = ayRegisterTrack(chip, reg);
+      if (track >= 0) {
+        printf("  chip %d, track %d, register %d: expected %02X, got %02X\n", chip, track, reg, exp->regs[r], act->regs[r]);
+      } else {
+        printf("  chip %d, shared register %d: expected %02X, got %02X\n", chip, reg, exp->regs[r], act->regs[r]);
+      }
+      regMismatch = 1;
+    }
+    if (!regMismatch) {
+      printf("  registers match at the end of the frame, write sequence differs (hash %08x, expected %08x)\n",
+        act->hash, exp->hash);
+    }
+  }
+
+  if (expectedCount != actualCount) {
+    printf("FAIL %s: song length %d frames, expected %d\n", name, actualCount, expectedCount);
+    mismatches++;
+  }
+
+  if (!mismatches) printf("OK   %s: %d frames\n", name, count);
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+  int update = 0;
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "--update")) {
+      update = 1;
+    } else if (!strcmp(argv[c], "-g") && c + 1 < argc) {
+      goldenDir = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [--update] [-g golden_dir] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  FrameRecord* actual = malloc(MAX_FRAMES * sizeof(FrameRecord));
+  FrameRecord* expected = malloc(MAX_FRAMES * sizeof(FrameRecord));
+  if (!actual || !expected) return 1;
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    char path[1024];
+    goldenPath(path, sizeof(path), files[c]);
+
+    int actualCount = recordProject(files[c], actual);
+    if (actualCount < 0) {
+      failed++;
+      continue;
+    }
+
+    if (update) {
+      if (saveGolden(path, actual, actualCount)) {
+        fprintf(stderr, "Can't write %s\n", path);
+        failed++;
+      } else {
+        printf("Updated %s: %d frames\n", path, actualCount);
+      }
+      continue;
+    }
+
+    int expectedCount = loadGolden(path, expected);
+    if (expectedCount < 0) {
+      printf("FAIL %s: no golden file %s, run with --update\n", files[c], path);
+      failed++;
+      continue;
+    }
+
+    failed += compareFrames(files[c], expected, expectedCount, actual, actualCount);
+  }
+
+  free(expected);
+  free(actual);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+
+// Register stream replay test: captures each project once, then replays the
+// capture at several sample rates at the same time, one thread per rate, and
+// checks that every replay renders exactly the same audio as the project.
+// The project's register dump is also exported, decoded and replayed at the
+// first sample rate.
+//
+// Usage: test_replay [-o scratch.cnr] project.cnm ...
+
+#define BLOCK_SAMPLES (4096)
+
+static const int sampleRates[] = {44100, 48000, 96000};
+#define SAMPLE_RATES_COUNT (int)(sizeof(sampleRates) / sizeof(sampleRates[0]))
+
+static const char* dumpPath = "test_replay.cnr";
+
+typedef struct RenderResult {
+  uint32_t hash;
+  int samples;
+} RenderResult;
+
+typedef struct ReplayJob {
+  const RegisterStream* stream;
+  int sampleRate;
+  RenderResult result;
+} ReplayJob;
+
+// FNV-1a over rendered samples until playback stops. Returns 1 on failure
+static int renderHash(ChipNomadState* state, RenderResult* result) {
+  float* buffer = malloc(BLOCK_SAMPLES * 2 * sizeof(float));
+  if (!buffer) return 1;
+
+  chipnomadSetQuality(state, CHIPNOMAD_QUALITY_BEST);
+  result->hash = 2166136261u;
+  result->samples = 0;
+
+  int rendered;
+  do {
+    rendered = chipnomadRender(state, buffer, BLOCK_SAMPLES);
+    const uint8_t* bytes = (const uint8_t*)buffer;
+    for (int c = 0; c < rendered * 2 * (int)sizeof(float); c++) {
+      result->hash = (result->hash ^ bytes[c]) * 16777619u;
+    }
+    result->samples += rendered;
+  } while (rendered == BLOCK_SAMPLES);
+
+  free(buffer);
+  return 0;
+}
+
+static int renderProject(Project* project, int sampleRate, RenderResult* result) {
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return 1;
+
+  state->project = *project;
+  playbackInit(&state->playbackState, &state->project);
+  chipnomadInitChips(state, sampleRate, NULL);
+  playbackStartSong(&state->playbackState, 0, 0, 0);
+
+  int failed = renderHash(state, result);
+  chipnomadDestroy(state);
+  return failed;
+}
+
+static int replayWorker(void* arg) {
+  ReplayJob* job = arg;
+  job->result.samples = -1;
+
+  ChipNomadState* state = chipnomadCreate();
+  if (!state) return 1;
+
+  chipnomadStartReplay(state, job->stream, job->sampleRate, NULL, 0xffffffff);
+  if (renderHash(state, &job->result)) job->result.samples = -1;
+  chipnomadDestroy(state);
+  return 0;
+}
+
+// Export the project's register dump and decode it. Returns NULL on failure
+static RegisterStream* dumpProject(Project* project) {
+  Exporter* exporter = createRegisterDumpExporter(dumpPath, project, 0);
+  if (!exporter) return NULL;
+
+  while (exporter->next(exporter) != -1);
+  if (exporter->finish(exporter)) return NULL;
+
+  RegisterStream* stream = registerDumpLoad(dumpPath);
+  fileDelete(dumpPath);
+  return stream;
+}
+
+// Returns 1 if any replay differs
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  if (projectLoad(project, path)) {
+    printf("FAIL %s: can't load project: %s\n", path, projectFileError);
+    free(project);
+    return 1;
+  }
+
+  RegisterStream* stream = registerStreamCapture(project, 0, 0);
+  if (!stream) {
+    printf("FAIL %s: capture failed\n", path);
+    free(project);
+    return 1;
+  }
+
+  RegisterStream* dumpStream = dumpProject(project);
+  if (!dumpStream) {
+    printf("FAIL %s: register dump export or decoding failed\n", path);
+    registerStreamFree(stream);
+    free(project);
+    return 1;
+  }
+
+  // One job per sample rate, and the decoded dump at the first rate
+  RenderResult expected[SAMPLE_RATES_COUNT];
+  ReplayJob jobs[SAMPLE_RATES_COUNT + 1];
+  int threadIds[SAMPLE_RATES_COUNT + 1];
+  for (int c = 0; c <= SAMPLE_RATES_COUNT; c++) {
+    if (c < SAMPLE_RATES_COUNT && renderProject(project, sampleRates[c], &expected[c])) expected[c].samples = -1;
+    jobs[c].stream = c < SAMPLE_RATES_COUNT ? stream : dumpStream;
+    jobs[c].sampleRate = sampleRates[c % SAMPLE_RATES_COUNT];
+    threadIds[c] = threadStart(replayWorker, &jobs[c]);
+    if (threadIds[c] == -1) replayWorker(&jobs[c]);
+  }
+
+  int failed = 0;
+  for (int c = 0; c <= SAMPLE_RATES_COUNT; c++) {
+    if (threadIds[c] != -1) threadJoin(threadIds[c]);
+
+    const char* source = c < SAMPLE_RATES_COUNT ? "replay" : "register dump";
+    RenderResult* reference = &expected[c % SAMPLE_RATES_COUNT];
+    RenderResult* actual = &jobs[c].result;
+    if (reference->samples < 0 || actual->samples < 0) {
+      printf("FAIL %s: can't render at %d Hz\n", path, jobs[c].sampleRate);
+      failed = 1;
+    } else if (actual->samples != reference->samples || actual->hash != reference->hash) {
+      printf("FAIL %s: %s at %d Hz differs (%d samples, expected %d)\n", path, source, jobs[c].sampleRate,
+        actual->samples, reference->samples);
+      failed = 1;
+    }
+  }
+
+  if (!failed) {
+    printf("OK   %s: %d frames, %d register writes\n", path, stream->framesCount, stream->writesCount);
+  }
+
+  registerStreamFree(dumpStream);
+  registerStreamFree(stream);
+  free(project);
+  return failed;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      dumpPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-o scratch.cnr] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  // Shared tables are filled once before threads start
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+
+// Free slot map test: scans each project and checks that every chain the song
+// plays, every phrase a chain plays and every instrument's table is in use.
+// Slots handed out must be empty and unreferenced, freeing one must clear it
+// and make it the next one handed out, and a full map must say so.
+//
+// Usage: test_slots project.cnm ...
+
+// Returns an error message or NULL
+static const char* checkScan(Project* p, ProjectSlots* slots) {
+  for (int c = 0; c < PROJECT_MAX_LENGTH; c++) {
+    for (int t = 0; t < p->tracksCount; t++) {
+      int chain = p->song[c][t];
+      if (chain == EMPTY_VALUE_16) continue;
+      if (!slots->isChainUsed[chain]) return "song chain not in use";
+      for (int r = 0; r < 16; r++) {
+        int phrase = p->chains[chain].rows[r].phrase;
+        if (phrase != EMPTY_VALUE_16 && !slots->isPhraseUsed[phrase]) return "chain phrase not in use";
+      }
+    }
+  }
+  for (int c = 0; c < PROJECT_MAX_INSTRUMENTS; c++) {
+    if (!instrumentIsEmpty(p, c) && !slots->isTableUsed[c]) return "instrument table not in use";
+  }
+  return NULL;
+}
+
+// Returns an error message or NULL
+static const char* checkAlloc(Project* p, ProjectSlots* slots) {
+  int used = slots->phrasesUsed;
+  int phrase = projectSlotsTakePhrase(slots, 0);
+  if (phrase == EMPTY_VALUE_16) return "no free phrase";
+  if (!phraseIsEmpty(p, phrase)) return "allocated phrase isn't empty";
+  if (slots->phrasesUsed != used + 1) return "phrase count not updated";
+  for (int c = 0; c < PROJECT_MAX_CHAINS; c++) {
+    for (int r = 0; r < 16; r++) {
+      if (p->chains[c].rows[r].phrase == phrase) return "allocated phrase is referenced";
+    }
+  }
+
+  p->phrases[phrase].rows[0].note = 12;
+  int other = projectSlotsTakePhrase(slots, 0);
+  if (other == phrase) return "phrase allocated twice";
+  projectSlotsFreePhrase(slots, p, phrase);
+  if (!phraseIsEmpty(p, phrase)) return "freed phrase isn't cleared";
+  if (projectSlotsTakePhrase(slots, 0) != phrase) return "freed phrase not reused";
+  projectSlotsFreePhrase(slots, p, phrase);
+  projectSlotsFreePhrase(slots, p, other);
+  if (slots->phrasesUsed != used) return "phrase count not restored";
+
+  int chain = projectSlotsTakeChain(slots, 0);
+  if (chain == EMPTY_VALUE_16) return "no free chain";
+  if (!chainIsEmpty(p, chain)) return "allocated chain isn't empty";
+  int table = projectSlotsTakeTable(slots, PROJECT_MAX_INSTRUMENTS);
+  if (table != EMPTY_VALUE_16 && (table < PROJECT_MAX_INSTRUMENTS || !tableIsEmpty(p, table))) {
+    return "unexpected table allocated";
+  }
+
+  while (projectSlotsTakeChain(slots, 0) != EMPTY_VALUE_16);
+  if (slots->chainsUsed != PROJECT_MAX_CHAINS) return "full map count differs";
+  return NULL;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  ProjectSlots* slots = malloc(sizeof(ProjectSlots));
+  if (!project || !slots) return 1;
+
+  const char* error = NULL;
+  int used[3] = {0, 0, 0};
+  if (projectLoad(project, path)) {
+    error = "can't load project";
+  } else {
+    projectSlotsScan(slots, project);
+    used[0] = slots->chainsUsed;
+    used[1] = slots->phrasesUsed;
+    used[2] = slots->tablesUsed;
+    error = checkScan(project, slots);
+    if (!error) error = checkAlloc(project, slots);
+  }
+
+  if (error) {
+    printf("FAIL %s: %s %s\n", path, error, projectFileError);
+  } else {
+    printf("OK   %s (%d chains, %d phrases, %d tables in use)\n", path,
+      used[0], used[1], used[2]);
+  }
+
+  free(project);
+  free(slots);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 1; c < argc; c++) {
+    failed += testProject(argv[c]);
+  }
+  return failed ? 1 : 0;
+}
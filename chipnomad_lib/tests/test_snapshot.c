@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_thread.h"
+
+// Project snapshot test: takes a snapshot of each project, edits a phrase and
+// an instrument and takes another one based on the first. Only the edited
+// pages may be copied, both snapshots must restore their own project, also
+// after the other one is freed, and a chain of snapshots freed on another
+// thread must leave the rest intact.
+//
+// Usage: test_snapshot project.cnm ...
+
+#define CHAIN_LENGTH (16)
+
+typedef struct {
+  ProjectSnapshot** snapshots;
+  int count;
+} FreeThreadData;
+
+static int freeRun(void* arg) {
+  FreeThreadData* data = arg;
+  for (int c = 0; c < data->count; c++) projectSnapshotFree(data->snapshots[c]);
+  return 0;
+}
+
+// Number of pages the byte range is in
+static int pagesTouched(const void* field, int size, const Project* p) {
+  long offset = (const uint8_t*)field - (const uint8_t*)p;
+  return (offset + size - 1) / PROJECT_SNAPSHOT_PAGE_SIZE - offset / PROJECT_SNAPSHOT_PAGE_SIZE + 1;
+}
+
+// Returns an error message or NULL
+static const char* testSnapshots(Project* project, Project* original, Project* restored) {
+  memcpy(original, project, sizeof(Project));
+  ProjectSnapshot* first = projectSnapshotTake(project, NULL);
+  if (!first) return "out of memory";
+
+  project->phrases[5].rows[3].volume = (project->phrases[5].rows[3].volume + 1) & 15;
+  project->instruments[7].name[0] ^= 1;
+  int expectedPages = pagesTouched(&project->phrases[5].rows[3].volume, 1, project) +
+    pagesTouched(&project->instruments[7].name[0], 1, project);
+
+  ProjectSnapshot* second = projectSnapshotTake(project, first);
+  if (!second) {
+    projectSnapshotFree(first);
+    return "out of memory";
+  }
+
+  const char* error = NULL;
+  ProjectSnapshot* pair[2] = {first, second};
+  ProjectSnapshotStats stats;
+  projectSnapshotGetStats(pair, 2, &stats);
+  if (first->pagesCopied != PROJECT_SNAPSHOT_PAGES_COUNT || second->pagesCopied != expectedPages) {
+    error = "unexpected number of pages copied";
+  } else if (stats.pagesAllocated != PROJECT_SNAPSHOT_PAGES_COUNT + expectedPages) {
+    error = "unexpected stats";
+  }
+
+  projectSnapshotRestore(first, restored);
+  if (!error && memcmp(restored, original, sizeof(Project))) error = "first snapshot differs";
+  projectSnapshotFree(first);
+  projectSnapshotRestore(second, restored);
+  if (!error && memcmp(restored, project, sizeof(Project))) error = "second snapshot differs after freeing the first";
+
+  // Every snapshot is based on the one before, the older ones go away on another thread
+  ProjectSnapshot* chain[CHAIN_LENGTH];
+  chain[0] = second;
+  for (int c = 1; c < CHAIN_LENGTH && !error; c++) {
+    project->phrases[c].rows[c].note = c;
+    chain[c] = projectSnapshotTake(project, chain[c - 1]);
+    if (!chain[c]) {
+      projectSnapshotFree(chain[0]);
+      for (int d = 1; d < c; d++) projectSnapshotFree(chain[d]);
+      return "out of memory";
+    }
+  }
+  if (!error) {
+    FreeThreadData data = {.snapshots = chain, .count = CHAIN_LENGTH - 1};
+    int threadId = threadStart(freeRun, &data);
+    if (threadId == -1) {
+      freeRun(&data);
+    } else {
+      threadJoin(threadId);
+    }
+    projectSnapshotRestore(chain[CHAIN_LENGTH - 1], restored);
+    if (memcmp(restored, project, sizeof(Project))) error = "last snapshot differs after freeing the chain";
+    projectSnapshotFree(chain[CHAIN_LENGTH - 1]);
+  } else {
+    projectSnapshotFree(second);
+  }
+  return error;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  Project* original = malloc(sizeof(Project));
+  Project* restored = malloc(sizeof(Project));
+  if (!project || !original || !restored) return 1;
+
+  const char* error = projectLoad(project, path) ? "can't load project" : testSnapshots(project, original, restored);
+  if (error) {
+    printf("FAIL %s: %s %s\n", path, error, projectFileError);
+  } else {
+    printf("OK   %s\n", path);
+  }
+
+  free(project);
+  free(original);
+  free(restored);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 1; c < argc; c++) {
+    failed += testProject(argv[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chipnomad_lib.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+
+// VGM export test: exports each project as is and with a second chip playing
+// the same song, parses the file and checks the header, the waits and that
+// the chip registers match a captured register stream on every frame.
+//
+// Usage: test_vgm [-o scratch.vgm] project.cnm ...
+
+#define VGM_REGS (14)
+#define VGM_SAMPLE_RATE (44100)
+
+static const char* vgmPath = "test_vgm.vgm";
+
+typedef struct VGMFile {
+  uint8_t* data;
+  long size;
+  uint32_t totalSamples;
+  uint32_t loopOffset; // Absolute, 0 if the song doesn't loop
+  uint32_t loopSamples;
+  uint32_t dataOffset;
+} VGMFile;
+
+// Compared with the capture frame by frame
+typedef struct VGMCheck {
+  const RegisterStream* stream;
+  int chipsCount;
+  int frame; // Next frame to compare
+  uint8_t expected[PROJECT_MAX_CHIPS][VGM_REGS];
+  uint8_t actual[PROJECT_MAX_CHIPS][VGM_REGS];
+  int actualTriggers; // Bit per chip that wrote the envelope shape in the frame
+} VGMCheck;
+
+static uint32_t framePosition(float tickRate, int frame) {
+  return (uint32_t)((double)frame * VGM_SAMPLE_RATE / tickRate + 0.5);
+}
+
+static int loadFile(const char* path, VGMFile* vgm) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return 1;
+  fseek(file, 0, SEEK_END);
+  vgm->size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  vgm->data = malloc(vgm->size > 0 ? vgm->size : 1);
+  int failed = !vgm->data || fread(vgm->data, 1, vgm->size, file) != (size_t)vgm->size;
+  fclose(file);
+  return failed;
+}
+
+// Returns an error message or NULL
+static const char* checkHeader(VGMFile* vgm, Project* project, int chipsCount) {
+  if (vgm->size < 0x80 || memcmp(vgm->data, "Vgm ", 4)) return "not a VGM file";
+  if (readLE32(vgm->data + 0x04) + 4 != (uint32_t)vgm->size) return "wrong EOF offset";
+  if (readLE32(vgm->data + 0x08) != 0x151) return "wrong version";
+
+  vgm->totalSamples = readLE32(vgm->data + 0x18);
+  vgm->loopOffset = readLE32(vgm->data + 0x1c);
+  if (vgm->loopOffset) vgm->loopOffset += 0x1c;
+  vgm->loopSamples = readLE32(vgm->data + 0x20);
+  vgm->dataOffset = readLE32(vgm->data + 0x34) + 0x34;
+  if (vgm->dataOffset < 0x80 || vgm->dataOffset >= vgm->size) return "wrong data offset";
+  if (vgm->loopOffset && (vgm->loopOffset < vgm->dataOffset || vgm->loopOffset >= vgm->size)) return "wrong loop offset";
+
+  uint32_t clock = (uint32_t)project->chipSetup.ay.clock | (chipsCount > 1 ? 0x40000000 : 0);
+  if (readLE32(vgm->data + 0x74) != clock) return "wrong AY clock";
+  if (vgm->data[0x78] != (project->chipSetup.ay.isYM ? 0x10 : 0x00)) return "wrong AY type";
+  return NULL;
+}
+
+// Compare registers after the frame with the capture. Returns 1 if they differ
+static int checkFrame(VGMCheck* check) {
+  const RegisterStream* stream = check->stream;
+  if (check->frame >= stream->framesCount) return 1;
+
+  int expectedTriggers = 0;
+  for (int c = stream->frameStarts[check->frame]; c < stream->frameStarts[check->frame + 1]; c++) {
+    RegisterWrite* write = &stream->writes[c];
+    if (write->reg >= VGM_REGS) continue;
+    check->expected[write->chip][write->reg] = write->value;
+    if (write->reg == 13) expectedTriggers |= 1 << write->chip;
+  }
+
+  int failed = expectedTriggers != check->actualTriggers ||
+    memcmp(check->expected, check->actual, sizeof(check->expected));
+  if (failed) printf("     frame %d: registers differ from the capture\n", check->frame);
+
+  check->actualTriggers = 0;
+  check->frame++;
+  return failed;
+}
+
+// Walk the commands and compare each frame. Returns an error message or NULL
+static const char* checkCommands(VGMFile* vgm, VGMCheck* check, float tickRate, int* loopFrame) {
+  uint32_t pos = vgm->dataOffset;
+  uint32_t samples = 0;
+  int isEnd = 0;
+  *loopFrame = -1;
+
+  while (!isEnd) {
+    if (pos >= vgm->size) return "no end command";
+    if (pos == vgm->loopOffset) {
+      if (samples != framePosition(tickRate, check->frame)) return "loop isn't at a frame start";
+      if (vgm->loopSamples != vgm->totalSamples - samples) return "wrong loop length";
+      *loopFrame = check->frame;
+    }
+
+    uint8_t command = vgm->data[pos];
+    if (command == 0xa0) {
+      if (pos + 3 > vgm->size) return "truncated AY write";
+      int chip = vgm->data[pos + 1] >> 7;
+      int reg = vgm->data[pos + 1] & 0x7f;
+      if (chip >= check->chipsCount || reg >= VGM_REGS) return "write to a wrong chip or register";
+      if (samples != framePosition(tickRate, check->frame)) return "write between frames";
+      check->actual[chip][reg] = vgm->data[pos + 2];
+      if (reg == 13) check->actualTriggers |= 1 << chip;
+      pos += 3;
+      continue;
+    }
+
+    uint32_t wait = 0;
+    if (command == 0x61) {
+      if (pos + 3 > vgm->size) return "truncated wait";
+      wait = vgm->data[pos + 1] | (vgm->data[pos + 2] << 8);
+      pos += 3;
+    } else if (command == 0x62) {
+      wait = 735;
+      pos++;
+    } else if (command == 0x63) {
+      wait = 882;
+      pos++;
+    } else if (command >= 0x70 && command <= 0x7f) {
+      wait = command - 0x70 + 1;
+      pos++;
+    } else if (command == 0x66) {
+      isEnd = 1;
+      pos++;
+    } else {
+      return "unexpected command";
+    }
+
+    // Frames that end during the wait or at the end of the song are complete
+    samples += wait;
+    while (framePosition(tickRate, check->frame + 1) <= samples || (isEnd && framePosition(tickRate, check->frame) < samples)) {
+      if (checkFrame(check)) return "registers differ";
+    }
+  }
+
+  if (samples != vgm->totalSamples) return "waits don't add up to the total samples";
+  if (vgm->loopOffset && *loopFrame < 0) return "loop offset isn't at a command";
+  return NULL;
+}
+
+// Returns 1 on failure
+static int testExport(const char* path, Project* project, const char* variant) {
+  RegisterStream* stream = registerStreamCapture(project, 0, 0);
+  if (!stream) {
+    printf("FAIL %s (%s): capture failed\n", path, variant);
+    return 1;
+  }
+
+  Exporter* exporter = createVGMExporter(vgmPath, project, 0);
+  int exported = exporter != NULL;
+  if (exporter) {
+    while (exporter->next(exporter) != -1);
+    exported = !exporter->finish(exporter);
+  }
+
+  VGMFile vgm;
+  memset(&vgm, 0, sizeof(vgm));
+  const char* error = NULL;
+  if (!exported) {
+    error = "export failed";
+  } else if (loadFile(vgmPath, &vgm)) {
+    error = "can't read the export";
+  }
+  fileDelete(vgmPath);
+
+  VGMCheck check;
+  memset(&check, 0, sizeof(check));
+  check.stream = stream;
+  check.chipsCount = project->chipsCount;
+  int loopFrame = -1;
+
+  if (!error) error = checkHeader(&vgm, project, project->chipsCount);
+  if (!error) error = checkCommands(&vgm, &check, project->tickRate, &loopFrame);
+  // A looping song leaves out the frame where it stops
+  if (!error && check.frame != stream->framesCount - (loopFrame >= 0 ? 1 : 0)) error = "wrong number of frames";
+
+  if (error) {
+    printf("FAIL %s (%s): %s\n", path, variant, error);
+  } else if (loopFrame >= 0) {
+    printf("OK   %s (%s): %d frames, %ld bytes, loops at frame %d\n", path, variant, check.frame, vgm.size, loopFrame);
+  } else {
+    printf("OK   %s (%s): %d frames, %ld bytes\n", path, variant, check.frame, vgm.size);
+  }
+
+  free(vgm.data);
+  registerStreamFree(stream);
+  return error != NULL;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  if (projectLoad(project, path)) {
+    printf("FAIL %s: can't load project: %s\n", path, projectFileError);
+    free(project);
+    return 1;
+  }
+
+  int failed = testExport(path, project, "1 chip");
+
+  // Second chip plays the first chip's tracks
+  if (project->chipsCount == 1) {
+    int chipTracks = project->tracksCount;
+    project->chipsCount = 2;
+    project->tracksCount = projectGetTotalTracks(project);
+    for (int row = 0; row < PROJECT_MAX_LENGTH; row++) {
+      for (int c = 0; c < chipTracks; c++) {
+        project->song[row][chipTracks + c] = project->song[row][c];
+      }
+    }
+    failed |= testExport(path, project, "2 chips");
+  }
+
+  free(project);
+  return failed;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      vgmPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  if (filesCount == 0) {
+    fprintf(stderr, "Usage: %s [-o scratch.vgm] project.cnm ...\n", argv[0]);
+    return 1;
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "chipnomad_lib.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+
+// Parallel WAV export test: exports each project as float32 with the serial
+// exporter and with the parallel one on several thread counts, and checks that
+// the files have the same length and the samples match within a tolerance.
+// Segments start from fast-forwarded chips and a short pre-roll, so they can
+// differ from the serial render by a little filter state.
+//
+// Usage: test_wav_parallel [-o scratch] project.cnm ...
+
+#define EXPORT_RATE (44100)
+#define SAMPLE_TOLERANCE (1e-3f)
+
+static const char* scratchPath = "test_wav_parallel";
+
+static const int threadCounts[] = { 2, 4 };
+
+// Returns an error message or NULL
+static const char* exportFile(Project* project, const char* path, int threadsCount) {
+  Exporter* exporter = threadsCount ?
+    createWAVExporterParallel(path, project, 0, EXPORT_RATE, 32, threadsCount) :
+    createWAVExporter(path, project, 0, EXPORT_RATE, 32);
+  if (!exporter) return "can't create the exporter";
+
+  while (exporter->next(exporter) != -1);
+  if (exporter->finish(exporter)) return "export failed";
+  return NULL;
+}
+
+// Float32 samples of the data chunk, NULL on failure
+static float* readSamples(const char* path, uint32_t* count) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return NULL;
+
+  uint8_t header[44];
+  float* samples = NULL;
+  if (fread(header, 1, sizeof(header), file) == sizeof(header) && header[34] == 32) {
+    uint32_t dataSize = header[40] | (header[41] << 8) | (header[42] << 16) | ((uint32_t)header[43] << 24);
+    *count = dataSize / sizeof(float);
+    samples = malloc(dataSize ? dataSize : 1);
+    if (samples && fread(samples, 1, dataSize, file) != dataSize) {
+      free(samples);
+      samples = NULL;
+    }
+  }
+  fclose(file);
+  return samples;
+}
+
+// Returns 1 on failure
+static int testProject(const char* path) {
+  Project* project = malloc(sizeof(Project));
+  if (!project) return 1;
+  if (projectLoad(project, path)) {
+    printf("FAIL %s: can't load project: %s\n", path, projectFileError);
+    free(project);
+    return 1;
+  }
+
+  char serialPath[1024];
+  char parallelPath[1024];
+  snprintf(serialPath, sizeof(serialPath), "%s-serial.wav", scratchPath);
+  snprintf(parallelPath, sizeof(parallelPath), "%s-parallel.wav", scratchPath);
+
+  uint32_t serialCount = 0;
+  float* serial = NULL;
+  const char* error = exportFile(project, serialPath, 0);
+  if (!error && !(serial = readSamples(serialPath, &serialCount))) error = "can't read the serial export";
+
+  float maxDiff = 0;
+  for (int t = 0; !error && t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++) {
+    uint32_t count;
+    float* parallel = NULL;
+    error = exportFile(project, parallelPath, threadCounts[t]);
+    if (!error && !(parallel = readSamples(parallelPath, &count))) error = "can't read the parallel export";
+    if (!error && count != serialCount) error = "parallel export length differs";
+    for (uint32_t c = 0; !error && c < count; c++) {
+      float diff = fabsf(parallel[c] - serial[c]);
+      if (!(diff <= SAMPLE_TOLERANCE)) error = "parallel samples differ";
+      if (diff > maxDiff) maxDiff = diff;
+    }
+    free(parallel);
+  }
+  free(serial);
+  fileDelete(serialPath);
+  fileDelete(parallelPath);
+
+  if (error) {
+    printf("FAIL %s: %s (max difference %g)\n", path, error, maxDiff);
+  } else {
+    printf("OK   %s: %u samples, max difference %g\n", path, serialCount, maxDiff);
+  }
+
+  free(project);
+  return error != NULL;
+}
+
+int main(int argc, char* argv[]) {
+  int filesCount = 0;
+  const char* files[256];
+
+  for (int c = 1; c < argc; c++) {
+    if (!strcmp(argv[c], "-o") && c + 1 < argc) {
+      scratchPath = argv[++c];
+    } else if (filesCount < 256) {
+      files[filesCount++] = argv[c];
+    }
+  }
+
+  fillFXNames();
+
+  int failed = 0;
+  for (int c = 0; c < filesCount; c++) {
+    failed += testProject(files[c]);
+  }
+  return failed ? 1 : 0;
+}
@@ -65,3 +65,23 @@ float centsToFrequency(int cents) {
   float semitones = (cents - 6900) / 100.0f;
   return 440.0f * powf(2.0f, semitones / 12.0f);
 }
+
+void writeLE16(uint8_t* data, uint16_t value) {
+  data[0] = value & 0xff;
+  data[1] = value >> 8;
+}
+
+void writeLE32(uint8_t* data, uint32_t value) {
+  data[0] = value & 0xff;
+  data[1] = (value >> 8) & 0xff;
+  data[2] = (value >> 16) & 0xff;
+  data[3] = value >> 24;
+}
+
+uint16_t readLE16(const uint8_t* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32_t readLE32(const uint8_t* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
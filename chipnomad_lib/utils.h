@@ -12,4 +12,10 @@ int max(int a, int b);
 // Convert cents value to frequency in Hz (with safeguards)
 float centsToFrequency(int cents);
 
+// Little-endian integers in byte buffers, as file formats store them
+void writeLE16(uint8_t* data, uint16_t value);
+void writeLE32(uint8_t* data, uint32_t value);
+uint16_t readLE16(const uint8_t* data);
+uint32_t readLE32(const uint8_t* data);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glob.h>
+#include "chipnomad_lib.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+#include "render_jobs.h"
+
+#define MAX_INPUTS (4096)
+
+static const char* qualityNames[] = {"low", "medium", "high", "best"};
+
+static void usage(const char* name) {
+  fprintf(stderr,
+    "Usage: %s [options] project.cnm|glob ...\n"
+    "\n"
+    "  -f FORMATS   Comma-separated list of wav, raw, stems, psg, vgm, cnr (default: wav)\n"
+    "  -o DIR       Output directory (default: next to each project),\n"
+    "               - streams a single wav or raw job to stdout\n"
+    "  -r RATE      Sample rate (default: 44100)\n"
+    "  -b BITS      Bit depth: 16, 24 or 32 (default: 16)\n"
+    "  -s ROW       Start song row, hex (default: 00)\n"
+    "  -q QUALITY   low, medium, high or best (default: best)\n"
+    "  -v VOLUME    Mix volume, 0.0 to 1.0 (default: 0.6)\n"
+    "  -n LUFS      Normalize wav output to the loudness, true peak at most -1 dBTP (default: off)\n"
+    "  -j THREADS   Worker threads (default: number of CPU cores)\n",
+    name);
+}
+
+// Returns 0 on success
+static int parseFormats(const char* list, int* formats) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%s", list);
+  memset(formats, 0, renderFormatsCount * sizeof(int));
+
+  for (char* token = strtok(buffer, ","); token; token = strtok(NULL, ",")) {
+    if (!strcmp(token, "wav")) {
+      formats[renderWAV] = 1;
+    } else if (!strcmp(token, "raw")) {
+      formats[renderRaw] = 1;
+    } else if (!strcmp(token, "stems")) {
+      formats[renderStems] = 1;
+    } else if (!strcmp(token, "psg")) {
+      formats[renderPSG] = 1;
+    } else if (!strcmp(token, "vgm")) {
+      formats[renderVGM] = 1;
+    } else if (!strcmp(token, "cnr")) {
+      formats[renderDump] = 1;
+    } else {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Returns -1 if the name is unknown
+static int parseQuality(const char* name) {
+  for (int c = 0; c < 4; c++) {
+    if (!strcmp(name, qualityNames[c])) return CHIPNOMAD_QUALITY_LOW + c;
+  }
+  return -1;
+}
+
+// Adds the path or all files matching the glob. Returns number of files added
+static int addInputs(const char* pattern, char** inputs, int* inputsCount) {
+  if (!strpbrk(pattern, "*?[")) {
+    if (*inputsCount == MAX_INPUTS) return 0;
+    inputs[(*inputsCount)++] = strdup(pattern);
+    return 1;
+  }
+
+  glob_t matches;
+  if (glob(pattern, 0, NULL, &matches) != 0) return 0;
+
+  int added = 0;
+  for (size_t c = 0; c < matches.gl_pathc && *inputsCount < MAX_INPUTS; c++) {
+    inputs[(*inputsCount)++] = strdup(matches.gl_pathv[c]);
+    added++;
+  }
+  globfree(&matches);
+  return added;
+}
+
+// Reports go to stderr when audio is streamed to stdout
+static FILE* report;
+
+static void printJob(RenderJob* job) {
+  const char* name = strrchr(job->inputPath, '/');
+  name = name ? name + 1 : job->inputPath;
+
+  if (job->result) {
+    fprintf(report, "FAIL %-28s %-5s %s\n", name, renderFormatName(job->format), job->error);
+  } else {
+    double realtime = job->renderMs > 0 ? job->audioSeconds * 1000.0 / job->renderMs : 0;
+    fprintf(report, "OK   %-28s %-5s %7.1fs %8dms %7.1fx  %s\n", name, renderFormatName(job->format),
+      job->audioSeconds, job->renderMs, realtime, job->outputPath);
+  }
+  fflush(report);
+}
+
+int main(int argc, char* argv[]) {
+  RenderOptions options = {
+    .outputDir = NULL,
+    .sampleRate = 44100,
+    .bitDepth = 16,
+    .startRow = 0,
+    .quality = CHIPNOMAD_QUALITY_BEST,
+    .mixVolume = 0.6f,
+    .normalizeLUFS = 0,
+    .threadsCount = 0,
+  };
+  int formats[renderFormatsCount] = {1};
+
+  char** inputs = malloc(MAX_INPUTS * sizeof(char*));
+  int inputsCount = 0;
+  if (!inputs) return 1;
+
+  for (int c = 1; c < argc; c++) {
+    const char* arg = argv[c];
+    const char* value = c + 1 < argc ? argv[c + 1] : NULL;
+
+    if (arg[0] != '-') {
+      if (!addInputs(arg, inputs, &inputsCount)) fprintf(stderr, "No files match %s\n", arg);
+      continue;
+    }
+    if (!value || arg[2] != 0) {
+      usage(argv[0]);
+      return 1;
+    }
+    c++;
+
+    switch (arg[1]) {
+      case 'f':
+        if (parseFormats(value, formats)) {
+          fprintf(stderr, "Unknown format in %s\n", value);
+          return 1;
+        }
+        break;
+      case 'o':
+        options.outputDir = value;
+        break;
+      case 'r':
+        options.sampleRate = atoi(value);
+        if (options.sampleRate < 8000) options.sampleRate = 8000;
+        break;
+      case 'b':
+        options.bitDepth = atoi(value);
+        if (options.bitDepth != 16 && options.bitDepth != 24 && options.bitDepth != 32) {
+          fprintf(stderr, "Bit depth must be 16, 24 or 32\n");
+          return 1;
+        }
+        break;
+      case 's':
+        options.startRow = (int)strtol(value, NULL, 16);
+        if (options.startRow < 0 || options.startRow >= PROJECT_MAX_LENGTH) options.startRow = 0;
+        break;
+      case 'q': {
+        int quality = parseQuality(value);
+        if (quality < 0) {
+          fprintf(stderr, "Unknown quality %s\n", value);
+          return 1;
+        }
+        options.quality = quality;
+        break;
+      }
+      case 'v':
+        options.mixVolume = (float)atof(value);
+        break;
+      case 'n':
+        options.normalizeLUFS = (float)atof(value);
+        if (options.normalizeLUFS >= 0 || options.normalizeLUFS < -70) {
+          fprintf(stderr, "Loudness must be between -70 and 0 LUFS\n");
+          return 1;
+        }
+        break;
+      case 'j':
+        options.threadsCount = atoi(value);
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (inputsCount == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (options.threadsCount <= 0) options.threadsCount = threadCPUCount();
+
+  options.toStdout = options.outputDir && !strcmp(options.outputDir, "-");
+  report = options.toStdout ? stderr : stdout;
+
+  if (!options.toStdout && options.outputDir && !fileDirectoryExists(options.outputDir) && fileCreateDirectory(options.outputDir)) {
+    fprintf(stderr, "Can't create output directory %s\n", options.outputDir);
+    return 1;
+  }
+
+  // One job per input and format
+  RenderJob* jobs = calloc(inputsCount * renderFormatsCount, sizeof(RenderJob));
+  if (!jobs) return 1;
+  int jobsCount = 0;
+  for (int c = 0; c < inputsCount; c++) {
+    for (int f = 0; f < renderFormatsCount; f++) {
+      if (!formats[f]) continue;
+      jobs[jobsCount].inputPath = inputs[c];
+      jobs[jobsCount].format = (RenderFormat)f;
+      jobsCount++;
+    }
+  }
+
+  if (options.toStdout && (jobsCount != 1 || (jobs[0].format != renderWAV && jobs[0].format != renderRaw))) {
+    fprintf(stderr, "Streaming to stdout needs a single project and the wav or raw format\n");
+    return 1;
+  }
+
+  // Shared tables are filled once before workers start
+  fillFXNames();
+
+  int startTicks = threadTicks();
+  int failed = renderJobs(jobs, jobsCount, &options, printJob);
+  int totalMs = threadTicks() - startTicks;
+
+  double audioSeconds = 0;
+  for (int c = 0; c < jobsCount; c++) {
+    audioSeconds += jobs[c].audioSeconds;
+  }
+
+  fprintf(report, "%d files, %d jobs, %d failed. %.1fs of audio in %.2fs on %d threads (%.1fx realtime)\n",
+    inputsCount, jobsCount, failed, audioSeconds, totalMs / 1000.0, options.threadsCount,
+    totalMs > 0 ? audioSeconds * 1000.0 / totalMs : 0);
+
+  for (int c = 0; c < inputsCount; c++) {
+    free(inputs[c]);
+  }
+  free(inputs);
+  free(jobs);
+  return failed ? 1 : 0;
+}
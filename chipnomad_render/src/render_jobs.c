@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render_jobs.h"
+#include "export/export.h"
+#include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
+
+#define RENDER_TRUE_PEAK_LIMIT (-1.0f)
+
+typedef struct RenderPool {
+  RenderJob* jobs;
+  int jobsCount;
+  const RenderOptions* options;
+  RenderJobDone onDone;
+  int nextJob; // Accessed atomically
+  int failedCount;
+  int openFiles;
+  int filesMutex; // Guards openFiles
+  int loadMutex; // Project loading and exporter setup aren't thread-safe
+  int doneMutex;
+} RenderPool;
+
+const char* renderFormatName(RenderFormat format) {
+  switch (format) {
+    case renderWAV: return "wav";
+    case renderRaw: return "raw";
+    case renderStems: return "stems";
+    case renderPSG: return "psg";
+    case renderDump: return "cnr";
+    case renderVGM: return "vgm";
+    case renderFormatsCount: break;
+  }
+  return "?";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Open files budget. The file layer has a fixed number of file slots, so
+// jobs wait until there are enough free slots for all their output files.
+//
+
+static void reserveFiles(RenderPool* pool, int count) {
+  while (1) {
+    mutexLock(pool->filesMutex);
+    if (pool->openFiles + count <= CORELIB_MAX_OPEN_FILES) {
+      pool->openFiles += count;
+      mutexUnlock(pool->filesMutex);
+      return;
+    }
+    mutexUnlock(pool->filesMutex);
+    threadSleep(5);
+  }
+}
+
+static void releaseFiles(RenderPool* pool, int count) {
+  mutexLock(pool->filesMutex);
+  pool->openFiles -= count;
+  mutexUnlock(pool->filesMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Jobs
+//
+
+// Output files opened through the file layer
+static int outputFilesCount(RenderFormat format, Project* project, const RenderOptions* options) {
+  if (options->toStdout) return 0;
+  switch (format) {
+    case renderWAV: return options->normalizeLUFS != 0 ? 2 : 1; // Temporary float file when normalizing
+    case renderRaw: return 0; // Written with stdio directly
+
+    case renderStems: return projectGetTotalTracks(project);
+    case renderPSG: return project->chipsCount;
+    case renderDump: return 1;
+    case renderVGM: return 1;
+    case renderFormatsCount: break;
+  }
+  return 1;
+}
+
+// Output path without extension: output directory (or the input's one) and input file name
+static void outputBasePath(char* buffer, int size, const char* inputPath, const char* outputDir) {
+  const char* name = strrchr(inputPath, PATH_SEPARATOR);
+  name = name ? name + 1 : inputPath;
+  int nameLength = (int)strlen(name);
+  const char* ext = strrchr(name, '.');
+  if (ext) nameLength = (int)(ext - name);
+
+  if (outputDir) {
+    snprintf(buffer, size, "%s%s%.*s", outputDir, PATH_SEPARATOR_STR, nameLength, name);
+  } else {
+    snprintf(buffer, size, "%.*s%.*s", (int)(name - inputPath), inputPath, nameLength, name);
+  }
+}
+
+// stream is set to the file opened for raw output, it has to be closed after the export
+static Exporter* createExporter(RenderJob* job, Project* project, const RenderOptions* options, FILE** stream) {
+  *stream = NULL;
+
+  if (options->toStdout) {
+    snprintf(job->outputPath, sizeof(job->outputPath), "stdout");
+    return createPCMStreamExporter(stdout, project, options->startRow, options->sampleRate, options->bitDepth,
+      job->format == renderRaw ? pcmStreamRaw : pcmStreamWAV);
+  }
+
+  char basePath[1000];
+  outputBasePath(basePath, sizeof(basePath), job->inputPath, options->outputDir);
+
+  Exporter* exporter = NULL;
+  switch (job->format) {
+    case renderWAV:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s.wav", basePath);
+      exporter = createWAVExporter(job->outputPath, project, options->startRow, options->sampleRate, options->bitDepth);
+      if (exporter && options->normalizeLUFS != 0 && wavExporterSetNormalization(exporter, options->normalizeLUFS, RENDER_TRUE_PEAK_LIMIT)) {
+        exporter->cancel(exporter);
+        exporter = NULL;
+      }
+      break;
+    case renderRaw:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s.raw", basePath);
+      *stream = fopen(job->outputPath, "wb");
+      if (!*stream) return NULL;
+      exporter = createPCMStreamExporter(*stream, project, options->startRow, options->sampleRate, options->bitDepth, pcmStreamRaw);
+      if (!exporter) {
+        fclose(*stream);
+        *stream = NULL;
+      }
+      break;
+    case renderStems:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s-NN.wav", basePath);
+      exporter = createWAVStemsExporter(basePath, project, options->startRow, options->sampleRate, options->bitDepth, 0);
+      break;
+    case renderPSG:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s.psg", basePath);
+      exporter = createPSGExporter(job->outputPath, project, options->startRow);
+      break;
+    case renderDump:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s.cnr", basePath);
+      exporter = createRegisterDumpExporter(job->outputPath, project, options->startRow);
+      break;
+    case renderVGM:
+      snprintf(job->outputPath, sizeof(job->outputPath), "%s.vgm", basePath);
+      exporter = createVGMExporter(job->outputPath, project, options->startRow);
+      break;
+    case renderFormatsCount:
+      break;
+  }
+
+  // Register formats don't render audio
+  if (exporter && job->format != renderPSG && job->format != renderDump && job->format != renderVGM) {
+    exporter->chipnomadState->mixVolume = options->mixVolume;
+    chipnomadSetQuality(exporter->chipnomadState, options->quality);
+  }
+  return exporter;
+}
+
+static void renderJob(RenderPool* pool, RenderJob* job) {
+  const RenderOptions* options = pool->options;
+  job->result = 1;
+
+  Project* project = malloc(sizeof(Project));
+  if (!project) {
+    snprintf(job->error, sizeof(job->error), "Out of memory");
+    return;
+  }
+
+  reserveFiles(pool, 1);
+  mutexLock(pool->loadMutex);
+  int loadResult = projectLoad(project, job->inputPath);
+  if (loadResult) snprintf(job->error, sizeof(job->error), "Can't load: %s", projectFileError);
+  mutexUnlock(pool->loadMutex);
+  releaseFiles(pool, 1);
+
+  if (loadResult) {
+    free(project);
+    return;
+  }
+
+  int filesCount = outputFilesCount(job->format, project, options);
+  reserveFiles(pool, filesCount);
+
+  int startTicks = threadTicks();
+  FILE* stream;
+  mutexLock(pool->loadMutex);
+  Exporter* exporter = createExporter(job, project, options, &stream);
+  mutexUnlock(pool->loadMutex);
+
+  if (!exporter) {
+    snprintf(job->error, sizeof(job->error), "Can't create output files");
+  } else {
+    while (exporter->next(exporter) != -1);
+    job->audioSeconds = exporter->chipnomadState->framesCount / project->tickRate;
+    job->result = exporter->finish(exporter);
+    if (stream && fclose(stream) != 0) job->result = 1;
+    if (job->result) snprintf(job->error, sizeof(job->error), "Write failed");
+  }
+  job->renderMs = threadTicks() - startTicks;
+
+  releaseFiles(pool, filesCount);
+  free(project);
+}
+
+static int renderWorker(void* arg) {
+  RenderPool* pool = arg;
+
+  while (1) {
+    int jobIdx = atomicAdd(&pool->nextJob, 1) - 1;
+    if (jobIdx >= pool->jobsCount) break;
+
+    RenderJob* job = &pool->jobs[jobIdx];
+    renderJob(pool, job);
+
+    mutexLock(pool->doneMutex);
+    if (job->result) pool->failedCount++;
+    if (pool->onDone) pool->onDone(job);
+    mutexUnlock(pool->doneMutex);
+  }
+  return 0;
+}
+
+int renderJobs(RenderJob* jobs, int jobsCount, const RenderOptions* options, RenderJobDone onDone) {
+  RenderPool pool = {
+    .jobs = jobs,
+    .jobsCount = jobsCount,
+    .options = options,
+    .onDone = onDone,
+  };
+
+  pool.filesMutex = mutexCreate();
+  pool.loadMutex = mutexCreate();
+  pool.doneMutex = mutexCreate();
+  if (pool.filesMutex == -1 || pool.loadMutex == -1 || pool.doneMutex == -1) return jobsCount;
+
+  int threadsCount = options->threadsCount;
+  if (threadsCount > jobsCount) threadsCount = jobsCount;
+  if (threadsCount > CORELIB_MAX_THREADS) threadsCount = CORELIB_MAX_THREADS;
+
+  int threadIds[CORELIB_MAX_THREADS];
+  int startedCount = 0;
+  for (int i = 0; i < threadsCount; i++) {
+    threadIds[startedCount] = threadStart(renderWorker, &pool);
+    if (threadIds[startedCount] != -1) startedCount++;
+  }
+
+  // Nothing started, render on this thread
+  if (startedCount == 0) renderWorker(&pool);
+
+  for (int i = 0; i < startedCount; i++) {
+    threadJoin(threadIds[i]);
+  }
+
+  mutexDestroy(pool.filesMutex);
+  mutexDestroy(pool.loadMutex);
+  mutexDestroy(pool.doneMutex);
+  return pool.failedCount;
+}
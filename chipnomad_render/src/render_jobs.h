@@ -0,0 +1,47 @@
+#ifndef __RENDER_JOBS_H__
+#define __RENDER_JOBS_H__
+
+#include "chipnomad_lib.h"
+
+typedef enum RenderFormat {
+  renderWAV,
+  renderRaw, // Headerless PCM
+  renderStems,
+  renderPSG,
+  renderDump, // Compact register dump (.cnr)
+  renderVGM,
+  renderFormatsCount,
+} RenderFormat;
+
+typedef struct RenderOptions {
+  const char* outputDir; // NULL to write next to the input file
+  int toStdout; // Stream the only WAV or raw job to stdout
+  int sampleRate;
+  int bitDepth;
+  int startRow;
+  chipnomad_quality_t quality;
+  float mixVolume;
+  float normalizeLUFS; // Target loudness of WAV files, 0 to leave them as rendered
+  int threadsCount;
+} RenderOptions;
+
+typedef struct RenderJob {
+  const char* inputPath;
+  RenderFormat format;
+  // Filled in when the job is done
+  char outputPath[1024];
+  int result; // 0 on success
+  char error[64];
+  double audioSeconds;
+  int renderMs;
+} RenderJob;
+
+typedef void (*RenderJobDone)(RenderJob* job);
+
+const char* renderFormatName(RenderFormat format);
+
+// Renders all jobs on options->threadsCount worker threads. onDone is called
+// for every job as it finishes, one call at a time. Returns number of failed jobs
+int renderJobs(RenderJob* jobs, int jobsCount, const RenderOptions* options, RenderJobDone onDone);
+
+#endif
@@ -0,0 +1,96 @@
+#include <SDL2/SDL.h>
+#include "corelib/corelib_thread.h"
+
+typedef struct {
+  SDL_Thread* thread;
+  ThreadFunction function;
+  void* data;
+  int isUsed;
+} ThreadSlot;
+
+typedef struct {
+  SDL_mutex* mutex;
+  int isUsed;
+} MutexSlot;
+
+static ThreadSlot threads[CORELIB_MAX_THREADS];
+static MutexSlot mutexes[CORELIB_MAX_MUTEXES];
+
+static int threadEntry(void* arg) {
+  ThreadSlot* slot = arg;
+  return slot->function(slot->data);
+}
+
+int threadStart(ThreadFunction function, void* data) {
+  for (int c = 0; c < CORELIB_MAX_THREADS; c++) {
+    if (!__sync_bool_compare_and_swap(&threads[c].isUsed, 0, 1)) continue;
+
+    threads[c].function = function;
+    threads[c].data = data;
+    threads[c].thread = SDL_CreateThread(threadEntry, "chipnomad", &threads[c]);
+    if (!threads[c].thread) {
+      atomicSet(&threads[c].isUsed, 0);
+      return -1;
+    }
+    return c;
+  }
+  return -1;
+}
+
+int threadJoin(int threadId) {
+  int result = 0;
+  SDL_WaitThread(threads[threadId].thread, &result);
+  atomicSet(&threads[threadId].isUsed, 0);
+  return result;
+}
+
+int threadCPUCount(void) {
+  return SDL_GetCPUCount();
+}
+
+void threadSleep(int ms) {
+  SDL_Delay(ms);
+}
+
+int threadTicks(void) {
+  return (int)SDL_GetTicks();
+}
+
+int mutexCreate(void) {
+  for (int c = 0; c < CORELIB_MAX_MUTEXES; c++) {
+    if (!__sync_bool_compare_and_swap(&mutexes[c].isUsed, 0, 1)) continue;
+
+    mutexes[c].mutex = SDL_CreateMutex();
+    if (!mutexes[c].mutex) {
+      atomicSet(&mutexes[c].isUsed, 0);
+      return -1;
+    }
+    return c;
+  }
+  return -1;
+}
+
+void mutexLock(int mutexId) {
+  SDL_LockMutex(mutexes[mutexId].mutex);
+}
+
+void mutexUnlock(int mutexId) {
+  SDL_UnlockMutex(mutexes[mutexId].mutex);
+}
+
+void mutexDestroy(int mutexId) {
+  SDL_DestroyMutex(mutexes[mutexId].mutex);
+  atomicSet(&mutexes[mutexId].isUsed, 0);
+}
+
+int atomicGet(int* value) {
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+void atomicSet(int* value, int newValue) {
+  __atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+}
+
+int atomicAdd(int* value, int delta) {
+  return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+}
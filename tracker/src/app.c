@@ -1,3 +1,5 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "corelib_gfx.h"
 #include "corelib_font.h"
@@ -5,6 +7,7 @@
 #include "audio_manager.h"
 #include "app.h"
 #include "screens.h"
+#include "file_browser.h"
 #include "chipnomad_lib.h"
 #include "project_utils.h"
 #include "waveform_display.h"
@@ -26,6 +29,28 @@ static int tapCount;
 /** Frame counter for key repeats */
 static int keyRepeatCount;
 
+// Autosave vars:
+
+/** Frames between autosave journal syncs (one second at 60 FPS) */
+#define AUTOSAVE_SYNC_FRAMES (60)
+/** Edit journal of the auto-saved project */
+static ProjectJournal autosaveJournal;
+/** Whether the journal could be opened */
+static int isAutosaveJournalOpen;
+/** Frame counter for journal syncs */
+static int autosaveTimer;
+
+// Project I/O vars:
+
+/** Load or save running on the I/O worker */
+static ProjectIO* projectIO;
+/** Whether the running job is a save */
+static int isProjectIOSave;
+/** Path of the project being loaded or saved */
+static char projectIOPath[PATH_LENGTH + 1];
+/** Called when the load or save has finished */
+static ProjectIOCallback* projectIOCallback;
+
 /**
 * @brief Handle play/stop key commands
 *
@@ -109,6 +134,9 @@ static void appInput(int isKeyDown, int keys, int tapCount) {
     }
   }
 
+  // The project can't be edited until the load has finished. Saves write a copy
+  if (projectIO && !isProjectIOSave) return;
+
   // Stop phrase row and preview
   if (chipnomadState->playbackState.tracks[*pSongTrack].mode == playbackModePhraseRow && keys == 0) {
     playbackStop(&chipnomadState->playbackState);
@@ -122,6 +150,103 @@ static void appInput(int isKeyDown, int keys, int tapCount) {
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Background project loads and saves
+//
+
+/**
+* @brief Report the finished load or save to its caller
+*
+* @param result 0 on success
+*/
+static void projectIODone(int result) {
+  ProjectIOCallback* callback = projectIOCallback;
+  projectIOCallback = NULL;
+  if (callback) callback(projectIOPath, result);
+}
+
+/**
+* @brief Check the background load or save, called every frame
+*
+* @param isForced wait for the load or save to finish instead of checking it
+*/
+static void updateProjectIO(int isForced) {
+  if (projectIO) {
+    if (!isForced && !projectIOIsDone(projectIO)) {
+      screenMessage(MESSAGE_TIME, "%s project... %ds", isProjectIOSave ? "Saving" : "Loading",
+        projectIOElapsed(projectIO) / 1000);
+      return;
+    }
+
+    Project* loaded = NULL;
+    int result = projectIOFinish(projectIO, &loaded);
+    projectIO = NULL;
+    if (loaded) {
+      // Chips are freed and set up again, which can't happen during an audio callback
+      audioManager.pause();
+      chipnomadSetProject(chipnomadState, loaded);
+      chipnomadSetQuality(chipnomadState, appSettings.quality);
+      audioManager.resume();
+      free(loaded);
+    }
+    projectIODone(result);
+  }
+}
+
+/**
+* @brief Start loading a project in the background. The current project is replaced when it's loaded
+*
+* @param path Project file
+* @param onDone Called when the project is loaded or failed to load
+*/
+void appLoadProject(const char* path, ProjectIOCallback* onDone) {
+  updateProjectIO(1);
+
+  snprintf(projectIOPath, sizeof(projectIOPath), "%s", path);
+  projectIOCallback = onDone;
+  isProjectIOSave = 0;
+  projectIO = projectIOLoad(path);
+  if (!projectIO) projectIODone(1);
+}
+
+/**
+* @brief Start saving the current project in the background. Edits made from now on aren't saved
+*
+* @param path Project file
+* @param onDone Called when the project is saved or failed to save
+*/
+void appSaveProject(const char* path, ProjectIOCallback* onDone) {
+  updateProjectIO(1);
+
+  snprintf(projectIOPath, sizeof(projectIOPath), "%s", path);
+  projectIOCallback = onDone;
+  isProjectIOSave = 1;
+  ProjectSnapshot* snapshot = isAutosaveJournalOpen ? appSnapshotProject() : NULL;
+  projectIO = snapshot ? projectIOSaveSnapshot(snapshot, path) : projectIOSave(&chipnomadState->project, path);
+  if (!projectIO) projectIODone(1);
+}
+
+/**
+* @brief Snapshot of the current project for background work. Based on the autosave journal's snapshot
+* when it's open, so only pages edited since the last sync take new memory
+*
+* @return ProjectSnapshot* NULL if out of memory
+*/
+ProjectSnapshot* appSnapshotProject(void) {
+  return projectSnapshotTake(&chipnomadState->project, isAutosaveJournalOpen ? autosaveJournal.shadow : NULL);
+}
+
+/**
+* @brief Check for a running background load or save
+*
+* @return int 1 until the project is loaded or saved
+*/
+int appIsProjectIOBusy(void) {
+  return projectIO != NULL;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // High-level application functions
@@ -159,12 +284,16 @@ void appSetup(void) {
     return;
   }
 
-  // Try to load an auto-saved project
-  if (projectLoad(&chipnomadState->project, getAutosavePath())) {
+  // Try to load an auto-saved project with the edits journaled since it was saved
+  if (projectJournalLoad(&chipnomadState->project, getAutosavePath())) {
     // Failed to load autosave, initialize empty project
     projectInitAY(&chipnomadState->project);
   }
 
+  // Start a new autosave journal
+  isAutosaveJournalOpen = !projectJournalOpen(&autosaveJournal, &chipnomadState->project, getAutosavePath());
+  autosaveTimer = AUTOSAVE_SYNC_FRAMES;
+
   // Initialize all screen states
   screensInitAll();
 
@@ -186,11 +315,32 @@ void appSetup(void) {
 * @brief Release all resources before closing the application
 */
 void appCleanup(void) {
+  updateProjectIO(1);
+  fileBrowserCleanup();
   audioManager.stop();
+  if (isAutosaveJournalOpen) {
+    projectJournalClose(&autosaveJournal);
+    isAutosaveJournalOpen = 0;
+  }
   chipnomadDestroy(chipnomadState);
   chipnomadState = NULL;
 }
 
+/**
+* @brief Append project edits made since the last call to the autosave journal
+*/
+void appAutosave(void) {
+  // The project is swapped or written on another thread meanwhile
+  if (!chipnomadState || appIsProjectIOBusy()) return;
+
+  if (isAutosaveJournalOpen) {
+    projectJournalSync(&autosaveJournal, &chipnomadState->project);
+  } else {
+    projectSave(&chipnomadState->project, getAutosavePath());
+  }
+  autosaveTimer = AUTOSAVE_SYNC_FRAMES;
+}
+
 /**
 * @brief Main draw function. Draws playback status
 */
@@ -314,6 +464,10 @@ void appOnEvent(enum MainLoopEvent event, int value, void* userdata) {
     }
     break;
   case eventTick:
+    updateProjectIO(0);
+    if (isAutosaveJournalOpen && --autosaveTimer <= 0) {
+      appAutosave();
+    }
     if (tapTimerCount > 0) {
       tapTimerCount--;
       if (tapTimerCount == 0) {
@@ -337,8 +491,13 @@ void appOnEvent(enum MainLoopEvent event, int value, void* userdata) {
     }
     break;
   case eventExit:
-    // Auto-save the current project on exit
-    projectSave(&chipnomadState->project, getAutosavePath());
+    // Auto-save the current project on exit and start with an empty journal next time
+    updateProjectIO(1);
+    if (isAutosaveJournalOpen) {
+      projectJournalCompact(&autosaveJournal, &chipnomadState->project);
+    } else {
+      projectSave(&chipnomadState->project, getAutosavePath());
+    }
     // Save settings on exit
     settingsSave();
     break;
@@ -6,6 +6,14 @@
 void appSetup(void);
 void appCleanup(void);
 void appDraw(void);
+void appAutosave(void);
+
+/** Called when a project load or save has finished, result is 0 on success */
+typedef void ProjectIOCallback(const char* path, int result);
+void appLoadProject(const char* path, ProjectIOCallback* onDone);
+void appSaveProject(const char* path, ProjectIOCallback* onDone);
+int appIsProjectIOBusy(void);
+ProjectSnapshot* appSnapshotProject(void);
 void appOnEvent(enum MainLoopEvent event, int value, void* userdata);
 
 #endif
\ No newline at end of file
@@ -119,8 +119,8 @@ int settingsSave(void) {
   filePrintf(fileId, "fontPath: %s\n", appSettings.fontPath);
   filePrintf(fileId, "fontFolderPath: %s\n", appSettings.fontFolderPath);
 
-  fileClose(fileId);
-  return 0;
+  // Writes are buffered, a failed one shows when the file is closed
+  return fileClose(fileId) ? 1 : 0;
 }
 
 int settingsLoad(void) {
@@ -252,8 +252,7 @@ int saveTheme(const char* path) {
   filePrintf(fileId, "colorSelection: 0x%06x\n", appSettings.colorScheme.selection);
   filePrintf(fileId, "colorWarning: 0x%06x\n", appSettings.colorScheme.warning);
 
-  fileClose(fileId);
-  return 0;
+  return fileClose(fileId) ? 1 : 0;
 }
 
 int loadTheme(const char* path) {
@@ -437,6 +437,10 @@ int cloneInstrument(int srcIdx, int dstIdx) {
 int deepCloneChain(int chainIdx) {
   if (chainIdx >= PROJECT_MAX_CHAINS) return 0;
 
+  // Slots taken for earlier clones stay taken even if the clone is empty
+  ProjectSlots slots;
+  projectSlotsScan(&slots, &chipnomadState->project);
+
   // Find all distinct phrases used in the chain
   uint16_t usedPhrases[16];
   uint16_t phraseMapping[16];
@@ -460,7 +464,7 @@ int deepCloneChain(int chainIdx) {
 
     if (found == -1) {
       // New phrase, find empty slot
-      int newPhraseIdx = findEmptyPhrase(&chipnomadState->project, 0);
+      int newPhraseIdx = projectSlotsTakePhrase(&slots, 0);
       if (newPhraseIdx == EMPTY_VALUE_16) return 0;
 
       // Clone the phrase
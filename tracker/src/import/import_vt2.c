@@ -191,6 +191,27 @@ static void setEnvelopePeriodCommands(PhraseRow* phraseRow, int* fxSlot, uint16_
 
 static int getOrCreateGroove(Project* project, uint8_t speed);
 
+// Returns an earlier phrase with the same contents, giving this one back to
+// the slot map, or keeps the phrase and returns it
+static int sharePhrase(ProjectSlots* slots, Project* project, int phraseIdx,
+                       uint32_t* hashes, int* kept, int* keptCount) {
+  const uint8_t* data = (const uint8_t*)&project->phrases[phraseIdx];
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(Phrase); i++) hash = (hash ^ data[i]) * 16777619u;
+
+  for (int i = 0; i < *keptCount; i++) {
+    int other = kept[i];
+    if (hashes[other] == hash && !memcmp(&project->phrases[other], data, sizeof(Phrase))) {
+      projectSlotsFreePhrase(slots, project, phraseIdx);
+      return other;
+    }
+  }
+
+  hashes[phraseIdx] = hash;
+  kept[(*keptCount)++] = phraseIdx;
+  return phraseIdx;
+}
+
 static void getPhraseIndicesForPattern(int phraseNum, const int* phraseIndices, int* phraseA, int* phraseB, int* phraseC) {
   int baseIdx = phraseNum * VT2_CHANNELS;
   *phraseA = phraseIndices[baseIdx + 0];
@@ -1047,7 +1068,13 @@ int projectLoadVT2(const char* path) {
   int patternToPhrases[VT2_MAX_PATTERNS][3][16];
   int patternPhraseCounts[VT2_MAX_PATTERNS];
   
-  int phraseIdx = 0;
+  // Phrases and chains come from the slot map, so the slots instruments and tables
+  // already took stay theirs and identical ones can be given back
+  ProjectSlots slots;
+  projectSlotsScan(&slots, project);
+  uint32_t phraseHashes[PROJECT_MAX_PHRASES];
+  int keptPhrases[PROJECT_MAX_PHRASES];
+  int keptPhrasesCount = 0;
   
   uint8_t globalCurrentInstrument[VT2_CHANNELS] = {0, 0, 0};
   uint8_t globalCurrentOrnament[VT2_CHANNELS] = {0, 0, 0};
@@ -1076,8 +1103,9 @@ int projectLoadVT2(const char* path) {
     int phrasesAllocated = 0;
     
     for (int i = 0; i < phrasesNeeded * 3; i++) {
-      if (phraseIdx >= PROJECT_MAX_PHRASES) break;
-      phraseIndices[i] = phraseIdx++;
+      int phraseIdx = projectSlotsTakePhrase(&slots, 0);
+      if (phraseIdx == EMPTY_VALUE_16) break;
+      phraseIndices[i] = phraseIdx;
       phrasesAllocated++;
     }
     
@@ -1087,7 +1115,7 @@ int projectLoadVT2(const char* path) {
     }
     
     int isFirstPattern = (patIdx == firstPatternInPlayOrder);
-    int phrasesUsed = convertPatternToPhrases(pattern, project, phraseIndices, phrasesAllocated,
+    int phrasesUsed = convertPatternToPhrases(pattern, project, phraseIndices, phrasesAllocated / 3,
                                                ornamentBaseIdx, &cloneMap,
                                                globalCurrentInstrument, globalCurrentOrnament,
                                                globalCurrentVolume,
@@ -1096,6 +1124,14 @@ int projectLoadVT2(const char* path) {
     
     patternPhraseCounts[patIdx] = phrasesUsed;
     
+    for (int i = 0; i < phrasesAllocated; i++) {
+      if (i >= phrasesUsed * 3) {
+        projectSlotsFreePhrase(&slots, project, phraseIndices[i]);
+      } else {
+        phraseIndices[i] = sharePhrase(&slots, project, phraseIndices[i], phraseHashes, keptPhrases, &keptPhrasesCount);
+      }
+    }
+    
     for (int ch = 0; ch < 3; ch++) {
       for (int ph = 0; ph < phrasesUsed && ph < 16; ph++) {
         patternToPhrases[patIdx][ch][ph] = phraseIndices[ph * 3 + ch];
@@ -1103,7 +1139,9 @@ int projectLoadVT2(const char* path) {
     }
   }
   
-  int chainIdx = 0;
+  // A pattern repeated in the play order plays the same chains again
+  int patternChains[VT2_MAX_PATTERNS][3];
+  for (int p = 0; p < VT2_MAX_PATTERNS; p++) patternChains[p][0] = -1;
 
   for (int i = 0; i < module.playOrderLength && i < PROJECT_MAX_LENGTH; i++) {
     int patNum = module.playOrder[i];
@@ -1111,19 +1149,18 @@ int projectLoadVT2(const char* path) {
     if (patNum >= 0 && patNum < module.patternCount && patternPhraseCounts[patNum] > 0) {
       int phrasesNeeded = patternPhraseCounts[patNum];
       
-      if (chainIdx + 3 > PROJECT_MAX_CHAINS) break;
-      
-      int chainA = chainIdx++;
-      int chainB = chainIdx++;
-      int chainC = chainIdx++;
-      
-      createMultiPhraseChain(project, chainA, patternToPhrases[patNum][0], phrasesNeeded);
-      createMultiPhraseChain(project, chainB, patternToPhrases[patNum][1], phrasesNeeded);
-      createMultiPhraseChain(project, chainC, patternToPhrases[patNum][2], phrasesNeeded);
+      if (patternChains[patNum][0] == -1) {
+        if (slots.chainsUsed + 3 > PROJECT_MAX_CHAINS) break;
+        
+        for (int ch = 0; ch < 3; ch++) {
+          patternChains[patNum][ch] = projectSlotsTakeChain(&slots, 0);
+          createMultiPhraseChain(project, patternChains[patNum][ch], patternToPhrases[patNum][ch], phrasesNeeded);
+        }
+      }
       
-      project->song[i][0] = chainA;
-      project->song[i][1] = chainB;
-      project->song[i][2] = chainC;
+      project->song[i][0] = patternChains[patNum][0];
+      project->song[i][1] = patternChains[patNum][1];
+      project->song[i][2] = patternChains[patNum][2];
       
     }
   }
@@ -110,8 +110,8 @@ int pitchTableSaveCSV(Project* project, const char* folderPath, const char* file
     filePrintf(fileId, "%s,%d\n", project->pitchTable.noteNames[i], project->pitchTable.values[i]);
   }
 
-  fileClose(fileId);
-  return 0;
+  // Writes are buffered, a failed one shows when the file is closed
+  return fileClose(fileId) ? 1 : 0;
 }
 
 // Create 12TET scale
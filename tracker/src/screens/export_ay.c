@@ -7,8 +7,9 @@
 #include <string.h>
 
 static int getColumnCount(int row) {
-  // The first 3 rows come from the common export screen fields
+  // The first rows come from the common export screen fields
   if (row < SCR_EXPORT_ROWS) return exportCommonColumnCount(row);
+  if (row == SCR_EXPORT_ROWS) return 2; // PSG, register dump
 
   return 1; // Default
 }
@@ -16,13 +17,20 @@ static int getColumnCount(int row) {
 static void drawStatic(void) {
   exportCommonDrawStatic();
   gfxSetFgColor(appSettings.colorScheme.textValue);
-  gfxPrint(0, 8, "PSG");
+  gfxPrint(0, 9, "PSG");
+  gfxPrint(0, 10, "VGM");
 }
 
 static void drawCursor(int col, int row) {
   if (row < SCR_EXPORT_ROWS) return exportCommonDrawCursor(col, row);
   if (row == SCR_EXPORT_ROWS) {
-    gfxCursor(13, 8, 6);
+    if (col == 0) {
+      gfxCursor(13, 9, 6);
+    } else {
+      gfxCursor(20, 9, 4);
+    }
+  } else if (row == SCR_EXPORT_ROWS + 1) {
+    gfxCursor(13, 10, 6);
   }
 }
 
@@ -32,16 +40,41 @@ static void drawField(int col, int row, int state) {
   gfxSetFgColor(state == stateFocus ? appSettings.colorScheme.textValue : appSettings.colorScheme.textDefault);
 
   if (row == SCR_EXPORT_ROWS) {
-    gfxPrint(13, 8, "Export");
+    if (col == 0) {
+      gfxPrint(13, 9, "Export");
+    } else {
+      gfxPrint(20, 9, "Dump");
+    }
+  } else if (row == SCR_EXPORT_ROWS + 1) {
+    gfxPrint(13, 10, "Export");
   }
 }
 
+// Exporter factories, called on the export thread
+
+static Exporter* createPSGExport(Project* project, void* arg) {
+  ExportSetup* setup = arg;
+  Exporter* exporter = createPSGExporter(setup->path, project, setup->startRow);
+  if (exporter) exporter->chipnomadState->mixVolume = setup->mixVolume;
+  return exporter;
+}
+
+static Exporter* createDumpExport(Project* project, void* arg) {
+  ExportSetup* setup = arg;
+  return createRegisterDumpExporter(setup->path, project, setup->startRow);
+}
+
+static Exporter* createVGMExport(Project* project, void* arg) {
+  ExportSetup* setup = arg;
+  return createVGMExporter(setup->path, project, setup->startRow);
+}
+
 static int onEdit(int col, int row, enum CellEditAction action) {
   if (row < SCR_EXPORT_ROWS) return exportCommonOnEdit(col, row, action);
 
   int handled = 0;
 
-  if (row == SCR_EXPORT_ROWS) {
+  if (row == SCR_EXPORT_ROWS && col == 0) {
     // PSG Export
     if (currentExporter) return 1; // Already exporting
 
@@ -49,10 +82,8 @@ static int onEdit(int col, int row, enum CellEditAction action) {
     generatePSGExportPath(exportPath, sizeof(exportPath));
     strcat(exportPath, ".psg");
 
-    currentExporter = createPSGExporter(exportPath, &chipnomadState->project, startRow);
+    currentExporter = exportStart(createPSGExport, exportPath);
     if (currentExporter) {
-      // Set mix volume from app settings
-      currentExporter->chipnomadState->mixVolume = appSettings.mixVolume;
       if (chipnomadState->project.chipsCount > 1) {
         screenMessage(MESSAGE_TIME, "Starting export (%d files)...", chipnomadState->project.chipsCount);
       } else {
@@ -62,6 +93,38 @@ static int onEdit(int col, int row, enum CellEditAction action) {
       screenMessage(MESSAGE_TIME, "Export failed to start");
     }
     handled = 1;
+  } else if (row == SCR_EXPORT_ROWS && col == 1) {
+    // Compact register dump
+    if (currentExporter) return 1;
+
+    char exportPath[1024];
+    generateExportPath(exportPath, sizeof(exportPath), "cnr");
+
+    currentExporter = exportStart(createDumpExport, exportPath);
+    if (currentExporter) {
+      screenMessage(MESSAGE_TIME, "Starting export...");
+    } else {
+      screenMessage(MESSAGE_TIME, "Export failed to start");
+    }
+    handled = 1;
+  } else if (row == SCR_EXPORT_ROWS + 1) {
+    // VGM Export
+    if (currentExporter) return 1;
+    if (chipnomadState->project.chipsCount > 2) {
+      screenMessage(MESSAGE_TIME, "VGM supports up to 2 chips");
+      return 1;
+    }
+
+    char exportPath[1024];
+    generateExportPath(exportPath, sizeof(exportPath), "vgm");
+
+    currentExporter = exportStart(createVGMExport, exportPath);
+    if (currentExporter) {
+      screenMessage(MESSAGE_TIME, "Starting export...");
+    } else {
+      screenMessage(MESSAGE_TIME, "Export failed to start");
+    }
+    handled = 1;
   }
 
   return handled;
@@ -72,7 +135,7 @@ static void drawColHeader(int col, int state) {}
 static void drawSelection(int col1, int row1, int col2, int row2) {}
 
 ScreenData screenExportAY = {
-  .rows = 5,
+  .rows = 7,
   .cursorRow = 0,
   .cursorCol = 0,
   .selectMode = -1,
@@ -2,7 +2,9 @@
 #include "corelib/corelib_file.h"
 #include "corelib_gfx.h"
 #include "screen_create_folder.h"
+#include "app.h"
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 
 #define VISIBLE_ENTRIES 16
@@ -33,6 +35,10 @@ static void (*onFileSelected)(const char* path);
 static void (*onCancelled)(void);
 static char pendingSavePath[2048];
 static ScrollState scrollState = {-1, 0, 0, 1};
+// Info of the project files in the current folder, when browsing projects
+static ProjectIndex* projectIndex = NULL;
+// Sorted listings of visited folders, rescanned in the background
+static DirectoryCache* directoryCache = NULL;
 
 static void fileBrowserRefreshWithSelection(const char* selectName);
 void fileBrowserRefresh(void);
@@ -74,16 +80,70 @@ static int compareEntries(const void* a, const void* b) {
   return strcmp(entryA->name, entryB->name);
 }
 
+static int isProjectBrowser(void) {
+  return !isFolderMode && strstr(fileExtension, ".cnm") != NULL;
+}
+
+static int isProjectFile(const char* name) {
+  const char* dot = strrchr(name, '.');
+  return dot && (strcasecmp(dot, ".cnm") == 0 || strcasecmp(dot, ".cnb") == 0);
+}
+
+static void closeProjectIndex(void) {
+  if (!projectIndex) return;
+  // Read-only folders just don't keep their index
+  projectIndexSave(projectIndex);
+  projectIndexClose(projectIndex);
+  projectIndex = NULL;
+}
+
+static void openProjectIndex(void) {
+  if (projectIndex && (!isProjectBrowser() || strcmp(projectIndex->folder, currentPath))) {
+    closeProjectIndex();
+  }
+  if (!projectIndex && isProjectBrowser()) {
+    projectIndex = projectIndexOpen(currentPath);
+  }
+  if (projectIndex && entries) {
+    projectIndexRetain(projectIndex, entries, entryCount);
+  }
+}
+
+// Reads the info of one project without an up to date entry per frame, the
+// selected one first, then the visible ones
+static void updateProjectIndex(void) {
+  if (!projectIndex || appIsProjectIOBusy()) return;
+
+  int selectedEntry = getEntryIndex();
+  for (int i = -1; i < VISIBLE_ENTRIES; i++) {
+    int entryIdx = i < 0 ? selectedEntry : (isFolderMode ? topIndex + i - 2 : topIndex + i);
+    if (entryIdx < 0 || entryIdx >= entryCount) continue;
+
+    FileEntry* file = &entries[entryIdx];
+    if (file->isDirectory || !isProjectFile(file->name)) continue;
+    if (projectIndexFind(projectIndex, file->name, file->size, file->modifiedTime)) continue;
+
+    projectIndexUpdate(projectIndex, file->name, file->size, file->modifiedTime);
+    return;
+  }
+}
+
 static void fileBrowserRefreshWithSelection(const char* selectName) {
   if (entries) {
     free(entries);
     entries = NULL;
   }
 
-  entries = fileListDirectory(currentPath, fileExtension, &entryCount);
-  if (entries && entryCount > 0) {
-    qsort(entries, entryCount, sizeof(FileEntry), compareEntries);
+  if (!directoryCache) directoryCache = directoryCacheCreate(compareEntries);
+  if (directoryCache) {
+    entries = directoryCacheList(directoryCache, currentPath, fileExtension, &entryCount);
+  } else {
+    entries = fileListDirectory(currentPath, fileExtension, &entryCount);
+    if (entries && entryCount > 0) {
+      qsort(entries, entryCount, sizeof(FileEntry), compareEntries);
+    }
   }
+  openProjectIndex();
 
   selectedIndex = 0;
   topIndex = 0;
@@ -107,6 +167,42 @@ void fileBrowserRefresh(void) {
   resetScrollStateOnSelectionChange();
 }
 
+// A fresh scan of the folder landed. The selected entry stays selected, and
+// where it was on the screen, if it's still there
+static void reloadListing(void) {
+  char selectName[256] = "";
+  int entryIdx = getEntryIndex();
+  if (entryIdx >= 0 && entryIdx < entryCount) strcpy(selectName, entries[entryIdx].name);
+  int lastSelectedIndex = selectedIndex;
+  int lastTopIndex = topIndex;
+
+  fileBrowserRefreshWithSelection(selectName[0] ? selectName : NULL);
+
+  entryIdx = getEntryIndex();
+  int isFound = selectName[0] && entryIdx >= 0 && entryIdx < entryCount && !strcmp(entries[entryIdx].name, selectName);
+  if (!isFound) {
+    int maxIndex = entryCount - 1 + (isFolderMode ? 2 : 0);
+    selectedIndex = lastSelectedIndex < maxIndex ? lastSelectedIndex : maxIndex;
+    if (selectedIndex < 0) selectedIndex = 0;
+  }
+
+  topIndex = lastTopIndex;
+  if (selectedIndex < topIndex) {
+    topIndex = selectedIndex;
+  } else if (selectedIndex >= topIndex + VISIBLE_ENTRIES) {
+    topIndex = selectedIndex - VISIBLE_ENTRIES + 1;
+  }
+}
+
+void fileBrowserCleanup(void) {
+  closeProjectIndex();
+  directoryCacheFree(directoryCache);
+  directoryCache = NULL;
+  free(entries);
+  entries = NULL;
+  entryCount = 0;
+}
+
 void fileBrowserSetup(const char* title, const char* extension, const char* startPath, void (*fileCallback)(const char*), void (*cancelCallback)(void)) {
   strncpy(browserTitle, title, 31);
   browserTitle[31] = 0;
@@ -208,6 +304,11 @@ static int handleBoundaryWait(int isAtStart, int isAtEnd) {
 }
 
 void fileBrowserUpdate(void) {
+  if (directoryCache && directoryCacheUpdate(directoryCache, currentPath, fileExtension)) {
+    reloadListing();
+  }
+  updateProjectIndex();
+
   if (selectedIndex != scrollState.lastSelectedIndex) {
     scrollState.lastSelectedIndex = selectedIndex;
     resetScrollState();
@@ -258,6 +359,36 @@ void fileBrowserUpdate(void) {
   }
 }
 
+// Title, author, chips, tick rate and song length of the selected project
+static void drawProjectInfo(void) {
+  int entryIdx = getEntryIndex();
+  if (!projectIndex || entryIdx < 0 || entryIdx >= entryCount || entries[entryIdx].isDirectory) return;
+
+  const FileEntry* file = &entries[entryIdx];
+  const ProjectIndexEntry* entry = projectIndexFind(projectIndex, file->name, file->size, file->modifiedTime);
+  if (!entry || !entry->isValid) return;
+
+  const ProjectInfo* info = &entry->info;
+  char details[40];
+  if (info->chipsCount > 1) {
+    snprintf(details, sizeof(details), "%dxAY %gHz %d rows", info->chipsCount, info->tickRate, info->songLength);
+  } else {
+    snprintf(details, sizeof(details), "AY %gHz %d rows", info->tickRate, info->songLength);
+  }
+
+  char names[64];
+  if (info->author[0]) {
+    snprintf(names, sizeof(names), "%s - %s", info->title, info->author);
+  } else {
+    snprintf(names, sizeof(names), "%s", info->title);
+  }
+
+  int detailsLength = strlen(details);
+  gfxSetFgColor(appSettings.colorScheme.textInfo);
+  gfxPrintf(0, 2, "%.*s", 39 - detailsLength, names);
+  gfxPrint(40 - detailsLength, 2, details);
+}
+
 void fileBrowserDraw(void) {
   gfxSetBgColor(appSettings.colorScheme.background);
   gfxClear();
@@ -274,9 +405,16 @@ void fileBrowserDraw(void) {
     snprintf(displayPath, sizeof(displayPath), "...%s", currentPath + pathLen - 77);
     gfxPrint(0, 1, displayPath);
   }
+  drawProjectInfo();
 
   int totalItems = entryCount + (isFolderMode ? 2 : 0);
 
+  // First visit to the folder, its listing isn't there yet
+  if (entryCount == 0 && directoryCache && directoryCacheIsScanning(directoryCache, currentPath, fileExtension)) {
+    gfxSetFgColor(appSettings.colorScheme.textInfo);
+    gfxPrint(2, 3 + (isFolderMode ? 2 : 0), "Scanning...");
+  }
+
   for (int i = 0; i < VISIBLE_ENTRIES && (topIndex + i) < totalItems; i++) {
     int itemIndex = topIndex + i;
     int y = 3 + i;
@@ -464,6 +602,7 @@ int fileBrowserInput(int keys, int tapCount) {
       // Select file (only in file mode)
       char fullPath[2048];
       snprintf(fullPath, sizeof(fullPath), "%s%s%s", currentPath, PATH_SEPARATOR_STR, entries[entryIdx].name);
+      closeProjectIndex();
       if (onFileSelected) {
         onFileSelected(fullPath);
         return 0;
@@ -472,6 +611,7 @@ int fileBrowserInput(int keys, int tapCount) {
     return 1;
   } else if (keys == keyOpt) {
     // Cancel
+    closeProjectIndex();
     if (onCancelled) {
       onCancelled();
       return 0;
@@ -18,4 +18,7 @@ void fileBrowserUpdate(void);
 // Handle input, returns 1 if handled
 int fileBrowserInput(int keys, int isDoubleTap);
 
+// Wait for a background folder scan and free the cached listings
+void fileBrowserCleanup(void);
+
 #endif
\ No newline at end of file
@@ -2,9 +2,11 @@
 #include "common.h"
 #include "corelib_gfx.h"
 #include "corelib/corelib_file.h"
+#include "corelib/corelib_thread.h"
 #include "chipnomad_lib.h"
 #include "screens.h"
 #include "export/export.h"
+#include "app.h"
 #include <string.h>
 
 // Export state
@@ -18,10 +20,19 @@ static int sampleRates[] = {44100, 48000, 88200, 96000};
 static int bitDepths[] = {16, 24, 32};
 static int currentSampleRateIndex = 0;
 static int currentBitDepthIndex = 0;
+// Target loudness in LUFS, 0 is off
+static int normalizeTargets[] = {0, -14, -16, -23};
+static int currentNormalizeIndex = 0;
 int startRow = 0;
+// WAV file being exported, its loudness is shown when done
+static char wavExportPath[1024] = "";
+
+#define EXPORT_TRUE_PEAK_LIMIT (-1.0f)
+// Parallel WAV export threads. One core is left to the audio callback and UI
+#define EXPORT_MAX_THREADS (4)
 
 static ScreenData screenExportCommon = {
-  .rows = 4,
+  .rows = 5,
   .cursorRow = 0,
   .cursorCol = 0,
   .selectMode = -1,
@@ -46,6 +57,7 @@ static ScreenData* exportScreen(void) {
 static void setup(int input) {
   currentSampleRateIndex = 0;
   currentBitDepthIndex = 0;
+  currentNormalizeIndex = 0;
   startRow = 0;
 }
 
@@ -58,14 +70,25 @@ static void draw(void) {
   if (currentExporter) {
     int seconds = currentExporter->next(currentExporter);
     if (seconds == -1) {
-      if (currentExporter->finish(currentExporter) == 0) {
-        screenMessage(MESSAGE_TIME, "Export completed");
-      } else {
+      LoudnessStats stats;
+      if (currentExporter->finish(currentExporter) != 0) {
         screenMessage(MESSAGE_TIME, "Export failed");
+      } else if (wavExportPath[0] && wavReadLoudness(wavExportPath, &stats) == 0) {
+        screenMessage(MESSAGE_TIME, "Export completed, %.1f LUFS, %.1f dBTP", stats.integrated, stats.truePeak);
+      } else {
+        screenMessage(MESSAGE_TIME, "Export completed");
       }
       currentExporter = NULL;
+      wavExportPath[0] = 0;
     } else {
-      screenMessage(MESSAGE_TIME, "Exporting... %ds. B to cancel", seconds);
+      ExportProgress progress;
+      backgroundExporterProgress(currentExporter, &progress);
+      if (progress.etaSeconds >= 0) {
+        screenMessage(MESSAGE_TIME, "Exporting %d%%, %ds left. B to cancel",
+          progress.framesDone * 100 / progress.framesTotal, progress.etaSeconds);
+      } else {
+        screenMessage(MESSAGE_TIME, "Exporting... %ds. B to cancel", seconds);
+      }
     }
   }
 }
@@ -75,6 +98,7 @@ static int onInput(int isKeyDown, int keys, int tapCount) {
     if (keys == keyOpt) {
       currentExporter->cancel(currentExporter);
       currentExporter = NULL;
+      wavExportPath[0] = 0;
       screenMessage(MESSAGE_TIME, "Export cancelled");
     }
     return 1; // Block all other input during export
@@ -110,6 +134,8 @@ int exportCommonColumnCount(int row) {
     return 1;
   } else if (row == 3) {
     return 1;
+  } else if (row == 4) {
+    return 1;
   }
   return 0;
 }
@@ -128,6 +154,7 @@ void exportCommonDrawStatic(void) {
   gfxSetFgColor(cs.textDefault);
   gfxPrint(0, 5, "Sample rate");
   gfxPrint(0, 6, "Bit depth");
+  gfxPrint(0, 7, "Normalize");
 }
 
 void exportCommonDrawCursor(int col, int row) {
@@ -143,6 +170,8 @@ void exportCommonDrawCursor(int col, int row) {
     gfxCursor(13, 5, 5);
   } else if (row == 3) {
     gfxCursor(13, 6, 2);
+  } else if (row == 4) {
+    gfxCursor(13, 7, 8);
   }
 }
 
@@ -164,6 +193,13 @@ void exportCommonDrawField(int col, int row, int state) {
   } else if (row == 3) {
     gfxClearRect(13, 6, 2, 1);
     gfxPrintf(13, 6, "%d", bitDepths[currentBitDepthIndex]);
+  } else if (row == 4) {
+    gfxClearRect(13, 7, 8, 1);
+    if (normalizeTargets[currentNormalizeIndex] == 0) {
+      gfxPrint(13, 7, "Off");
+    } else {
+      gfxPrintf(13, 7, "%d LUFS", normalizeTargets[currentNormalizeIndex]);
+    }
   }
 }
 
@@ -255,6 +291,50 @@ void generateExportPath(char* outputPath, int maxLen, const char* extension) {
   outputPath[maxLen - 1] = 0;
 }
 
+static int exportThreadsCount(void) {
+  int threadsCount = threadCPUCount() - 1;
+  if (threadsCount > EXPORT_MAX_THREADS) threadsCount = EXPORT_MAX_THREADS;
+  if (threadsCount < 1) threadsCount = 1;
+  return threadsCount;
+}
+
+Exporter* exportStart(ExporterFactory* factory, const char* path) {
+  ExportSetup* setup = malloc(sizeof(ExportSetup));
+  if (!setup) return NULL;
+
+  snprintf(setup->path, sizeof(setup->path), "%s", path);
+  setup->startRow = startRow;
+  setup->sampleRate = sampleRates[currentSampleRateIndex];
+  setup->bitDepth = bitDepths[currentBitDepthIndex];
+  setup->threadsCount = exportThreadsCount();
+  setup->normalizeTarget = normalizeTargets[currentNormalizeIndex];
+  setup->mixVolume = appSettings.mixVolume;
+
+  return createBackgroundExporterFromSnapshot(appSnapshotProject(), factory, setup);
+}
+
+// Exporter factories, called on the export thread
+
+static Exporter* createWAVExport(Project* project, void* arg) {
+  ExportSetup* setup = arg;
+  Exporter* exporter = createWAVExporterParallel(setup->path, project, setup->startRow, setup->sampleRate, setup->bitDepth, setup->threadsCount);
+  if (!exporter) return NULL;
+
+  if (setup->normalizeTarget != 0 && wavExporterSetNormalization(exporter, (float)setup->normalizeTarget, EXPORT_TRUE_PEAK_LIMIT)) {
+    exporter->cancel(exporter);
+    return NULL;
+  }
+  exporter->chipnomadState->mixVolume = setup->mixVolume;
+  return exporter;
+}
+
+static Exporter* createStemsExport(Project* project, void* arg) {
+  ExportSetup* setup = arg;
+  Exporter* exporter = createWAVStemsExporter(setup->path, project, setup->startRow, setup->sampleRate, setup->bitDepth, 0);
+  if (exporter) exporter->chipnomadState->mixVolume = setup->mixVolume;
+  return exporter;
+}
+
 int exportCommonOnEdit(int col, int row, enum CellEditAction action) {
   int handled = 0;
 
@@ -266,9 +346,9 @@ int exportCommonOnEdit(int col, int row, enum CellEditAction action) {
     char exportPath[1024];
     generateExportPath(exportPath, sizeof(exportPath), "wav");
 
-    currentExporter = createWAVExporter(exportPath, &chipnomadState->project, startRow, sampleRates[currentSampleRateIndex], bitDepths[currentBitDepthIndex]);
+    currentExporter = exportStart(createWAVExport, exportPath);
     if (currentExporter) {
-      currentExporter->chipnomadState->mixVolume = appSettings.mixVolume;
+      strcpy(wavExportPath, exportPath);
       screenMessage(MESSAGE_TIME, "Starting export...");
     } else {
       screenMessage(MESSAGE_TIME, "Export failed to start");
@@ -280,9 +360,8 @@ int exportCommonOnEdit(int col, int row, enum CellEditAction action) {
     char basePath[512];
     generateStemsExportPath(basePath, sizeof(basePath));
 
-    currentExporter = createWAVStemsExporter(basePath, &chipnomadState->project, startRow, sampleRates[currentSampleRateIndex], bitDepths[currentBitDepthIndex]);
+    currentExporter = exportStart(createStemsExport, basePath);
     if (currentExporter) {
-      currentExporter->chipnomadState->mixVolume = appSettings.mixVolume;
       int trackCount = chipnomadState->project.chipsCount * 3;
       screenMessage(MESSAGE_TIME, "Starting stems export (%d files)...", trackCount);
     } else {
@@ -305,6 +384,14 @@ int exportCommonOnEdit(int col, int row, enum CellEditAction action) {
       currentBitDepthIndex = (currentBitDepthIndex + 2) % 3;
       handled = 1;
     }
+  } else if (row == 4) {
+    if (action == editIncrease) {
+      currentNormalizeIndex = (currentNormalizeIndex + 1) % 4;
+      handled = 1;
+    } else if (action == editDecrease) {
+      currentNormalizeIndex = (currentNormalizeIndex + 3) % 4;
+      handled = 1;
+    }
   }
 
   return handled;
@@ -7,12 +7,27 @@
 struct Exporter;
 
 // Common rows on the export screen
-#define SCR_EXPORT_ROWS (4)
+#define SCR_EXPORT_ROWS (5)
 
 // Export state
 extern struct Exporter* currentExporter;
 extern int startRow;
 
+// Export screen settings, passed to the exporter factories
+typedef struct ExportSetup {
+  char path[1024];
+  int startRow;
+  int sampleRate;
+  int bitDepth;
+  int threadsCount;
+  int normalizeTarget; // LUFS, 0 is off
+  float mixVolume;
+} ExportSetup;
+
+// Start exporting a snapshot of the project in the background. The exporter is created by
+// factory(project, setup) on the export thread. Returns NULL if the export couldn't start
+struct Exporter* exportStart(struct Exporter* (*factory)(Project* project, void* setup), const char* path);
+
 int exportCommonColumnCount(int row);
 void exportCommonDrawStatic(void);
 void exportCommonDrawCursor(int col, int row);
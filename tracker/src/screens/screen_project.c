@@ -8,6 +8,7 @@
 #include "pitch_table_utils.h"
 #include "version.h"
 #include "audio_manager.h"
+#include "app.h"
 #include "file_browser.h"
 #include "import/import_vt2.h"
 #include <string.h>
@@ -19,6 +20,20 @@ static int editingStringLength = 0;
 static int tickRateI = 0;
 static uint16_t tickRateF = 0;
 
+static void onProjectLoadDone(const char* path, int result) {
+  if (result == 0) {
+    // Store filename without extension
+    extractFilenameWithoutExtension(path, appSettings.projectFilename, FILENAME_LENGTH + 1);
+
+    // Reset all screen states (including song position)
+    screensInitAll();
+  } else {
+    screenMessage(MESSAGE_TIME, "Load failed");
+  }
+
+  screenSetup(&screenProject, 0);
+}
+
 static void onProjectLoaded(const char* path) {
   if (!path) {
     screenSetup(&screenProject, 0);
@@ -37,50 +52,43 @@ static void onProjectLoaded(const char* path) {
     appSettings.projectPath[0] = '\0';
   }
 
-  playbackStop(&chipnomadState->playbackState);
-  
   // Check file extension to determine loader
   const char* ext = strrchr(path, '.');
-  int loadResult = -1;
-  
-  if (ext != NULL) {
-    if (strcasecmp(ext, ".vt2") == 0) {
-      // Load VT2 file
-      loadResult = projectLoadVT2(path);
-    } else if (strcasecmp(ext, ".cnm") == 0) {
-      // Load ChipNomad native format
-      loadResult = projectLoad(&chipnomadState->project, path);
-    } else {
-      // Try native format by default
-      loadResult = projectLoad(&chipnomadState->project, path);
-    }
+
+  if (ext != NULL && strcasecmp(ext, ".vt2") == 0) {
+    // Load VT2 file
+    playbackStop(&chipnomadState->playbackState);
+    int loadResult = projectLoadVT2(path);
+    if (loadResult == 0) chipnomadInitChips(chipnomadState, appSettings.audioSampleRate, NULL);
+    onProjectLoadDone(path, loadResult);
   } else {
-    // No extension, try native format
-    loadResult = projectLoad(&chipnomadState->project, path);
+    // ChipNomad native format, text or binary, is loaded in the background
+    // and swapped in on the main thread by updateProjectIO with audio paused
+    appLoadProject(path, onProjectLoadDone);
+    screenSetup(&screenProject, 0);
   }
-  
-  if (loadResult == 0) {
-    chipnomadInitChips(chipnomadState, appSettings.audioSampleRate, NULL);
-
-    // Store filename without extension
-    extractFilenameWithoutExtension(path, appSettings.projectFilename, FILENAME_LENGTH + 1);
+}
 
-    // Reset all screen states (including song position)
-    screensInitAll();
+static void onProjectSaveDone(const char* path, int result) {
+  if (result == 0) {
+    // Save the directory path
+    const char* lastSeparator = strrchr(path, PATH_SEPARATOR);
+    int pathLen = lastSeparator ? lastSeparator - path : 0;
+    if (pathLen > PATH_LENGTH) pathLen = PATH_LENGTH;
+    strncpy(appSettings.projectPath, path, pathLen);
+    appSettings.projectPath[pathLen] = 0;
+    screenMessage(MESSAGE_TIME, "Project saved");
+  } else {
+    screenMessage(MESSAGE_TIME, "Save failed");
   }
-
-  screenSetup(&screenProject, 0);
 }
 
 static void onProjectSaved(const char* folderPath) {
   char fullPath[2048];
   snprintf(fullPath, sizeof(fullPath), "%s%s%s.cnm", folderPath, PATH_SEPARATOR_STR, appSettings.projectFilename);
 
-  if (projectSave(&chipnomadState->project, fullPath) == 0) {
-    // Save the directory path
-    strncpy(appSettings.projectPath, folderPath, PATH_LENGTH);
-    appSettings.projectPath[PATH_LENGTH] = 0;
-  }
+  // The project is copied now and written in the background
+  appSaveProject(fullPath, onProjectSaveDone);
   screenSetup(&screenProject, 0);
 }
 
@@ -262,7 +270,7 @@ int projectCommonOnEdit(int col, int row, enum CellEditAction action) {
     // Load/Save/New/Export
     if (col == 0) {
       // Load project - go directly to file browser
-      fileBrowserSetup("LOAD PROJECT", ".cnm,.vt2", appSettings.projectPath, onProjectLoaded, onProjectCancelled);
+      fileBrowserSetup("LOAD PROJECT", ".cnm,.cnb,.vt2", appSettings.projectPath, onProjectLoaded, onProjectCancelled);
       screenSetup(&screenFileBrowser, 0);
     } else if (col == 1) {
       // Save project - check filename first
@@ -6,6 +6,7 @@
 #include "corelib_gfx.h"
 #include "utils.h"
 #include "copy_paste.h"
+#include "app.h"
 
 const AppScreen* currentScreen = NULL;
 
@@ -61,7 +62,7 @@ void drawScreenMap() {
 }
 
 void screenSetup(const AppScreen* screen, int input) {
-  projectSave(&chipnomadState->project, getAutosavePath()); // Temporary measure against random crashes
+  appAutosave(); // Journal edits made on the previous screen
 
   currentScreen = screen;
   currentScreen->setup(input);
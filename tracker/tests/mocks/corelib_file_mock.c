@@ -7,11 +7,18 @@ int fileOpen(const char* path, int isWriting) { return -1; }
 int fileClose(int fileId) { return 0; }
 int fileRead(int fileId, void* buffer, int maxLength) { return 0; }
 char* fileReadString(int fileId) { return NULL; }
+char* fileReadLine(int fileId, int* length) { return NULL; }
+void fileSetBufferSize(int size) {}
 int fileWrite(int fileId, void* data, int length) { return 0; }
 int filePrintf(int fileId, const char* format, ...) { return 0; }
+int fileFlush(int fileId) { return 0; }
+int fileRename(const char* from, const char* to) { return -1; }
+const void* fileMap(const char* path, long* size) { return NULL; }
+void fileUnmap(const void* data, long size) {}
 FileEntry* fileListDirectory(const char* path, const char* extension, int* entryCount) {
   *entryCount = 0;
   return NULL;
 }
 int fileGetCurrentDirectory(char* buffer, int bufferSize) { return 0; }
-int fileDirectoryExists(const char* path) { return 0; }
\ No newline at end of file
+int fileDirectoryExists(const char* path) { return 0; }
+int fileGetModifiedTime(const char* path, long long* modifiedTime) { return -1; }
\ No newline at end of file